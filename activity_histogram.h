@@ -0,0 +1,110 @@
+#ifndef ACTIVITY_HISTOGRAM_H
+#define ACTIVITY_HISTOGRAM_H
+
+#include <math.h>
+#include <stdint.h>
+#include "config.h"
+
+// Per-weekday, per-15-minute histogram of observed fire starts (7 * 96 bytes) behind the
+// learned check schedule. Free of hardware access so tools/activity_replay.cpp runs the same
+// code on a host; ActivityScheduler adds the wall clock and NVS.
+// A fresh histogram holds a prior matching the former fixed day-part intervals.
+class ActivityHistogram {
+public:
+    static constexpr int DAYS = 7;
+    static constexpr int SLOTS_PER_DAY = 96;              // 15 minute slots
+    static constexpr int SLOT_MINUTES = 24 * 60 / SLOTS_PER_DAY;
+    static constexpr uint8_t MAX_WEIGHT = 255;
+
+private:
+    static constexpr long MAX_DECAY_STEPS = 128;          // Every weight is 0 long before
+
+    uint8_t histogram[DAYS][SLOTS_PER_DAY];
+
+    // Adds to an absolute slot offset, carrying into the neighbouring days and the week
+    void addWeight(int day, int slot, uint8_t amount) {
+        while (slot < 0) { slot += SLOTS_PER_DAY; day--; }
+        while (slot >= SLOTS_PER_DAY) { slot -= SLOTS_PER_DAY; day++; }
+        day = ((day % DAYS) + DAYS) % DAYS;
+        uint16_t weight = histogram[day][slot] + amount;
+        histogram[day][slot] = weight > MAX_WEIGHT ? MAX_WEIGHT : weight;
+    }
+
+public:
+    ActivityHistogram() {
+        seedPrior();
+    }
+
+    // Weight whose check interval is the given one, the inverse of checkInterval()
+    static uint8_t weightFor(unsigned long interval) {
+        float score = logf(static_cast<float>(Config::Activity::MAX_CHECK_INTERVAL) / interval) /
+                      logf(static_cast<float>(Config::Activity::MAX_CHECK_INTERVAL) / Config::Activity::MIN_CHECK_INTERVAL);
+        if (score <= 0.0f) return 0;
+        if (score >= 1.0f) return MAX_WEIGHT;
+        return static_cast<uint8_t>(lroundf(score * MAX_WEIGHT));
+    }
+
+    // The former fixed intervals: 30 minutes at night, 5 during the day, 3 in the evening
+    static uint8_t priorWeight(int slot) {
+        int hour = slot * SLOT_MINUTES / 60;
+        if (hour >= 22 || hour < 6) return weightFor(30 * 60000UL);
+        if (hour >= 17) return weightFor(3 * 60000UL);
+        return weightFor(5 * 60000UL);
+    }
+
+    void seedPrior() {
+        for (int day = 0; day < DAYS; day++) {
+            for (int slot = 0; slot < SLOTS_PER_DAY; slot++) {
+                histogram[day][slot] = priorWeight(slot);
+            }
+        }
+    }
+
+    // Weight at an absolute slot offset, wrapping across midnight and the week
+    uint8_t weightAt(int day, int slot) const {
+        while (slot < 0) { slot += SLOTS_PER_DAY; day--; }
+        while (slot >= SLOTS_PER_DAY) { slot -= SLOTS_PER_DAY; day++; }
+        return histogram[((day % DAYS) + DAYS) % DAYS][slot];
+    }
+
+    // Spread over the neighbouring slots, fires are rarely lit at the exact same minute
+    void recordStart(int weekday, int slot) {
+        addWeight(weekday, slot, Config::Activity::START_INCREMENT);
+        addWeight(weekday, slot - 1, Config::Activity::START_INCREMENT / 2);
+        addWeight(weekday, slot + 1, Config::Activity::START_INCREMENT / 2);
+    }
+
+    // One decay step per elapsed day
+    void decay(long days) {
+        if (days > MAX_DECAY_STEPS) days = MAX_DECAY_STEPS;
+        for (long step = 0; step < days; step++) {
+            for (int day = 0; day < DAYS; day++) {
+                for (int slot = 0; slot < SLOTS_PER_DAY; slot++) {
+                    uint16_t weight = histogram[day][slot];
+                    histogram[day][slot] = (weight * Config::Activity::DECAY_NUMERATOR) >> 8;
+                }
+            }
+        }
+    }
+
+    // Likelihood score 0..255 for a fire start in the given or the next slot
+    uint8_t likelihood(int weekday, int slot) const {
+        uint8_t current = weightAt(weekday, slot);
+        uint8_t next = weightAt(weekday, slot + 1);
+        return current > next ? current : next;
+    }
+
+    // Check interval in ms, log-interpolated between the configured bounds:
+    // likely slots are checked every MIN_CHECK_INTERVAL, unlikely ones every MAX_CHECK_INTERVAL
+    static unsigned long checkInterval(uint8_t likelihood) {
+        float score = likelihood / static_cast<float>(MAX_WEIGHT);
+        float ratio = static_cast<float>(Config::Activity::MIN_CHECK_INTERVAL) /
+                      Config::Activity::MAX_CHECK_INTERVAL;
+        return static_cast<unsigned long>(Config::Activity::MAX_CHECK_INTERVAL * powf(ratio, score));
+    }
+
+    uint8_t* data() { return &histogram[0][0]; }
+    static constexpr size_t size() { return sizeof(uint8_t) * DAYS * SLOTS_PER_DAY; }
+};
+
+#endif // ACTIVITY_HISTOGRAM_H
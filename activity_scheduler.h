@@ -0,0 +1,95 @@
+#ifndef ACTIVITY_SCHEDULER_H
+#define ACTIVITY_SCHEDULER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+#include "logging.h"
+#include "timekeeper.h"
+#include "activity_histogram.h"
+
+// Learns when fires are usually lit and derives the sleep-mode check interval from it.
+// The ActivityHistogram of observed fire starts decays one step per day, so old habits fade
+// out over a few weeks; the day of the last decay is stored with it, so days without power
+// count as well.
+class ActivityScheduler {
+private:
+    static constexpr const char* NVS_NAMESPACE = "activity";
+    static constexpr const char* NVS_KEY = "hist";
+    static constexpr const char* NVS_DAY_KEY = "day";
+
+    const Timekeeper& clock;
+    ActivityHistogram histogram;
+    long lastDecayDay = -1;
+
+    void applyDailyDecay(long day) {
+        if (lastDecayDay == day) return;
+        long elapsed = day - lastDecayDay;
+        bool firstCall = lastDecayDay < 0;
+        lastDecayDay = day;
+        if (firstCall || elapsed < 0) {
+            save();  // No reference yet, or the clock went back: count from today
+            return;
+        }
+
+        histogram.decay(elapsed);
+        save();
+        LOG_PRINT("DEBUG: Activity histogram decayed, days ");
+        LOG_PRINTLN(elapsed);
+    }
+
+    void save() {
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, false)) {
+            prefs.putBytes(NVS_KEY, histogram.data(), ActivityHistogram::size());
+            prefs.putLong(NVS_DAY_KEY, lastDecayDay);
+            prefs.end();
+        }
+    }
+
+public:
+    explicit ActivityScheduler(const Timekeeper& timekeeper) : clock(timekeeper) {}
+
+    // Loads the learned histogram from NVS; keeps the prior if nothing was stored yet
+    void begin() {
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, true)) {
+            if (prefs.getBytesLength(NVS_KEY) == ActivityHistogram::size()) {
+                prefs.getBytes(NVS_KEY, histogram.data(), ActivityHistogram::size());
+                lastDecayDay = prefs.getLong(NVS_DAY_KEY, -1);
+                LOG_PRINTLN("DEBUG: Activity histogram loaded");
+            }
+            prefs.end();
+        }
+    }
+
+    // Records an observed fire start at the current time; ignored without a wall clock
+    void recordFireStart() {
+        if (!clock.isSynced()) return;
+        applyDailyDecay(clock.dayNumber());
+
+        int weekday = clock.weekday();
+        int slot = clock.slot();
+        histogram.recordStart(weekday, slot);
+        save();
+
+        LOG_PRINT("DEBUG: Fire start recorded, weekday ");
+        LOG_PRINT(weekday);
+        LOG_PRINT(" slot ");
+        LOG_PRINTLN(slot);
+    }
+
+    // Likelihood score 0..255 for a fire start in the current or next slot.
+    // Without a wall clock the daytime prior is used.
+    uint8_t likelihood() {
+        if (!clock.isSynced()) return ActivityHistogram::priorWeight(12 * 60 / ActivityHistogram::SLOT_MINUTES);
+        applyDailyDecay(clock.dayNumber());
+        return histogram.likelihood(clock.weekday(), clock.slot());
+    }
+
+    unsigned long getCheckInterval() {
+        return ActivityHistogram::checkInterval(likelihood());
+    }
+};
+
+#endif // ACTIVITY_SCHEDULER_H
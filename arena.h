@@ -0,0 +1,134 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+class Arena;
+
+// Bounded text builder over a caller-provided buffer, used instead of String concatenation.
+// On overflow the text is truncated, further output is dropped and overflowed() reports it;
+// it never falls back to the heap. When opened from an Arena the used space is charged to it.
+class TextWriter {
+private:
+    char* buffer;
+    size_t capacity;
+    size_t len = 0;
+    bool overflow = false;
+    Arena* owner = nullptr;
+
+    void charge();
+
+public:
+    TextWriter(char* target, size_t size, Arena* arena = nullptr)
+        : buffer(target), capacity(size), owner(arena) {
+        if (capacity > 0) buffer[0] = '\0';
+        charge();
+    }
+
+    TextWriter& print(const char* text, size_t length) {
+        if (overflow) return *this;
+        if (capacity == 0 || len + length >= capacity) {
+            // Keep what fits so the truncated text is still terminated
+            size_t room = capacity > len + 1 ? capacity - len - 1 : 0;
+            if (room > 0) memcpy(buffer + len, text, room);
+            len += room;
+            if (capacity > 0) buffer[len] = '\0';
+            overflow = true;
+        } else {
+            memcpy(buffer + len, text, length);
+            len += length;
+            buffer[len] = '\0';
+        }
+        charge();
+        return *this;
+    }
+
+    TextWriter& print(const char* text) { return print(text, strlen(text)); }
+    TextWriter& print(char c) { return print(&c, 1); }
+    TextWriter& print(bool value) { return print(value ? "true" : "false"); }
+    TextWriter& print(int value) { return print(static_cast<long>(value)); }
+    TextWriter& print(unsigned int value) { return print(static_cast<unsigned long>(value)); }
+
+    TextWriter& print(long value) {
+        char digits[16];
+        int n = snprintf(digits, sizeof(digits), "%ld", value);
+        return print(digits, n);
+    }
+
+    TextWriter& print(unsigned long value) {
+        char digits[16];
+        int n = snprintf(digits, sizeof(digits), "%lu", value);
+        return print(digits, n);
+    }
+
+    TextWriter& print(double value, int decimals) {
+        char digits[24];
+        int n = snprintf(digits, sizeof(digits), "%.*f", decimals, value);
+        return print(digits, n > 0 && static_cast<size_t>(n) < sizeof(digits) ? n : 0);
+    }
+
+    const char* c_str() const { return buffer; }
+    size_t length() const { return len; }
+    bool overflowed() const { return overflow; }
+};
+
+// Fixed-size scratch memory for handling one request. Allocations bump a pointer and are
+// all released at once by reset() after the response has been queued, so request handling
+// never touches (or fragments) the heap. A text writer opened from the arena takes the
+// remaining space and grows with its content; only the most recent allocation may grow.
+class Arena {
+private:
+    friend class TextWriter;
+
+    char* memory;
+    size_t capacity;
+    size_t used = 0;
+    size_t highWater = 0;
+    uint32_t overflows = 0;
+
+    void grow(size_t end) {
+        used = end;
+        if (used > highWater) highWater = used;
+    }
+
+public:
+    Arena(char* target, size_t size) : memory(target), capacity(size) {}
+
+    // Returns nullptr (and counts an overflow) when the request does not fit
+    void* allocate(size_t size) {
+        size_t start = (used + 3) & ~static_cast<size_t>(3);
+        if (start + size > capacity) {
+            overflows++;
+            return nullptr;
+        }
+        grow(start + size);
+        return memory + start;
+    }
+
+    TextWriter text() {
+        return TextWriter(memory + used, capacity - used, this);
+    }
+
+    void reset() {
+        used = 0;
+    }
+
+    size_t size() const { return capacity; }
+    size_t getHighWater() const { return highWater; }
+    uint32_t getOverflows() const { return overflows; }
+};
+
+inline void TextWriter::charge() {
+    if (!owner) return;
+    size_t end = static_cast<size_t>(buffer - owner->memory) + len + 1;
+    if (end > owner->used) owner->grow(end);
+    if (overflow) {
+        owner->overflows++;
+        owner = nullptr;            // Count each overflowing writer once
+    }
+}
+
+#endif // ARENA_H
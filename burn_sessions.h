@@ -0,0 +1,282 @@
+#ifndef BURN_SESSIONS_H
+#define BURN_SESSIONS_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "config.h"
+#include "logging.h"
+#include "system_status.h"
+#include "timekeeper.h"
+#include "arena.h"
+
+// Splits operation into burn sessions, one fire from lighting to cooled down, using the
+// smoothed temperature and its slope:
+//   start  at START_TEMP and rising by START_SLOPE, or above START_TEMP + HOT_MARGIN
+//   end    below END_TEMP and not rising for END_HOLD; restoking within the hold continues
+//          the session, which ends where the cooling began
+// Each tick updates the statistics of the open session in O(1): duration, peak and mean
+// temperature, heat recovered, fan energy and peak heat power. Finished sessions go to a ring
+// of the last MAX_SESSIONS and into daily and weekly rollups keyed by the local date of their
+// start (date 0 while the wall clock is unknown). All storage is fixed; none survives a reboot.
+class BurnSessionTracker {
+public:
+    struct Session {
+        uint32_t startEpoch = 0;        // Wall clock at the start, 0 if unknown
+        uint32_t startUptime = 0;       // Seconds since boot at the start
+        uint32_t duration = 0;          // s
+        float peakTemperature = 0.0f;
+        float meanTemperature = 0.0f;
+        float heatWh = 0.0f;
+        float fanWh = 0.0f;
+        float peakPower = 0.0f;         // Heat power in W
+
+        float averagePower() const {
+            return duration > 0 ? heatWh * 3600.0f / duration : 0.0f;
+        }
+    };
+
+    struct Rollup {
+        uint32_t date = 0;              // YYYYMMDD of the day, or of the Monday of the week
+        uint16_t sessions = 0;
+        uint32_t seconds = 0;
+        float heatWh = 0.0f;
+        float fanWh = 0.0f;
+        float peakTemperature = 0.0f;
+
+        void add(const Session& session) {
+            sessions++;
+            seconds += session.duration;
+            heatWh += session.heatWh;
+            fanWh += session.fanWh;
+            peakTemperature = fmaxf(peakTemperature, session.peakTemperature);
+        }
+    };
+
+private:
+    static constexpr int MAX_SESSIONS = Config::BurnSession::MAX_SESSIONS;
+    static constexpr int DAYS = Config::BurnSession::DAYS;
+    static constexpr int WEEKS = Config::BurnSession::WEEKS;
+
+    // Fixed ring, newest entry at index newest
+    template <typename T, int SIZE>
+    struct Ring {
+        T entries[SIZE];
+        int newest = SIZE - 1;
+        int count = 0;
+
+        T& push() {
+            newest = (newest + 1) % SIZE;
+            entries[newest] = T();
+            if (count < SIZE) count++;
+            return entries[newest];
+        }
+
+        const T& fromNewest(int i) const { return entries[(newest - i + SIZE) % SIZE]; }
+    };
+
+    SystemStatus& status;
+    const Timekeeper& timekeeper;
+
+    unsigned long lastTick = 0;
+    float lastHeatEnergyKWh = 0.0f;
+
+    // Open session
+    bool active = false;
+    Session current;
+    unsigned long startMs = 0;
+    bool cooling = false;
+    unsigned long coolingSince = 0;
+    float temperatureSum = 0.0f;        // °C·s
+    float sampledSeconds = 0.0f;
+
+    Ring<Session, MAX_SESSIONS> sessions;
+    Ring<Rollup, DAYS> days;
+    Ring<Rollup, WEEKS> weeks;
+    uint32_t sessionCount = 0;
+    uint32_t discardedCount = 0;
+
+    static uint32_t dateKey(const struct tm& date) {
+        return (date.tm_year + 1900) * 10000UL + (date.tm_mon + 1) * 100UL + date.tm_mday;
+    }
+
+    template <int SIZE>
+    static void addToRollup(Ring<Rollup, SIZE>& ring, uint32_t date, const Session& session) {
+        if (ring.count == 0 || ring.entries[ring.newest].date != date) {
+            ring.push().date = date;
+        }
+        ring.entries[ring.newest].add(session);
+    }
+
+    void begin(unsigned long now) {
+        active = true;
+        cooling = false;
+        startMs = now;
+        temperatureSum = 0.0f;
+        sampledSeconds = 0.0f;
+        current = Session();
+        current.startUptime = now / 1000;
+        current.startEpoch = timekeeper.isSynced() ? static_cast<uint32_t>(time(nullptr)) : 0;
+        LOG_PRINTLN("DEBUG: Burn session started");
+    }
+
+    void finish(unsigned long end) {
+        active = false;
+        current.duration = (end - startMs) / 1000;
+        if (current.duration < Config::BurnSession::MIN_DURATION) {
+            discardedCount++;
+            LOG_PRINTLN("DEBUG: Burn session too short, dropped");
+            return;
+        }
+        current.meanTemperature = sampledSeconds > 0.0f ? temperatureSum / sampledSeconds : 0.0f;
+        sessions.push() = current;
+        sessionCount++;
+
+        uint32_t day = 0;
+        uint32_t week = 0;
+        if (current.startEpoch != 0) {
+            time_t start = current.startEpoch;
+            struct tm date;
+            localtime_r(&start, &date);
+            day = dateKey(date);
+            date.tm_mday -= (date.tm_wday + 6) % 7;     // Back to Monday
+            date.tm_hour = 12;
+            date.tm_isdst = -1;
+            mktime(&date);
+            week = dateKey(date);
+        }
+        addToRollup(days, day, current);
+        addToRollup(weeks, week, current);
+
+        LOG_PRINT("DEBUG: Burn session finished, heat Wh ");
+        LOG_PRINTLN(current.heatWh);
+    }
+
+    bool isStart(float temperature, float slope) const {
+        using namespace Config::BurnSession;
+        return temperature >= START_TEMP && (slope >= START_SLOPE || temperature >= START_TEMP + HOT_MARGIN);
+    }
+
+    // The hold restarts whenever the temperature rises again
+    void checkEnd(float temperature, float slope, unsigned long now) {
+        using namespace Config::BurnSession;
+        if (temperature >= END_TEMP || slope > END_SLOPE) {
+            cooling = false;
+        } else if (!cooling) {
+            cooling = true;
+            coolingSince = now;
+        } else if (now - coolingSince >= END_HOLD) {
+            finish(coolingSince);
+        }
+    }
+
+    void appendSession(TextWriter& out, const Session& session, unsigned long nowSeconds) const {
+        out.print("{\"start\":").print(static_cast<unsigned long>(session.startEpoch));
+        out.print(",\"ago\":").print(nowSeconds - session.startUptime);
+        out.print(",\"duration\":").print(static_cast<unsigned long>(session.duration));
+        out.print(",\"peak_temp\":").print(session.peakTemperature, 1);
+        out.print(",\"mean_temp\":").print(session.meanTemperature, 1);
+        out.print(",\"heat_wh\":").print(session.heatWh, 1);
+        out.print(",\"fan_wh\":").print(session.fanWh, 3);
+        out.print(",\"avg_power\":").print(session.averagePower(), 1);
+        out.print(",\"peak_power\":").print(session.peakPower, 1).print('}');
+    }
+
+    // Compact rows: [date, sessions, seconds, heat_wh, fan_wh, peak_temp], newest first
+    template <int SIZE>
+    static void appendRollups(TextWriter& out, const char* name, const Ring<Rollup, SIZE>& ring) {
+        out.print('"').print(name).print("\":[");
+        for (int i = 0; i < ring.count; i++) {
+            const Rollup& rollup = ring.fromNewest(i);
+            if (i > 0) out.print(',');
+            out.print('[').print(static_cast<unsigned long>(rollup.date));
+            out.print(',').print(static_cast<unsigned int>(rollup.sessions));
+            out.print(',').print(static_cast<unsigned long>(rollup.seconds));
+            out.print(',').print(rollup.heatWh, 1);
+            out.print(',').print(rollup.fanWh, 3);
+            out.print(',').print(rollup.peakTemperature, 1).print(']');
+        }
+        out.print(']');
+    }
+
+public:
+    BurnSessionTracker(SystemStatus& systemStatus, const Timekeeper& clock)
+        : status(systemStatus), timekeeper(clock) {}
+
+    void begin() {
+        lastTick = millis();
+#if FEATURE_HEAT_ENGINE
+        lastHeatEnergyKWh = status.totalHeatEnergy;
+#endif
+    }
+
+    // Call once per statistics period, after the energy meter has updated the fan power
+    void tick() {
+        unsigned long now = millis();
+        unsigned long elapsed = now - lastTick;
+        lastTick = now;
+        if (elapsed == 0) return;
+        float seconds = elapsed / 1000.0f;
+
+#if FEATURE_HEAT_ENGINE
+        float heatKWh = status.totalHeatEnergy - lastHeatEnergyKWh;
+        lastHeatEnergyKWh = status.totalHeatEnergy;
+        float heatWh = heatKWh > 0.0f ? heatKWh * 1000.0f : 0.0f;
+        float heatPower = status.currentHeatPower;
+#else
+        float heatWh = 0.0f;
+        float heatPower = 0.0f;
+#endif
+
+        // Without valid readings an open session only keeps accumulating energy
+        bool sensorValid = status.errorState != SystemStatus::ErrorState::SENSOR_ERROR;
+        float temperature = status.filteredTemperature;
+        float slope = status.temperatureSlope;
+
+        if (!active) {
+            if (!sensorValid || !isStart(temperature, slope)) return;
+            begin(now);
+        }
+
+        current.heatWh += heatWh;
+        current.fanWh += status.fanPower * seconds / 3600.0f;
+        current.peakPower = fmaxf(current.peakPower, heatPower);
+        if (sensorValid) {
+            current.peakTemperature = fmaxf(current.peakTemperature, temperature);
+            temperatureSum += temperature * seconds;
+            sampledSeconds += seconds;
+            checkEnd(temperature, slope, now);
+        }
+    }
+
+    bool isActive() const { return active; }
+    uint32_t getSessionCount() const { return sessionCount; }
+
+    void toJson(TextWriter& out) const {
+        unsigned long nowSeconds = millis() / 1000;
+        out.print("{\"active\":").print(active);
+        out.print(",\"cooling\":").print(active && cooling);
+        out.print(",\"current\":");
+        if (active) {
+            Session open = current;
+            open.duration = (millis() - startMs) / 1000;
+            open.meanTemperature = sampledSeconds > 0.0f ? temperatureSum / sampledSeconds : 0.0f;
+            appendSession(out, open, nowSeconds);
+        } else {
+            out.print("null");
+        }
+        out.print(",\"session_count\":").print(static_cast<unsigned long>(sessionCount));
+        out.print(",\"discarded\":").print(static_cast<unsigned long>(discardedCount));
+        out.print(",\"sessions\":[");
+        for (int i = 0; i < sessions.count; i++) {
+            if (i > 0) out.print(',');
+            appendSession(out, sessions.fromNewest(i), nowSeconds);
+        }
+        out.print("],");
+        appendRollups(out, "daily", days);
+        out.print(',');
+        appendRollups(out, "weekly", weeks);
+        out.print('}');
+    }
+};
+
+#endif // BURN_SESSIONS_H
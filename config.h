@@ -1,6 +1,35 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+// Feature selection. Each feature defaults to enabled; define it as 0 (e.g. with
+// -DFEATURE_WEB_UI=0 in the build flags) to drop its code and data from the build.
+// tools/feature_footprint.sh measures the flash and RAM cost of each one.
+#ifndef FEATURE_WEB_UI
+#define FEATURE_WEB_UI 1            // Dashboard served at /
+#endif
+#ifndef FEATURE_REST_API
+#define FEATURE_REST_API 1          // HTTP server and /api/v1 endpoints
+#endif
+#ifndef FEATURE_HEAT_ENGINE
+#define FEATURE_HEAT_ENGINE 1       // Recovered heat calculation
+#endif
+#ifndef FEATURE_STATISTICS
+#define FEATURE_STATISTICS 1        // Energy meter, operating and power statistics
+#endif
+#ifndef FEATURE_LOGGING
+#define FEATURE_LOGGING 1           // Serial debug output
+#endif
+#ifndef FEATURE_MQTT
+#define FEATURE_MQTT 1              // MQTT telemetry, commands and Home Assistant discovery
+#endif
+
+#if FEATURE_WEB_UI && !FEATURE_REST_API
+#error "FEATURE_WEB_UI needs FEATURE_REST_API"
+#endif
+
 namespace Config {
     // Temperature Configuration
     constexpr float TEMP_THRESHOLD = 25.0f;    // Start temperature in °C
@@ -10,6 +39,14 @@ namespace Config {
     // Check Configuration
     constexpr unsigned long CHECK_DURATION = 30000;  // Duration of activity check in ms
 
+    // Activity Schedule Configuration (learned fire start histogram)
+    namespace Activity {
+        constexpr unsigned long MIN_CHECK_INTERVAL = 1 * 60000UL;   // Check interval when a fire is likely
+        constexpr unsigned long MAX_CHECK_INTERVAL = 45 * 60000UL;  // Check interval when a fire is unlikely
+        constexpr uint8_t START_INCREMENT = 255;                    // Histogram weight added per fire start
+        constexpr uint16_t DECAY_NUMERATOR = 252;                   // Daily decay factor (252/256, ~44 day half-life)
+    }
+
     // Heat Configuration
     namespace Heat {
         // Fan specifications (Noctua NF-A12x25 PWM)
@@ -20,6 +57,7 @@ namespace Config {
         // Physical constants
         constexpr float AIR_SPECIFIC_HEAT = 1.005f;  // Specific heat capacity of air in kJ/(kg·K)
         constexpr float AIR_DENSITY = 1.204f;        // Air density at 20°C in kg/m³
+        constexpr float AMBIENT_PRESSURE = 101325.0f; // Air pressure in Pa, lower it at altitude (psychrometrics)
         
         // Calculation intervals
         constexpr unsigned long CALC_INTERVAL = 10000; // Heat calculation interval in ms
@@ -31,11 +69,53 @@ namespace Config {
         constexpr float MIN_TEMP_DIFF = 0.5f;        // Minimum temperature difference to consider
     }
     
+    // Energy Configuration
+    namespace Energy {
+        struct PowerPoint {
+            float speed;                             // Fan speed 0.0 - 1.0
+            float watts;                             // Electrical power in W
+        };
+        // Speed -> power curve, fitted as P = 0.18 W + 1.5 W * speed³ (NF-A12x25: 1.68 W peak)
+        constexpr PowerPoint POWER_CURVE[] = {
+            {0.0f, 0.18f}, {0.2f, 0.19f}, {0.4f, 0.28f}, {0.6f, 0.50f}, {0.8f, 0.95f}, {1.0f, 1.68f}
+        };
+    }
+
+    // Burn Session Configuration
+    namespace BurnSession {
+        constexpr float START_TEMP = TEMP_THRESHOLD;       // Temperature a fire must reach in °C
+        constexpr float START_SLOPE = 0.5f;                // Rise that marks a lit fire in °C/min
+        constexpr float HOT_MARGIN = 10.0f;                // Above START_TEMP + margin a session starts without a rise in °C
+        constexpr float END_TEMP = TEMP_THRESHOLD - HYSTERESIS; // Cooled down below this in °C
+        constexpr float END_SLOPE = 0.1f;                  // Rising slower than this counts as cooling in °C/min
+        constexpr unsigned long END_HOLD = 15 * 60000UL;   // Cooling time before a session ends in ms, restoking continues it
+        constexpr unsigned long MIN_DURATION = 10 * 60UL;  // Shorter sessions are dropped in s
+        constexpr int MAX_SESSIONS = 8;                    // Finished sessions kept
+        constexpr int DAYS = 14;                           // Daily rollups kept
+        constexpr int WEEKS = 8;                           // Weekly rollups kept
+    }
+    
     // WiFi Configuration
     constexpr const char* WIFI_SSID = "yourSSID";
     constexpr const char* WIFI_PASSWORD = "yourPassword";
-    constexpr int WIFI_CONNECT_TIMEOUT = 10000; // WiFi connection timeout in ms
-    constexpr int WIFI_RETRY_DELAY = 500;       // Delay between connection attempts in ms
+
+    // WiFi connection manager
+    namespace Wifi {
+        constexpr unsigned long CONNECT_TIMEOUT = 10000;   // Attempt without an IP address fails in ms
+        constexpr unsigned long CONNECT_POLL = 250;        // Link event check while connecting in ms
+        constexpr unsigned long BACKOFF_MIN = 2000;        // Wait after the first failed attempt in ms
+        constexpr unsigned long BACKOFF_MAX = 300000;      // Longest wait between attempts in ms
+        constexpr float JITTER = 0.3f;                     // Random part of each wait taken off
+        constexpr unsigned long RSSI_INTERVAL = 10000;     // RSSI sampling while connected in ms
+        constexpr float RSSI_SMOOTHING = 0.3f;             // Weight of a new RSSI sample
+    }
+    
+    // Time Configuration
+    namespace Time {
+        constexpr const char* TIMEZONE = "CET-1CEST,M3.5.0,M10.5.0/3"; // POSIX TZ rule (Central European Time)
+        constexpr const char* NTP_SERVER_PRIMARY = "pool.ntp.org";
+        constexpr const char* NTP_SERVER_SECONDARY = "time.google.com";
+    }
     
     // Pin Configuration
     namespace Pins {
@@ -51,37 +131,214 @@ namespace Config {
 
     // PWM Configuration
     namespace PWM {
+        // Bits of duty resolution a timer clock allows at a PWM frequency
+        constexpr int highestResolution(uint32_t clock, uint32_t frequency) {
+            int bits = 0;
+            while ((clock / frequency) >> (bits + 1)) bits++;
+            return bits;
+        }
+
         constexpr int FREQUENCY = 25000;         // PWM frequency in Hz
         constexpr int CHANNEL = 0;               // PWM channel (0-15)
-        constexpr int RESOLUTION = 8;            // Resolution in bits (8 = values 0-255)
-        constexpr int MIN_DUTY = 20;             // Minimum duty cycle
-        constexpr int MAX_DUTY = 255;            // Maximum duty cycle at 8 bit
+        constexpr uint32_t SOURCE_CLOCK = 80000000; // LEDC timer clock in Hz
+        constexpr int RESOLUTION = highestResolution(SOURCE_CLOCK, FREQUENCY); // 11 bit at 25 kHz
+        constexpr int MAX_DUTY = (1 << RESOLUTION) - 1;
+        constexpr int MIN_DUTY = (20 * MAX_DUTY + 127) / 255; // Minimum duty cycle (20 of 255)
+        constexpr bool DITHERING = true;         // Sigma-delta dithering between LEDC steps
+        constexpr int DITHER_BITS = 8;           // Fractional duty bits below one LEDC step
+        constexpr uint32_t DITHER_RATE = 1000;   // Dithering updates per second
     }
     
     // Sensor Configuration
     namespace Sensor {
         constexpr unsigned long UPDATE_INTERVAL = 2000; // Sensor update interval in ms
         constexpr unsigned long WARMUP_TIME = 100;      // Sensor warmup time in ms
+
+        // Adaptive sampling (sample_scheduler.h)
+        constexpr unsigned long MIN_INTERVAL = 4000;        // Fastest sampling in ms; shorter makes the slope noisier than the activity threshold
+        constexpr unsigned long MAX_INTERVAL = 10000;       // Slowest sampling of a flat signal in ms; longer detects fire starts later than fixed 10 s sampling
+        constexpr unsigned long ACTIVE_MAX_INTERVAL = 10000; // Slowest sampling while the fan runs in ms
+        constexpr float TARGET_STEP = 0.1f;                 // Temperature change between samples in °C
+        constexpr float RESIDUAL_LIMIT = 0.1f;              // Prediction miss that restarts fast sampling in °C
+        constexpr float INTERVAL_GROWTH = 1.5f;             // Largest interval increase per sample
+
+        // Filter pipeline
+        constexpr int MEDIAN_WINDOW = 5;                    // Samples in the despiking median window
+        constexpr int SLOPE_WINDOW = 6;                     // Samples in the least-squares slope window
+        constexpr float SMOOTHING_TIME_CONSTANT = 20.0f;    // Exponential smoother time constant in s
+        constexpr float MAX_SPIKE_DEVIATION = 5.0f;         // Maximum deviation from the median in °C
+        constexpr uint8_t MAX_SAME_VALUE_COUNT = 5;         // Identical readings before the sensor counts as stuck
+    }
+    
+    // Over-temperature safety monitor (independent task with its own sampling)
+    namespace Safety {
+        constexpr float TRIP_MARGIN = 10.0f;               // Full airflow from MAX_TEMP - margin in °C
+        constexpr float RELEASE_HYSTERESIS = 10.0f;        // Release below the trip temperature - hysteresis in °C
+        constexpr unsigned long RELEASE_HOLD = 60000;      // Time below the release temperature before release in ms
+        constexpr unsigned long SAMPLE_INTERVAL = 1000;    // Safety sampling period near the trip temperature in ms
+        constexpr unsigned long MAX_SAMPLE_INTERVAL = 30000; // Safety sampling period far below it in ms
+        constexpr float MAX_RISE_RATE = 2.0f;              // Fastest rise the longer periods allow for in K/s
+        constexpr unsigned long BUS_TIMEOUT = 100;         // Longest wait for the sensor bus in ms
+        constexpr unsigned long SENSOR_READ_TIME = 10;     // SHT4x high precision measurement in ms
+        constexpr unsigned long MAX_RESPONSE_TIME = SAMPLE_INTERVAL + BUS_TIMEOUT + SENSOR_READ_TIME; // Crossing to full airflow
+        constexpr unsigned long SENSOR_LOSS_TIMEOUT = 5000; // No valid sample while hot -> full airflow in ms
+        constexpr int TASK_PRIORITY = 5;                   // Above the loop task, below WiFi and lwIP
+        constexpr uint32_t TASK_STACK_SIZE = 3072;         // Bytes
     }
     
     // Tachometer Configuration
     namespace Tacho {
         constexpr unsigned long RPM_UPDATE_INTERVAL = 1000; // RPM calculation interval in ms
         constexpr int PULSES_PER_REVOLUTION = 2;           // Pulses per revolution
-        constexpr int MIN_RPM_THRESHOLD = 450;             // Minimum valid RPM
+        constexpr int MIN_RPM_THRESHOLD = 450;             // Minimum valid RPM until the fan is calibrated
         constexpr int MAX_NO_RPM_COUNT = 5;                // Max error count
     }
     
+    // Fan RPM Regulation (inner loop on tach feedback)
+    namespace Fan {
+        struct RpmPoint {
+            float duty;                              // PWM duty 0.0 - 1.0
+            float rpm;                               // Expected speed at this duty
+        };
+        // Duty -> RPM feed-forward table (NF-A12x25 PWM at 12 V, free air) until the fan is calibrated
+        constexpr RpmPoint RPM_CURVE[] = {
+            {0.08f, 450.0f}, {0.20f, 620.0f}, {0.40f, 980.0f}, {0.60f, 1330.0f}, {0.80f, 1670.0f}, {1.00f, 2000.0f}
+        };
+        constexpr float MAX_RPM = 2000.0f;                 // Speed at full airflow
+        constexpr float MIN_RPM = 600.0f;                  // Lowest regulated speed until calibrated, kept above the stall check
+        constexpr float MIN_DUTY_FRACTION = static_cast<float>(PWM::MIN_DUTY) / PWM::MAX_DUTY; // Lowest duty until calibrated
+        constexpr float KP = 0.0002f;                      // Duty per RPM of error
+        constexpr float KI = 0.0001f;                      // Duty per RPM of error and second
+        constexpr float MAX_CORRECTION = 0.3f;             // Limit of the integral duty correction
+        constexpr float ERROR_AVERAGE_ALPHA = 0.1f;        // Smoothing of the reported tracking error
+        constexpr unsigned long SPINUP_TIME = 3000;        // No integration after the fan starts in ms
+    }
+
+    // User fan curve for automatic mode (fan_curve.h)
+    namespace FanCurve {
+        struct CurvePoint {
+            float temperature;                             // °C
+            float speed;                                   // Fan speed 0.0 - 1.0
+            bool cubic;                                    // Segment to the next point: monotone cubic or linear
+        };
+        constexpr int MAX_POINTS = 16;                     // Breakpoints kept in NVS
+        // Default curve, close to the operating shape of the rule engine
+        constexpr CurvePoint DEFAULT_CURVE[] = {
+            {26.9f, 0.0f, false}, {27.0f, 0.3f, true}, {45.0f, 0.35f, true}, {62.5f, 0.48f, true},
+            {80.0f, 0.68f, true}, {100.0f, 1.0f, true}
+        };
+        constexpr float DEFAULT_HYSTERESIS = HYSTERESIS;   // Fall before the speed follows down in °C
+        constexpr float MAX_HYSTERESIS = 10.0f;            // °C
+    }
+
+    // Fan calibration sweep (fan_calibrator.h, fan_model.h)
+    namespace FanCalibration {
+        constexpr int MAX_POINTS = 12;                     // Duty -> RPM points kept in NVS
+        constexpr float SWEEP_STEP = 0.1f;                 // Duty step of the sweep from full duty down
+        constexpr float FINE_STEP = 0.01f;                 // Duty step of the stall and start searches
+        constexpr float STALL_RPM = 100.0f;                // Below this the fan counts as stopped
+        constexpr int SETTLE_SAMPLES = 6;                  // Tach readings in the settle window
+        constexpr float SETTLE_TOLERANCE = 0.01f;          // Drift between the window halves as a fraction of the speed
+        constexpr float SETTLE_MIN_RPM = 60000.0f / (Tacho::RPM_UPDATE_INTERVAL * Tacho::PULSES_PER_REVOLUTION) /
+                                         (SETTLE_SAMPLES / 2); // One tach pulse over half the window
+        constexpr int STOPPED_SAMPLES = 3;                 // Readings without pulses before the start search
+        constexpr unsigned long MIN_SETTLE_TIME = 3000;    // Shortest wait per step in ms
+        constexpr unsigned long SETTLE_TIMEOUT = 20000;    // Longest wait per step in ms
+        constexpr unsigned long START_WAIT = 5000;         // Time a start attempt gets before the duty is raised in ms
+        constexpr unsigned long MAX_DURATION = 600000;     // Whole sweep in ms
+        constexpr float MIN_RPM_STEP = 20.0f;              // Points closer than this in speed are merged
+        constexpr float STALL_MARGIN = 0.03f;              // Lowest regulated duty above the stall duty
+        constexpr float FAULT_RPM_FRACTION = 0.5f;         // Tach below this fraction of the table counts as blocked
+    }
+    
+    // Fan Health Configuration
+    namespace FanHealth {
+        constexpr int DUTY_BUCKETS = 10;                   // Duty range split into equal buckets
+        constexpr uint16_t BASELINE_SAMPLES = 120;         // Samples per bucket to learn the healthy baseline
+        constexpr uint16_t MIN_RECENT_SAMPLES = 30;        // Recent samples before a bucket is evaluated
+        constexpr float RECENT_ALPHA = 0.02f;              // EWMA weight of recent behaviour (~50 samples)
+        constexpr float TREND_ALPHA = 0.2f;                // Smoothing of the hourly shortfall rate
+        constexpr float MAINTENANCE_SHORTFALL = 0.15f;     // RPM shortfall fraction that needs maintenance
+        constexpr float VARIANCE_RATIO_LIMIT = 4.0f;       // Recent / baseline variance flagged as abnormal
+        constexpr float MIN_VARIANCE = 100.0f;             // Variance floor in RPM² (tach quantization)
+        constexpr unsigned long SETTLE_TIME = 5000;        // Time after a duty change before sampling in ms
+        constexpr float DUTY_CHANGE_TOLERANCE = 0.01f;     // Duty change that restarts settling
+    }
+    
     // Webserver Configuration
     namespace WebServer {
         constexpr int PORT = 80;                           // HTTP port
         constexpr unsigned long UPDATE_INTERVAL = 2000;    // Client update interval in ms
+        constexpr int MAX_CONNECTIONS = 4;                 // Concurrent client connections
+        constexpr size_t RX_BUFFER_SIZE = 1024;            // Per-connection request buffer in bytes
+        constexpr size_t TX_BUFFER_SIZE = 4096;            // Per-connection response buffer in bytes
+        constexpr size_t ARENA_SIZE = 3072;                // Scratch memory for building one response in bytes
+        constexpr unsigned long REQUEST_TIMEOUT = 5000;    // Time allowed to receive or send a request in ms
+        constexpr unsigned long KEEP_ALIVE_TIMEOUT = 15000; // Idle keep-alive connection timeout in ms
+        constexpr int MAX_KEEP_ALIVE_REQUESTS = 100;       // Requests per connection before it is closed
+        constexpr unsigned long MIN_EVICT_IDLE = 1000;     // Keep-alive idle time before a new client may take the slot in ms
+        constexpr unsigned long MAX_LONG_POLL_WAIT = 30000; // Longest wait of a deferred request in ms
+        constexpr unsigned long LONG_POLL_CHECK_INTERVAL = 250; // Change check while requests wait in ms
+    }
+    
+    // MQTT Configuration
+    namespace Mqtt {
+        constexpr const char* BROKER_HOST = "";            // Broker IP address or hostname, empty disables MQTT
+        constexpr uint16_t BROKER_PORT = 1883;
+        constexpr const char* USERNAME = "";               // Empty for anonymous access
+        constexpr const char* PASSWORD = "";
+        constexpr const char* BASE_TOPIC = "heatfan";      // Topics are <base>/<device id>/...
+        constexpr const char* DISCOVERY_PREFIX = "homeassistant";
+        constexpr uint16_t KEEP_ALIVE = 60;                // Keep-alive interval in s
+        constexpr unsigned long CONNECT_TIMEOUT = 5000;    // Time allowed for TCP connect and CONNACK in ms
+        constexpr unsigned long MIN_RETRY_DELAY = 1000;    // First reconnect delay in ms, doubled per failure
+        constexpr unsigned long MAX_RETRY_DELAY = 60000;   // Longest reconnect delay in ms
+        constexpr size_t TX_BUFFER_SIZE = 1536;            // Outgoing packet queue in bytes
+        constexpr size_t RX_BUFFER_SIZE = 256;             // Largest incoming packet in bytes
+        constexpr unsigned long STATE_REFRESH_INTERVAL = 300000; // State published at least this often in ms
+
+        // Change needed before a value is published again
+        constexpr float TEMPERATURE_DEADBAND = 0.2f;       // °C
+        constexpr float HUMIDITY_DEADBAND = 1.0f;          // %
+        constexpr float RPM_DEADBAND = 50.0f;              // RPM
+        constexpr float SPEED_DEADBAND = 0.02f;            // Fan speed fraction
+        constexpr float HEAT_POWER_DEADBAND = 10.0f;       // W
+        constexpr float HEAT_ENERGY_DEADBAND = 0.01f;      // kWh
+    }
+    
+    // Power Management Configuration
+    namespace Power {
+        constexpr int MAX_CPU_FREQ_MHZ = 160;              // CPU frequency while busy
+        constexpr int MIN_CPU_FREQ_MHZ = 40;               // CPU frequency while idle
+        constexpr unsigned long MAX_SLEEP_TIME = 60000;    // Longest single sleep between events in ms
+        // Estimated supply current per state (ESP32-C6, WiFi associated)
+        constexpr float CURRENT_ACTIVE_MA = 45.0f;
+        constexpr float CURRENT_IDLE_MA = 25.0f;
+        constexpr float CURRENT_LIGHT_SLEEP_MA = 2.5f;      // Average including DTIM beacon wakeups
     }
     
     // System Configuration
     namespace System {
         constexpr int SERIAL_BAUD = 115200;               // Baud rate for serial communication
-        constexpr int WATCHDOG_DELAY = 10;                // Delay for ESP32 watchdog in ms
+    }
+
+    // Watchdog Configuration
+    namespace Watchdog {
+        constexpr uint32_t TIMEOUT = 10000;                // Task watchdog timeout for the main loop in ms
+        constexpr unsigned long MAX_WAIT = 4000;           // Longest idle wait, keeps the watchdog fed in ms
+        // Longest silence of each subsystem heartbeat before the system restarts in ms
+        constexpr unsigned long SENSOR_TIMEOUT = 60000;    // Sensor sampling on schedule
+        constexpr unsigned long CONTROL_TIMEOUT = 15000;   // RPM regulation step
+        constexpr unsigned long TACH_TIMEOUT = 15000;      // RPM measurement
+        constexpr unsigned long NETWORK_TIMEOUT = 15000;   // HTTP and MQTT servicing
+    }
+
+    // Event Journal Configuration
+    namespace EventLog {
+        constexpr int CAPACITY = 64;                       // Events kept in RAM, a power of two
+        constexpr bool FLASH_MIRROR = true;                // Copy the journal to NVS
+        constexpr unsigned long PERSIST_INTERVAL = 60000;  // Shortest time between flash copies in ms
+        constexpr int MAX_PER_RESPONSE = 32;               // Events per /api/v1/events/log response
     }
 }
 
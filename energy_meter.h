@@ -0,0 +1,247 @@
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "logging.h"
+#include "system_status.h"
+#include "timekeeper.h"
+#include "burn_sessions.h"
+#include "arena.h"
+
+// Fan electrical power from a calibrated speed -> power table (linear interpolation
+// between points; the table follows the roughly cubic fan law plus the idle draw).
+class FanPowerModel {
+public:
+    static float powerAt(float speed) {
+        const auto& curve = Config::Energy::POWER_CURVE;
+        constexpr int points = sizeof(Config::Energy::POWER_CURVE) / sizeof(Config::Energy::POWER_CURVE[0]);
+
+        speed = constrain(speed, 0.0f, 1.0f);
+        for (int i = 1; i < points; i++) {
+            if (speed <= curve[i].speed) {
+                float span = curve[i].speed - curve[i - 1].speed;
+                float t = span > 0.0f ? (speed - curve[i - 1].speed) / span : 0.0f;
+                return curve[i - 1].watts + t * (curve[i].watts - curve[i - 1].watts);
+            }
+        }
+        return curve[points - 1].watts;
+    }
+};
+
+// Integrates fan energy on real elapsed time, once per tick, and keeps fixed-size
+// buckets for the last 24 hours, the last 7 days and the current/last burn (a burn being
+// a session of the BurnSessionTracker, so activity checks in sleep mode do not count).
+// Hour and day buckets follow the local wall clock once it is known, since boot before.
+// Heat recovered per bucket is taken from the heat calculation so a coefficient of
+// performance (heat recovered / fan energy) can be reported.
+class EnergyMeter {
+public:
+    struct Bucket {
+        float fanEnergyWh = 0.0f;
+        float heatEnergyWh = 0.0f;
+        uint32_t fanSeconds = 0;
+
+        float cop() const {
+            return fanEnergyWh > 0.0f ? heatEnergyWh / fanEnergyWh : 0.0f;
+        }
+
+        void add(float fanWh, float heatWh, float seconds, bool fanOn) {
+            fanEnergyWh += fanWh;
+            heatEnergyWh += heatWh;
+            if (fanOn) fanSeconds += static_cast<uint32_t>(seconds + 0.5f);
+        }
+    };
+
+private:
+    static constexpr int HOURS = 24;
+    static constexpr int DAYS = 7;
+    static constexpr unsigned long HOUR_MS = 3600000UL;
+    static constexpr unsigned long DAY_MS = 24UL * HOUR_MS;
+
+    SystemStatus& status;
+    const BurnSessionTracker& sessions;
+    const Timekeeper& timekeeper;
+
+    unsigned long lastTick = 0;
+    unsigned long operatingMs = 0;          // Sub-second remainders of the operating counters
+    unsigned long fanOperatingMs = 0;
+    float lastHeatEnergyKWh = 0.0f;
+
+    Bucket hours[HOURS];
+    Bucket days[DAYS];
+    int hourIndex = 0;
+    int dayIndex = 0;
+    unsigned long hourElapsed = 0;          // Since the last advance
+    unsigned long dayElapsed = 0;
+    bool clockAligned = false;
+    int lastHour = 0;                       // Wall clock of the newest buckets
+    int lastYearDay = 0;
+
+    Bucket currentBurn;
+    Bucket lastBurn;
+    unsigned long burnStart = 0;
+    bool burnActive = false;
+    uint32_t burnSessionCount = 0;          // Sessions of the tracker when the burn began
+
+    Bucket total;
+
+    static void advance(Bucket* ring, int size, int& index, int steps) {
+        for (int i = 0; i < min(steps, size); i++) {
+            index = (index + 1) % size;
+            ring[index] = Bucket();
+        }
+    }
+
+    // Wall clock steps are capped by the elapsed time, so a clock set backwards or a DST change
+    // cannot clear buckets that are still current
+    void advanceBuckets(unsigned long elapsed) {
+        hourElapsed += elapsed;
+        dayElapsed += elapsed;
+
+        if (!timekeeper.isSynced()) {
+            while (hourElapsed >= HOUR_MS) {
+                hourElapsed -= HOUR_MS;
+                advance(hours, HOURS, hourIndex, 1);
+            }
+            while (dayElapsed >= DAY_MS) {
+                dayElapsed -= DAY_MS;
+                advance(days, DAYS, dayIndex, 1);
+            }
+            return;
+        }
+
+        // The newest buckets become the current hour and day when the clock first appears
+        if (!clockAligned) {
+            clockAligned = true;
+            lastHour = timekeeper.hour();
+            lastYearDay = timekeeper.yearDay();
+            hourElapsed = 0;
+            dayElapsed = 0;
+            LOG_PRINTLN("DEBUG: Energy buckets follow the wall clock");
+            return;
+        }
+
+        if (timekeeper.hour() != lastHour) {
+            int steps = min((timekeeper.hour() - lastHour + 24) % 24, static_cast<int>(hourElapsed / HOUR_MS) + 1);
+            advance(hours, HOURS, hourIndex, steps);
+            lastHour = timekeeper.hour();
+            hourElapsed = 0;
+        }
+        if (timekeeper.yearDay() != lastYearDay) {
+            int steps = min((timekeeper.yearDay() - lastYearDay + 366) % 366, static_cast<int>(dayElapsed / DAY_MS) + 1);
+            advance(days, DAYS, dayIndex, max(steps, 1));
+            lastYearDay = timekeeper.yearDay();
+            dayElapsed = 0;
+        }
+    }
+
+    // Follows the burn sessions; a session the tracker drops as too short is not kept either
+    void updateBurn(unsigned long now) {
+        bool active = sessions.isActive();
+        if (active && !burnActive) {
+            burnActive = true;
+            burnStart = now;
+            burnSessionCount = sessions.getSessionCount();
+            currentBurn = Bucket();
+        } else if (!active && burnActive) {
+            burnActive = false;
+            if (sessions.getSessionCount() == burnSessionCount) return;
+            lastBurn = currentBurn;
+            LOG_PRINT("DEBUG: Burn finished, COP ");
+            LOG_PRINTLN(lastBurn.cop());
+        }
+    }
+
+    static void appendBucket(TextWriter& out, const char* name, const Bucket& bucket) {
+        out.print('"').print(name).print("\":{\"fan_wh\":").print(bucket.fanEnergyWh, 3);
+        out.print(",\"heat_wh\":").print(bucket.heatEnergyWh, 1);
+        out.print(",\"fan_seconds\":").print(bucket.fanSeconds);
+        out.print(",\"cop\":").print(bucket.cop(), 1).print('}');
+    }
+
+    static void appendRing(TextWriter& out, const char* name, const Bucket* ring, int size, int newest) {
+        out.print('"').print(name).print("\":[");
+        for (int i = 0; i < size; i++) {
+            const Bucket& bucket = ring[(newest - i + size) % size];
+            if (i > 0) out.print(',');
+            out.print('[').print(bucket.fanEnergyWh, 3).print(',').print(bucket.heatEnergyWh, 1).print(']');
+        }
+        out.print(']');
+    }
+
+public:
+    EnergyMeter(SystemStatus& systemStatus, const BurnSessionTracker& burnSessions, const Timekeeper& clock)
+        : status(systemStatus), sessions(burnSessions), timekeeper(clock) {}
+
+    void begin() {
+        lastTick = millis();
+#if FEATURE_HEAT_ENGINE
+        lastHeatEnergyKWh = status.totalHeatEnergy;
+#endif
+    }
+
+    // Integrates power over the time since the previous tick; call exactly once per period
+    void tick() {
+        unsigned long now = millis();
+        unsigned long elapsed = now - lastTick;
+        lastTick = now;
+        if (elapsed == 0) return;
+
+        float seconds = elapsed / 1000.0f;
+        bool fanOn = status.fanOn;
+        float power = fanOn ? FanPowerModel::powerAt(status.currentFanSpeed) : 0.0f;
+        float fanWh = power * seconds / 3600.0f;
+
+#if FEATURE_HEAT_ENGINE
+        float heatKWh = status.totalHeatEnergy - lastHeatEnergyKWh;
+        lastHeatEnergyKWh = status.totalHeatEnergy;
+        float heatWh = heatKWh > 0.0f ? heatKWh * 1000.0f : 0.0f;
+#else
+        float heatWh = 0.0f;
+#endif
+
+        // Operating time counters in whole seconds, remainders carried over
+        operatingMs += elapsed;
+        status.totalOperatingTime += operatingMs / 1000;
+        operatingMs %= 1000;
+        if (fanOn) {
+            fanOperatingMs += elapsed;
+            status.fanOperatingTime += fanOperatingMs / 1000;
+            fanOperatingMs %= 1000;
+        }
+
+        status.fanPower = power;
+        status.energyUsage += fanWh;
+
+        advanceBuckets(elapsed);
+        updateBurn(now);
+        hours[hourIndex].add(fanWh, heatWh, seconds, fanOn);
+        days[dayIndex].add(fanWh, heatWh, seconds, fanOn);
+        total.add(fanWh, heatWh, seconds, fanOn);
+        if (burnActive) currentBurn.add(fanWh, heatWh, seconds, fanOn);
+
+        status.coefficientOfPerformance = total.cop();
+    }
+
+    const Bucket& getTotal() const { return total; }
+    const Bucket& getLastBurn() const { return lastBurn; }
+
+    void toJson(TextWriter& out) const {
+        out.print("{\"fan_power\":").print(status.fanPower, 3).print(',');
+        appendBucket(out, "total", total);
+        out.print(',');
+        appendBucket(out, "current_burn", burnActive ? currentBurn : Bucket());
+        out.print(",\"burn_active\":").print(burnActive);
+        out.print(",\"burn_duration\":").print(burnActive ? (millis() - burnStart) / 1000 : 0UL);
+        out.print(',');
+        appendBucket(out, "last_burn", lastBurn);
+        out.print(",\"clock_aligned\":").print(clockAligned).print(',');
+        appendRing(out, "hourly", hours, HOURS, hourIndex);
+        out.print(',');
+        appendRing(out, "daily", days, DAYS, dayIndex);
+        out.print('}');
+    }
+};
+
+#endif // ENERGY_METER_H
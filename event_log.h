@@ -0,0 +1,263 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <Preferences.h>
+#include "config.h"
+#include "logging.h"
+#include "arena.h"
+
+// Journal of typed events (mode changes, fan and sensor faults and their recoveries, safety
+// trips, restarts) with a sequence number, boot number, milliseconds since boot and a small
+// payload. Like the LOG_ macros it is reachable from everywhere, so the state is static.
+// record() is lock-free and safe from any task or ISR: a writer reserves a sequence number
+// with one atomic increment, marks its slot busy, fills it and publishes the sequence number
+// last; a reader takes a slot only if its sequence number matches before and after the copy.
+// The RAM ring holds the last CAPACITY events. With FLASH_MIRROR it is copied to NVS from the
+// loop when events were added (at most every PERSIST_INTERVAL) and before a restart, and
+// restored at boot, so sequence numbers keep counting across reboots.
+class EventLog {
+public:
+    enum class Code : uint8_t {
+        BOOT,                   // detail: esp_reset_reason_t
+        RESTART,                // detail: RestartCause, value: subsystem for a heartbeat timeout
+        MODE_CHANGE,            // detail: 1 automatic, 0 manual
+        FAN_SWITCH,             // detail: 1 on, 0 off
+        FAN_ERROR,              // value: RPM
+        FAN_RECOVERED,          // value: RPM
+        SENSOR_IMPLAUSIBLE,     // value: rejected temperature in 0.01 °C
+        SENSOR_ERROR,
+        SENSOR_RECOVERED,
+        SAFETY_TRIP,            // detail: SafetyTrip::Reason, value: temperature in 0.01 °C
+        SAFETY_RELEASE,         // value: temperature in 0.01 °C
+        CALIBRATION_DONE,       // value: highest RPM
+        CALIBRATION_FAILED,     // detail: 1 aborted, 0 failed
+        WIFI_ERROR,             // detail: disconnect reason; first failed attempt of an outage
+        WIFI_CONNECTED,         // detail: failed attempts before, value: RSSI in dBm
+        WIFI_DISCONNECTED,      // detail: disconnect reason, value: last RSSI in dBm
+        COUNT
+    };
+
+    enum class RestartCause : uint8_t {
+        FAN_ERRORS,
+        HEARTBEAT_TIMEOUT
+    };
+
+    struct Entry {
+        uint32_t seq;           // From 1, increases across reboots
+        uint32_t time;          // ms since boot
+        uint16_t boot;
+        uint8_t code;
+        uint8_t detail;
+        int32_t value;
+    };
+
+private:
+    static constexpr int CAPACITY = Config::EventLog::CAPACITY;
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Capacity must be a power of two");
+    static constexpr uint16_t STORE_VERSION = 1;
+    static constexpr const char* NVS_NAMESPACE = "events";
+    static constexpr const char* NVS_KEY = "ring";
+
+    // Payload words are atomics too, so a reader racing a writer is defined behaviour.
+    // Only used in static storage, which starts zeroed.
+    struct Slot {
+        std::atomic<uint32_t> seq;                  // 0 while being written
+        std::atomic<uint32_t> time;
+        std::atomic<uint32_t> meta;                 // boot | code << 16 | detail << 24
+        std::atomic<int32_t> value;
+    };
+
+    struct Stored {
+        uint16_t version;
+        uint16_t boot;
+        uint32_t nextSeq;
+        Entry entries[CAPACITY];
+    };
+
+    static inline Slot slots[CAPACITY];
+    static inline std::atomic<uint32_t> nextSeq{1};
+    static inline uint16_t boot = 0;
+    static inline uint32_t bootFirstSeq = 1;        // Older sequence numbers come from flash
+    static inline uint32_t persistedSeq = 1;        // nextSeq at the last flash copy
+    static inline unsigned long lastPersist = 0;
+
+    // Copy of one slot if it still holds seq; false while it is written or after it was overwritten
+    static bool load(uint32_t seq, Entry& entry) {
+        const Slot& slot = slots[seq & (CAPACITY - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != seq) return false;
+        entry.seq = seq;
+        entry.time = slot.time.load(std::memory_order_relaxed);
+        uint32_t meta = slot.meta.load(std::memory_order_relaxed);
+        entry.value = slot.value.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) return false;
+        entry.boot = static_cast<uint16_t>(meta);
+        entry.code = static_cast<uint8_t>(meta >> 16);
+        entry.detail = static_cast<uint8_t>(meta >> 24);
+        return true;
+    }
+
+    static void store(const Entry& entry) {
+        Slot& slot = slots[entry.seq & (CAPACITY - 1)];
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.time.store(entry.time, std::memory_order_relaxed);
+        slot.meta.store(entry.boot | static_cast<uint32_t>(entry.code) << 16 | static_cast<uint32_t>(entry.detail) << 24,
+                        std::memory_order_relaxed);
+        slot.value.store(entry.value, std::memory_order_relaxed);
+        slot.seq.store(entry.seq, std::memory_order_release);
+    }
+
+public:
+    // Restores the flash copy and records the boot; call first in setup()
+    static void begin(uint8_t resetReason) {
+        if (Config::EventLog::FLASH_MIRROR) {
+            Preferences prefs;
+            if (prefs.begin(NVS_NAMESPACE, true)) {
+                Stored* stored = new Stored;
+                if (prefs.getBytesLength(NVS_KEY) == sizeof(Stored) &&
+                    prefs.getBytes(NVS_KEY, stored, sizeof(Stored)) == sizeof(Stored) &&
+                    stored->version == STORE_VERSION) {
+                    for (const Entry& entry : stored->entries) {
+                        if (entry.seq != 0 && entry.seq < stored->nextSeq) store(entry);
+                    }
+                    nextSeq.store(stored->nextSeq);
+                    persistedSeq = stored->nextSeq;
+                    boot = stored->boot + 1;
+                }
+                delete stored;
+                prefs.end();
+            }
+        }
+        bootFirstSeq = nextSeq.load();
+        record(Code::BOOT, resetReason);
+        LOG_PRINT("DEBUG: Event log started, boot ");
+        LOG_PRINTLN(boot);
+    }
+
+    // Lock-free, callable from any task or ISR
+    static void record(Code code, uint8_t detail = 0, int32_t value = 0) {
+        Entry entry;
+        entry.seq = nextSeq.fetch_add(1, std::memory_order_relaxed);
+        entry.time = millis();
+        entry.boot = boot;
+        entry.code = static_cast<uint8_t>(code);
+        entry.detail = detail;
+        entry.value = value;
+        store(entry);
+    }
+
+    // Temperatures and similar payloads in hundredths
+    static int32_t centi(float value) {
+        return isnan(value) ? INT32_MIN : static_cast<int32_t>(lroundf(value * 100.0f));
+    }
+
+    // Sequence number of the newest event, 0 if none
+    static uint32_t lastSeq() {
+        return nextSeq.load(std::memory_order_acquire) - 1;
+    }
+
+    // Up to max events with seq > after, in order. Stops before an event still being written,
+    // so a cursor never skips one. cursor is the last sequence number consumed, lost counts the
+    // events after the old cursor that were overwritten. A cursor ahead of the journal (flash
+    // lost) starts over from the oldest event.
+    static int read(uint32_t after, Entry* out, int max, uint32_t& cursor, uint32_t& lost) {
+        uint32_t last = lastSeq();
+        if (after > last) after = 0;
+        uint32_t oldest = last >= static_cast<uint32_t>(CAPACITY) ? last - CAPACITY + 1 : 1;
+        lost = after + 1 < oldest ? oldest - (after + 1) : 0;
+        cursor = after + lost;
+        int count = 0;
+        for (uint32_t seq = cursor + 1; seq <= last && count < max; seq++) {
+            if (load(seq, out[count])) {
+                count++;
+            } else if (seq >= bootFirstSeq && slots[seq & (CAPACITY - 1)].seq.load(std::memory_order_acquire) == 0) {
+                break;
+            } else {
+                lost++;
+            }
+            cursor = seq;
+        }
+        return count;
+    }
+
+    // Copies the ring to flash if events were added; from the loop, or forced before a restart
+    static void persist(bool force = false) {
+        if (!Config::EventLog::FLASH_MIRROR) return;
+        uint32_t next = nextSeq.load(std::memory_order_acquire);
+        if (next == persistedSeq) return;
+        if (!force && millis() - lastPersist < Config::EventLog::PERSIST_INTERVAL) return;
+        lastPersist = millis();
+
+        Stored* stored = new Stored;
+        memset(stored, 0, sizeof(Stored));
+        stored->version = STORE_VERSION;
+        stored->boot = boot;
+        stored->nextSeq = next;
+        for (uint32_t seq = next > CAPACITY ? next - CAPACITY : 1; seq < next; seq++) {
+            Entry entry;
+            if (load(seq, entry)) stored->entries[seq & (CAPACITY - 1)] = entry;
+        }
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, false)) {
+            if (prefs.putBytes(NVS_KEY, stored, sizeof(Stored)) == sizeof(Stored)) {
+                persistedSeq = next;
+            }
+            prefs.end();
+        }
+        delete stored;
+    }
+
+    static const char* codeName(uint8_t code) {
+        switch (static_cast<Code>(code)) {
+            case Code::BOOT:               return "boot";
+            case Code::RESTART:            return "restart";
+            case Code::MODE_CHANGE:        return "mode_change";
+            case Code::FAN_SWITCH:         return "fan_switch";
+            case Code::FAN_ERROR:          return "fan_error";
+            case Code::FAN_RECOVERED:      return "fan_recovered";
+            case Code::SENSOR_IMPLAUSIBLE: return "sensor_implausible";
+            case Code::SENSOR_ERROR:       return "sensor_error";
+            case Code::SENSOR_RECOVERED:   return "sensor_recovered";
+            case Code::SAFETY_TRIP:        return "safety_trip";
+            case Code::SAFETY_RELEASE:     return "safety_release";
+            case Code::CALIBRATION_DONE:   return "calibration_done";
+            case Code::CALIBRATION_FAILED: return "calibration_failed";
+            case Code::WIFI_ERROR:         return "wifi_error";
+            case Code::WIFI_CONNECTED:     return "wifi_connected";
+            case Code::WIFI_DISCONNECTED:  return "wifi_disconnected";
+            default:                       return "unknown";
+        }
+    }
+
+    // Events after the cursor as rows [seq, boot, time_ms, code, detail, value]; next is the
+    // cursor for the following request, more is set when the limit cut the answer short
+    static void toJson(TextWriter& out, uint32_t after, int limit) {
+        Entry entries[Config::EventLog::MAX_PER_RESPONSE];
+        uint32_t cursor = 0;
+        uint32_t lost = 0;
+        int count = read(after, entries, constrain(limit, 1, Config::EventLog::MAX_PER_RESPONSE), cursor, lost);
+
+        out.print("{\"boot\":").print(static_cast<unsigned int>(boot));
+        out.print(",\"last\":").print(static_cast<unsigned long>(lastSeq()));
+        out.print(",\"next\":").print(static_cast<unsigned long>(cursor));
+        out.print(",\"lost\":").print(static_cast<unsigned long>(lost));
+        out.print(",\"more\":").print(cursor < lastSeq());
+        out.print(",\"events\":[");
+        for (int i = 0; i < count; i++) {
+            const Entry& entry = entries[i];
+            if (i > 0) out.print(',');
+            out.print('[').print(static_cast<unsigned long>(entry.seq));
+            out.print(',').print(static_cast<unsigned int>(entry.boot));
+            out.print(',').print(static_cast<unsigned long>(entry.time));
+            out.print(",\"").print(codeName(entry.code)).print('"');
+            out.print(',').print(static_cast<unsigned int>(entry.detail));
+            out.print(',').print(static_cast<long>(entry.value)).print(']');
+        }
+        out.print("]}");
+    }
+};
+
+#endif // EVENT_LOG_H
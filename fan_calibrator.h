@@ -0,0 +1,325 @@
+#ifndef FAN_CALIBRATOR_H
+#define FAN_CALIBRATOR_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+#include "fan_model.h"
+
+// Calibration sweep that measures the installed fan instead of trusting the datasheet.
+// Non-blocking: step() is called with every tach measurement and returns the MOSFET state
+// and duty to apply until the next one, so the loop and the web server keep running.
+//   SPIN_UP       full duty until the speed settles (fails if the fan does not turn)
+//   SWEEP         duty down in SWEEP_STEP steps, one settled point per step
+//   STALL_SEARCH  duty down in FINE_STEP steps until the fan stops; a stall already in the
+//                 sweep restarts the fan at full duty and searches below the last running step
+//   STOPPING      power off until the fan stands still
+//   START_SEARCH  power on, duty up in FINE_STEP steps from the stall duty until it turns
+// The result is a FanModel::Table with the settled points, merged where the speed no
+// longer changes, and the stall and start duties.
+// Free of hardware access so tools/fan_calibration_sim.cpp runs it against a simulated fan.
+class FanCalibrator {
+public:
+    enum class State : uint8_t {
+        IDLE,
+        SPIN_UP,
+        SWEEP,
+        STALL_SEARCH,
+        STOPPING,
+        START_SEARCH,
+        DONE,
+        ABORTED,
+        FAILED
+    };
+
+    struct Output {
+        bool power;         // MOSFET on
+        float duty;         // PWM duty 0.0 - 1.0
+    };
+
+private:
+    static constexpr int SWEEP_POINTS = static_cast<int>(1.0f / Config::FanCalibration::SWEEP_STEP + 0.5f);
+    static_assert(SWEEP_POINTS + 1 <= FanModel::MAX_POINTS, "Sweep exceeds the table");
+
+    State state = State::IDLE;
+    const char* failure = "";
+    unsigned long startTime = 0;
+    unsigned long stepStart = 0;
+    bool power = false;
+    float duty = 0.0f;
+
+    // Settle detection over the last readings of the current step
+    float window[Config::FanCalibration::SETTLE_SAMPLES];
+    int windowCount = 0;
+    float settledRpm = 0.0f;
+
+    int sweepIndex = 0;                 // Current sweep step, duty = 1 - index * SWEEP_STEP
+    float lastRunningDuty = 1.0f;       // Lowest duty the fan was seen turning at
+    float lastRunningRpm = 0.0f;
+    float fineStart = 0.0f;             // Duty the stall search started below
+    bool kicking = false;               // Restarting the fan at full duty before the stall search
+    float stallDuty = 0.0f;
+    float startDuty = 0.0f;
+
+    // Settled points in descending duty
+    FanModel::Point measured[FanModel::MAX_POINTS];
+    int measuredCount = 0;
+    FanModel::Table result;
+
+    static uint16_t scaled(float fraction) {
+        return static_cast<uint16_t>(lroundf(fminf(fmaxf(fraction, 0.0f), 1.0f) * FanModel::DUTY_SCALE));
+    }
+
+    void beginStep(bool on, float newDuty, unsigned long now) {
+        power = on;
+        duty = fminf(fmaxf(newDuty, 0.0f), 1.0f);
+        stepStart = now;
+        windowCount = 0;
+    }
+
+    // True once the newer half of the window no longer drifts from the older half, or the step
+    // timed out; settledRpm is the mean of the newer half. Comparing half-window means averages
+    // out the tach quantization, which a spread check over single readings cannot.
+    bool settled(float rpm, unsigned long now) {
+        constexpr int samples = Config::FanCalibration::SETTLE_SAMPLES;
+        constexpr int half = samples / 2;
+        window[windowCount % samples] = rpm;
+        windowCount++;
+        if (windowCount < samples || now - stepStart < Config::FanCalibration::MIN_SETTLE_TIME) return false;
+
+        float older = 0.0f;
+        float newer = 0.0f;
+        for (int i = 0; i < samples; i++) {
+            float value = window[(windowCount + i) % samples];   // Oldest first
+            if (i < samples - half) older += value;
+            else newer += value;
+        }
+        older /= samples - half;
+        newer /= half;
+        settledRpm = newer;
+        float tolerance = fmaxf(newer * Config::FanCalibration::SETTLE_TOLERANCE, Config::FanCalibration::SETTLE_MIN_RPM);
+        return fabsf(newer - older) <= tolerance || now - stepStart >= Config::FanCalibration::SETTLE_TIMEOUT;
+    }
+
+    void record(float pointDuty, float rpm) {
+        uint16_t d = scaled(pointDuty);
+        if (measuredCount > 0 && measured[measuredCount - 1].duty == d) return;
+        if (measuredCount < FanModel::MAX_POINTS) {
+            measured[measuredCount++] = {d, static_cast<uint16_t>(lroundf(rpm))};
+        }
+    }
+
+    void fail(const char* reason) {
+        state = State::FAILED;
+        failure = reason;
+        power = false;
+        duty = 0.0f;
+    }
+
+    float sweepDuty(int index) const {
+        return 1.0f - index * Config::FanCalibration::SWEEP_STEP;
+    }
+
+    void beginStallSearch(unsigned long now) {
+        state = State::STALL_SEARCH;
+        fineStart = lastRunningDuty;
+        if (kicking) {
+            beginStep(true, 1.0f, now);
+        } else {
+            beginStep(true, fineStart - Config::FanCalibration::FINE_STEP, now);
+        }
+    }
+
+    // Lowest running point found: stop the fan for the start search
+    void endStallSearch(float stall, unsigned long now) {
+        stallDuty = stall;
+        record(lastRunningDuty, lastRunningRpm);
+        state = State::STOPPING;
+        beginStep(false, 0.0f, now);
+    }
+
+    // Keeps the highest duty of a flat stretch: below it the duty no longer slows the fan
+    bool buildTable() {
+        FanModel::Point descending[FanModel::MAX_POINTS];
+        int count = 0;
+        for (int i = 0; i < measuredCount; i++) {
+            if (count == 0 || measured[i].rpm + Config::FanCalibration::MIN_RPM_STEP < descending[count - 1].rpm) {
+                descending[count++] = measured[i];
+            }
+        }
+
+        memset(&result, 0, sizeof(result));
+        result.version = FanModel::TABLE_VERSION;
+        result.count = static_cast<uint8_t>(count);
+        result.stallDuty = scaled(stallDuty);
+        result.startDuty = scaled(startDuty);
+        for (int i = 0; i < count; i++) {
+            result.points[i] = descending[count - 1 - i];
+        }
+        return FanModel::isValid(result);
+    }
+
+public:
+    // Begins a sweep, a running sweep starts over; returns the first outputs
+    Output start(unsigned long now) {
+        state = State::SPIN_UP;
+        failure = "";
+        startTime = now;
+        measuredCount = 0;
+        sweepIndex = 0;
+        kicking = false;
+        lastRunningDuty = 1.0f;
+        lastRunningRpm = 0.0f;
+        stallDuty = 0.0f;
+        startDuty = 0.0f;
+        beginStep(true, 1.0f, now);
+        return {power, duty};
+    }
+
+    void abort() {
+        if (!isRunning()) return;
+        state = State::ABORTED;
+        power = false;
+        duty = 0.0f;
+    }
+
+    // One tach measurement; returns the outputs to hold until the next one
+    Output step(float rpm, unsigned long now) {
+        if (!isRunning()) return {false, 0.0f};
+        if (now - startTime >= Config::FanCalibration::MAX_DURATION) {
+            fail("timeout");
+            return {power, duty};
+        }
+
+        constexpr float stallRpm = Config::FanCalibration::STALL_RPM;
+        constexpr float fineStep = Config::FanCalibration::FINE_STEP;
+
+        switch (state) {
+            case State::SPIN_UP:
+                if (!settled(rpm, now)) break;
+                if (settledRpm < stallRpm) {
+                    fail("no rotation at full duty");
+                    break;
+                }
+                record(1.0f, settledRpm);
+                lastRunningRpm = settledRpm;
+                state = State::SWEEP;
+                sweepIndex = 1;
+                beginStep(true, sweepDuty(sweepIndex), now);
+                break;
+
+            case State::SWEEP:
+                if (!settled(rpm, now)) break;
+                if (settledRpm < stallRpm) {
+                    kicking = true;
+                    beginStallSearch(now);
+                    break;
+                }
+                record(duty, settledRpm);
+                lastRunningDuty = duty;
+                lastRunningRpm = settledRpm;
+                if (++sweepIndex < SWEEP_POINTS) {
+                    beginStep(true, sweepDuty(sweepIndex), now);
+                } else {
+                    beginStallSearch(now);
+                }
+                break;
+
+            case State::STALL_SEARCH:
+                if (kicking) {
+                    if (rpm >= stallRpm && now - stepStart >= Config::FanCalibration::MIN_SETTLE_TIME) {
+                        kicking = false;
+                        beginStep(true, fineStart - fineStep, now);
+                    } else if (now - stepStart >= Config::FanCalibration::SETTLE_TIMEOUT) {
+                        fail("no restart at full duty");
+                    }
+                    break;
+                }
+                if (!settled(rpm, now)) break;
+                if (settledRpm < stallRpm) {
+                    endStallSearch(lastRunningDuty, now);
+                } else if (duty <= 0.0f) {
+                    lastRunningDuty = 0.0f;
+                    lastRunningRpm = settledRpm;
+                    endStallSearch(0.0f, now);
+                } else {
+                    lastRunningDuty = duty;
+                    lastRunningRpm = settledRpm;
+                    beginStep(true, duty - fineStep < fineStep / 2 ? 0.0f : duty - fineStep, now);
+                }
+                break;
+
+            case State::STOPPING:
+                if (rpm > 0.0f) windowCount = 0;
+                else windowCount++;
+                if (windowCount >= Config::FanCalibration::STOPPED_SAMPLES ||
+                    now - stepStart >= Config::FanCalibration::SETTLE_TIMEOUT) {
+                    state = State::START_SEARCH;
+                    beginStep(true, stallDuty, now);
+                }
+                break;
+
+            case State::START_SEARCH:
+                if (rpm >= stallRpm) {
+                    startDuty = duty;
+                    if (buildTable()) {
+                        state = State::DONE;
+                        power = false;
+                        duty = 0.0f;
+                    } else {
+                        fail("inconsistent curve");
+                    }
+                } else if (now - stepStart >= Config::FanCalibration::START_WAIT) {
+                    if (duty >= 1.0f) {
+                        fail("no start at full duty");
+                    } else {
+                        beginStep(true, duty + fineStep, now);
+                    }
+                }
+                break;
+
+            default:
+                break;
+        }
+        return {power, duty};
+    }
+
+    bool isRunning() const {
+        return state != State::IDLE && state != State::DONE && state != State::ABORTED && state != State::FAILED;
+    }
+
+    State getState() const { return state; }
+    const char* getFailure() const { return failure; }
+    const FanModel::Table& getResult() const { return result; }
+
+    // Rough fraction of the sweep done, for the status
+    float getProgress() const {
+        switch (state) {
+            case State::SPIN_UP:      return 0.0f;
+            case State::SWEEP:        return 0.05f + 0.6f * sweepIndex / SWEEP_POINTS;
+            case State::STALL_SEARCH: return fineStart > 0.0f ? 0.65f + 0.2f * fminf(1.0f - duty / fineStart, 1.0f) : 0.65f;
+            case State::STOPPING:     return 0.85f;
+            case State::START_SEARCH: return 0.9f;
+            case State::DONE:         return 1.0f;
+            default:                  return 0.0f;
+        }
+    }
+
+    static const char* getStateName(State state) {
+        switch (state) {
+            case State::IDLE:         return "idle";
+            case State::SPIN_UP:      return "spin_up";
+            case State::SWEEP:        return "sweep";
+            case State::STALL_SEARCH: return "stall_search";
+            case State::STOPPING:     return "stopping";
+            case State::START_SEARCH: return "start_search";
+            case State::DONE:         return "done";
+            case State::ABORTED:      return "aborted";
+            case State::FAILED:       return "failed";
+            default:                  return "unknown";
+        }
+    }
+};
+
+#endif // FAN_CALIBRATOR_H
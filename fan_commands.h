@@ -0,0 +1,147 @@
+#ifndef FAN_COMMANDS_H
+#define FAN_COMMANDS_H
+
+#include "config.h"
+#include "logging.h"
+#include "system_status.h"
+#include "fan_controller.h"
+#include "fan_health.h"
+#include "safety_monitor.h"
+#include "event_log.h"
+
+// Control actions shared by the REST API and MQTT, so every interface applies the same rules.
+// Each returns whether it was applied and a message for the client.
+class FanCommands {
+public:
+    struct Result {
+        bool ok;
+        const char* message;
+    };
+
+private:
+    SystemStatus& status;
+    FanController& controller;
+    FanHealthMonitor& fanHealth;
+    SafetyMonitor& safety;
+
+public:
+    FanCommands(SystemStatus& systemStatus, FanController& fanController, FanHealthMonitor& healthMonitor,
+                SafetyMonitor& safetyMonitor)
+        : status(systemStatus), controller(fanController), fanHealth(healthMonitor), safety(safetyMonitor) {}
+
+    Result toggleFan() {
+        return setFan(!status.fanOn);
+    }
+
+    Result setFan(bool on) {
+        if (status.autoMode) {
+            return {false, "Cannot toggle fan in automatic mode"};
+        }
+        if (controller.isSafetyOverride()) {
+            return {false, "Safety override active"};
+        }
+        if (controller.isCalibrating()) {
+            return {false, "Fan calibration running"};
+        }
+
+        if (on != status.fanOn) {
+            status.fanOn = on;
+            EventLog::record(EventLog::Code::FAN_SWITCH, on);
+            controller.toggleFan(on);
+            controller.setFanSpeed(on ? status.manualFanSpeed : 0.0f);
+        }
+        return {true, "Fan state toggled successfully"};
+    }
+
+    Result setAutoMode(bool enable) {
+        if (controller.isCalibrating()) {
+            return {false, "Fan calibration running"};
+        }
+        bool changed = enable != status.autoMode;
+        if (!status.setAutoMode(enable)) {
+            return {false, "Failed to update mode"};
+        }
+        if (changed) EventLog::record(EventLog::Code::MODE_CHANGE, enable);
+
+        if (enable) {
+            controller.updateAutomaticMode();
+        } else if (status.fanOn) {
+            controller.setFanSpeed(status.manualFanSpeed);
+        }
+        return {true, "Mode updated successfully"};
+    }
+
+    // Speed 0.0 - 1.0, applies to manual mode only
+    Result setManualSpeed(float speed) {
+        if (status.autoMode) {
+            LOG_PRINTLN("DEBUG: Cannot set fan speed in automatic mode");
+            return {false, "Cannot set fan speed in automatic mode"};
+        }
+        if (controller.isSafetyOverride()) {
+            return {false, "Safety override active"};
+        }
+        if (controller.isCalibrating()) {
+            return {false, "Fan calibration running"};
+        }
+        if (isnan(speed) || speed < 0.0f || speed > 1.0f) {
+            LOG_PRINTLN("DEBUG: Invalid speed value");
+            return {false, "Invalid speed value"};
+        }
+
+        status.manualFanSpeed = speed;
+        if (status.fanOn) {
+            controller.setFanSpeed(speed);
+        }
+        return {true, "Speed updated successfully"};
+    }
+
+    // Temperature -> airflow curve of automatic mode, stored in NVS
+    Result setFanCurve(const FanCurve::Table& table) {
+        if (!controller.setCurve(table)) {
+            return {false, "Invalid fan curve"};
+        }
+        return {true, "Fan curve updated successfully"};
+    }
+
+    Result resetTemperature() {
+        status.resetMinMaxTemperature();
+        return {true, "Temperature ranges reset successfully"};
+    }
+
+    Result resetFanHealth() {
+        fanHealth.reset();
+        return {true, "Fan health model reset successfully"};
+    }
+
+    // Sweeps the fan for its duty -> RPM table; the mode resumes when it ends
+    Result startCalibration() {
+        if (controller.isSafetyOverride()) {
+            return {false, "Safety override active"};
+        }
+        if (controller.isCalibrating()) {
+            return {false, "Fan calibration already running"};
+        }
+        if (!controller.startCalibration()) {
+            return {false, "Fan calibration could not start"};
+        }
+        return {true, "Fan calibration started"};
+    }
+
+    // Keeps the previous table
+    Result abortCalibration() {
+        if (!controller.isCalibrating()) {
+            return {false, "No fan calibration running"};
+        }
+        controller.abortCalibration();
+        return {true, "Fan calibration aborted"};
+    }
+
+    // Acknowledges the latched safety event; an ongoing trip is not affected
+    Result resetSafety() {
+        safety.clearLatch();
+        safety.update(status);
+        return {true, "Safety event acknowledged"};
+    }
+};
+
+#endif // FAN_COMMANDS_H
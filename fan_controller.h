@@ -2,103 +2,82 @@
 #define FAN_CONTROLLER_H
 
 #include <Arduino.h>
-#include <driver/ledc.h>
+#include <atomic>
 #include "config.h"
+#include "logging.h"
 #include "system_status.h"
+#include "activity_scheduler.h"
+#include "sleep_mode.h"
+#include "rpm_regulator.h"
+#include "fan_model.h"
+#include "fan_calibrator.h"
+#include "fan_curve.h"
+#include "pwm_driver.h"
+#include "event_log.h"
 
 class FanController {
 private:
     SystemStatus& status;
-    float lastTemperature = 0.0f;
-    unsigned long lastTempUpdate = 0;
-    unsigned long lastCheckTime = 0;
-    bool inSleepMode = true;
+    ActivityScheduler& scheduler;
+    PwmDriver& pwm;
+    FanModel& model;
+    FanCurve& curve;
+    RpmRegulator regulator;
+    FanCalibrator calibrator;
+    bool fanOnBeforeCalibration = false;
+    float targetRpm = 0.0f;
+    SleepMode sleepMode;
+    bool safetyOverride = false;
+    bool fanOnBeforeOverride = false;
+    const std::atomic<bool>* safetyTrip = nullptr;  // Set by the safety task ahead of the override
     int errorCount = 0;
 
-    // Temperature history for trend analysis
-    static constexpr int TEMP_HISTORY_SIZE = 6;
-    float tempHistory[TEMP_HISTORY_SIZE] = {0};
-    int tempHistoryIndex = 0;
-    
     // Constants
-    static constexpr float SLEEP_TEMP_THRESHOLD = 22.0f;    // Below this temperature -> sleep mode
-    static constexpr float TEMP_RISE_THRESHOLD = 0.2f;      // Temperature rise indicating activity
+    static constexpr float WARMUP_SLOPE_THRESHOLD = 0.5f;   // Temperature slope indicating warm-up in °C/min
     static constexpr float MIN_SPEED = 0.2f;                // Minimum fan speed when active
     static constexpr int MAX_ERRORS = 3;
     
-    // LEDC configuration
-    ledc_timer_config_t ledcTimer;
-    ledc_channel_config_t ledcChannel;
-
     void initPWM() {
-        Serial.println("DEBUG: Initializing PWM");
-        
-        // LEDC Timer configuration
-        ledcTimer.speed_mode = LEDC_LOW_SPEED_MODE;
-        ledcTimer.duty_resolution = static_cast<ledc_timer_bit_t>(Config::PWM::RESOLUTION);
-        ledcTimer.timer_num = LEDC_TIMER_0;
-        ledcTimer.freq_hz = Config::PWM::FREQUENCY;
-        ledc_timer_config(&ledcTimer);
-
-        // LEDC Channel configuration
-        ledcChannel.gpio_num = Config::Pins::PWM_PIN;
-        ledcChannel.speed_mode = LEDC_LOW_SPEED_MODE;
-        ledcChannel.channel = static_cast<ledc_channel_t>(Config::PWM::CHANNEL);
-        ledcChannel.timer_sel = LEDC_TIMER_0;
-        ledcChannel.duty = 0;
-        ledcChannel.hpoint = 0;
-        ledc_channel_config(&ledcChannel);
+        LOG_PRINTLN("DEBUG: Initializing PWM");
+        pwm.begin();
 
         pinMode(Config::Pins::MOSFET_PIN, OUTPUT);
         digitalWrite(Config::Pins::MOSFET_PIN, LOW);
-        
-        Serial.println("DEBUG: PWM initialized");
     }
 
-    unsigned long getCheckInterval() {
-        time_t now;
-        time(&now);
-        struct tm* timeinfo = localtime(&now);
-        
-        // Night time (22:00 - 06:00)
-        if (timeinfo->tm_hour >= 22 || timeinfo->tm_hour < 6) {
-            return 30 * 60000; // 30 minutes
-        }
-        // Peak usage time (17:00 - 22:00)
-        else if (timeinfo->tm_hour >= 17 && timeinfo->tm_hour < 22) {
-            return 3 * 60000;  // 3 minutes
-        }
-        // Default interval
-        return 5 * 60000;     // 5 minutes
+    // The task may trip between two loop passes; its outputs must not be undone meanwhile
+    bool forcedFullAirflow() const {
+        return safetyOverride || (safetyTrip && safetyTrip->load());
     }
 
-    void updateTempHistory(float temp) {
-        tempHistory[tempHistoryIndex] = temp;
-        tempHistoryIndex = (tempHistoryIndex + 1) % TEMP_HISTORY_SIZE;
+    // Writes a duty fraction to the PWM driver; 0 releases the PWM input
+    void writeDuty(float fraction) {
+        if (forcedFullAirflow()) fraction = 1.0f;
+        if (fraction > 0.0f) {
+            fraction = constrain(fraction, model.minDuty(), 1.0f);
+        }
+        pwm.setDuty(fraction);
+        status.fanDuty = pwm.getDuty();
     }
 
-    float getTempTrend() {
-        float sum = 0;
-        for (int i = 1; i < TEMP_HISTORY_SIZE; i++) {
-            int prev = (tempHistoryIndex - i - 1 + TEMP_HISTORY_SIZE) % TEMP_HISTORY_SIZE;
-            int curr = (tempHistoryIndex - i + TEMP_HISTORY_SIZE) % TEMP_HISTORY_SIZE;
-            sum += tempHistory[curr] - tempHistory[prev];
-        }
-        return sum / (TEMP_HISTORY_SIZE - 1);
+    unsigned long getCheckInterval() {
+        return scheduler.getCheckInterval();
     }
 
-    void handleError(const String& errorType) {
+    void handleError(const char* errorType) {
         errorCount++;
-        Serial.print("DEBUG: Fan error: ");
-        Serial.println(errorType);
+        LOG_PRINT("DEBUG: Fan error: ");
+        LOG_PRINTLN(errorType);
         
         if (errorCount >= MAX_ERRORS) {
-            status.autoModeStatus = "Critical Error - System Restart Required";
-            Serial.println("DEBUG: Maximum errors reached, restarting system");
+            status.setStatus(SystemStatus::StatusCode::CRITICAL_ERROR);
+            LOG_PRINTLN("DEBUG: Maximum errors reached, restarting system");
+            EventLog::record(EventLog::Code::RESTART, static_cast<uint8_t>(EventLog::RestartCause::FAN_ERRORS));
+            EventLog::persist(true);
             ESP.restart();
         } else {
-            status.autoModeStatus = "Error - Recovery Attempt " + String(errorCount);
-            Serial.println("DEBUG: Attempting error recovery");
+            status.setStatus(SystemStatus::StatusCode::ERROR_RECOVERY, errorCount);
+            LOG_PRINTLN("DEBUG: Attempting error recovery");
             initPWM();
             toggleFan(false);
             delay(1000);
@@ -111,120 +90,173 @@ private:
     void clearErrors() {
         if (errorCount > 0) {
             errorCount = 0;
-            status.autoModeStatus = "System Recovered";
-            Serial.println("DEBUG: System recovered from errors");
+            status.setStatus(SystemStatus::StatusCode::RECOVERED);
+            LOG_PRINTLN("DEBUG: System recovered from errors");
         }
     }
 
-    bool shouldActivateCheck() {
-        if (!inSleepMode) return true;
-        
-        unsigned long now = millis();
-        unsigned long checkInterval = getCheckInterval();
-        
-        if (now - lastCheckTime >= checkInterval) {
-            lastCheckTime = now;
-            status.autoModeStatus = "Checking for Activity...";
-            Serial.println("DEBUG: Starting activity check");
-            return true;
+    // The sweep drives MOSFET and PWM directly, below the regulator's lowest duty
+    void applyCalibration(const FanCalibrator::Output& out) {
+        digitalWrite(Config::Pins::MOSFET_PIN, out.power ? HIGH : LOW);
+        status.fanOn = out.power;
+        pwm.setDuty(out.duty);
+        status.fanDuty = pwm.getDuty();
+        status.setStatus(SystemStatus::StatusCode::CALIBRATING, lroundf(calibrator.getProgress() * 100));
+    }
+
+    // Takes over a finished table and hands the fan back to the mode
+    void finishCalibration() {
+        if (calibrator.getState() == FanCalibrator::State::DONE && model.apply(calibrator.getResult())) {
+            model.save();
+            regulator.reset();
+            EventLog::record(EventLog::Code::CALIBRATION_DONE, 0, lroundf(model.maxRpm()));
+            LOG_PRINTLN("DEBUG: Fan calibration stored");
+        } else {
+            EventLog::record(EventLog::Code::CALIBRATION_FAILED,
+                             calibrator.getState() == FanCalibrator::State::ABORTED ? 1 : 0);
+            LOG_PRINT("DEBUG: Fan calibration ended: ");
+            LOG_PRINTLN(FanCalibrator::getStateName(calibrator.getState()));
         }
-        
-        if (now - lastCheckTime < Config::CHECK_DURATION) {
-            return true;
+        publishCalibration();
+
+        targetRpm = 0.0f;
+        toggleFan(false);
+        if (forcedFullAirflow()) return;
+        if (status.autoMode) {
+            updateAutomaticMode();
+        } else {
+            status.setStatus(SystemStatus::StatusCode::READY);
+            if (fanOnBeforeCalibration) {
+                toggleFan(true);
+                setFanSpeed(status.manualFanSpeed);
+            }
+        }
+    }
+
+    // One sweep step per tach measurement, from regulateSpeed()
+    void stepCalibration(float measuredRpm) {
+        if (forcedFullAirflow()) {
+            abortCalibration();
+            return;
+        }
+        FanCalibrator::Output out = calibrator.step(measuredRpm, millis());
+        if (calibrator.isRunning()) {
+            applyCalibration(out);
+            publishCalibration();
+        } else {
+            finishCalibration();
         }
-        
-        status.autoModeStatus = "Sleep Mode - Next Check in " + 
-            String((checkInterval - (now - lastCheckTime)) / 60000) + " Minutes";
-        return false;
     }
 
     float calculateTargetSpeed() {
         float temp = status.temperature;
         float targetSpeed = 0.0f;
-        String statusMsg;
-        
-        updateTempHistory(temp);
-        float tempTrend = getTempTrend();
+        SystemStatus::StatusCode statusCode = SystemStatus::StatusCode::READY;
+        uint32_t statusValue = 0;
         
-        float tempChangeRate = 0.0f;
-        unsigned long timeDiff = millis() - lastTempUpdate;
-        if (timeDiff > 0) {
-            tempChangeRate = (temp - lastTemperature) / (timeDiff / 60000.0f);
-        }
+        // Least-squares slope from the shared sensor filter pipeline, in °C/min
+        float tempSlope = status.temperatureSlope;
+
+        // The user curve replaces the warm-up, operating and cooling shapes; a curve that
+        // runs the fan below the sleep threshold also keeps it out of sleep mode
+        float curveSpeed = curve.isSelected() ? curve.evaluate(temp) : 0.0f;
 
         // Sleep mode logic
-        if (temp < SLEEP_TEMP_THRESHOLD) {
-            if (!shouldActivateCheck()) {
-                lastTemperature = temp;
-                lastTempUpdate = millis();
-                return 0.0f;
-            }
-            targetSpeed = MIN_SPEED;
-            
-            if (tempChangeRate > TEMP_RISE_THRESHOLD || tempTrend > TEMP_RISE_THRESHOLD) {
-                inSleepMode = false;
-                statusMsg = "Activity Detected - Starting Normal Operation";
-                Serial.println("DEBUG: Activity detected, exiting sleep mode");
-            } else {
-                statusMsg = "Checking for Activity (" + 
-                    String((Config::CHECK_DURATION - (millis() - lastCheckTime)) / 1000) + "s)";
+        if (temp < SleepMode::SLEEP_TEMP_THRESHOLD && curveSpeed <= 0.0f) {
+            unsigned long checkInterval = getCheckInterval();
+            switch (sleepMode.belowThreshold(tempSlope, status.fanOn, millis(), checkInterval)) {
+                case SleepMode::Action::SLEEP:
+                    status.setStatus(SystemStatus::StatusCode::SLEEPING, sleepMode.getLastCheck() + checkInterval);
+                    return 0.0f;
+                case SleepMode::Action::START_CHECK:
+                    status.setStatus(SystemStatus::StatusCode::CHECK_STARTED);
+                    LOG_PRINTLN("DEBUG: Starting activity check");
+                    // fall through
+                case SleepMode::Action::CHECK:
+                    targetSpeed = MIN_SPEED;
+                    statusCode = SystemStatus::StatusCode::CHECKING;
+                    statusValue = sleepMode.getLastCheck() + Config::CHECK_DURATION;
+                    break;
+                case SleepMode::Action::FIRE_START:
+                    scheduler.recordFireStart();
+                    LOG_PRINTLN("DEBUG: Activity detected, exiting sleep mode");
+                    // fall through
+                case SleepMode::Action::ACTIVE:
+                    targetSpeed = MIN_SPEED;
+                    statusCode = SystemStatus::StatusCode::ACTIVITY_DETECTED;
+                    break;
+                case SleepMode::Action::COOL_DOWN:
+                    statusCode = SystemStatus::StatusCode::COOLING_FAN_OFF;
+                    break;
+                case SleepMode::Action::ENTER_SLEEP:
+                    statusCode = SystemStatus::StatusCode::ENTERING_SLEEP;
+                    LOG_PRINTLN("DEBUG: Entering sleep mode");
+                    break;
             }
         } else {
-            inSleepMode = false;
+            if (sleepMode.aboveThreshold(tempSlope)) {
+                scheduler.recordFireStart();
+            }
             
-            if (tempChangeRate > 0.5f || tempTrend > 0.3f) {
+            if (curve.isSelected()) {
+                targetSpeed = curveSpeed;
+                if (targetSpeed > 0.0f) {
+                    statusCode = SystemStatus::StatusCode::OPERATING;
+                    statusValue = lroundf(targetSpeed * 100);
+                } else {
+                    statusCode = SystemStatus::StatusCode::COOLING_FAN_OFF;
+                }
+            }
+            else if (tempSlope > WARMUP_SLOPE_THRESHOLD) {
                 float normalizedTemp = (temp - Config::TEMP_THRESHOLD) / 
                                      (Config::MAX_TEMP - Config::TEMP_THRESHOLD);
                 targetSpeed = 0.6f + (normalizedTemp * 0.4f);
-                statusMsg = "Warm-up Phase: Optimizing Heat Distribution (" + 
-                    String(targetSpeed * 100, 0) + "%)";
-                Serial.println("DEBUG: Warm-up phase active");
+                statusCode = SystemStatus::StatusCode::WARMUP;
+                statusValue = lroundf(targetSpeed * 100);
+                LOG_PRINTLN("DEBUG: Warm-up phase active");
             }
             else if (temp >= Config::TEMP_THRESHOLD + Config::HYSTERESIS) {
                 float normalizedTemp = (temp - Config::TEMP_THRESHOLD) / 
                                      (Config::MAX_TEMP - Config::TEMP_THRESHOLD);
                 targetSpeed = 0.3f + (pow(normalizedTemp, 2) * 0.7f);
-                statusMsg = "Operating Phase: " + String(targetSpeed * 100, 0) + "% Power";
+                statusCode = SystemStatus::StatusCode::OPERATING;
+                statusValue = lroundf(targetSpeed * 100);
             }
             else if (temp > Config::TEMP_THRESHOLD - Config::HYSTERESIS) {
                 if (status.currentFanSpeed < 0.1f) {
                     targetSpeed = 0.0f;
-                    statusMsg = "Cooling Phase: Fan Off";
-                    if (tempChangeRate < 0 && temp < SLEEP_TEMP_THRESHOLD) {
-                        inSleepMode = true;
-                        statusMsg = "Entering Sleep Mode";
-                        Serial.println("DEBUG: Entering sleep mode");
-                    }
+                    statusCode = SystemStatus::StatusCode::COOLING_FAN_OFF;
                 } else {
                     targetSpeed = 0.3f;
-                    statusMsg = "Cooling Phase: Using Residual Heat";
+                    statusCode = SystemStatus::StatusCode::COOLING_RESIDUAL;
                 }
             }
         }
 
-        lastTemperature = temp;
-        lastTempUpdate = millis();
-        status.autoModeStatus = statusMsg;
+        status.setStatus(statusCode, statusValue);
 
-        Serial.print("DEBUG: Target speed calculated: ");
-        Serial.println(targetSpeed);
+        LOG_PRINT("DEBUG: Target speed calculated: ");
+        LOG_PRINTLN(targetSpeed);
         
         return targetSpeed;
     }
 
 public:
-    explicit FanController(SystemStatus& systemStatus) : status(systemStatus) {
+    FanController(SystemStatus& systemStatus, ActivityScheduler& activityScheduler, PwmDriver& pwmDriver,
+                  FanModel& fanModel, FanCurve& fanCurve)
+        : status(systemStatus), scheduler(activityScheduler), pwm(pwmDriver), model(fanModel), curve(fanCurve),
+          regulator(fanModel) {
         initPWM();
-        lastCheckTime = millis() - getCheckInterval(); // Allow immediate first check
-        Serial.println("DEBUG: Fan controller initialized");
+        sleepMode.begin(millis(), getCheckInterval()); // Allow immediate first check
+        LOG_PRINTLN("DEBUG: Fan controller initialized");
     }
 
     bool isInSleepMode() const {
-        return inSleepMode;
+        return sleepMode.isSleeping();
     }
 
     void updateAutomaticMode() {
-        if (!status.autoMode) return;
+        if (!status.autoMode || safetyOverride || calibrator.isRunning()) return;
 
         try {
             float targetSpeed = calculateTargetSpeed();
@@ -232,13 +264,13 @@ public:
 
             if (targetSpeed > 0.0f) {
                 if (!status.fanOn) {
-                    Serial.println("DEBUG: Auto mode activating fan");
+                    LOG_PRINTLN("DEBUG: Auto mode activating fan");
                     toggleFan(true);
                 }
                 setFanSpeed(targetSpeed);
             } else {
                 if (status.fanOn) {
-                    Serial.println("DEBUG: Auto mode deactivating fan");
+                    LOG_PRINTLN("DEBUG: Auto mode deactivating fan");
                     toggleFan(false);
                 }
             }
@@ -248,30 +280,64 @@ public:
         }
     }
 
+    // Speed is the commanded airflow 0.0 - 1.0; the RPM regulator holds the matching fan speed
     void setFanSpeed(float speed) {
         try {
-            speed = constrain(speed, 0.0f, 1.0f);
-            uint32_t duty = map(speed * 100, 0, 100, Config::PWM::MIN_DUTY, Config::PWM::MAX_DUTY);
+            speed = safetyOverride ? 1.0f : constrain(speed, 0.0f, 1.0f);
+            float rpm = regulator.rpmForAirflow(speed);
+            if (rpm == targetRpm && rpm > 0.0f) {
+                status.currentFanSpeed = speed;
+                return;
+            }
+
+            // Starting and stopping take effect at once; a running fan only gets the new set
+            // point, regulateSpeed() moves the duty with the next tach measurement
+            bool running = targetRpm > 0.0f;
+            if (!running && rpm > 0.0f) {
+                regulator.holdFeedback(Config::Fan::SPINUP_TIME, millis());
+            }
+            targetRpm = rpm;
+            if (!running || targetRpm <= 0.0f) {
+                writeDuty(regulator.output(targetRpm));
+            }
             
-            Serial.print("DEBUG: Setting fan speed to ");
-            Serial.print(speed);
-            Serial.print(" (duty: ");
-            Serial.print(duty);
-            Serial.println(")");
+            LOG_PRINT("DEBUG: Setting fan speed to ");
+            LOG_PRINT(speed);
+            LOG_PRINT(" (target RPM: ");
+            LOG_PRINT(targetRpm, 0);
+            LOG_PRINT(", duty: ");
+            LOG_PRINT(status.fanDuty);
+            LOG_PRINTLN(")");
             
-            ledc_set_duty(LEDC_LOW_SPEED_MODE, static_cast<ledc_channel_t>(Config::PWM::CHANNEL), duty);
-            ledc_update_duty(LEDC_LOW_SPEED_MODE, static_cast<ledc_channel_t>(Config::PWM::CHANNEL));
             status.currentFanSpeed = speed;
+            status.targetRPM = targetRpm;
+            if (targetRpm <= 0.0f) {
+                status.rpmError = 0.0f;
+            }
             clearErrors();
         } catch (...) {
             handleError("Fan Speed Control Error");
         }
     }
 
+    // Inner loop step with a new tach measurement; interval in seconds
+    void regulateSpeed(float measuredRpm, float interval) {
+        if (calibrator.isRunning()) {
+            stepCalibration(measuredRpm);
+            return;
+        }
+        if (!status.fanOn || targetRpm <= 0.0f || safetyOverride) return;
+
+        writeDuty(regulator.update(targetRpm, measuredRpm, interval, millis()));
+        status.rpmError = regulator.getLastError();
+        status.rpmErrorAverage = regulator.getAverageAbsError();
+    }
+
     void toggleFan(bool on) {
         try {
-            Serial.print("DEBUG: Toggling fan ");
-            Serial.println(on ? "ON" : "OFF");
+            on = on || forcedFullAirflow();
+            LOG_PRINT("DEBUG: Toggling fan ");
+            LOG_PRINTLN(on ? "ON" : "OFF");
             
             digitalWrite(Config::Pins::MOSFET_PIN, on ? HIGH : LOW);
             status.fanOn = on;
@@ -283,6 +349,88 @@ public:
             handleError("Fan Toggle Error");
         }
     }
+
+    // Full airflow in any mode while the safety monitor has tripped (it already drives the
+    // outputs); on release the mode takes over again
+    void setSafetyOverride(bool active) {
+        if (active == safetyOverride) return;
+
+        if (active) {
+            LOG_PRINTLN("DEBUG: Safety override, full airflow");
+            bool wasOn = calibrator.isRunning() ? fanOnBeforeCalibration : status.fanOn;
+            abortCalibration();
+            fanOnBeforeOverride = wasOn;
+            safetyOverride = true;
+            toggleFan(true);
+            setFanSpeed(1.0f);
+            status.targetFanSpeed = 1.0f;
+            status.setStatus(SystemStatus::StatusCode::SAFETY_OVERRIDE);
+            return;
+        }
+
+        LOG_PRINTLN("DEBUG: Safety override released");
+        safetyOverride = false;
+        if (status.autoMode) {
+            updateAutomaticMode();
+        } else {
+            toggleFan(fanOnBeforeOverride);
+            if (fanOnBeforeOverride) setFanSpeed(status.manualFanSpeed);
+            status.setStatus(SystemStatus::StatusCode::READY);
+        }
+    }
+
+    // Sweep state and the model in use, for the status
+    void publishCalibration() {
+        auto& stats = status.fanCalibration;
+        stats.calibrated = model.isCalibrated();
+        stats.running = calibrator.isRunning();
+        stats.state = FanCalibrator::getStateName(calibrator.getState());
+        stats.failure = calibrator.getFailure();
+        stats.progress = calibrator.getProgress();
+        stats.startDuty = model.startDuty();
+        stats.minDuty = model.minDuty();
+        stats.minRpm = model.minRpm();
+        stats.maxRpm = model.maxRpm();
+    }
+
+    // Starts the calibration sweep; the mode resumes when it ends
+    bool startCalibration() {
+        if (forcedFullAirflow() || calibrator.isRunning()) return false;
+
+        LOG_PRINTLN("DEBUG: Fan calibration started");
+        fanOnBeforeCalibration = status.fanOn;
+        applyCalibration(calibrator.start(millis()));
+        publishCalibration();
+        return true;
+    }
+
+    void abortCalibration() {
+        if (!calibrator.isRunning()) return;
+        calibrator.abort();
+        finishCalibration();
+    }
+
+    bool isCalibrating() const {
+        return calibrator.isRunning();
+    }
+
+    // Replaces the user curve and strategy and stores them; automatic mode follows at once
+    bool setCurve(const FanCurve::Table& table) {
+        if (!curve.apply(table)) return false;
+        curve.save();
+        LOG_PRINT("DEBUG: Fan curve updated, strategy ");
+        LOG_PRINTLN(FanCurve::getStrategyName(curve.getStrategy()));
+        updateAutomaticMode();
+        return true;
+    }
+
+    void attachSafetyTrip(const std::atomic<bool>& trip) {
+        safetyTrip = &trip;
+    }
+
+    bool isSafetyOverride() const {
+        return safetyOverride;
+    }
 };
 
 #endif // FAN_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,270 @@
+#ifndef FAN_CURVE_H
+#define FAN_CURVE_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "arena.h"
+
+#ifdef ARDUINO
+#include <Preferences.h>
+#include "logging.h"
+#endif
+
+// User temperature -> speed curve for automatic mode, selectable instead of the rule engine's
+// built-in warm-up and operating shapes. Up to MAX_POINTS breakpoints; each segment is linear
+// or monotone cubic (Hermite with Fritsch-Carlson tangents, computed once when the curve is
+// applied, so it never overshoots between points). Below the first and above the last point
+// the end speeds hold. Lookup is a binary search over the breakpoints without heap use.
+// Hysteresis: the curve follows a rising temperature at once, but a falling one only after it
+// dropped by the hysteresis, so the speed does not hunt around a breakpoint.
+// The curve and the selected strategy are kept in NVS.
+class FanCurve {
+public:
+    static constexpr int MAX_POINTS = Config::FanCurve::MAX_POINTS;
+    static constexpr uint16_t TABLE_VERSION = 1;
+
+    enum class Strategy : uint8_t {
+        RULES,                              // Rule engine of the fan controller
+        CURVE
+    };
+
+    struct Point {
+        float temperature;                  // °C, strictly ascending
+        float speed;                        // 0.0 - 1.0
+        uint8_t cubic;                      // Segment to the next point is monotone cubic
+    };
+
+    // Compact NVS image
+    struct Table {
+        uint16_t version;
+        uint8_t count;
+        uint8_t strategy;
+        float hysteresis;                   // °C
+        Point points[MAX_POINTS];
+    };
+
+private:
+    static constexpr const char* NVS_NAMESPACE = "fancurve";
+    static constexpr const char* NVS_KEY = "table";
+    static constexpr float MIN_TEMPERATURE = -40.0f;   // Sensor range
+    static constexpr float MAX_TEMPERATURE = 125.0f;
+
+    Table table;
+    float tangents[MAX_POINTS];             // Speed per °C at each point, for cubic segments
+    float reference = NAN;                  // Temperature the curve is evaluated at (hysteresis)
+
+    // Fritsch-Carlson: secant means, zero at local extrema, limited so each segment stays monotone
+    void computeTangents() {
+        int n = table.count;
+        const Point* p = table.points;
+        float secants[MAX_POINTS] = {};
+        for (int i = 0; i < n - 1; i++) {
+            secants[i] = (p[i + 1].speed - p[i].speed) / (p[i + 1].temperature - p[i].temperature);
+        }
+        tangents[0] = secants[0];
+        tangents[n - 1] = secants[n - 2];
+        for (int i = 1; i < n - 1; i++) {
+            tangents[i] = secants[i - 1] * secants[i] <= 0.0f ? 0.0f : (secants[i - 1] + secants[i]) / 2.0f;
+        }
+        for (int i = 0; i < n - 1; i++) {
+            if (secants[i] == 0.0f) {
+                tangents[i] = 0.0f;
+                tangents[i + 1] = 0.0f;
+                continue;
+            }
+            float a = tangents[i] / secants[i];
+            float b = tangents[i + 1] / secants[i];
+            float sum = a * a + b * b;
+            if (sum > 9.0f) {
+                float tau = 3.0f / sqrtf(sum);
+                tangents[i] = tau * a * secants[i];
+                tangents[i + 1] = tau * b * secants[i];
+            }
+        }
+    }
+
+    void loadDefaults() {
+        memset(&table, 0, sizeof(table));
+        table.version = TABLE_VERSION;
+        constexpr int count = sizeof(Config::FanCurve::DEFAULT_CURVE) / sizeof(Config::FanCurve::DEFAULT_CURVE[0]);
+        static_assert(count >= 2 && count <= MAX_POINTS, "Default curve does not fit the table");
+        for (int i = 0; i < count; i++) {
+            table.points[i].temperature = Config::FanCurve::DEFAULT_CURVE[i].temperature;
+            table.points[i].speed = Config::FanCurve::DEFAULT_CURVE[i].speed;
+            table.points[i].cubic = Config::FanCurve::DEFAULT_CURVE[i].cubic;
+        }
+        table.count = count;
+        table.strategy = static_cast<uint8_t>(Strategy::RULES);
+        table.hysteresis = Config::FanCurve::DEFAULT_HYSTERESIS;
+        computeTangents();
+        reference = NAN;
+    }
+
+public:
+    FanCurve() {
+        loadDefaults();
+    }
+
+    static bool isValid(const Table& candidate) {
+        if (candidate.version != TABLE_VERSION || candidate.count < 2 || candidate.count > MAX_POINTS) return false;
+        if (candidate.strategy > static_cast<uint8_t>(Strategy::CURVE)) return false;
+        if (!(candidate.hysteresis >= 0.0f && candidate.hysteresis <= Config::FanCurve::MAX_HYSTERESIS)) return false;
+        for (int i = 0; i < candidate.count; i++) {
+            const Point& point = candidate.points[i];
+            if (!(point.temperature >= MIN_TEMPERATURE && point.temperature <= MAX_TEMPERATURE)) return false;
+            if (!(point.speed >= 0.0f && point.speed <= 1.0f)) return false;
+            if (i > 0 && !(point.temperature > candidate.points[i - 1].temperature)) return false;
+        }
+        return true;
+    }
+
+    bool apply(const Table& candidate) {
+        if (!isValid(candidate)) return false;
+        table = candidate;
+        computeTangents();
+        reference = NAN;
+        return true;
+    }
+
+    // Parses "temp:speed[:c|l],..." into the points of a table, e.g. "25:0,30:0.3:c,80:1";
+    // segments are linear unless marked c. Leaves the rest of the table alone.
+    static bool parsePoints(const char* text, Table& out) {
+        int count = 0;
+        const char* cursor = text;
+        while (*cursor) {
+            if (count >= MAX_POINTS) return false;
+            char* end;
+            float temperature = strtof(cursor, &end);
+            if (end == cursor || *end != ':') return false;
+            cursor = end + 1;
+            float speed = strtof(cursor, &end);
+            if (end == cursor) return false;
+            cursor = end;
+            bool cubic = false;
+            if (*cursor == ':') {
+                if (cursor[1] != 'c' && cursor[1] != 'l') return false;
+                cubic = cursor[1] == 'c';
+                cursor += 2;
+            }
+            out.points[count++] = {temperature, speed, static_cast<uint8_t>(cubic)};
+            if (*cursor == ',') {
+                cursor++;
+            } else if (*cursor) {
+                return false;
+            }
+        }
+        out.count = static_cast<uint8_t>(count);
+        return true;
+    }
+
+    // Curve speed at a temperature, without hysteresis
+    float speedAt(float temperature) const {
+        const Point* p = table.points;
+        int n = table.count;
+        if (!(temperature > p[0].temperature)) return p[0].speed;
+        if (temperature >= p[n - 1].temperature) return p[n - 1].speed;
+
+        // Last point at or below the temperature
+        int low = 0;
+        int high = n - 1;
+        while (high - low > 1) {
+            int mid = (low + high) / 2;
+            if (p[mid].temperature <= temperature) low = mid;
+            else high = mid;
+        }
+
+        float width = p[high].temperature - p[low].temperature;
+        float t = (temperature - p[low].temperature) / width;
+        float speed;
+        if (p[low].cubic) {
+            float t2 = t * t;
+            float t3 = t2 * t;
+            speed = (2.0f * t3 - 3.0f * t2 + 1.0f) * p[low].speed + (t3 - 2.0f * t2 + t) * width * tangents[low] +
+                    (-2.0f * t3 + 3.0f * t2) * p[high].speed + (t3 - t2) * width * tangents[high];
+        } else {
+            speed = p[low].speed + t * (p[high].speed - p[low].speed);
+        }
+        return fminf(fmaxf(speed, 0.0f), 1.0f);
+    }
+
+    // Speed for a new temperature sample, with hysteresis on falling temperatures
+    float evaluate(float temperature) {
+        if (isnan(reference) || temperature > reference) {
+            reference = temperature;
+        } else if (temperature < reference - table.hysteresis) {
+            reference = temperature + table.hysteresis;
+        }
+        return speedAt(reference);
+    }
+
+    void select(Strategy strategy) {
+        table.strategy = static_cast<uint8_t>(strategy);
+        reference = NAN;
+    }
+
+    bool isSelected() const { return table.strategy == static_cast<uint8_t>(Strategy::CURVE); }
+    Strategy getStrategy() const { return static_cast<Strategy>(table.strategy); }
+    const Table& getTable() const { return table; }
+
+    static const char* getStrategyName(Strategy strategy) {
+        return strategy == Strategy::CURVE ? "curve" : "rules";
+    }
+
+    static bool parseStrategy(const char* name, Strategy& strategy) {
+        if (strcmp(name, "curve") == 0) {
+            strategy = Strategy::CURVE;
+        } else if (strcmp(name, "rules") == 0) {
+            strategy = Strategy::RULES;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    void toJson(TextWriter& out) const {
+        out.print("{\"strategy\":\"").print(getStrategyName(getStrategy())).print('"');
+        out.print(",\"hysteresis\":").print(table.hysteresis, 1);
+        out.print(",\"reference_temp\":");
+        if (isnan(reference)) out.print("null");
+        else out.print(reference, 2);
+        out.print(",\"points\":[");
+        for (int i = 0; i < table.count; i++) {
+            const Point& point = table.points[i];
+            if (i > 0) out.print(',');
+            out.print("{\"temp\":").print(point.temperature, 1);
+            out.print(",\"speed\":").print(point.speed, 3);
+            out.print(",\"interpolation\":\"").print(point.cubic ? "cubic" : "linear").print("\"}");
+        }
+        out.print("]}");
+    }
+
+#ifdef ARDUINO
+    void begin() {
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, true)) {
+            Table stored;
+            if (prefs.getBytesLength(NVS_KEY) == sizeof(stored)) {
+                prefs.getBytes(NVS_KEY, &stored, sizeof(stored));
+                if (apply(stored)) {
+                    LOG_PRINT("DEBUG: Fan curve loaded, strategy ");
+                    LOG_PRINTLN(getStrategyName(getStrategy()));
+                }
+            }
+            prefs.end();
+        }
+    }
+
+    void save() const {
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, false)) {
+            prefs.putBytes(NVS_KEY, &table, sizeof(table));
+            prefs.end();
+        }
+    }
+#endif
+};
+
+#endif // FAN_CURVE_H
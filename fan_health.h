@@ -0,0 +1,206 @@
+#ifndef FAN_HEALTH_H
+#define FAN_HEALTH_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+#include "logging.h"
+#include "system_status.h"
+
+// Online model of the expected RPM per duty bucket. Each bucket learns a baseline
+// (mean/variance via Welford) from its first samples and keeps a fast exponentially
+// weighted mean/variance of the recent behaviour. Comparing the two reveals a clogged
+// filter or blocked duct (RPM shortfall or rise at the same duty), a failing bearing
+// (rising variance) and slow drift. O(1) per sample, fixed memory; learned baselines
+// are kept in NVS so a reboot does not relearn a degraded fan as healthy.
+class FanHealthMonitor {
+private:
+    static constexpr int BUCKETS = Config::FanHealth::DUTY_BUCKETS;
+    static constexpr const char* NVS_NAMESPACE = "fanhealth";
+    static constexpr const char* NVS_KEY = "baseline";
+
+    struct Baseline {
+        float mean;
+        float m2;               // Welford sum of squared deviations
+        uint16_t count;
+    };
+
+    struct Recent {
+        float mean;
+        float variance;
+        uint16_t count;
+    };
+
+    SystemStatus& status;
+    Baseline baseline[BUCKETS];
+    Recent recent[BUCKETS];
+
+    float lastDuty = -1.0f;
+    unsigned long dutyChangedAt = 0;
+
+    // Shortfall trend for the time-to-maintenance estimate
+    float hourlySnapshot = 0.0f;
+    bool snapshotValid = false;
+    unsigned long snapshotTime = 0;
+    float shortfallRatePerHour = 0.0f;
+
+    static int bucketFor(float duty) {
+        int bucket = static_cast<int>(duty * BUCKETS);
+        return constrain(bucket, 0, BUCKETS - 1);
+    }
+
+    static float baselineVariance(const Baseline& b) {
+        return b.count > 1 ? b.m2 / (b.count - 1) : 0.0f;
+    }
+
+    void learnBaseline(Baseline& b, float rpm) {
+        b.count++;
+        float delta = rpm - b.mean;
+        b.mean += delta / b.count;
+        b.m2 += delta * (rpm - b.mean);
+        if (b.count == Config::FanHealth::BASELINE_SAMPLES) {
+            save();
+            LOG_PRINT("DEBUG: Fan health baseline learned at ");
+            LOG_PRINT(b.mean);
+            LOG_PRINTLN(" RPM");
+        }
+    }
+
+    void updateRecent(Recent& r, float rpm) {
+        if (r.count == 0) {
+            r.mean = rpm;
+            r.variance = 0.0f;
+        } else {
+            // Exponentially weighted mean and variance
+            const float alpha = Config::FanHealth::RECENT_ALPHA;
+            float delta = rpm - r.mean;
+            r.mean += alpha * delta;
+            r.variance = (1.0f - alpha) * (r.variance + alpha * delta * delta);
+        }
+        if (r.count < 0xFFFF) r.count++;
+    }
+
+    void evaluate(unsigned long now) {
+        // Aggregate over buckets with a learned baseline and enough recent samples
+        float shortfallSum = 0.0f;
+        float varianceRatioMax = 1.0f;
+        float weightSum = 0.0f;
+        for (int i = 0; i < BUCKETS; i++) {
+            const Baseline& b = baseline[i];
+            const Recent& r = recent[i];
+            if (b.count < Config::FanHealth::BASELINE_SAMPLES || r.count < Config::FanHealth::MIN_RECENT_SAMPLES ||
+                b.mean <= 0.0f) {
+                continue;
+            }
+            float weight = r.count;
+            shortfallSum += weight * (b.mean - r.mean) / b.mean;
+            weightSum += weight;
+
+            float expectedVariance = max(baselineVariance(b), Config::FanHealth::MIN_VARIANCE);
+            float ratio = r.variance / expectedVariance;
+            if (ratio > varianceRatioMax) varianceRatioMax = ratio;
+        }
+
+        SystemStatus::FanHealthStats& health = status.fanHealth;
+        health.modelReady = weightSum > 0.0f;
+        if (!health.modelReady) return;
+
+        float shortfall = shortfallSum / weightSum;
+        health.rpmShortfallPercent = shortfall * 100.0f;
+        health.varianceRatio = varianceRatioMax;
+
+        // Shortfall rate from hourly snapshots, smoothed over several hours
+        if (!snapshotValid) {
+            hourlySnapshot = shortfall;
+            snapshotTime = now;
+            snapshotValid = true;
+        } else if (now - snapshotTime >= 3600000UL) {
+            float hours = (now - snapshotTime) / 3600000.0f;
+            float rate = (shortfall - hourlySnapshot) / hours;
+            shortfallRatePerHour += Config::FanHealth::TREND_ALPHA * (rate - shortfallRatePerHour);
+            hourlySnapshot = shortfall;
+            snapshotTime = now;
+        }
+
+        // Score: shortfall counts 70 points, variance 30 points
+        const float maintenance = Config::FanHealth::MAINTENANCE_SHORTFALL;
+        float shortfallPenalty = constrain(fabsf(shortfall) / maintenance, 0.0f, 1.0f) * 70.0f;
+        float variancePenalty = constrain((varianceRatioMax - 1.0f) /
+                                          (Config::FanHealth::VARIANCE_RATIO_LIMIT - 1.0f), 0.0f, 1.0f) * 30.0f;
+        health.score = 100.0f - shortfallPenalty - variancePenalty;
+
+        health.shortfallWarning = fabsf(shortfall) >= maintenance * 0.5f;
+        health.varianceWarning = varianceRatioMax >= Config::FanHealth::VARIANCE_RATIO_LIMIT;
+        health.driftWarning = shortfallRatePerHour * 24.0f * 7.0f >= maintenance * 0.25f;
+
+        // Hours until the shortfall reaches the maintenance threshold at the current rate
+        if (shortfall >= maintenance) {
+            health.hoursToMaintenance = 0.0f;
+        } else if (shortfallRatePerHour > 1e-6f) {
+            health.hoursToMaintenance = (maintenance - shortfall) / shortfallRatePerHour;
+        } else {
+            health.hoursToMaintenance = -1.0f;  // No degradation trend
+        }
+    }
+
+    void save() {
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, false)) {
+            prefs.putBytes(NVS_KEY, baseline, sizeof(baseline));
+            prefs.end();
+        }
+    }
+
+public:
+    explicit FanHealthMonitor(SystemStatus& systemStatus) : status(systemStatus) {
+        memset(baseline, 0, sizeof(baseline));
+        memset(recent, 0, sizeof(recent));
+    }
+
+    void begin() {
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, true)) {
+            if (prefs.getBytesLength(NVS_KEY) == sizeof(baseline)) {
+                prefs.getBytes(NVS_KEY, baseline, sizeof(baseline));
+                LOG_PRINTLN("DEBUG: Fan health baseline loaded");
+            }
+            prefs.end();
+        }
+    }
+
+    // Feeds one tach measurement; samples taken while the fan settles after a duty change are skipped
+    void addSample(float duty, float rpm, bool fanOn) {
+        unsigned long now = millis();
+        if (!fanOn || duty <= 0.0f) {
+            lastDuty = -1.0f;
+            return;
+        }
+        if (fabsf(duty - lastDuty) > Config::FanHealth::DUTY_CHANGE_TOLERANCE) {
+            lastDuty = duty;
+            dutyChangedAt = now;
+            return;
+        }
+        if (now - dutyChangedAt < Config::FanHealth::SETTLE_TIME) return;
+
+        int bucket = bucketFor(duty);
+        if (baseline[bucket].count < Config::FanHealth::BASELINE_SAMPLES) {
+            learnBaseline(baseline[bucket], rpm);
+            return;
+        }
+        updateRecent(recent[bucket], rpm);
+        evaluate(now);
+    }
+
+    // Forgets the learned model, e.g. after cleaning the filter or replacing the fan
+    void reset() {
+        memset(baseline, 0, sizeof(baseline));
+        memset(recent, 0, sizeof(recent));
+        snapshotValid = false;
+        shortfallRatePerHour = 0.0f;
+        status.fanHealth = SystemStatus::FanHealthStats();
+        save();
+        LOG_PRINTLN("DEBUG: Fan health model reset");
+    }
+};
+
+#endif // FAN_HEALTH_H
@@ -0,0 +1,195 @@
+#ifndef FAN_MODEL_H
+#define FAN_MODEL_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+#include "arena.h"
+
+#ifdef ARDUINO
+#include <Preferences.h>
+#include "logging.h"
+#endif
+
+// Duty <-> RPM behaviour of the installed fan: the feed-forward of the RPM regulator, the
+// reachable speed range for the airflow mapping and the stall threshold of the fault check.
+// Starts from the datasheet curve in Config::Fan and is replaced by a calibration sweep
+// (fan_calibrator.h), which measures the fan in its duct. The table is kept in NVS.
+class FanModel {
+public:
+    static constexpr int MAX_POINTS = Config::FanCalibration::MAX_POINTS;
+    static constexpr uint16_t DUTY_SCALE = 10000;   // Duties stored in 1/10000
+    static constexpr uint16_t TABLE_VERSION = 1;
+
+    struct Point {
+        uint16_t duty;
+        uint16_t rpm;
+    };
+
+    // Compact NVS image
+    struct Table {
+        uint16_t version;
+        uint8_t count;
+        uint8_t reserved;
+        uint16_t startDuty;                 // Lowest duty that starts the fan from standstill
+        uint16_t stallDuty;                 // Lowest duty a running fan keeps turning at, 0 if it never stalls
+        Point points[MAX_POINTS];           // Ascending duty and RPM
+    };
+
+private:
+    static constexpr const char* NVS_NAMESPACE = "fancal";
+    static constexpr const char* NVS_KEY = "table";
+
+    Table table;
+    bool calibrated = false;
+
+    static float toFraction(uint16_t duty) { return static_cast<float>(duty) / DUTY_SCALE; }
+
+    void loadDefaults() {
+        memset(&table, 0, sizeof(table));
+        table.version = TABLE_VERSION;
+        constexpr int count = sizeof(Config::Fan::RPM_CURVE) / sizeof(Config::Fan::RPM_CURVE[0]);
+        static_assert(count <= MAX_POINTS, "Datasheet curve exceeds the table");
+        for (int i = 0; i < count; i++) {
+            table.points[i].duty = static_cast<uint16_t>(lroundf(Config::Fan::RPM_CURVE[i].duty * DUTY_SCALE));
+            table.points[i].rpm = static_cast<uint16_t>(lroundf(Config::Fan::RPM_CURVE[i].rpm));
+        }
+        table.count = count;
+        table.startDuty = static_cast<uint16_t>(lroundf(Config::Fan::MIN_DUTY_FRACTION * DUTY_SCALE));
+        table.stallDuty = table.startDuty;
+        calibrated = false;
+    }
+
+public:
+    FanModel() {
+        loadDefaults();
+    }
+
+    // A usable table: enough points, strictly ascending, inside the duty range
+    static bool isValid(const Table& candidate) {
+        if (candidate.version != TABLE_VERSION || candidate.count < 2 || candidate.count > MAX_POINTS) return false;
+        if (candidate.startDuty > DUTY_SCALE || candidate.stallDuty > candidate.startDuty) return false;
+        for (int i = 0; i < candidate.count; i++) {
+            if (candidate.points[i].duty > DUTY_SCALE || candidate.points[i].rpm == 0) return false;
+            if (i > 0 && (candidate.points[i].duty <= candidate.points[i - 1].duty ||
+                          candidate.points[i].rpm <= candidate.points[i - 1].rpm)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool apply(const Table& candidate) {
+        if (!isValid(candidate)) return false;
+        table = candidate;
+        calibrated = true;
+        return true;
+    }
+
+    // Back to the datasheet curve
+    void reset() {
+        loadDefaults();
+    }
+
+    // Duty expected to give the requested RPM (inverse of the table)
+    float feedForward(float rpm) const {
+        const Point* p = table.points;
+        if (rpm <= p[0].rpm) return toFraction(p[0].duty);
+        for (int i = 1; i < table.count; i++) {
+            if (rpm <= p[i].rpm) {
+                float t = (rpm - p[i - 1].rpm) / static_cast<float>(p[i].rpm - p[i - 1].rpm);
+                return toFraction(p[i - 1].duty) + t * (toFraction(p[i].duty) - toFraction(p[i - 1].duty));
+            }
+        }
+        return toFraction(p[table.count - 1].duty);
+    }
+
+    // RPM expected at a duty
+    float rpmAt(float duty) const {
+        const Point* p = table.points;
+        if (duty <= toFraction(p[0].duty)) return p[0].rpm;
+        for (int i = 1; i < table.count; i++) {
+            float d = toFraction(p[i].duty);
+            if (duty <= d) {
+                float d0 = toFraction(p[i - 1].duty);
+                float t = (duty - d0) / (d - d0);
+                return p[i - 1].rpm + t * (p[i].rpm - p[i - 1].rpm);
+            }
+        }
+        return p[table.count - 1].rpm;
+    }
+
+    float maxRpm() const { return table.points[table.count - 1].rpm; }
+
+    // Lowest speed the regulator may ask for
+    float minRpm() const {
+        if (!calibrated) return Config::Fan::MIN_RPM;
+        return rpmAt(minDuty());
+    }
+
+    // Lowest duty the regulator may output: a margin above the stall duty, and not below the
+    // first point, since lower duties do not slow the fan any further
+    float minDuty() const {
+        if (!calibrated) return Config::Fan::MIN_DUTY_FRACTION;
+        float duty = fmaxf(toFraction(table.stallDuty) + Config::FanCalibration::STALL_MARGIN, toFraction(table.points[0].duty));
+        return fminf(duty, 1.0f);
+    }
+
+    float startDuty() const { return toFraction(table.startDuty); }
+
+    // Tach reading below which the fan counts as blocked at this duty
+    float faultThreshold(float duty) const {
+        if (!calibrated) return Config::Tacho::MIN_RPM_THRESHOLD;
+        return rpmAt(duty) * Config::FanCalibration::FAULT_RPM_FRACTION;
+    }
+
+    bool isCalibrated() const { return calibrated; }
+    const Table& getTable() const { return table; }
+
+    void toJson(TextWriter& out) const {
+        out.print("{\"calibrated\":").print(calibrated);
+        out.print(",\"start_duty\":").print(startDuty(), 4);
+        out.print(",\"stall_duty\":").print(toFraction(table.stallDuty), 4);
+        out.print(",\"min_duty\":").print(minDuty(), 4);
+        out.print(",\"min_rpm\":").print(minRpm(), 0);
+        out.print(",\"max_rpm\":").print(maxRpm(), 0);
+        out.print(",\"points\":[");
+        for (int i = 0; i < table.count; i++) {
+            if (i > 0) out.print(',');
+            out.print("{\"duty\":").print(toFraction(table.points[i].duty), 4);
+            out.print(",\"rpm\":").print(table.points[i].rpm).print('}');
+        }
+        out.print("]}");
+    }
+
+#ifdef ARDUINO
+    void begin() {
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, true)) {
+            Table stored;
+            if (prefs.getBytesLength(NVS_KEY) == sizeof(stored)) {
+                prefs.getBytes(NVS_KEY, &stored, sizeof(stored));
+                if (apply(stored)) {
+                    LOG_PRINTLN("DEBUG: Fan calibration loaded");
+                }
+            }
+            prefs.end();
+        }
+    }
+
+    void save() const {
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, false)) {
+            if (calibrated) {
+                prefs.putBytes(NVS_KEY, &table, sizeof(table));
+            } else {
+                prefs.remove(NVS_KEY);
+            }
+            prefs.end();
+        }
+    }
+#endif
+};
+
+#endif // FAN_MODEL_H
@@ -3,7 +3,9 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "logging.h"
 #include "system_status.h"
+#include "psychrometrics.h"
 
 class HeatCalculator {
 private:
@@ -11,19 +13,10 @@ private:
 
     /**
      * @brief Calculates air density based on temperature and humidity
-     * @return Corrected air density in kg/m³
+     * @return Moist air density in kg/m³ (ideal gas mix of dry air and water vapour)
      */
     float calculateAirDensity() const {
-        // Basic temperature correction for air density
-        // ρ = ρ0 * (T0 / T), where T is in Kelvin
-        float tempKelvin = status.temperature + 273.15f;
-        float density = Config::Heat::AIR_DENSITY * (293.15f / tempKelvin);
-        
-        // Humidity correction (simplified)
-        // Reduce density slightly with increasing humidity
-        density *= (1.0f - (status.humidity * 0.0002f));  // Max 2% reduction at 100% humidity
-        
-        return density;
+        return Psychrometrics::airState(status.temperature, status.humidity).density;
     }
 
     /**
@@ -67,7 +60,7 @@ public:
     void initialize() {
         if (!status.isHeatCalcInitialized()) {
             status.initHeatCalculation(status.temperature);
-            Serial.println("DEBUG: Heat calculation initialized.");
+            LOG_PRINTLN("DEBUG: Heat calculation initialized.");
         }
     }
 
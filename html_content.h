@@ -67,6 +67,9 @@ const char HTML_BODY[] PROGMEM = R"rawliteral(
                 <div class="metric-item">
                     <div class="metric-label">Humidity</div>
                     <div class="metric-value" id="humidity-value">-%</div>
+                    <div class="metric-minmax">
+                        <span id="dew-point">Dew point: -°C</span>
+                    </div>
                 </div>
             </div>
 
@@ -84,7 +87,7 @@ const char HTML_BODY[] PROGMEM = R"rawliteral(
                         <span id="auto-speed">0%</span>
                     </div>
                     <div class="progress-bar">
-                        <div class="progress-fill" style="width: 0%"></div>
+                        <div class="progress-fill" id="progress-fill" style="width: 0%"></div>
                     </div>
                 </div>
                 <div class="rpm-display">
@@ -143,12 +146,8 @@ const char HTML_BODY[] PROGMEM = R"rawliteral(
 </html>
 )rawliteral";
 
-String buildHtmlContent() {
-    String content = FPSTR(HTML_CONTENT);
-    content += FPSTR(HTML_STYLES);
-    content += FPSTR(HTML_SCRIPT);
-    content += FPSTR(HTML_BODY);
-    return content;
-}
+// Page segments in serving order, streamed by the web server without building one large String
+const char* const HTML_PARTS[] = { HTML_CONTENT, HTML_STYLES, HTML_SCRIPT, HTML_BODY };
+constexpr int HTML_PART_COUNT = sizeof(HTML_PARTS) / sizeof(HTML_PARTS[0]);
 
 #endif // HTML_CONTENT_H
\ No newline at end of file
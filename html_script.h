@@ -1,22 +1,23 @@
 #ifndef HTML_SCRIPT_H
 #define HTML_SCRIPT_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 
 const char HTML_SCRIPT[] PROGMEM = R"rawliteral(
 <script>
+    const POLL_INTERVAL = 2000;     // Status poll period while the tab is visible
+    const MAX_BACKOFF = 30000;      // Longest wait between polls after failures
+
     const globalState = {
         lastTemperature: null,
-        lastHumidity: null,
         lastUpdateTime: null,
         errorCount: 0,
         maxErrors: 5,
-        updateInterval: null,
-        temperatureTrend: 'stable',
-        manualSpeed: 0,
-        retryDelay: 2000,
-        maxRetries: 3,
-        currentRetry: 0
+        pollTimer: null,
+        polling: false,
+        backoff: 0                  // Current delay after failures, 0 while the device answers
     };
 
     // Helper Functions
@@ -24,79 +25,112 @@ const char HTML_SCRIPT[] PROGMEM = R"rawliteral(
         return (typeof value === 'number' && !isNaN(value)) ? value.toFixed(decimals) : 'N/A';
     }
 
-    async function fetchWithRetry(url, options = {}) {
-        let lastError;
-        for (let i = 0; i <= globalState.maxRetries; i++) {
-            try {
-                const response = await fetch(url, options);
-                if (!response.ok) throw new Error(`HTTP error! status: ${response.status}`);
-                globalState.currentRetry = 0; // Reset on success
-                return response;
-            } catch (error) {
-                lastError = error;
-                console.warn(`Attempt ${i + 1} failed:`, error);
-                if (i < globalState.maxRetries) {
-                    await new Promise(resolve => setTimeout(resolve, globalState.retryDelay));
-                }
-            }
+    // Element references, looked up once
+    const elements = {};
+    function el(id) {
+        return elements[id] || (elements[id] = document.getElementById(id));
+    }
+
+    // Diff rendering: a write is only queued when the value differs from the last one written,
+    // and all queued writes are applied together in the next animation frame
+    const rendered = new Map();
+    const pendingWrites = new Map();
+    let frameRequested = false;
+
+    function write(key, value, apply) {
+        if (rendered.get(key) === value) return;
+        rendered.set(key, value);
+        pendingWrites.set(key, () => apply(value));
+        if (!frameRequested) {
+            frameRequested = true;
+            requestAnimationFrame(flushWrites);
+        }
+    }
+
+    function flushWrites() {
+        frameRequested = false;
+        pendingWrites.forEach(apply => apply());
+        pendingWrites.clear();
+    }
+
+    // Forget a written value after the user changed the control, so the next status rewrites it
+    function forget(key) {
+        rendered.delete(key);
+    }
+
+    function setText(id, text) {
+        write(id + '.text', text, value => { el(id).textContent = value; });
+    }
+
+    function setVisible(id, visible) {
+        write(id + '.display', visible ? 'block' : 'none', value => { el(id).style.display = value; });
+    }
+
+    function setClass(id, className) {
+        write(id + '.class', className, value => { el(id).className = value; });
+    }
+
+    function setStyle(id, property, text) {
+        write(id + '.' + property, text, value => { el(id).style[property] = value; });
+    }
+
+    function setProperty(id, property, propertyValue) {
+        write(id + '.' + property, propertyValue, value => { el(id)[property] = value; });
+    }
+
+    // Single attempt; failures are absorbed by the global poll backoff, not retried per request
+    async function request(url, options = {}) {
+        const response = await fetch(url, options);
+        if (!response.ok) throw new Error(`HTTP error! status: ${response.status}`);
+        return response;
+    }
+
+    async function postCommand(url, body) {
+        const options = { method: 'POST' };
+        if (body !== undefined) {
+            options.headers = { 'Content-Type': 'application/x-www-form-urlencoded' };
+            options.body = body;
         }
-        throw lastError;
+        await request(url, options);
     }
 
     // Mode Control Functions
     async function setAutoMode(isAuto) {
+        forget('mode-toggle.checked');
         try {
-            const response = await fetchWithRetry('/api/v1/fan/mode', {
-                method: 'POST',
-                headers: {
-                    'Content-Type': 'application/x-www-form-urlencoded',
-                },
-                body: `mode=${isAuto ? '1' : '0'}`
-            });
-
-            if (!response.ok) throw new Error('Failed to update mode');
-
+            await postCommand('/api/v1/fan/mode', `mode=${isAuto ? '1' : '0'}`);
             updateModeUI(isAuto);
-            await fetchAndUpdateStatus();
         } catch (error) {
             console.error('Error setting mode:', error);
             handleUpdateError(error.message);
         }
+        pollNow();
     }
 
     function updateModeUI(isAuto) {
-        document.getElementById('mode-label').textContent = isAuto ? 'Automatic' : 'Manual';
-        document.getElementById('manual-speed-control').style.display = isAuto ? 'none' : 'block';
-        document.getElementById('fan-toggle').style.display = isAuto ? 'none' : 'block';
+        setText('mode-label', isAuto ? 'Automatic' : 'Manual');
+        setVisible('manual-speed-control', !isAuto);
+        setVisible('fan-toggle', !isAuto);
     }
 
     // Fan Control Functions
     async function toggleFan() {
         try {
-            const response = await fetchWithRetry('/api/v1/fan/toggle', {
-                method: 'POST'
-            });
-
-            if (!response.ok) throw new Error('Failed to toggle fan');
-            await fetchAndUpdateStatus();
+            await postCommand('/api/v1/fan/toggle');
         } catch (error) {
             console.error('Error toggling fan:', error);
             handleUpdateError(error.message);
         }
+        pollNow();
     }
 
     async function updateManualSpeed(value) {
         const speed = value / 100;
-        document.getElementById('manual-speed').textContent = `${value}%`;
+        forget('speed-slider.value');
+        setText('manual-speed', `${value}%`);
 
         try {
-            await fetchWithRetry('/api/v1/fan/speed', {
-                method: 'POST',
-                headers: {
-                    'Content-Type': 'application/x-www-form-urlencoded',
-                },
-                body: `speed=${speed}`
-            });
+            await postCommand('/api/v1/fan/speed', `speed=${speed}`);
         } catch (error) {
             console.error('Error updating speed:', error);
             handleUpdateError(error.message);
@@ -105,16 +139,12 @@ const char HTML_SCRIPT[] PROGMEM = R"rawliteral(
 
     async function resetTemperatureRanges() {
         try {
-            const response = await fetchWithRetry('/api/v1/temperature/reset', {
-                method: 'POST'
-            });
-
-            if (!response.ok) throw new Error('Failed to reset temperature ranges');
-            await fetchAndUpdateStatus();
+            await postCommand('/api/v1/temperature/reset');
         } catch (error) {
             console.error('Error resetting temperature ranges:', error);
             handleUpdateError(error.message);
         }
+        pollNow();
     }
 
     // UI Update Functions
@@ -138,23 +168,23 @@ const char HTML_SCRIPT[] PROGMEM = R"rawliteral(
     }
 
     function updateSensorReadings(data) {
-        document.getElementById('temp-value').textContent = safeFixed(data.temperature, 1) + '°C';
-        document.getElementById('temp-min').textContent = 'Min: ' + safeFixed(data.min_temperature, 1) + '°C';
-        document.getElementById('temp-max').textContent = 'Max: ' + safeFixed(data.max_temperature, 1) + '°C';
-        document.getElementById('humidity-value').textContent = safeFixed(data.humidity, 1) + '%';
+        setText('temp-value', safeFixed(data.temperature, 1) + '°C');
+        setText('temp-min', 'Min: ' + safeFixed(data.min_temperature, 1) + '°C');
+        setText('temp-max', 'Max: ' + safeFixed(data.max_temperature, 1) + '°C');
+        setText('humidity-value', safeFixed(data.humidity, 1) + '%');
+        setText('dew-point', 'Dew point: ' + safeFixed(data.dew_point, 1) + '°C');
         
         updateTemperatureTrend(data.temperature);
     }
 
     function updateTemperatureTrend(currentTemp) {
-        const trendIndicator = document.getElementById('temp-trend');
         if (globalState.lastTemperature !== null) {
             if (currentTemp > globalState.lastTemperature + 0.1) {
-                trendIndicator.className = 'trend-indicator rising';
+                setClass('temp-trend', 'trend-indicator rising');
             } else if (currentTemp < globalState.lastTemperature - 0.1) {
-                trendIndicator.className = 'trend-indicator falling';
+                setClass('temp-trend', 'trend-indicator falling');
             } else {
-                trendIndicator.className = 'trend-indicator stable';
+                setClass('temp-trend', 'trend-indicator stable');
             }
         }
         globalState.lastTemperature = currentTemp;
@@ -162,112 +192,112 @@ const char HTML_SCRIPT[] PROGMEM = R"rawliteral(
 
     function updateFanControls(data) {
         // Fan status indicator
-        const fanStatus = document.getElementById('fan-status');
-        fanStatus.className = 'status-indicator ' + (data.fan_on ? 'status-on' : 'status-off');
+        setClass('fan-status', 'status-indicator ' + (data.fan_on ? 'status-on' : 'status-off'));
 
         // Fan toggle button
-        const fanToggle = document.getElementById('fan-toggle');
-        const fanButtonText = document.getElementById('fan-button-text');
-        fanToggle.style.display = data.auto_mode ? 'none' : 'block';
-        fanButtonText.textContent = data.fan_on ? 'Turn Fan Off' : 'Turn Fan On';
+        setVisible('fan-toggle', !data.auto_mode);
+        setText('fan-button-text', data.fan_on ? 'Turn Fan Off' : 'Turn Fan On');
 
         // Speed controls
-        const speedControl = document.getElementById('manual-speed-control');
-        speedControl.style.display = data.auto_mode ? 'none' : 'block';
+        setVisible('manual-speed-control', !data.auto_mode);
 
         // Update speed displays
         updateSpeedDisplays(data);
     }
 
     function updateSpeedDisplays(data) {
-        const progressFill = document.querySelector('.progress-fill');
-        const autoSpeed = document.getElementById('auto-speed');
         const speed = data.current_fan_speed * 100;
-        
-        progressFill.style.width = `${speed}%`;
-        autoSpeed.textContent = `${safeFixed(speed, 1)}%`;
+        setStyle('progress-fill', 'width', `${speed}%`);
+        setText('auto-speed', `${safeFixed(speed, 1)}%`);
 
         if (!data.auto_mode) {
-            const speedSlider = document.getElementById('speed-slider');
-            const manualSpeedDisplay = document.getElementById('manual-speed');
-            speedSlider.value = data.manual_fan_speed * 100;
-            manualSpeedDisplay.textContent = `${safeFixed(data.manual_fan_speed * 100, 1)}%`;
+            setProperty('speed-slider', 'value', data.manual_fan_speed * 100);
+            setText('manual-speed', `${safeFixed(data.manual_fan_speed * 100, 1)}%`);
         }
 
-        document.getElementById('fan-rpm').textContent = `${Math.round(data.fan_rpm)} RPM`;
+        setText('fan-rpm', `${Math.round(data.fan_rpm)} RPM`);
     }
 
     function updateOperationMode(data) {
-        const modeToggle = document.getElementById('mode-toggle');
-        const modeLabel = document.getElementById('mode-label');
-        const fanMode = document.getElementById('fan-mode');
-
-        modeToggle.checked = data.auto_mode;
-        modeLabel.textContent = data.auto_mode ? 'Automatic' : 'Manual';
-        fanMode.textContent = data.auto_mode_status;
+        setProperty('mode-toggle', 'checked', data.auto_mode);
+        setText('mode-label', data.auto_mode ? 'Automatic' : 'Manual');
+        setText('fan-mode', data.auto_mode_status);
     }
 
     function updateHeatRecoveryStats(data) {
-        if (data.heat_calc_active) {
-            document.getElementById('current-heat-power').textContent = safeFixed(data.current_heat_power, 1) + ' W';
-            document.getElementById('total-heat-energy').textContent = safeFixed(data.total_heat_energy, 3) + ' kWh';
-            document.getElementById('avg-heat-power').textContent = safeFixed(data.avg_heat_power, 1) + ' W';
-            document.getElementById('air-volume').textContent = safeFixed(data.air_volume_moved, 1) + ' m³';
-        } else {
-            document.querySelectorAll('.heat-stats .stat-value').forEach(el => {
-                el.textContent = 'N/A';
-            });
-        }
+        const active = data.heat_calc_active;
+        setText('current-heat-power', active ? safeFixed(data.current_heat_power, 1) + ' W' : 'N/A');
+        setText('total-heat-energy', active ? safeFixed(data.total_heat_energy, 3) + ' kWh' : 'N/A');
+        setText('avg-heat-power', active ? safeFixed(data.avg_heat_power, 1) + ' W' : 'N/A');
+        setText('air-volume', active ? safeFixed(data.air_volume_moved, 1) + ' m³' : 'N/A');
     }
 
     function updateSystemStats(data) {
-        document.getElementById('total-runtime').textContent = safeFixed(data.total_operating_time / 3600, 1) + ' Hours';
-        document.getElementById('fan-runtime').textContent = safeFixed(data.fan_operating_time / 3600, 1) + ' Hours';
-        document.getElementById('energy-usage').textContent = safeFixed(data.energy_usage, 1) + ' Wh';
+        setText('total-runtime', safeFixed(data.total_operating_time / 3600, 1) + ' Hours');
+        setText('fan-runtime', safeFixed(data.fan_operating_time / 3600, 1) + ' Hours');
+        setText('energy-usage', safeFixed(data.energy_usage, 1) + ' Wh');
     }
 
     function updateStatusMessages(data) {
-        const autoStatus = document.getElementById('auto-status');
-        autoStatus.textContent = data.auto_mode_status || 'System Ready';
-        autoStatus.style.color = data.error_state === 'OK' ? '' : '#dc3545';
+        setText('auto-status', data.auto_mode_status || 'System Ready');
+        setStyle('auto-status', 'color', data.error_state === 'OK' ? '' : '#dc3545');
     }
 
     // Error Handling
     function handleUpdateError(message) {
         console.error('Update error:', message);
         globalState.errorCount++;
-        const statusElement = document.getElementById('auto-status');
         
         if (globalState.errorCount >= globalState.maxErrors) {
-            statusElement.textContent = 'Error: ' + message;
-            statusElement.style.color = '#dc3545';
+            setText('auto-status', 'Error: ' + message);
+            setStyle('auto-status', 'color', '#dc3545');
         }
-
-        // Increase retry delay for subsequent attempts
-        globalState.retryDelay = Math.min(globalState.retryDelay * 1.5, 10000);
     }
 
+    // Polling: one request at a time, chained with setTimeout. Failures double one global
+    // backoff; polling stops while the tab is hidden and resumes with a fresh poll when shown.
     async function fetchAndUpdateStatus() {
+        if (globalState.polling) return;
+        globalState.polling = true;
         try {
-            const response = await fetchWithRetry('/api/v1/status');
+            const response = await request('/api/v1/status');
             const data = await response.json();
+            globalState.backoff = 0;
             updateUI(data);
-            globalState.retryDelay = 2000; // Reset retry delay on success
         } catch (error) {
+            globalState.backoff = Math.min(globalState.backoff ? globalState.backoff * 2 : POLL_INTERVAL * 2, MAX_BACKOFF);
             handleUpdateError('Failed to fetch status: ' + error.message);
+        } finally {
+            globalState.polling = false;
         }
+        schedulePoll(globalState.backoff || POLL_INTERVAL);
+    }
+
+    function schedulePoll(delay) {
+        clearTimeout(globalState.pollTimer);
+        globalState.pollTimer = null;
+        if (document.hidden) return;
+        globalState.pollTimer = setTimeout(fetchAndUpdateStatus, delay);
+    }
+
+    // Immediate refresh after a command, unless the device is backing off
+    function pollNow() {
+        if (!globalState.backoff) schedulePoll(0);
     }
 
     function initializeUpdates() {
-        if (globalState.updateInterval) clearInterval(globalState.updateInterval);
-        globalState.updateInterval = setInterval(fetchAndUpdateStatus, 2000);
         fetchAndUpdateStatus();
     }
 
     // Event Listeners
     window.addEventListener('load', initializeUpdates);
-    window.addEventListener('focus', () => {
-        fetchAndUpdateStatus(); // Immediate update when tab becomes active
+    document.addEventListener('visibilitychange', () => {
+        if (document.hidden) {
+            clearTimeout(globalState.pollTimer);
+            globalState.pollTimer = null;
+        } else {
+            schedulePoll(0); // Immediate update when the tab is shown again
+        }
     });
 </script>
 )rawliteral";
@@ -1,7 +1,9 @@
 #ifndef HTML_STYLES_H
 #define HTML_STYLES_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 
 const char HTML_STYLES[] PROGMEM = R"rawliteral(
 <style>
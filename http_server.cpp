@@ -0,0 +1,832 @@
+#include "config.h"
+
+#if FEATURE_REST_API
+#include "http_server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#ifdef ARDUINO
+#include <lwip/sockets.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+unsigned long nowMs() {
+#ifdef ARDUINO
+    return millis();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long>(ts.tv_sec) * 1000UL + ts.tv_nsec / 1000000L;
+#endif
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool wouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Locates the end of the header block ("\r\n\r\n"), returns the offset just past it or 0
+size_t findHeaderEnd(const char* data, size_t length) {
+    for (size_t i = 3; i < length; i++) {
+        if (data[i] == '\n' && data[i - 1] == '\r' && data[i - 2] == '\n' && data[i - 3] == '\r') {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Non-destructive scan for Content-Length, the header block is only tokenized once complete
+long findContentLength(const char* data, size_t headerEnd) {
+    static const char NAME[] = "content-length:";
+    const size_t nameLen = sizeof(NAME) - 1;
+    for (size_t i = 0; i + nameLen < headerEnd; i++) {
+        if ((i == 0 || data[i - 1] == '\n') && strncasecmp(data + i, NAME, nameLen) == 0) {
+            long value = 0;
+            size_t j = i + nameLen;
+            while (j < headerEnd && data[j] == ' ') j++;
+            if (j >= headerEnd || data[j] < '0' || data[j] > '9') return -1;
+            while (j < headerEnd && data[j] >= '0' && data[j] <= '9') {
+                value = value * 10 + (data[j] - '0');
+                if (value > 1000000L) return -1;
+                j++;
+            }
+            return value;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+HttpServer::HttpServer(uint16_t serverPort) : port(serverPort), arena(arenaMemory, ARENA_SIZE) {}
+
+HttpServer::~HttpServer() {
+    for (Connection& conn : connections) {
+        if (conn.state != ConnState::FREE) closeConnection(conn);
+    }
+    if (listenFd >= 0) close(listenFd);
+}
+
+bool HttpServer::begin() {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) return false;
+
+    int enable = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(listenFd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, MAX_CONNECTIONS) != 0 ||
+        !setNonBlocking(listenFd)) {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::on(const char* path, HttpMethod method, Handler handler) {
+    if (routeCount >= MAX_ROUTES) return;
+    routes[routeCount].path = path;
+    routes[routeCount].method = method;
+    routes[routeCount].handler = handler;
+    routeCount++;
+}
+
+void HttpServer::onNotFound(Handler handler) {
+    notFoundHandler = handler;
+}
+
+void HttpServer::handle() {
+    if (listenFd < 0) return;
+
+    acceptConnections();
+
+    unsigned long now = nowMs();
+    for (Connection& conn : connections) {
+        if (conn.state != ConnState::FREE) {
+            service(conn, now);
+        }
+    }
+}
+
+bool HttpServer::waitForActivity(unsigned long timeoutMs, int extraFd) {
+    if (listenFd < 0 && extraFd < 0) {
+#ifdef ARDUINO
+        delay(timeoutMs);
+#else
+        usleep(timeoutMs * 1000UL);
+#endif
+        return false;
+    }
+
+    fd_set readSet;
+    fd_set writeSet;
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+    int maxFd = -1;
+    if (listenFd >= 0) {
+        // Without a slot a pending client stays readable; wait until a connection may be evicted
+        unsigned long now = nowMs();
+        if (freeConnection() || idleKeepAliveConnection(now)) {
+            FD_SET(listenFd, &readSet);
+            maxFd = listenFd;
+        } else {
+            unsigned long evictable = msUntilEvictable(now);
+            if (evictable < timeoutMs) timeoutMs = evictable;
+        }
+    }
+    if (extraFd >= 0) {
+        FD_SET(extraFd, &readSet);
+        if (extraFd > maxFd) maxFd = extraFd;
+    }
+    for (const Connection& conn : connections) {
+        if (conn.state == ConnState::READING) FD_SET(conn.fd, &readSet);
+        else if (conn.state == ConnState::WRITING) FD_SET(conn.fd, &writeSet);
+        else if (conn.state == ConnState::DEFERRED && conn.rxLen < RX_BUFFER_SIZE) FD_SET(conn.fd, &readSet);
+        else continue;
+        if (conn.fd > maxFd) maxFd = conn.fd;
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    return select(maxFd + 1, &readSet, &writeSet, nullptr, &timeout) > 0;
+}
+
+HttpServer::Connection* HttpServer::freeConnection() {
+    for (Connection& conn : connections) {
+        if (conn.state == ConnState::FREE) return &conn;
+    }
+    return nullptr;
+}
+
+// Oldest keep-alive connection that has waited at least MIN_EVICT_IDLE for its next request,
+// if any; a client answered just before is likely to send again
+HttpServer::Connection* HttpServer::idleKeepAliveConnection(unsigned long now) {
+    Connection* oldest = nullptr;
+    for (Connection& conn : connections) {
+        if (conn.state == ConnState::READING && conn.rxLen == 0 && conn.requestCount > 0 &&
+            now - conn.lastActivity >= Config::WebServer::MIN_EVICT_IDLE &&
+            (!oldest || conn.lastActivity - oldest->lastActivity > 0x80000000UL)) {
+            oldest = &conn;
+        }
+    }
+    return oldest;
+}
+
+// Time until a waiting keep-alive connection becomes evictable, ULONG_MAX without one
+unsigned long HttpServer::msUntilEvictable(unsigned long now) const {
+    unsigned long wait = ULONG_MAX;
+    for (const Connection& conn : connections) {
+        if (conn.state == ConnState::READING && conn.rxLen == 0 && conn.requestCount > 0) {
+            unsigned long idle = now - conn.lastActivity;
+            unsigned long remaining =
+                idle >= Config::WebServer::MIN_EVICT_IDLE ? 0 : Config::WebServer::MIN_EVICT_IDLE - idle;
+            if (remaining < wait) wait = remaining;
+        }
+    }
+    return wait;
+}
+
+// A connection is pending in the listen backlog
+bool HttpServer::clientWaiting() const {
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(listenFd, &readSet);
+    struct timeval timeout = {0, 0};
+    return select(listenFd + 1, &readSet, nullptr, nullptr, &timeout) > 0;
+}
+
+// Ends the wait of the long-poll closest to its deadline so its slot frees up; the answer
+// closes the connection. Nothing changes while an expired one is still being answered.
+void HttpServer::expireDeferred(unsigned long now) {
+    Connection* first = nullptr;
+    for (Connection& conn : connections) {
+        if (conn.state != ConnState::DEFERRED) continue;
+        if (static_cast<long>(now - conn.deferDeadline) >= 0) return;
+        if (!first || static_cast<long>(conn.deferDeadline - first->deferDeadline) < 0) first = &conn;
+    }
+    if (first) {
+        first->deferDeadline = now;
+        first->keepAlive = false;
+    }
+}
+
+void HttpServer::acceptConnections() {
+    while (true) {
+        unsigned long now = nowMs();
+        Connection* slot = freeConnection();
+        Connection* evict = slot ? nullptr : idleKeepAliveConnection(now);
+        if (!slot && !evict) {
+            // Leave further clients in the listen backlog; a long-poll makes room for them
+            if (clientWaiting()) expireDeferred(now);
+            return;
+        }
+
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return;
+
+        if (evict) {
+            closeConnection(*evict);
+            slot = evict;
+        }
+
+        setNonBlocking(fd);
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        slot->fd = fd;
+        slot->state = ConnState::READING;
+        slot->keepAlive = false;
+        slot->requestCount = 0;
+        slot->lastActivity = nowMs();
+        slot->requestStart = slot->lastActivity;
+        slot->rxLen = 0;
+        slot->requestLen = 0;
+        slot->txLen = slot->txSent = 0;
+        slot->staticCount = slot->staticIndex = 0;
+        slot->staticSent = 0;
+        connectionsAccepted++;
+    }
+}
+
+void HttpServer::service(Connection& conn, unsigned long now) {
+    if (conn.state == ConnState::DEFERRED) {
+        readDeferred(conn);
+        return;
+    }
+
+    if (conn.state == ConnState::READING) {
+        readFrom(conn, now);
+        if (conn.state != ConnState::READING) return;
+
+        if (conn.rxLen > 0 || conn.requestCount == 0) {
+            if (now - conn.requestStart > Config::WebServer::REQUEST_TIMEOUT) {
+                requestsRejected++;
+                sendDirect(conn, 408, "Request Timeout");
+            }
+        } else if (now - conn.lastActivity > Config::WebServer::KEEP_ALIVE_TIMEOUT) {
+            closeConnection(conn);
+        }
+    }
+
+    if (conn.state == ConnState::WRITING) {
+        writeTo(conn, now);
+        if (conn.state == ConnState::WRITING &&
+            now - conn.lastActivity > Config::WebServer::REQUEST_TIMEOUT) {
+            closeConnection(conn);  // Client stopped reading
+        }
+    }
+}
+
+void HttpServer::readFrom(Connection& conn, unsigned long now) {
+    if (conn.rxLen < RX_BUFFER_SIZE) {
+        ssize_t received = recv(conn.fd, conn.rx + conn.rxLen, RX_BUFFER_SIZE - conn.rxLen, 0);
+        if (received == 0) {
+            // Half-closed after sending: answer a buffered request first, the next pass
+            // closes once nothing complete is left
+            if (conn.rxLen == 0 || (!tryParseAndDispatch(conn) && conn.state == ConnState::READING)) {
+                closeConnection(conn);
+            }
+            return;
+        }
+        if (received < 0) {
+            if (!wouldBlock()) closeConnection(conn);
+            if (conn.state == ConnState::FREE || conn.rxLen == 0) return;
+        } else {
+            if (conn.rxLen == 0) conn.requestStart = now;
+            conn.rxLen += received;
+            conn.lastActivity = now;
+        }
+    }
+    tryParseAndDispatch(conn);
+}
+
+// The parked request keeps its strings in rx, later bytes are stored after it. End of stream
+// means the client gave up waiting and frees the slot.
+void HttpServer::readDeferred(Connection& conn) {
+    if (conn.rxLen >= RX_BUFFER_SIZE) return;
+    ssize_t received = recv(conn.fd, conn.rx + conn.rxLen, RX_BUFFER_SIZE - conn.rxLen, 0);
+    if (received == 0 || (received < 0 && !wouldBlock())) {
+        closeConnection(conn);
+        return;
+    }
+    if (received < 0) return;
+    if (conn.rxLen == conn.requestLen) {
+        // The first byte replaced the terminator of the parked request
+        conn.savedByte = conn.rx[conn.requestLen];
+        conn.rx[conn.requestLen] = '\0';
+    }
+    conn.rxLen += received;
+}
+
+bool HttpServer::tryParseAndDispatch(Connection& conn) {
+    size_t headerEnd = findHeaderEnd(conn.rx, conn.rxLen);
+    if (headerEnd == 0) {
+        if (conn.rxLen >= RX_BUFFER_SIZE) {
+            requestsRejected++;
+            sendDirect(conn, 431, "Request Header Fields Too Large");
+        }
+        return false;
+    }
+
+    long contentLength = findContentLength(conn.rx, headerEnd);
+    if (contentLength < 0) {
+        requestsRejected++;
+        sendDirect(conn, 400, "Bad Request");
+        return false;
+    }
+    if (headerEnd + contentLength > RX_BUFFER_SIZE) {
+        requestsRejected++;
+        sendDirect(conn, 413, "Payload Too Large");
+        return false;
+    }
+    if (conn.rxLen < headerEnd + contentLength) {
+        return false;  // Body still arriving
+    }
+
+    conn.requestLen = headerEnd + contentLength;
+    current = &conn;
+    if (!parseRequest(conn, headerEnd, contentLength)) {
+        current = nullptr;
+        requestsRejected++;
+        sendDirect(conn, 400, "Bad Request");
+        return false;
+    }
+
+    dispatch();
+    if (!request.responded && request.deferred) {
+        conn.parked = request;
+        arena.reset();
+        current = nullptr;
+        conn.state = ConnState::DEFERRED;
+        return true;
+    }
+    if (!request.responded) {
+        send(500, "text/plain", "No response");
+    }
+    arena.reset();  // The response has been copied to the connection buffer
+    current = nullptr;
+    conn.state = ConnState::WRITING;
+    return true;
+}
+
+bool HttpServer::parseRequest(Connection& conn, size_t headerEnd, size_t bodyLength) {
+    request = Request();
+    extraHeadersLen = 0;
+    extraHeaders[0] = '\0';
+
+    // Terminate the body so it can be parsed as a string; the byte after it belongs to a
+    // pipelined request and is restored in finishRequest()
+    char* body = conn.rx + headerEnd;
+    conn.savedByte = conn.rx[conn.requestLen];
+    conn.rx[conn.requestLen] = '\0';
+    conn.rx[headerEnd - 2] = '\0';
+
+    // Request line
+    char* line = conn.rx;
+    char* lineEnd = strstr(line, "\r\n");
+    if (!lineEnd) return false;
+    *lineEnd = '\0';
+
+    char* methodText = line;
+    char* uriText = strchr(methodText, ' ');
+    if (!uriText) return false;
+    *uriText++ = '\0';
+    char* versionText = strchr(uriText, ' ');
+    if (!versionText) return false;
+    *versionText++ = '\0';
+
+    request.method = parseMethod(methodText);
+    conn.keepAlive = strcmp(versionText, "HTTP/1.1") == 0;
+
+    char* query = strchr(uriText, '?');
+    if (query) *query++ = '\0';
+    request.uri = uriText;
+
+    // Header lines
+    line = lineEnd + 2;
+    while (*line) {
+        lineEnd = strstr(line, "\r\n");
+        if (lineEnd) *lineEnd = '\0';
+
+        char* colon = strchr(line, ':');
+        if (colon && request.headerCount < MAX_HEADERS) {
+            *colon = '\0';
+            char* value = colon + 1;
+            while (*value == ' ') value++;
+            request.headerNames[request.headerCount] = line;
+            request.headerValues[request.headerCount] = value;
+            request.headerCount++;
+        }
+
+        if (!lineEnd) break;
+        line = lineEnd + 2;
+    }
+
+    const char* connection = header("Connection");
+    if (connection) {
+        if (strcasecmp(connection, "close") == 0) conn.keepAlive = false;
+        else if (strcasecmp(connection, "keep-alive") == 0) conn.keepAlive = true;
+    }
+    if (conn.requestCount + 1 >= Config::WebServer::MAX_KEEP_ALIVE_REQUESTS) {
+        conn.keepAlive = false;
+    }
+
+    if (query) parseArgs(query);
+
+    const char* contentType = header("Content-Type");
+    if (bodyLength > 0 &&
+        (!contentType || strncasecmp(contentType, "application/x-www-form-urlencoded", 33) == 0)) {
+        parseArgs(body);
+    }
+    return true;
+}
+
+void HttpServer::parseArgs(char* text) {
+    while (text && *text && request.argCount < MAX_ARGS) {
+        char* next = strchr(text, '&');
+        if (next) *next++ = '\0';
+
+        char* value = strchr(text, '=');
+        if (value) *value++ = '\0';
+        else value = text + strlen(text);
+
+        urlDecode(text);
+        urlDecode(value);
+        if (*text) {
+            request.argNames[request.argCount] = text;
+            request.argValues[request.argCount] = value;
+            request.argCount++;
+        }
+        text = next;
+    }
+}
+
+void HttpServer::dispatch() {
+    int index = -1;
+    for (int i = 0; i < routeCount; i++) {
+        if (strcmp(routes[i].path, request.uri) == 0 &&
+            (routes[i].method == HttpMethod::ANY || routes[i].method == request.method)) {
+            index = i;
+            break;
+        }
+    }
+    current->routeIndex = index;
+    invokeRoute(index);
+}
+
+void HttpServer::invokeRoute(int index) {
+    if (index >= 0) {
+        routes[index].handler();
+    } else if (notFoundHandler) {
+        notFoundHandler();
+    } else {
+        send(404, "text/plain", "Not Found");
+    }
+}
+
+bool HttpServer::defer(unsigned long timeoutMs) {
+    if (!current || request.responded) return false;
+    // The deadline is fixed when the request is first parked
+    if (current->state != ConnState::DEFERRED) {
+        if (deferredCount() >= MAX_DEFERRED) return false;
+        if (timeoutMs > Config::WebServer::MAX_LONG_POLL_WAIT) timeoutMs = Config::WebServer::MAX_LONG_POLL_WAIT;
+        current->deferDeadline = nowMs() + timeoutMs;
+    }
+    request.deferred = true;
+    return true;
+}
+
+bool HttpServer::deferExpired() const {
+    return current && current->state == ConnState::DEFERRED &&
+           static_cast<long>(nowMs() - current->deferDeadline) >= 0;
+}
+
+void HttpServer::resumeDeferred() {
+    for (Connection& conn : connections) {
+        if (conn.state != ConnState::DEFERRED) continue;
+
+        current = &conn;
+        request = conn.parked;
+        request.responded = false;
+        request.deferred = false;
+        extraHeadersLen = 0;
+        extraHeaders[0] = '\0';
+
+        invokeRoute(conn.routeIndex);
+        if (!request.responded && request.deferred && !deferExpired()) {
+            arena.reset();
+            current = nullptr;
+            continue;  // Still waiting
+        }
+        if (!request.responded) {
+            send(500, "text/plain", "No response");
+        }
+        arena.reset();
+        current = nullptr;
+        conn.lastActivity = nowMs();
+        conn.state = ConnState::WRITING;
+    }
+}
+
+int HttpServer::deferredCount() const {
+    int count = 0;
+    for (const Connection& conn : connections) {
+        if (conn.state == ConnState::DEFERRED) count++;
+    }
+    return count;
+}
+
+void HttpServer::writeTo(Connection& conn, unsigned long now) {
+    while (conn.txSent < conn.txLen) {
+        ssize_t sent = ::send(conn.fd, conn.tx + conn.txSent, conn.txLen - conn.txSent, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            if (sent < 0 && !wouldBlock()) closeConnection(conn);
+            return;
+        }
+        conn.txSent += sent;
+        conn.lastActivity = now;
+    }
+
+    while (conn.staticIndex < conn.staticCount) {
+        const char* part = conn.staticParts[conn.staticIndex];
+        size_t remaining = conn.staticLengths[conn.staticIndex] - conn.staticSent;
+        if (remaining == 0) {
+            conn.staticIndex++;
+            conn.staticSent = 0;
+            continue;
+        }
+        // Bound each write so one large page does not monopolize the loop pass
+        size_t chunk = remaining < TX_BUFFER_SIZE ? remaining : TX_BUFFER_SIZE;
+        ssize_t sent = ::send(conn.fd, part + conn.staticSent, chunk, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            if (sent < 0 && !wouldBlock()) closeConnection(conn);
+            return;
+        }
+        conn.staticSent += sent;
+        conn.lastActivity = now;
+        if (static_cast<size_t>(sent) < chunk) return;  // Socket buffer full
+    }
+
+    finishRequest(conn);
+}
+
+void HttpServer::finishRequest(Connection& conn) {
+    requestsServed++;
+    conn.requestCount++;
+
+    if (!conn.keepAlive) {
+        closeConnection(conn);
+        return;
+    }
+
+    // Keep pipelined bytes that followed the request
+    if (conn.requestLen > 0) {
+        conn.rx[conn.requestLen] = conn.savedByte;
+        memmove(conn.rx, conn.rx + conn.requestLen, conn.rxLen - conn.requestLen);
+        conn.rxLen -= conn.requestLen;
+        conn.requestLen = 0;
+    }
+    conn.txLen = conn.txSent = 0;
+    conn.staticCount = conn.staticIndex = 0;
+    conn.staticSent = 0;
+    conn.state = ConnState::READING;
+    conn.requestStart = conn.lastActivity = nowMs();
+}
+
+void HttpServer::closeConnection(Connection& conn) {
+    if (conn.fd >= 0) {
+        close(conn.fd);
+    }
+    conn.fd = -1;
+    conn.state = ConnState::FREE;
+    conn.rxLen = conn.requestLen = 0;
+    conn.txLen = conn.txSent = 0;
+    conn.staticCount = 0;
+}
+
+// Error response outside of a handler, always closes the connection afterwards
+void HttpServer::sendDirect(Connection& conn, int code, const char* message) {
+    current = &conn;
+    request = Request();
+    extraHeadersLen = 0;
+    extraHeaders[0] = '\0';
+    conn.requestLen = 0;
+    conn.keepAlive = false;
+    send(code, "text/plain", message);
+    current = nullptr;
+    conn.state = ConnState::WRITING;
+}
+
+bool HttpServer::beginResponse(int code, const char* contentType, size_t contentLength) {
+    Connection& conn = *current;
+    int written = snprintf(conn.tx, TX_BUFFER_SIZE, "HTTP/1.1 %d %s\r\nConnection: %s\r\n",
+                           code, statusText(code), conn.keepAlive ? "keep-alive" : "close");
+    // 204 and 304 carry no body and no Content-Length
+    if (code != 204 && code != 304 && written > 0 && static_cast<size_t>(written) < TX_BUFFER_SIZE) {
+        written += snprintf(conn.tx + written, TX_BUFFER_SIZE - written, "Content-Length: %u\r\n",
+                            static_cast<unsigned>(contentLength));
+    }
+    if (contentType && written > 0 && static_cast<size_t>(written) < TX_BUFFER_SIZE) {
+        written += snprintf(conn.tx + written, TX_BUFFER_SIZE - written, "Content-Type: %s\r\n",
+                            contentType);
+    }
+    if (written > 0 && static_cast<size_t>(written) < TX_BUFFER_SIZE) {
+        written += snprintf(conn.tx + written, TX_BUFFER_SIZE - written, "%s\r\n", extraHeaders);
+    }
+    if (written <= 0 || static_cast<size_t>(written) >= TX_BUFFER_SIZE) {
+        conn.txLen = 0;
+        return false;
+    }
+
+    conn.txLen = written;
+    conn.txSent = 0;
+    conn.staticCount = conn.staticIndex = 0;
+    conn.staticSent = 0;
+    return true;
+}
+
+void HttpServer::sendHeader(const char* name, const char* value) {
+    if (!current) return;
+    int written = snprintf(extraHeaders + extraHeadersLen, EXTRA_HEADERS_SIZE - extraHeadersLen,
+                           "%s: %s\r\n", name, value);
+    if (written > 0 && extraHeadersLen + written < EXTRA_HEADERS_SIZE) {
+        extraHeadersLen += written;
+    } else {
+        extraHeaders[extraHeadersLen] = '\0';  // Drop headers that do not fit
+    }
+}
+
+void HttpServer::send(int code, const char* contentType, const char* body) {
+    send(code, contentType, body, body ? strlen(body) : 0);
+}
+
+void HttpServer::send(int code, const char* contentType, const char* body, size_t length) {
+    if (!current || request.responded) return;
+    request.responded = true;
+
+    Connection& conn = *current;
+    if (beginResponse(code, contentType, length) && conn.txLen + length <= TX_BUFFER_SIZE) {
+        if (length > 0) memcpy(conn.tx + conn.txLen, body, length);
+        conn.txLen += length;
+        return;
+    }
+
+    // Response does not fit the connection buffer
+    requestsRejected++;
+    extraHeadersLen = 0;
+    extraHeaders[0] = '\0';
+    conn.keepAlive = false;
+    static const char OVERFLOW_BODY[] = "Response too large";
+    beginResponse(500, "text/plain", sizeof(OVERFLOW_BODY) - 1);
+    memcpy(conn.tx + conn.txLen, OVERFLOW_BODY, sizeof(OVERFLOW_BODY) - 1);
+    conn.txLen += sizeof(OVERFLOW_BODY) - 1;
+}
+
+void HttpServer::send(int code, const char* contentType, const TextWriter& body) {
+    if (body.overflowed()) {
+        requestsRejected++;
+        send(500, "text/plain", "Response too large");
+        return;
+    }
+    send(code, contentType, body.c_str(), body.length());
+}
+
+void HttpServer::sendStatic(int code, const char* contentType, const char* const* parts, int partCount) {
+    if (!current || request.responded) return;
+    if (partCount > MAX_STATIC_PARTS) partCount = MAX_STATIC_PARTS;
+
+    size_t total = 0;
+    size_t lengths[MAX_STATIC_PARTS];
+    for (int i = 0; i < partCount; i++) {
+        lengths[i] = strlen(parts[i]);
+        total += lengths[i];
+    }
+
+    if (!beginResponse(code, contentType, total)) {
+        send(500, "text/plain", "Response too large");
+        return;
+    }
+    request.responded = true;
+
+    Connection& conn = *current;
+    for (int i = 0; i < partCount; i++) {
+        conn.staticParts[i] = parts[i];
+        conn.staticLengths[i] = lengths[i];
+    }
+    conn.staticCount = partCount;
+}
+
+const char* HttpServer::argName(int index) const {
+    return (index >= 0 && index < request.argCount) ? request.argNames[index] : "";
+}
+
+const char* HttpServer::arg(int index) const {
+    return (index >= 0 && index < request.argCount) ? request.argValues[index] : "";
+}
+
+const char* HttpServer::arg(const char* name) const {
+    for (int i = 0; i < request.argCount; i++) {
+        if (strcmp(request.argNames[i], name) == 0) return request.argValues[i];
+    }
+    return "";
+}
+
+bool HttpServer::hasArg(const char* name) const {
+    for (int i = 0; i < request.argCount; i++) {
+        if (strcmp(request.argNames[i], name) == 0) return true;
+    }
+    return false;
+}
+
+const char* HttpServer::header(const char* name) const {
+    for (int i = 0; i < request.headerCount; i++) {
+        if (strcasecmp(request.headerNames[i], name) == 0) return request.headerValues[i];
+    }
+    return nullptr;
+}
+
+int HttpServer::activeConnections() const {
+    int count = 0;
+    for (const Connection& conn : connections) {
+        if (conn.state != ConnState::FREE) count++;
+    }
+    return count;
+}
+
+HttpMethod HttpServer::parseMethod(const char* text) {
+    if (strcmp(text, "GET") == 0) return HttpMethod::GET;
+    if (strcmp(text, "POST") == 0) return HttpMethod::POST;
+    if (strcmp(text, "OPTIONS") == 0) return HttpMethod::OPTIONS;
+    return HttpMethod::OTHER;
+}
+
+const char* HttpServer::statusText(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "Unknown";
+    }
+}
+
+void HttpServer::urlDecode(char* text) {
+    char* out = text;
+    for (char* in = text; *in; in++) {
+        if (*in == '+') {
+            *out++ = ' ';
+        } else if (*in == '%' && hexValue(in[1]) >= 0 && hexValue(in[2]) >= 0) {
+            *out++ = static_cast<char>(hexValue(in[1]) * 16 + hexValue(in[2]));
+            in += 2;
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+}
+
+#endif // FEATURE_REST_API
@@ -0,0 +1,209 @@
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include "config.h"
+#include "arena.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+enum class HttpMethod : uint8_t {
+    ANY,
+    GET,
+    POST,
+    OPTIONS,
+    OTHER
+};
+
+// Event-driven HTTP/1.1 server on non-blocking BSD sockets (lwIP on the ESP32, POSIX on a host).
+// handle() never blocks: each call accepts pending clients, reads what has arrived and writes
+// what the socket takes. Several connections are served concurrently with keep-alive, bounded
+// per-connection buffers and request/idle timeouts. The request/response accessors mirror the
+// Arduino WebServer interface and refer to the request currently being dispatched.
+// Handlers build their responses in a fixed per-request arena (text()) instead of the heap.
+class HttpServer {
+public:
+    using Handler = std::function<void()>;
+
+private:
+    static constexpr int MAX_CONNECTIONS = Config::WebServer::MAX_CONNECTIONS;
+    static constexpr int MAX_DEFERRED = MAX_CONNECTIONS - 1;   // One slot stays for other clients
+    static constexpr size_t RX_BUFFER_SIZE = Config::WebServer::RX_BUFFER_SIZE;
+    static constexpr size_t TX_BUFFER_SIZE = Config::WebServer::TX_BUFFER_SIZE;
+    static constexpr size_t ARENA_SIZE = Config::WebServer::ARENA_SIZE;
+    static constexpr int MAX_ROUTES = 40;
+    static constexpr int MAX_ARGS = 8;
+    static constexpr int MAX_HEADERS = 16;
+    static constexpr int MAX_STATIC_PARTS = 4;
+    static constexpr size_t EXTRA_HEADERS_SIZE = 384;
+
+    enum class ConnState : uint8_t {
+        FREE,
+        READING,
+        WRITING,
+        DEFERRED                        // Request parked by its handler until resumed
+    };
+
+    struct Request {
+        HttpMethod method = HttpMethod::OTHER;
+        const char* uri = "";
+        const char* argNames[MAX_ARGS];
+        const char* argValues[MAX_ARGS];
+        int argCount = 0;
+        const char* headerNames[MAX_HEADERS];
+        const char* headerValues[MAX_HEADERS];
+        int headerCount = 0;
+        bool responded = false;
+        bool deferred = false;
+    };
+
+    struct Connection {
+        int fd = -1;
+        ConnState state = ConnState::FREE;
+        bool keepAlive = false;
+        uint16_t requestCount = 0;
+        unsigned long lastActivity = 0;
+        unsigned long requestStart = 0;
+
+        char rx[RX_BUFFER_SIZE + 1];
+        size_t rxLen = 0;
+        size_t requestLen = 0;          // Bytes of rx consumed by the request being served
+        char savedByte = 0;             // First byte after the request, overwritten by a terminator
+
+        char tx[TX_BUFFER_SIZE];
+        size_t txLen = 0;
+        size_t txSent = 0;
+        const char* staticParts[MAX_STATIC_PARTS];
+        size_t staticLengths[MAX_STATIC_PARTS];
+        int staticCount = 0;
+        int staticIndex = 0;
+        size_t staticSent = 0;
+
+        // Deferred request; its strings still point into rx, which is left untouched meanwhile
+        Request parked;
+        int routeIndex = -1;
+        unsigned long deferDeadline = 0;
+    };
+
+    struct Route {
+        const char* path;
+        HttpMethod method;
+        Handler handler;
+    };
+
+    uint16_t port;
+    int listenFd = -1;
+    Connection connections[MAX_CONNECTIONS];
+    Route routes[MAX_ROUTES];
+    int routeCount = 0;
+    Handler notFoundHandler;
+
+    // State of the request currently being dispatched
+    Connection* current = nullptr;
+    Request request;
+    char extraHeaders[EXTRA_HEADERS_SIZE];
+    size_t extraHeadersLen = 0;
+
+    // Scratch memory of the request being dispatched, released after each response
+    char arenaMemory[ARENA_SIZE];
+    Arena arena;
+
+    // Counters
+    uint32_t requestsServed = 0;
+    uint32_t requestsRejected = 0;
+    uint32_t connectionsAccepted = 0;
+
+    void acceptConnections();
+    Connection* freeConnection();
+    Connection* idleKeepAliveConnection(unsigned long now);
+    unsigned long msUntilEvictable(unsigned long now) const;
+    bool clientWaiting() const;
+    void expireDeferred(unsigned long now);
+    void service(Connection& conn, unsigned long now);
+    void readFrom(Connection& conn, unsigned long now);
+    void readDeferred(Connection& conn);
+    void writeTo(Connection& conn, unsigned long now);
+    bool tryParseAndDispatch(Connection& conn);
+    bool parseRequest(Connection& conn, size_t headerEnd, size_t bodyLength);
+    void parseArgs(char* text);
+    void dispatch();
+    void invokeRoute(int index);
+    void finishRequest(Connection& conn);
+    void closeConnection(Connection& conn);
+    void sendDirect(Connection& conn, int code, const char* message);
+    bool beginResponse(int code, const char* contentType, size_t contentLength);
+
+    static HttpMethod parseMethod(const char* text);
+    static const char* statusText(int code);
+    static void urlDecode(char* text);
+
+public:
+    explicit HttpServer(uint16_t serverPort);
+    ~HttpServer();
+
+    bool begin();
+    void handle();
+    // Blocks up to timeoutMs until a client connects, a connection becomes ready or
+    // data arrives on extraFd (another socket the caller serves, -1 for none)
+    bool waitForActivity(unsigned long timeoutMs, int extraFd = -1);
+
+    void on(const char* path, HttpMethod method, Handler handler);
+    void onNotFound(Handler handler);
+
+    // Request accessors, valid inside a handler
+    const char* uri() const { return request.uri; }
+    HttpMethod method() const { return request.method; }
+    int args() const { return request.argCount; }
+    const char* argName(int index) const;
+    const char* arg(int index) const;
+    const char* arg(const char* name) const;
+    bool hasArg(const char* name) const;
+    const char* header(const char* name) const;
+
+    // Scratch text in the request arena, valid until the handler returns
+    TextWriter text() { return arena.text(); }
+    Arena& scratch() { return arena; }
+
+    // Response, exactly one send per request
+    void sendHeader(const char* name, const char* value);
+    void send(int code, const char* contentType = nullptr, const char* body = nullptr);
+    void send(int code, const char* contentType, const char* body, size_t length);
+    // Body built in the request arena; an overflowed writer is answered with 500
+    void send(int code, const char* contentType, const TextWriter& body);
+    // Body made of constant segments (e.g. flash resources) that are streamed without copying
+    void sendStatic(int code, const char* contentType, const char* const* parts, int partCount);
+
+#ifdef ARDUINO
+    void sendHeader(const String& name, const String& value) {
+        sendHeader(name.c_str(), value.c_str());
+    }
+    void send(int code, const char* contentType, const String& body) {
+        send(code, contentType, body.c_str(), body.length());
+    }
+#endif
+
+    // Long-poll: instead of responding, a handler may defer the request. resumeDeferred()
+    // invokes the handler again (with the same arguments) until it responds; once the
+    // timeout has passed deferExpired() is true and the handler must answer.
+    // Returns false when MAX_DEFERRED requests already wait; the handler answers at once then.
+    // Headers set before defer() are dropped.
+    bool defer(unsigned long timeoutMs);
+    bool deferExpired() const;
+    void resumeDeferred();
+    int deferredCount() const;
+
+    // Statistics
+    int activeConnections() const;
+    uint32_t getRequestsServed() const { return requestsServed; }
+    uint32_t getRequestsRejected() const { return requestsRejected; }
+    uint32_t getConnectionsAccepted() const { return connectionsAccepted; }
+    size_t getArenaSize() const { return arena.size(); }
+    size_t getArenaHighWater() const { return arena.getHighWater(); }
+    uint32_t getArenaOverflows() const { return arena.getOverflows(); }
+};
+
+#endif // HTTP_SERVER_H
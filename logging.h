@@ -0,0 +1,18 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Serial debug output; compiles to nothing (arguments and strings included) without FEATURE_LOGGING
+#if FEATURE_LOGGING
+#define LOG_BEGIN(baud) Serial.begin(baud)
+#define LOG_PRINT(...) Serial.print(__VA_ARGS__)
+#define LOG_PRINTLN(...) Serial.println(__VA_ARGS__)
+#else
+#define LOG_BEGIN(baud) do {} while (0)
+#define LOG_PRINT(...) do {} while (0)
+#define LOG_PRINTLN(...) do {} while (0)
+#endif
+
+#endif // LOGGING_H
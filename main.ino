@@ -1,23 +1,75 @@
 #include <Arduino.h>
-#include <WiFi.h>
 #include <Wire.h>
-#include <driver/ledc.h>  // For PWM control
 #include <Adafruit_SHT4x.h>
 #include "config.h"
+#include "logging.h"
 #include "sensor_manager.h"
-#include "web_server.h"
 #include "system_status.h"
 #include "fan_controller.h"
+#include "pwm_driver.h"
+#include "fan_model.h"
+#include "fan_curve.h"
+#include "activity_scheduler.h"
+#include "timekeeper.h"
+#include "power_manager.h"
+#include "fan_health.h"
+#include "fan_commands.h"
+#include "watchdog.h"
+#include "sensor_bus.h"
+#include "safety_monitor.h"
+#include "event_log.h"
+#include "wifi_manager.h"
+#if FEATURE_REST_API
+#include "web_server.h"
+#endif
+#if FEATURE_STATISTICS
+#include "energy_meter.h"
+#include "burn_sessions.h"
+#endif
+#if FEATURE_MQTT
+#include "mqtt_manager.h"
+#endif
 
 // Global objects
+RTC_NOINIT_ATTR Watchdog::Record watchdogRecord; // Forensic record, survives resets
+Watchdog watchdog(watchdogRecord);         // Task watchdog and subsystem heartbeats
 Adafruit_SHT4x sht4;                       // Temperature sensor
+SensorBus sensorBus(sht4);                 // Sensor access shared by the loop and the safety task
 SystemStatus systemStatus;                 // System status
-FanController fanController(systemStatus); // Fan controller
-SensorManager sensorManager(sht4, systemStatus, fanController); // Sensor manager
-WebServerManager webServer(systemStatus, fanController); // Web server
+WifiManager wifi(systemStatus);            // Background WiFi connection with backoff
+Timekeeper timekeeper;                     // SNTP clock with cached calendar state
+ActivityScheduler activityScheduler(timekeeper); // Learned activity check schedule
+PwmDriver pwm;                             // Fan PWM output (LEDC) with dithering
+FanModel fanModel;                         // Calibrated duty -> RPM table of the fan
+FanCurve fanCurve;                         // User temperature -> speed curve
+FanController fanController(systemStatus, activityScheduler, pwm, fanModel, fanCurve); // Fan controller
+SafetyMonitor safetyMonitor(sensorBus, pwm); // Independent over-temperature protection
+SensorManager sensorManager(sensorBus, systemStatus, fanController); // Sensor manager
+FanHealthMonitor fanHealth(systemStatus);  // Airflow degradation detector
+FanCommands fanCommands(systemStatus, fanController, fanHealth, safetyMonitor); // Control actions for REST and MQTT
+#if FEATURE_STATISTICS
+BurnSessionTracker burnSessions(systemStatus, timekeeper); // Per-fire statistics and rollups
+EnergyMeter energyMeter(systemStatus, burnSessions, timekeeper); // Fan energy accounting
+#endif
+#if FEATURE_REST_API && FEATURE_STATISTICS
+WebServerManager webServer(systemStatus, fanCommands, watchdog, safetyMonitor, fanModel, fanCurve, energyMeter,
+                           burnSessions); // Web server
+#elif FEATURE_REST_API
+WebServerManager webServer(systemStatus, fanCommands, watchdog, safetyMonitor, fanModel, fanCurve); // Web server
+#endif
+#if FEATURE_MQTT
+MqttManager mqtt(systemStatus, fanCommands); // MQTT telemetry and commands
+#endif
+#if FEATURE_REST_API
+PowerManager powerManager(systemStatus, fanController, safetyMonitor, webServer); // Sleep between events
+#else
+PowerManager powerManager(systemStatus, fanController, safetyMonitor); // Sleep between events
+#endif
 unsigned long tachoLastPulse = 0;          // Timestamp of last tachometer pulse
 volatile unsigned long tachoPulses = 0;    // Number of tachometer pulses
+#if FEATURE_STATISTICS
 unsigned long lastStatsUpdate = 0;         // Timestamp of last statistics update
+#endif
 
 // Interrupt handler for tachometer sensor
 void IRAM_ATTR handleTachoInterrupt() {
@@ -34,114 +86,165 @@ void initializeHardware() {
     Wire.begin(Config::Pins::I2C_SDA, Config::Pins::I2C_SCL);
     
     // Initialize Serial
-    Serial.begin(Config::System::SERIAL_BAUD);
+    LOG_BEGIN(Config::System::SERIAL_BAUD);
 
     // Configure MOSFET pin
     pinMode(Config::Pins::MOSFET_PIN, OUTPUT);
     digitalWrite(Config::Pins::MOSFET_PIN, LOW);  // Default to off
 
-    // LEDC timer configuration for PWM
-    ledc_timer_config_t ledcTimer = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = static_cast<ledc_timer_bit_t>(Config::PWM::RESOLUTION),
-        .timer_num = LEDC_TIMER_0,
-        .freq_hz = Config::PWM::FREQUENCY
-    };
-    ledc_timer_config(&ledcTimer);
-
-    // LEDC channel configuration for PWM
-    ledc_channel_config_t ledcChannel = {
-        .gpio_num = Config::Pins::PWM_PIN,
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = static_cast<ledc_channel_t>(Config::PWM::CHANNEL),
-        .timer_sel = LEDC_TIMER_0,
-        .duty = 0,
-        .hpoint = 0
-    };
-    ledc_channel_config(&ledcChannel);
-
     // Configure tachometer pin and interrupt
     pinMode(Config::Pins::TACHO_PIN, INPUT_PULLUP);  // Pull-up for hall sensor
     attachInterrupt(digitalPinToInterrupt(Config::Pins::TACHO_PIN), handleTachoInterrupt, RISING);
 }
 
-// Initialize WiFi
-void initializeWiFi() {
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(Config::WIFI_SSID, Config::WIFI_PASSWORD);
-    
-    unsigned long startAttemptTime = millis();
-    
-    // Wait for WiFi connection
-    while (WiFi.status() != WL_CONNECTED && 
-           millis() - startAttemptTime < Config::WIFI_CONNECT_TIMEOUT) {
-        Serial.print(".");
-        delay(Config::WIFI_RETRY_DELAY);
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\nConnected to WiFi");
-        Serial.print("IP Address: ");
-        Serial.println(WiFi.localIP());
-    } else {
-        Serial.println("\nUnable to connect to WiFi!");
-        systemStatus.errorState = SystemStatus::ErrorState::WIFI_ERROR;
-    }
-}
-
 // Calculate RPM
 void updateRPM() {
     if (systemStatus.needsRPMUpdate()) {
+        watchdog.enter(Watchdog::Subsystem::TACH);
         unsigned long pulses = tachoPulses;
         tachoPulses = 0; // Reset counter
         
-        float rpm = (pulses * 60000.0f) / 
-                   ((millis() - systemStatus.lastRPMUpdate) * Config::Tacho::PULSES_PER_REVOLUTION);
+        unsigned long interval = millis() - systemStatus.lastRPMUpdate;
+        float rpm = (pulses * 60000.0f) / (interval * Config::Tacho::PULSES_PER_REVOLUTION);
                    
         // Update status
         systemStatus.fanRPM = rpm;
         systemStatus.lastRPMUpdate = millis();
+        watchdog.beat(Watchdog::Subsystem::TACH);
+        
+        // Inner RPM loop: correct the duty towards the commanded airflow
+        watchdog.enter(Watchdog::Subsystem::CONTROL);
+        fanController.regulateSpeed(rpm, interval / 1000.0f);
+        watchdog.beat(Watchdog::Subsystem::CONTROL);
+        
+        // The calibration sweep stalls the fan on purpose
+        if (fanController.isCalibrating()) return;
         
-        // Check if fan is blocked
-        if (systemStatus.fanOn && rpm < Config::Tacho::MIN_RPM_THRESHOLD) {
+        // Feed the health model (expected RPM per duty)
+        fanHealth.addSample(systemStatus.fanDuty, rpm, systemStatus.fanOn);
+        
+        // Check if fan is blocked, against the speed the table expects at this duty
+        if (systemStatus.fanOn && rpm < fanModel.faultThreshold(systemStatus.fanDuty)) {
+            if (systemStatus.errorState != SystemStatus::ErrorState::FAN_ERROR) {
+                EventLog::record(EventLog::Code::FAN_ERROR, 0, lroundf(rpm));
+            }
             systemStatus.errorState = SystemStatus::ErrorState::FAN_ERROR;
         } else if (systemStatus.errorState == SystemStatus::ErrorState::FAN_ERROR) {
             systemStatus.errorState = SystemStatus::ErrorState::NONE;
+            EventLog::record(EventLog::Code::FAN_RECOVERED, 0, lroundf(rpm));
         }
     }
 }
 
 void setup() {
     initializeHardware();
-    Serial.println("\nHardware initialized");
+    LOG_PRINTLN("\nHardware initialized");
+    EventLog::begin(esp_reset_reason());
+    
+    activityScheduler.begin();
+    fanHealth.begin();
+    fanModel.begin();
+    fanController.publishCalibration();
+    fanCurve.begin();
     
-    initializeWiFi();
+    wifi.begin();
+    timekeeper.begin();
     
     if (!sensorManager.initialize()) {
-        Serial.println("Sensor initialization failed!");
+        LOG_PRINTLN("Sensor initialization failed!");
     } else {
-        Serial.println("Sensor initialized");
+        LOG_PRINTLN("Sensor initialized");
     }
+    fanController.attachSafetyTrip(safetyMonitor.overrideFlag());
+    safetyMonitor.begin();
     
+#if FEATURE_STATISTICS
+    energyMeter.begin();
+    burnSessions.begin();
+#endif
+#if FEATURE_REST_API
     webServer.begin();
+#endif
+#if FEATURE_MQTT
+    mqtt.begin();
+#endif
+    powerManager.begin();
+
+    // Last, so the blocking sensor setup cannot trip it
+    watchdog.begin();
+}
+
+// Time in ms until loop() has work again
+unsigned long msUntilNextEvent() {
+    unsigned long next = sensorManager.msUntilNextSample();
+    if (systemStatus.fanOn) {
+        // RPM regulation and energy accounting every second while the fan runs
+        unsigned long elapsed = millis() - systemStatus.lastRPMUpdate;
+        next = min(next, elapsed >= Config::Tacho::RPM_UPDATE_INTERVAL
+                             ? 0UL : Config::Tacho::RPM_UPDATE_INTERVAL - elapsed);
+    }
+    next = min(next, wifi.msUntilNextEvent());
+#if FEATURE_REST_API
+    next = min(next, webServer.msUntilNextEvent());
+#endif
+#if FEATURE_MQTT
+    next = min(next, mqtt.msUntilNextEvent());
+#endif
+    return next;
 }
 
 void loop() {
-    // Feed the watchdog
-    delay(Config::System::WATCHDOG_DELAY);
+    watchdog.beginLoop();
+
+    // Update cached calendar state
+    timekeeper.update();
+
+    // Follow the safety task before anything else drives the fan
+    safetyMonitor.update(systemStatus);
+    fanController.setSafetyOverride(safetyMonitor.overrideActive());
     
-    // Update sensor data
+    // Update sensor data; the heartbeat confirms sampling keeps to its schedule
+    watchdog.enter(Watchdog::Subsystem::SENSOR);
     sensorManager.update();
+    if (sensorManager.msUntilNextSample() > 0) {
+        watchdog.beat(Watchdog::Subsystem::SENSOR);
+    }
     
     // Update RPM
     updateRPM();
     
+    watchdog.enter(Watchdog::Subsystem::NETWORK);
+    wifi.handle();
+#if FEATURE_REST_API
     // Update web server
     webServer.handle();
+#endif
+
+#if FEATURE_MQTT
+    // Publish changes and receive commands
+    mqtt.handle();
+#endif
+    watchdog.beat(Watchdog::Subsystem::NETWORK);
+    watchdog.enter(Watchdog::Subsystem::LOOP);
 
-    // Update operating statistics every second
+#if FEATURE_STATISTICS
+    // Update operating statistics and energy accounting every second
     if (millis() - lastStatsUpdate >= 1000) {  // Interval of 1 second
-        systemStatus.updateOperatingStats();
+        energyMeter.tick();
+        burnSessions.tick();
         lastStatsUpdate = millis();
     }
+#endif
+
+    // Mirror new journal entries to flash, rate limited
+    EventLog::persist();
+
+    watchdog.endLoop(systemStatus);
+
+    // Wait for the next event; sleeps until the next sample while the controller is in sleep mode
+#if FEATURE_MQTT
+    powerManager.idle(msUntilNextEvent(), mqtt.socket());
+#else
+    powerManager.idle(msUntilNextEvent());
+#endif
 }
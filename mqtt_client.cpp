@@ -0,0 +1,507 @@
+#include "config.h"
+
+#if FEATURE_MQTT
+#include "mqtt_client.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef ARDUINO
+#include <lwip/dns.h>
+#include <lwip/netdb.h>
+#include <lwip/sockets.h>
+#include <lwip/tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+constexpr uint8_t CONNECT = 0x10;
+constexpr uint8_t CONNACK = 0x20;
+constexpr uint8_t PUBLISH = 0x30;
+constexpr uint8_t SUBSCRIBE = 0x82;     // Reserved flags 0b0010
+constexpr uint8_t SUBACK = 0x90;
+constexpr uint8_t PINGREQ = 0xC0;
+constexpr uint8_t PINGRESP = 0xD0;
+
+constexpr unsigned long CONNECT_POLL_INTERVAL = 50;  // Poll while a connect is in progress in ms
+constexpr unsigned long NO_EVENT = 0xFFFFFFFFUL;
+
+unsigned long nowMs() {
+#ifdef ARDUINO
+    return millis();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long>(ts.tv_sec) * 1000UL + ts.tv_nsec / 1000000L;
+#endif
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool wouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+size_t lengthFieldSize(size_t remaining) {
+    size_t bytes = 1;
+    while (remaining >= 128) {
+        remaining /= 128;
+        bytes++;
+    }
+    return bytes;
+}
+
+bool reached(unsigned long now, unsigned long deadline) {
+    return static_cast<long>(now - deadline) >= 0;
+}
+
+} // namespace
+
+MqttClient::~MqttClient() {
+    if (fd >= 0) close(fd);
+}
+
+void MqttClient::setServer(const char* brokerHost, uint16_t brokerPort) {
+    host = (brokerHost && *brokerHost) ? brokerHost : nullptr;
+    port = brokerPort;
+    address = 0;
+}
+
+void MqttClient::setCredentials(const char* user, const char* pass) {
+    username = (user && *user) ? user : nullptr;
+    password = (pass && *pass) ? pass : nullptr;
+}
+
+void MqttClient::setWill(const char* topic, const char* payload) {
+    willTopic = topic;
+    willPayload = payload;
+}
+
+void MqttClient::loop() {
+    unsigned long now = nowMs();
+
+    switch (state) {
+        case State::DISCONNECTED:
+            if (host && reached(now, retryAt)) startConnect(now);
+            break;
+
+        case State::RESOLVING:
+            checkLookup(now);
+            break;
+
+        case State::CONNECTING:
+            checkConnected(now);
+            break;
+
+        case State::HANDSHAKE:
+        case State::CONNECTED:
+            flush(now);
+            if (state == State::DISCONNECTED) break;
+            receive(now);
+            if (state == State::HANDSHAKE && now - stateSince > Config::Mqtt::CONNECT_TIMEOUT) {
+                closeSocket(now, true);
+            } else if (state == State::CONNECTED) {
+                keepAlive(now);
+                flush(now);
+            }
+            break;
+    }
+}
+
+void MqttClient::startConnect(unsigned long now) {
+    struct in_addr literal;
+    if (address == 0 && inet_aton(host, &literal)) {
+        address = literal.s_addr;
+    }
+    if (address != 0) {
+        openSocket(now);
+        return;
+    }
+
+    state = State::RESOLVING;
+    stateSince = now;
+    startLookup();
+    checkLookup(now);
+}
+
+#ifdef ARDUINO
+// Queued to the tcpip thread, where lwIP's DNS API must be called; never waits for the queue
+void MqttClient::startLookup() {
+    lookup.store(LOOKUP_PENDING);
+    if (tcpip_try_callback(lookupOnTcpip, this) != ERR_OK) {
+        lookup.store(LOOKUP_FAILED);
+    }
+}
+
+void MqttClient::lookupOnTcpip(void* client) {
+    MqttClient* self = static_cast<MqttClient*>(client);
+    ip_addr_t cached;
+    err_t result = dns_gethostbyname_addrtype(self->host, &cached, dnsFound, self, LWIP_DNS_ADDRTYPE_IPV4);
+    if (result == ERR_OK) {
+        dnsFound(self->host, &cached, self);
+    } else if (result != ERR_INPROGRESS) {
+        dnsFound(self->host, nullptr, self);
+    }
+}
+
+// On the tcpip thread; ip is null when the lookup failed
+void MqttClient::dnsFound(const char* name, const ip_addr_t* ip, void* client) {
+    (void)name;
+    MqttClient* self = static_cast<MqttClient*>(client);
+    if (ip && IP_IS_V4(ip)) {
+        self->lookupAddress.store(ip4_addr_get_u32(ip_2_ip4(ip)));
+        self->lookup.store(LOOKUP_FOUND);
+    } else {
+        self->lookup.store(LOOKUP_FAILED);
+    }
+}
+#else
+void MqttClient::startLookup() {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) {
+        lookup.store(LOOKUP_FAILED);
+        return;
+    }
+    lookupAddress.store(reinterpret_cast<struct sockaddr_in*>(result->ai_addr)->sin_addr.s_addr);
+    lookup.store(LOOKUP_FOUND);
+    freeaddrinfo(result);
+}
+#endif
+
+// Connects once the lookup has an address; a lookup that fails or outlasts CONNECT_TIMEOUT
+// counts as a failed attempt and the next attempt looks up again
+void MqttClient::checkLookup(unsigned long now) {
+    uint8_t result = lookup.load();
+    if (result == LOOKUP_FOUND) {
+        address = lookupAddress.load();
+        openSocket(now);
+    } else if (result == LOOKUP_FAILED || now - stateSince > Config::Mqtt::CONNECT_TIMEOUT) {
+        closeSocket(now, true);
+    }
+}
+
+void MqttClient::openSocket(unsigned long now) {
+    fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || !setNonBlocking(fd)) {
+        closeSocket(now, true);
+        return;
+    }
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    struct sockaddr_in broker;
+    memset(&broker, 0, sizeof(broker));
+    broker.sin_family = AF_INET;
+    broker.sin_addr.s_addr = address;
+    broker.sin_port = htons(port);
+
+    state = State::CONNECTING;
+    stateSince = now;
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&broker), sizeof(broker)) != 0 &&
+        errno != EINPROGRESS) {
+        closeSocket(now, true);
+        return;
+    }
+    checkConnected(now);
+}
+
+// Completes the TCP connect once the socket is writable, then sends CONNECT
+void MqttClient::checkConnected(unsigned long now) {
+    fd_set writeSet;
+    FD_ZERO(&writeSet);
+    FD_SET(fd, &writeSet);
+    struct timeval poll = {0, 0};
+    if (select(fd + 1, nullptr, &writeSet, nullptr, &poll) <= 0) {
+        if (now - stateSince > Config::Mqtt::CONNECT_TIMEOUT) closeSocket(now, true);
+        return;
+    }
+
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+        closeSocket(now, true);
+        return;
+    }
+
+    uint8_t flags = 0x02;  // Clean session
+    size_t remaining = 10 + 2 + strlen(clientId);
+    if (willTopic && willPayload) {
+        flags |= 0x04 | 0x20;  // Will, retained, QoS 0
+        remaining += 2 + strlen(willTopic) + 2 + strlen(willPayload);
+    }
+    if (username) {
+        flags |= 0x80;
+        remaining += 2 + strlen(username);
+        if (password) {
+            flags |= 0x40;
+            remaining += 2 + strlen(password);
+        }
+    }
+    if (!beginPacket(CONNECT, remaining)) {
+        closeSocket(now, true);
+        return;
+    }
+    putString("MQTT");
+    putByte(4);  // Protocol level 3.1.1
+    putByte(flags);
+    putU16(Config::Mqtt::KEEP_ALIVE);
+    putString(clientId);
+    if (flags & 0x04) {
+        putString(willTopic);
+        putString(willPayload);
+    }
+    if (flags & 0x80) putString(username);
+    if (flags & 0x40) putString(password);
+
+    state = State::HANDSHAKE;
+    stateSince = now;
+    flush(now);
+}
+
+// Drops the connection and schedules the next attempt with exponential backoff
+void MqttClient::closeSocket(unsigned long now, bool failed) {
+    if (fd >= 0) close(fd);
+    fd = -1;
+    state = State::DISCONNECTED;
+    txLen = rxLen = discard = 0;
+    pingOutstanding = false;
+    if (failed) address = 0;  // Look the host up again, its address may have changed
+
+    retryAt = now + retryDelay;
+    retryDelay = retryDelay * 2 < Config::Mqtt::MAX_RETRY_DELAY ? retryDelay * 2 : Config::Mqtt::MAX_RETRY_DELAY;
+}
+
+void MqttClient::flush(unsigned long now) {
+    size_t sent = 0;
+    while (sent < txLen) {
+        ssize_t result = ::send(fd, tx + sent, txLen - sent, MSG_NOSIGNAL);
+        if (result <= 0) {
+            if (result < 0 && !wouldBlock()) {
+                closeSocket(now, false);
+                return;
+            }
+            break;
+        }
+        sent += result;
+    }
+    if (sent > 0) {
+        memmove(tx, tx + sent, txLen - sent);
+        txLen -= sent;
+    }
+}
+
+void MqttClient::receive(unsigned long now) {
+    while (rxLen < RX_BUFFER_SIZE) {
+        ssize_t received = recv(fd, rx + rxLen, RX_BUFFER_SIZE - rxLen, 0);
+        if (received == 0 || (received < 0 && !wouldBlock())) {
+            closeSocket(now, false);
+            return;
+        }
+        if (received < 0) return;
+        rxLen += received;
+
+        // Skip the rest of a packet that does not fit the buffer
+        if (discard > 0) {
+            size_t skip = discard < rxLen ? discard : rxLen;
+            memmove(rx, rx + skip, rxLen - skip);
+            rxLen -= skip;
+            discard -= skip;
+        }
+
+        // Handle every complete packet: type byte, remaining length (1-4 bytes), body
+        size_t offset = 0;
+        while (rxLen - offset >= 2) {
+            size_t remaining = 0;
+            size_t lengthBytes = 0;
+            bool complete = false;
+            for (int shift = 0; lengthBytes < 4 && offset + 1 + lengthBytes < rxLen; shift += 7) {
+                uint8_t digit = rx[offset + 1 + lengthBytes++];
+                remaining |= static_cast<size_t>(digit & 0x7F) << shift;
+                if (!(digit & 0x80)) {
+                    complete = true;
+                    break;
+                }
+            }
+            if (!complete) {
+                if (lengthBytes >= 4) closeSocket(now, false);  // Malformed length
+                if (state == State::DISCONNECTED) return;
+                break;
+            }
+
+            size_t total = 1 + lengthBytes + remaining;
+            if (total > RX_BUFFER_SIZE) {
+                droppedCount++;
+                discard = total - (rxLen - offset);
+                offset = rxLen;
+                break;
+            }
+            if (offset + total > rxLen) break;  // Rest still arriving
+
+            uint8_t* end = rx + offset + total;
+            uint8_t saved = *end;
+            handlePacket(rx[offset], rx + offset + 1 + lengthBytes, remaining);
+            if (state == State::DISCONNECTED) return;
+            *end = saved;
+            offset += total;
+        }
+
+        if (offset > 0) {
+            memmove(rx, rx + offset, rxLen - offset);
+            rxLen -= offset;
+        }
+    }
+}
+
+void MqttClient::handlePacket(uint8_t header, uint8_t* body, size_t length) {
+    unsigned long now = nowMs();
+    switch (header & 0xF0) {
+        case CONNACK:
+            if (state != State::HANDSHAKE || length < 2 || body[1] != 0) {
+                closeSocket(now, true);  // Refused, e.g. bad credentials
+                return;
+            }
+            state = State::CONNECTED;
+            stateSince = lastPing = now;
+            retryDelay = Config::Mqtt::MIN_RETRY_DELAY;
+            connectCount++;
+            if (connectHandler) connectHandler();
+            break;
+
+        case PUBLISH: {
+            if (length < 2) return;
+            size_t topicLength = (static_cast<size_t>(body[0]) << 8) | body[1];
+            size_t headerLength = 2 + topicLength + ((header & 0x06) ? 2 : 0);  // Packet id with QoS > 0
+            if (headerLength > length) return;
+
+            // Move the topic over its length field to terminate it in place; the byte after
+            // the payload is restored by the caller
+            memmove(body, body + 2, topicLength);
+            body[topicLength] = '\0';
+            char* payload = reinterpret_cast<char*>(body + headerLength);
+            body[length] = '\0';
+            if (messageHandler) {
+                messageHandler(reinterpret_cast<char*>(body), payload, length - headerLength);
+            }
+            break;
+        }
+
+        case PINGRESP:
+            pingOutstanding = false;
+            break;
+
+        case SUBACK:
+        default:
+            break;
+    }
+}
+
+void MqttClient::keepAlive(unsigned long now) {
+    const unsigned long interval = Config::Mqtt::KEEP_ALIVE * 1000UL / 2;
+    if (pingOutstanding) {
+        if (now - lastPing > interval) closeSocket(now, false);  // Broker stopped answering
+        return;
+    }
+    if (now - lastPing >= interval && beginPacket(PINGREQ, 0)) {
+        lastPing = now;
+        pingOutstanding = true;
+    }
+}
+
+unsigned long MqttClient::msUntilNextEvent() const {
+    unsigned long now = nowMs();
+    switch (state) {
+        case State::DISCONNECTED:
+            if (!host) return NO_EVENT;
+            return reached(now, retryAt) ? 0 : retryAt - now;
+        case State::RESOLVING:
+        case State::CONNECTING:
+        case State::HANDSHAKE:
+            return CONNECT_POLL_INTERVAL;
+        case State::CONNECTED:
+        default: {
+            if (txLen > 0) return CONNECT_POLL_INTERVAL;
+            unsigned long due = lastPing + Config::Mqtt::KEEP_ALIVE * 1000UL / 2;
+            return reached(now, due) ? 0 : due - now;
+        }
+    }
+}
+
+bool MqttClient::publish(const char* topic, const char* payload, size_t length, bool retain) {
+    if (state != State::CONNECTED) return false;
+    if (!beginPacket(PUBLISH | (retain ? 0x01 : 0x00), 2 + strlen(topic) + length)) {
+        droppedCount++;
+        return false;
+    }
+    putString(topic);
+    putBytes(payload, length);
+    publishCount++;
+    return true;
+}
+
+bool MqttClient::publish(const char* topic, const char* payload, bool retain) {
+    return publish(topic, payload, strlen(payload), retain);
+}
+
+bool MqttClient::subscribe(const char* topic) {
+    if (state != State::CONNECTED || !beginPacket(SUBSCRIBE, 2 + 2 + strlen(topic) + 1)) return false;
+    putU16(nextPacketId++);
+    if (nextPacketId == 0) nextPacketId = 1;
+    putString(topic);
+    putByte(0);  // Requested QoS
+    return true;
+}
+
+// Writes the fixed header if the whole packet fits the transmit buffer
+bool MqttClient::beginPacket(uint8_t header, size_t remaining) {
+    if (txLen + 1 + lengthFieldSize(remaining) + remaining > TX_BUFFER_SIZE) return false;
+    putByte(header);
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        putByte(remaining > 0 ? digit | 0x80 : digit);
+    } while (remaining > 0);
+    return true;
+}
+
+void MqttClient::putByte(uint8_t value) {
+    tx[txLen++] = value;
+}
+
+void MqttClient::putU16(uint16_t value) {
+    putByte(value >> 8);
+    putByte(value & 0xFF);
+}
+
+void MqttClient::putBytes(const void* data, size_t length) {
+    memcpy(tx + txLen, data, length);
+    txLen += length;
+}
+
+void MqttClient::putString(const char* text) {
+    size_t length = strlen(text);
+    putU16(static_cast<uint16_t>(length));
+    putBytes(text, length);
+}
+
+#endif // FEATURE_MQTT
@@ -0,0 +1,128 @@
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include "config.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <lwip/ip_addr.h>
+#endif
+
+// Minimal MQTT 3.1.1 client (QoS 0) on a non-blocking socket (lwIP on the ESP32, POSIX on a host).
+// loop() never waits for the network: it advances the connection (TCP connect, CONNECT/CONNACK),
+// flushes queued packets and parses what has arrived. Failed or lost connections are retried
+// with exponential backoff. Outgoing packets are queued in a fixed buffer; a publish that does
+// not fit is refused and the caller retries later.
+// A hostname is looked up with lwIP's asynchronous DNS on the tcpip thread, so an unreachable
+// DNS server only delays the connection; the host build resolves with getaddrinfo().
+class MqttClient {
+public:
+    // Topic and payload are terminated and valid only during the call
+    using MessageHandler = std::function<void(const char* topic, const char* payload, size_t length)>;
+    using ConnectHandler = std::function<void()>;
+
+    enum class State : uint8_t {
+        DISCONNECTED,
+        RESOLVING,                      // DNS lookup of the broker in progress
+        CONNECTING,                     // TCP connect in progress
+        HANDSHAKE,                      // CONNECT sent, waiting for CONNACK
+        CONNECTED
+    };
+
+private:
+    static constexpr size_t TX_BUFFER_SIZE = Config::Mqtt::TX_BUFFER_SIZE;
+    static constexpr size_t RX_BUFFER_SIZE = Config::Mqtt::RX_BUFFER_SIZE;
+
+    const char* host = nullptr;
+    uint16_t port = 0;
+    const char* clientId = "";
+    const char* username = nullptr;
+    const char* password = nullptr;
+    const char* willTopic = nullptr;
+    const char* willPayload = nullptr;
+    MessageHandler messageHandler;
+    ConnectHandler connectHandler;
+
+    int fd = -1;
+    State state = State::DISCONNECTED;
+    uint32_t address = 0;               // Resolved broker address, network byte order
+
+    // Result of the DNS lookup, written by the tcpip thread on the ESP32
+    enum Lookup : uint8_t { LOOKUP_PENDING, LOOKUP_FOUND, LOOKUP_FAILED };
+    std::atomic<uint8_t> lookup{LOOKUP_PENDING};
+    std::atomic<uint32_t> lookupAddress{0};
+    unsigned long stateSince = 0;
+    unsigned long retryAt = 0;
+    unsigned long retryDelay = Config::Mqtt::MIN_RETRY_DELAY;
+    unsigned long lastPing = 0;
+    bool pingOutstanding = false;
+    size_t discard = 0;                 // Bytes left of an incoming packet too large for rx
+    uint16_t nextPacketId = 1;
+
+    uint8_t tx[TX_BUFFER_SIZE];
+    size_t txLen = 0;
+    uint8_t rx[RX_BUFFER_SIZE + 1];     // One spare byte to terminate a payload at the end
+    size_t rxLen = 0;
+
+    // Counters
+    uint32_t connectCount = 0;
+    uint32_t publishCount = 0;
+    uint32_t droppedCount = 0;
+
+    void startConnect(unsigned long now);
+    void startLookup();
+    void checkLookup(unsigned long now);
+    void openSocket(unsigned long now);
+#ifdef ARDUINO
+    static void lookupOnTcpip(void* client);
+    static void dnsFound(const char* name, const ip_addr_t* ip, void* client);
+#endif
+    void checkConnected(unsigned long now);
+    void closeSocket(unsigned long now, bool failed);
+    void flush(unsigned long now);
+    void receive(unsigned long now);
+    void handlePacket(uint8_t header, uint8_t* body, size_t length);
+    void keepAlive(unsigned long now);
+
+    bool beginPacket(uint8_t header, size_t remaining);
+    void putByte(uint8_t value);
+    void putU16(uint16_t value);
+    void putBytes(const void* data, size_t length);
+    void putString(const char* text);
+
+public:
+    MqttClient() = default;
+    ~MqttClient();
+
+    void setServer(const char* brokerHost, uint16_t brokerPort);
+    void setCredentials(const char* user, const char* pass);
+    void setClientId(const char* id) { clientId = id; }
+    // Retained message the broker publishes when the connection is lost
+    void setWill(const char* topic, const char* payload);
+    void onMessage(MessageHandler handler) { messageHandler = handler; }
+    // Called after every successful (re)connect; subscriptions must be renewed there
+    void onConnect(ConnectHandler handler) { connectHandler = handler; }
+
+    void loop();
+
+    bool publish(const char* topic, const char* payload, size_t length, bool retain);
+    bool publish(const char* topic, const char* payload, bool retain);
+    bool subscribe(const char* topic);
+
+    bool connected() const { return state == State::CONNECTED; }
+    State getState() const { return state; }
+    // Socket to include in a select() wait, -1 without a connection
+    int socket() const { return fd; }
+    // Time until loop() has timed work (connect retry, keep-alive), for sleep budgeting
+    unsigned long msUntilNextEvent() const;
+
+    uint32_t getConnectCount() const { return connectCount; }
+    uint32_t getPublishCount() const { return publishCount; }
+    uint32_t getDroppedCount() const { return droppedCount; }
+};
+
+#endif // MQTT_CLIENT_H
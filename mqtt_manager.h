@@ -0,0 +1,291 @@
+#ifndef MQTT_MANAGER_H
+#define MQTT_MANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "config.h"
+#include "logging.h"
+#include "arena.h"
+#include "mqtt_client.h"
+#include "system_status.h"
+#include "fan_commands.h"
+
+// Publishes the controller state to MQTT and accepts commands on <base>/<device>/<key>/set.
+// Values are checked once per sample cycle and sent together as one retained JSON state
+// message when any of them moved by more than its deadband (discrete state on every change),
+// using the same field names as /api/v1/status. Home Assistant discovery entries point at
+// that message, so one publish updates every entity.
+class MqttManager {
+private:
+    MqttClient client;
+    SystemStatus& status;
+    FanCommands& commands;
+
+    // Deadband-filtered values that trigger a state publish
+    struct Metric {
+        float (*read)(const SystemStatus& status);
+        float deadband;                         // 0: any change
+        bool perSample;                         // Only evaluated when a new sample arrived
+    };
+    static constexpr Metric METRICS[] = {
+        {[](const SystemStatus& s) { return s.temperature; }, Config::Mqtt::TEMPERATURE_DEADBAND, true},
+        {[](const SystemStatus& s) { return s.humidity; }, Config::Mqtt::HUMIDITY_DEADBAND, true},
+        {[](const SystemStatus& s) { return s.fanRPM; }, Config::Mqtt::RPM_DEADBAND, true},
+        {[](const SystemStatus& s) { return s.currentFanSpeed; }, Config::Mqtt::SPEED_DEADBAND, true},
+#if FEATURE_HEAT_ENGINE
+        {[](const SystemStatus& s) { return s.currentHeatPower; }, Config::Mqtt::HEAT_POWER_DEADBAND, true},
+        {[](const SystemStatus& s) { return s.totalHeatEnergy; }, Config::Mqtt::HEAT_ENERGY_DEADBAND, true},
+#endif
+        {[](const SystemStatus& s) { return s.fanOn ? 1.0f : 0.0f; }, 0.0f, false},
+        {[](const SystemStatus& s) { return s.autoMode ? 1.0f : 0.0f; }, 0.0f, false},
+        {[](const SystemStatus& s) { return s.manualFanSpeed; }, 0.0f, false},
+        {[](const SystemStatus& s) { return static_cast<float>(s.statusCode); }, 0.0f, false},
+        {[](const SystemStatus& s) { return static_cast<float>(s.errorState); }, 0.0f, false},
+        {[](const SystemStatus& s) { return s.safety.overrideActive ? 1.0f : 0.0f; }, 0.0f, false},
+    };
+    static constexpr int METRIC_COUNT = sizeof(METRICS) / sizeof(METRICS[0]);
+
+    // Home Assistant entities; commands arrive on <base>/<device>/<key>/set
+    struct Entity {
+        const char* component;
+        const char* key;
+        const char* name;
+        const char* valueTemplate;              // nullptr for entities without state
+        const char* options;                    // Additional discovery attributes
+        bool command;
+    };
+    static constexpr Entity ENTITIES[] = {
+        {"sensor", "temperature", "Temperature", "{{ value_json.temperature }}",
+         "\"device_class\":\"temperature\",\"state_class\":\"measurement\",\"unit_of_measurement\":\"°C\"", false},
+        {"sensor", "humidity", "Humidity", "{{ value_json.humidity }}",
+         "\"device_class\":\"humidity\",\"state_class\":\"measurement\",\"unit_of_measurement\":\"%\"", false},
+        {"sensor", "dew_point", "Dew point", "{{ value_json.dew_point }}",
+         "\"device_class\":\"temperature\",\"state_class\":\"measurement\",\"unit_of_measurement\":\"°C\"", false},
+        {"sensor", "fan_rpm", "Fan speed", "{{ value_json.fan_rpm | round(0) }}",
+         "\"state_class\":\"measurement\",\"unit_of_measurement\":\"rpm\",\"icon\":\"mdi:fan\"", false},
+#if FEATURE_HEAT_ENGINE
+        {"sensor", "current_heat_power", "Heat recovery power", "{{ value_json.current_heat_power }}",
+         "\"device_class\":\"power\",\"state_class\":\"measurement\",\"unit_of_measurement\":\"W\"", false},
+        {"sensor", "total_heat_energy", "Heat recovered", "{{ value_json.total_heat_energy }}",
+         "\"device_class\":\"energy\",\"state_class\":\"total_increasing\",\"unit_of_measurement\":\"kWh\"", false},
+#endif
+        {"sensor", "status_code", "Status", "{{ value_json.status_code }}", "\"icon\":\"mdi:state-machine\"", false},
+        {"switch", "fan_on", "Fan", "{{ 'ON' if value_json.fan_on else 'OFF' }}", "\"icon\":\"mdi:fan\"", true},
+        {"switch", "auto_mode", "Automatic mode", "{{ 'ON' if value_json.auto_mode else 'OFF' }}",
+         "\"icon\":\"mdi:thermostat-auto\"", true},
+        {"number", "manual_fan_speed", "Manual fan speed", "{{ (value_json.manual_fan_speed * 100) | round(0) }}",
+         "\"min\":0,\"max\":100,\"step\":1,\"unit_of_measurement\":\"%\"", true},
+        {"button", "reset_temperature", "Reset temperature range", nullptr, "\"icon\":\"mdi:restore\"", true},
+        {"button", "reset_fan_health", "Reset fan health", nullptr, "\"icon\":\"mdi:restore\"", true},
+        {"binary_sensor", "safety_override", "Over-temperature", "{{ 'ON' if value_json.safety.override_active else 'OFF' }}",
+         "\"device_class\":\"heat\"", false},
+        {"button", "reset_safety", "Acknowledge over-temperature", nullptr, "\"icon\":\"mdi:alarm-light-off\"", true},
+        {"button", "calibrate_fan", "Calibrate fan", nullptr, "\"icon\":\"mdi:tune-vertical\"", true},
+    };
+    static constexpr int ENTITY_COUNT = sizeof(ENTITIES) / sizeof(ENTITIES[0]);
+
+    char deviceId[20];
+    char baseTopic[48];
+    char availabilityTopic[64];
+    char stateTopic[64];
+    char commandFilter[64];
+    SystemStatus::FieldMask stateFields = 0;
+
+    float published[METRIC_COUNT];
+    bool publishPending = false;
+    int discoveryIndex = ENTITY_COUNT;          // Next discovery entry, ENTITY_COUNT when done
+    unsigned long lastSampleSeen = 0;
+    unsigned long lastStatePublish = 0;
+
+    void onConnect() {
+        LOG_PRINTLN("DEBUG: MQTT connected");
+        client.publish(availabilityTopic, "online", true);
+        client.subscribe(commandFilter);
+        discoveryIndex = 0;
+        publishPending = true;
+    }
+
+    // Queues discovery entries while the transmit buffer has room
+    void publishDiscovery() {
+        while (discoveryIndex < ENTITY_COUNT) {
+            const Entity& entity = ENTITIES[discoveryIndex];
+            char topic[128];
+            snprintf(topic, sizeof(topic), "%s/%s/%s/%s/config",
+                     Config::Mqtt::DISCOVERY_PREFIX, entity.component, deviceId, entity.key);
+
+            char buffer[768];
+            TextWriter json(buffer, sizeof(buffer));
+            json.print("{\"name\":\"").print(entity.name).print('"');
+            json.print(",\"unique_id\":\"").print(deviceId).print('_').print(entity.key).print('"');
+            json.print(",\"availability_topic\":\"").print(availabilityTopic).print('"');
+            if (entity.valueTemplate) {
+                json.print(",\"state_topic\":\"").print(stateTopic).print('"');
+                json.print(",\"value_template\":\"").print(entity.valueTemplate).print('"');
+            }
+            if (entity.command) {
+                json.print(",\"command_topic\":\"").print(baseTopic).print('/').print(entity.key).print("/set\"");
+            }
+            json.print(',').print(entity.options);
+            json.print(",\"device\":{\"identifiers\":[\"").print(deviceId).print("\"]");
+            json.print(",\"name\":\"Heat Recovery Fan\",\"model\":\"XIAO ESP32C6\",\"manufacturer\":\"DIY\"}}");
+
+            if (json.overflowed()) {
+                discoveryIndex++;  // Skip, cannot ever fit
+                continue;
+            }
+            if (!client.publish(topic, json.c_str(), json.length(), true)) return;  // Retry next pass
+            discoveryIndex++;
+        }
+    }
+
+    // Marks the state for publishing when a value left its deadband
+    void checkForChanges() {
+        bool newSample = status.lastSensorUpdate != lastSampleSeen;
+        lastSampleSeen = status.lastSensorUpdate;
+
+        for (int i = 0; i < METRIC_COUNT && !publishPending; i++) {
+            if (METRICS[i].perSample && !newSample) continue;
+            float value = METRICS[i].read(status);
+            if (value != published[i] && !(fabsf(value - published[i]) < METRICS[i].deadband)) {
+                publishPending = true;
+            }
+        }
+        if (millis() - lastStatePublish >= Config::Mqtt::STATE_REFRESH_INTERVAL) {
+            publishPending = true;
+        }
+    }
+
+    void publishState() {
+        char buffer[512];
+        TextWriter json(buffer, sizeof(buffer));
+        status.toJson(json, stateFields);
+        if (json.overflowed() || !client.publish(stateTopic, json.c_str(), json.length(), true)) return;
+
+        for (int i = 0; i < METRIC_COUNT; i++) {
+            published[i] = METRICS[i].read(status);
+        }
+        publishPending = false;
+        lastStatePublish = millis();
+    }
+
+    static bool parseSwitch(const char* payload, bool& on) {
+        if (strcasecmp(payload, "ON") == 0 || strcmp(payload, "1") == 0 || strcasecmp(payload, "true") == 0) {
+            on = true;
+        } else if (strcasecmp(payload, "OFF") == 0 || strcmp(payload, "0") == 0 || strcasecmp(payload, "false") == 0) {
+            on = false;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Routes <base>/<key>/set to the shared command handlers
+    void onMessage(const char* topic, const char* payload) {
+        size_t baseLength = strlen(baseTopic);
+        if (strncmp(topic, baseTopic, baseLength) != 0 || topic[baseLength] != '/') return;
+        const char* key = topic + baseLength + 1;
+        const char* suffix = strchr(key, '/');
+        if (!suffix || strcmp(suffix, "/set") != 0) return;
+        size_t keyLength = suffix - key;
+
+        LOG_PRINT("DEBUG: MQTT command ");
+        LOG_PRINT(topic);
+        LOG_PRINT(": ");
+        LOG_PRINTLN(payload);
+
+        auto is = [key, keyLength](const char* name) {
+            return strlen(name) == keyLength && strncmp(key, name, keyLength) == 0;
+        };
+        FanCommands::Result result = {false, "Unknown command"};
+        bool on = false;
+        if (is("fan_on")) {
+            result = parseSwitch(payload, on) ? commands.setFan(on) : FanCommands::Result{false, "Invalid value"};
+        } else if (is("auto_mode")) {
+            result = parseSwitch(payload, on) ? commands.setAutoMode(on) : FanCommands::Result{false, "Invalid value"};
+        } else if (is("manual_fan_speed")) {
+            char* end = nullptr;
+            float percent = strtof(payload, &end);
+            result = (end != payload) ? commands.setManualSpeed(percent / 100.0f)
+                                      : FanCommands::Result{false, "Invalid speed value"};
+        } else if (is("reset_temperature")) {
+            result = commands.resetTemperature();
+        } else if (is("reset_fan_health")) {
+            result = commands.resetFanHealth();
+        } else if (is("reset_safety")) {
+            result = commands.resetSafety();
+        } else if (is("calibrate_fan")) {
+            result = commands.startCalibration();
+        }
+
+        LOG_PRINT("DEBUG: MQTT command result: ");
+        LOG_PRINTLN(result.message);
+        publishPending = true;  // Report the resulting state, also when the command was refused
+    }
+
+public:
+    MqttManager(SystemStatus& systemStatus, FanCommands& fanCommands)
+        : status(systemStatus), commands(fanCommands) {
+        memset(published, 0, sizeof(published));
+    }
+
+    void begin() {
+        if (!*Config::Mqtt::BROKER_HOST) {
+            LOG_PRINTLN("DEBUG: MQTT disabled, no broker configured");
+            return;
+        }
+
+        uint8_t mac[6];
+        WiFi.macAddress(mac);
+        snprintf(deviceId, sizeof(deviceId), "heatfan_%02x%02x%02x", mac[3], mac[4], mac[5]);
+        snprintf(baseTopic, sizeof(baseTopic), "%s/%s", Config::Mqtt::BASE_TOPIC, deviceId);
+        snprintf(availabilityTopic, sizeof(availabilityTopic), "%s/availability", baseTopic);
+        snprintf(stateTopic, sizeof(stateTopic), "%s/state", baseTopic);
+        snprintf(commandFilter, sizeof(commandFilter), "%s/+/set", baseTopic);
+
+        stateFields = SystemStatus::parseFieldList(
+            "temperature,humidity,dew_point,auto_mode,fan_on,manual_fan_speed,current_fan_speed,fan_rpm,"
+            "current_heat_power,total_heat_energy,status_code,error_state,safety");
+
+        client.setServer(Config::Mqtt::BROKER_HOST, Config::Mqtt::BROKER_PORT);
+        client.setCredentials(Config::Mqtt::USERNAME, Config::Mqtt::PASSWORD);
+        client.setClientId(deviceId);
+        client.setWill(availabilityTopic, "offline");
+        client.onConnect([this]() { onConnect(); });
+        client.onMessage([this](const char* topic, const char* payload, size_t) { onMessage(topic, payload); });
+
+        LOG_PRINT("DEBUG: MQTT topics at ");
+        LOG_PRINTLN(baseTopic);
+    }
+
+    void handle() {
+        if (WiFi.status() != WL_CONNECTED && !client.connected()) return;
+
+        client.loop();
+        if (!client.connected()) return;
+
+        publishDiscovery();
+        checkForChanges();
+        if (publishPending) publishState();
+    }
+
+    // Time until handle() has timed work, for the power manager
+    unsigned long msUntilNextEvent() const {
+        if (!client.connected()) return client.msUntilNextEvent();
+        if (publishPending || discoveryIndex < ENTITY_COUNT) return 0;
+        unsigned long sinceState = millis() - lastStatePublish;
+        unsigned long untilState = sinceState < Config::Mqtt::STATE_REFRESH_INTERVAL
+                                       ? Config::Mqtt::STATE_REFRESH_INTERVAL - sinceState : 0;
+        return min(client.msUntilNextEvent(), untilState);
+    }
+
+    // Socket that wakes the power manager when a command arrives, -1 without a connection
+    int socket() const {
+        return client.socket();
+    }
+
+    bool connected() const {
+        return client.connected();
+    }
+};
+
+#endif // MQTT_MANAGER_H
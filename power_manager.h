@@ -0,0 +1,177 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_pm.h>
+#include "config.h"
+#include "logging.h"
+#include "system_status.h"
+#include "fan_controller.h"
+#include "safety_monitor.h"
+#if FEATURE_REST_API
+#include "web_server.h"
+#endif
+
+// Lets the chip sleep between scheduled events instead of spinning through loop().
+// The loop task blocks on the web server's sockets until the next event is due, so an
+// incoming request still wakes it immediately. With power management available the idle
+// task then enters automatic light sleep, WiFi stays associated in modem sleep and wakes
+// for DTIM beacons. Residency per state, wakeups and an estimated current are published
+// in SystemStatus::power; samples of the safety task during a wait count as wakeups and add
+// one measurement at active current each.
+class PowerManager {
+public:
+    enum class State {
+        ACTIVE,         // Running loop() work
+        IDLE,           // Waiting with the CPU idle (modem sleep, no light sleep)
+        LIGHT_SLEEP     // Waiting with automatic light sleep between events
+    };
+
+private:
+    SystemStatus& status;
+    FanController& controller;
+    SafetyMonitor& safety;
+#if FEATURE_REST_API
+    WebServerManager& webServer;
+#endif
+
+    bool lightSleepAvailable = false;
+
+#if FEATURE_STATISTICS
+    unsigned long lastIdleExit = 0;
+    uint64_t residencyMs[3] = {0, 0, 0};
+    uint64_t modeMs[2] = {0, 0};           // Time with the controller active / in sleep mode
+    uint32_t modeWakeups[2] = {0, 0};      // Loop and safety wakeups with the controller active / in sleep mode
+    uint32_t safetyWakeups[3] = {0, 0, 0}; // Safety samples per state of the loop
+#endif
+
+    void configurePowerManagement() {
+        esp_pm_config_t pmConfig = {};
+        pmConfig.max_freq_mhz = Config::Power::MAX_CPU_FREQ_MHZ;
+        pmConfig.min_freq_mhz = Config::Power::MIN_CPU_FREQ_MHZ;
+        pmConfig.light_sleep_enable = true;
+
+        if (esp_pm_configure(&pmConfig) == ESP_OK) {
+            lightSleepAvailable = true;
+            LOG_PRINTLN("DEBUG: Automatic light sleep enabled");
+            return;
+        }
+
+        // Build without tickless idle: keep frequency scaling only
+        pmConfig.light_sleep_enable = false;
+        if (esp_pm_configure(&pmConfig) == ESP_OK) {
+            LOG_PRINTLN("DEBUG: Light sleep unavailable, using frequency scaling");
+        } else {
+            LOG_PRINTLN("DEBUG: Power management unavailable");
+        }
+    }
+
+    bool canSleep() const {
+#if FEATURE_REST_API
+        if (webServer.activeConnections() > 0) return false;
+#endif
+        return status.autoMode && controller.isInSleepMode() && !status.fanOn && !controller.isCalibrating();
+    }
+
+    // Blocks until the timeout; with the REST API an incoming request (or data on
+    // wakeSocket) ends the wait early
+    void wait(unsigned long timeoutMs, int wakeSocket) {
+#if FEATURE_REST_API
+        webServer.waitForActivity(timeoutMs, wakeSocket);
+#else
+        delay(timeoutMs);
+#endif
+    }
+
+#if FEATURE_STATISTICS
+    static float perHour(uint32_t count, uint64_t ms) {
+        return ms > 0 ? count * 3600000.0f / ms : 0.0f;
+    }
+
+    static float stateCurrent(int state) {
+        switch (static_cast<State>(state)) {
+            case State::ACTIVE: return Config::Power::CURRENT_ACTIVE_MA;
+            case State::IDLE:   return Config::Power::CURRENT_IDLE_MA;
+            default:            return Config::Power::CURRENT_LIGHT_SLEEP_MA;
+        }
+    }
+
+    void publishStats() {
+        uint64_t total = residencyMs[0] + residencyMs[1] + residencyMs[2];
+        if (total == 0) return;
+
+        status.power.activePercent = residencyMs[static_cast<int>(State::ACTIVE)] * 100.0f / total;
+        status.power.idlePercent = residencyMs[static_cast<int>(State::IDLE)] * 100.0f / total;
+        status.power.lightSleepPercent = residencyMs[static_cast<int>(State::LIGHT_SLEEP)] * 100.0f / total;
+        status.power.activeWakeupsPerHour = perHour(modeWakeups[0], modeMs[0]);
+        status.power.sleepWakeupsPerHour = perHour(modeWakeups[1], modeMs[1]);
+        float charge = 0.0f;    // mA * ms
+        for (int state = 0; state < 3; state++) {
+            charge += residencyMs[state] * stateCurrent(state);
+            // A safety sample keeps the chip active for one measurement
+            charge += safetyWakeups[state] * static_cast<float>(Config::Safety::SENSOR_READ_TIME) *
+                      (Config::Power::CURRENT_ACTIVE_MA - stateCurrent(state));
+        }
+        status.power.estimatedCurrent = charge / total;
+        status.power.lightSleepAvailable = lightSleepAvailable;
+    }
+#endif
+
+public:
+#if FEATURE_REST_API
+    PowerManager(SystemStatus& systemStatus, FanController& fanController, SafetyMonitor& safetyMonitor,
+                 WebServerManager& server)
+        : status(systemStatus), controller(fanController), safety(safetyMonitor), webServer(server) {}
+#else
+    PowerManager(SystemStatus& systemStatus, FanController& fanController, SafetyMonitor& safetyMonitor)
+        : status(systemStatus), controller(fanController), safety(safetyMonitor) {}
+#endif
+
+    void begin() {
+        configurePowerManagement();
+        WiFi.setSleep(WIFI_PS_MIN_MODEM);  // Modem sleep, radio wakes for every DTIM beacon
+#if FEATURE_STATISTICS
+        lastIdleExit = millis();
+#endif
+    }
+
+    // Waits until the next scheduled event (or network activity) and accounts the time.
+    // untilNextEvent is the time in ms until loop() has work again, wakeSocket an additional
+    // socket whose incoming data ends the wait (-1 for none).
+    void idle(unsigned long untilNextEvent, int wakeSocket = -1) {
+#if FEATURE_STATISTICS
+        unsigned long start = millis();
+        residencyMs[static_cast<int>(State::ACTIVE)] += start - lastIdleExit;
+        int mode = controller.isInSleepMode() ? 1 : 0;
+#endif
+
+        State state = State::IDLE;
+        unsigned long budget = untilNextEvent;
+        if (canSleep()) {
+            budget = min(untilNextEvent, Config::Power::MAX_SLEEP_TIME);
+            state = lightSleepAvailable ? State::LIGHT_SLEEP : State::IDLE;
+        }
+        budget = min(budget, Config::Watchdog::MAX_WAIT);  // Wake in time to feed the watchdog
+
+#if FEATURE_STATISTICS
+        uint32_t samplesBefore = safety.getSampleCount();
+#endif
+        if (budget > 0) {
+            wait(budget, wakeSocket);
+        }
+
+#if FEATURE_STATISTICS
+        unsigned long now = millis();
+        uint32_t samples = safety.getSampleCount() - samplesBefore;
+        residencyMs[static_cast<int>(state)] += now - start;
+        safetyWakeups[static_cast<int>(state)] += samples;
+        modeMs[mode] += now - lastIdleExit;
+        modeWakeups[mode] += 1 + samples;
+        lastIdleExit = now;
+        publishStats();
+#endif
+    }
+};
+
+#endif // POWER_MANAGER_H
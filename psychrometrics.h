@@ -0,0 +1,114 @@
+#ifndef PSYCHROMETRICS_H
+#define PSYCHROMETRICS_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Moist air properties from temperature and relative humidity (over water, as the SHT4x reports).
+// The saturation vapour pressure is linearly interpolated in a 1 °C table of the reference
+// equations (IAPWS-IF97 above 0 °C, Murphy & Koop 2005 for supercooled water below), and the
+// dew point is found by binary search in the same table, so an update needs no exp() or log():
+// the ESP32-C6 has no FPU. Unlike the Magnus formula the table stays accurate up to 125 °C.
+// tools/psychrometrics_bench.cpp regenerates the reference values, checks the errors and
+// measures the cost per sample.
+namespace Psychrometrics {
+    constexpr float GAS_CONSTANT_DRY_AIR = 287.042f;   // J/(kg·K)
+    constexpr float GAS_CONSTANT_VAPOUR = 461.524f;    // J/(kg·K)
+    constexpr float MOLAR_MASS_RATIO = 0.621945f;      // Water vapour / dry air
+    constexpr float SPECIFIC_HEAT_DRY_AIR = 1.006f;    // kJ/(kg·K)
+    constexpr float SPECIFIC_HEAT_VAPOUR = 1.86f;      // kJ/(kg·K)
+    constexpr float LATENT_HEAT = 2501.0f;             // Vaporization at 0 °C in kJ/kg
+
+    // Saturation vapour pressure in Pa at TABLE_MIN_TEMP + i °C
+    constexpr int TABLE_MIN_TEMP = -40;
+    constexpr int TABLE_MAX_TEMP = 125;
+    constexpr int TABLE_SIZE = TABLE_MAX_TEMP - TABLE_MIN_TEMP + 1;
+    inline constexpr float SATURATION_TABLE[TABLE_SIZE] = {
+        18.91215f, 20.97505f, 23.23885f, 25.72075f, 28.43925f, 31.4142f, 34.66688f, 38.22008f,
+        42.09823f, 46.32743f, 50.93562f, 55.9526f, 61.4102f, 67.34237f, 73.78527f, 80.7774f,
+        88.35975f, 96.57588f, 105.4721f, 115.0975f, 125.5042f, 136.7475f, 148.8859f, 161.9815f,
+        176.0998f, 191.3101f, 207.6857f, 225.3039f, 244.2464f, 264.5992f, 286.453f, 309.9033f,
+        335.0507f, 362.001f, 390.8654f, 421.7606f, 454.8095f, 490.1408f, 527.8895f, 568.1974f,
+        611.2127f, 657.088f, 705.9879f, 758.0824f, 813.5494f, 872.5749f, 935.3531f, 1002.087f,
+        1072.988f, 1148.277f, 1228.184f, 1312.949f, 1402.822f, 1498.064f, 1598.944f, 1705.745f,
+        1818.759f, 1938.291f, 2064.657f, 2198.184f, 2339.215f, 2488.102f, 2645.211f, 2810.924f,
+        2985.633f, 3169.747f, 3363.687f, 3567.892f, 3782.813f, 4008.917f, 4246.688f, 4496.626f,
+        4759.247f, 5035.083f, 5324.685f, 5628.62f, 5947.474f, 6281.849f, 6632.37f, 6999.676f,
+        7384.427f, 7787.306f, 8209.01f, 8650.261f, 9111.8f, 9594.389f, 10098.81f, 10625.87f,
+        11176.4f, 11751.24f, 12351.27f, 12977.38f, 13630.5f, 14311.56f, 15021.54f, 15761.41f,
+        16532.21f, 17334.97f, 18170.75f, 19040.66f, 19945.8f, 20887.33f, 21866.41f, 22884.24f,
+        23942.05f, 25041.1f, 26182.66f, 27368.04f, 28598.58f, 29875.64f, 31200.64f, 32574.98f,
+        34000.12f, 35477.55f, 37008.78f, 38595.36f, 40238.87f, 41940.9f, 43703.1f, 45527.14f,
+        47414.72f, 49367.57f, 51387.45f, 53476.17f, 55635.55f, 57867.45f, 60173.78f, 62556.46f,
+        65017.44f, 67558.73f, 70182.36f, 72890.39f, 75684.91f, 78568.06f, 81542.0f, 84608.94f,
+        87771.1f, 91030.77f, 94390.23f, 97851.85f, 101418.0f, 105091.0f, 108873.5f, 112767.8f,
+        116776.5f, 120902.1f, 125147.2f, 129514.5f, 134006.5f, 138626.1f, 143376.0f, 148258.8f,
+        153277.5f, 158434.8f, 163733.7f, 169177.0f, 174767.8f, 180509.0f, 186403.6f, 192454.7f,
+        198665.4f, 205038.9f, 211578.2f, 218286.7f, 225167.6f, 232224.2f
+    };
+
+    struct AirState {
+        float vaporPressure;        // Pa
+        float humidityRatio;        // kg water / kg dry air
+        float dewPoint;             // °C
+        float absoluteHumidity;     // g/m³
+        float enthalpy;             // kJ/kg dry air, 0 at 0 °C dry air
+        float dryAirDensity;        // kg dry air / m³ moist air
+        float density;              // kg/m³ moist air
+    };
+
+    // Saturation vapour pressure in Pa, clamped to the table range (the SHT4x range)
+    inline float saturationPressure(float temperature) {
+        float x = temperature - TABLE_MIN_TEMP;
+        if (!(x > 0.0f)) return SATURATION_TABLE[0];
+        if (x >= TABLE_SIZE - 1) return SATURATION_TABLE[TABLE_SIZE - 1];
+        int i = static_cast<int>(x);
+        float fraction = x - i;
+        return SATURATION_TABLE[i] + fraction * (SATURATION_TABLE[i + 1] - SATURATION_TABLE[i]);
+    }
+
+    // Temperature in °C at which the vapour pressure saturates: inverse of saturationPressure()
+    inline float dewPointFromPressure(float vaporPressure) {
+        if (!(vaporPressure > SATURATION_TABLE[0])) return TABLE_MIN_TEMP;
+        if (vaporPressure >= SATURATION_TABLE[TABLE_SIZE - 1]) return TABLE_MAX_TEMP;
+        int low = 0;
+        int high = TABLE_SIZE - 1;
+        while (high - low > 1) {
+            int middle = (low + high) / 2;
+            if (SATURATION_TABLE[middle] <= vaporPressure) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        float fraction = (vaporPressure - SATURATION_TABLE[low]) / (SATURATION_TABLE[high] - SATURATION_TABLE[low]);
+        return TABLE_MIN_TEMP + low + fraction;
+    }
+
+    inline float enthalpy(float temperature, float humidityRatio) {
+        return SPECIFIC_HEAT_DRY_AIR * temperature +
+               humidityRatio * (LATENT_HEAT + SPECIFIC_HEAT_VAPOUR * temperature);
+    }
+
+    // Relative humidity in %, pressure in Pa
+    inline AirState airState(float temperature, float relativeHumidity,
+                             float pressure = Config::Heat::AMBIENT_PRESSURE) {
+        float rh = relativeHumidity < 0.0f ? 0.0f : (relativeHumidity > 100.0f ? 100.0f : relativeHumidity);
+        float vaporPressure = saturationPressure(temperature) * rh * 0.01f;
+        float dryPressure = pressure - vaporPressure;
+        float kelvin = temperature + 273.15f;
+
+        AirState state;
+        state.vaporPressure = vaporPressure;
+        state.humidityRatio = MOLAR_MASS_RATIO * vaporPressure / dryPressure;
+        state.dewPoint = dewPointFromPressure(vaporPressure);
+        float vaporDensity = vaporPressure / (GAS_CONSTANT_VAPOUR * kelvin);
+        state.absoluteHumidity = vaporDensity * 1000.0f;
+        state.enthalpy = enthalpy(temperature, state.humidityRatio);
+        state.dryAirDensity = dryPressure / (GAS_CONSTANT_DRY_AIR * kelvin);
+        state.density = state.dryAirDensity + vaporDensity;
+        return state;
+    }
+}
+
+#endif // PSYCHROMETRICS_H
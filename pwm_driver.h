@@ -0,0 +1,140 @@
+#ifndef PWM_DRIVER_H
+#define PWM_DRIVER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <driver/ledc.h>
+#include <esp_timer.h>
+#include "config.h"
+#include "logging.h"
+
+// Owner of the LEDC timer and channel of the fan PWM, at the highest resolution the source
+// clock allows at 25 kHz (11 bit). Duties are kept with DITHER_BITS more fractional bits; when
+// DITHERING is on, a first-order sigma-delta modulator alternates between the two neighbouring
+// LEDC steps at DITHER_RATE, so the fan sees the average and moves in steps well below one LSB.
+// That matters in the quiet low-speed band, where one 8-bit step was tens of RPM.
+// The modulator timer only runs while the duty has a fractional part; it stops itself otherwise.
+// Called from the loop and the safety task; a spinlock keeps the level and the LEDC output consistent.
+class PwmDriver {
+private:
+    static constexpr ledc_channel_t CHANNEL = static_cast<ledc_channel_t>(Config::PWM::CHANNEL);
+    static constexpr uint32_t FRACTION_ONE = 1UL << Config::PWM::DITHER_BITS;
+    static constexpr uint32_t FRACTION_MASK = FRACTION_ONE - 1;
+
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    esp_timer_handle_t ditherTimer = nullptr;
+    std::atomic<bool> ditherRunning{false};
+    uint32_t level = 0;                 // Duty in LSB << DITHER_BITS
+    uint32_t accumulator = 0;
+    uint32_t written = 0;               // Duty last written to the LEDC
+
+    void write(uint32_t duty) {
+        if (duty == written) return;
+        ledc_set_duty(LEDC_LOW_SPEED_MODE, CHANNEL, duty);
+        ledc_update_duty(LEDC_LOW_SPEED_MODE, CHANNEL);
+        written = duty;
+    }
+
+    static void ditherEntry(void* driver) {
+        static_cast<PwmDriver*>(driver)->dither();
+    }
+
+    void dither() {
+        portENTER_CRITICAL(&lock);
+        uint32_t fraction = level & FRACTION_MASK;
+        accumulator += fraction;
+        uint32_t duty = (level >> Config::PWM::DITHER_BITS) + (accumulator >> Config::PWM::DITHER_BITS);
+        accumulator &= FRACTION_MASK;
+        write(duty);
+        portEXIT_CRITICAL(&lock);
+
+        if (fraction == 0) {
+            esp_timer_stop(ditherTimer);
+            ditherRunning.store(false);
+
+            // A setDuty() before the store saw the timer running and left it to us
+            portENTER_CRITICAL(&lock);
+            bool pending = (level & FRACTION_MASK) != 0;
+            portEXIT_CRITICAL(&lock);
+            if (pending) startDither();
+        }
+    }
+
+    void startDither() {
+        if (ditherRunning.exchange(true)) return;
+        if (esp_timer_start_periodic(ditherTimer, 1000000UL / Config::PWM::DITHER_RATE) != ESP_OK) {
+            ditherRunning.store(false);
+        }
+    }
+
+public:
+    // Configures timer and channel with the output off; safe to call again for recovery
+    void begin() {
+        ledc_timer_config_t timer = {};
+        timer.speed_mode = LEDC_LOW_SPEED_MODE;
+        timer.duty_resolution = static_cast<ledc_timer_bit_t>(Config::PWM::RESOLUTION);
+        timer.timer_num = LEDC_TIMER_0;
+        timer.freq_hz = Config::PWM::FREQUENCY;
+        timer.clk_cfg = LEDC_AUTO_CLK;
+        ledc_timer_config(&timer);
+
+        ledc_channel_config_t channel = {};
+        channel.gpio_num = Config::Pins::PWM_PIN;
+        channel.speed_mode = LEDC_LOW_SPEED_MODE;
+        channel.channel = CHANNEL;
+        channel.timer_sel = LEDC_TIMER_0;
+        channel.duty = 0;
+        channel.hpoint = 0;
+        ledc_channel_config(&channel);
+
+        if (Config::PWM::DITHERING && !ditherTimer) {
+            esp_timer_create_args_t args = {};
+            args.callback = ditherEntry;
+            args.arg = this;
+            args.name = "pwm_dither";
+            esp_timer_create(&args, &ditherTimer);
+        }
+
+        if (ditherTimer && ditherRunning.exchange(false)) {
+            esp_timer_stop(ditherTimer);
+        }
+        portENTER_CRITICAL(&lock);
+        level = 0;
+        accumulator = 0;
+        written = 0;
+        portEXIT_CRITICAL(&lock);
+
+        LOG_PRINT("DEBUG: PWM initialized, ");
+        LOG_PRINT(Config::PWM::RESOLUTION);
+        LOG_PRINTLN(" bit");
+    }
+
+    // Duty fraction 0.0 - 1.0
+    void setDuty(float fraction) {
+        fraction = constrain(fraction, 0.0f, 1.0f);
+        uint32_t target = static_cast<uint32_t>(lroundf(fraction * Config::PWM::MAX_DUTY * FRACTION_ONE));
+        if (!Config::PWM::DITHERING) {
+            target = (target + FRACTION_ONE / 2) & ~FRACTION_MASK;
+        }
+
+        portENTER_CRITICAL(&lock);
+        level = target;
+        write(target >> Config::PWM::DITHER_BITS);
+        portEXIT_CRITICAL(&lock);
+
+        if ((target & FRACTION_MASK) != 0 && ditherTimer) {
+            startDither();
+        }
+    }
+
+    // Average duty fraction the fan sees
+    float getDuty() const {
+        return static_cast<float>(level) / (static_cast<float>(Config::PWM::MAX_DUTY) * FRACTION_ONE);
+    }
+
+    bool isDithering() const {
+        return ditherRunning.load();
+    }
+};
+
+#endif // PWM_DRIVER_H
@@ -0,0 +1,88 @@
+#ifndef RPM_REGULATOR_H
+#define RPM_REGULATOR_H
+
+#include <math.h>
+#include "config.h"
+#include "fan_model.h"
+
+// Inner control loop that holds the fan at a target RPM using the tach signal.
+// Feed-forward comes from the duty -> RPM table of the fan model, a PI term corrects for supply
+// voltage, temperature, filter load and ageing. The integral is kept across set point changes,
+// since it mostly represents how far this fan deviates from the table.
+// Only update() moves the duty of a running fan, so a P correction holds until the next tach
+// measurement. Free of hardware access; tools/rpm_regulator_sim.cpp runs it on a host.
+class RpmRegulator {
+private:
+    const FanModel& model;
+    float integral = 0.0f;          // Duty correction accumulated by the I term
+    float lastError = 0.0f;
+    float averageAbsError = 0.0f;
+    unsigned long holdUntil = 0;    // No integration while the fan spins up or settles
+
+    float clampDuty(float duty) const {
+        return fminf(fmaxf(duty, model.minDuty()), 1.0f);
+    }
+
+public:
+    explicit RpmRegulator(const FanModel& fanModel) : model(fanModel) {}
+
+    // Target RPM for an airflow fraction; airflow scales linearly with RPM (fan law)
+    float rpmForAirflow(float airflow) const {
+        if (airflow <= 0.0f) return 0.0f;
+        return fmaxf(airflow * model.maxRpm(), model.minRpm());
+    }
+
+    // A new table makes the accumulated correction meaningless
+    void reset() {
+        integral = 0.0f;
+        lastError = 0.0f;
+        averageAbsError = 0.0f;
+    }
+
+    // Called when the set point changes; the fan needs time before feedback is meaningful
+    void holdFeedback(unsigned long duration, unsigned long now) {
+        holdUntil = now + duration;
+    }
+
+    // Duty to start the fan with, or 0 to stop it, without feedback
+    float output(float targetRpm) const {
+        if (targetRpm <= 0.0f) return 0.0f;
+        return clampDuty(model.feedForward(targetRpm) + integral);
+    }
+
+    // One control step with a new tach measurement; dt in seconds
+    float update(float targetRpm, float measuredRpm, float dt, unsigned long now) {
+        if (targetRpm <= 0.0f) {
+            lastError = 0.0f;
+            return 0.0f;
+        }
+
+        float error = targetRpm - measuredRpm;
+        lastError = error;
+        averageAbsError += Config::Fan::ERROR_AVERAGE_ALPHA * (fabsf(error) - averageAbsError);
+
+        if (static_cast<long>(now - holdUntil) < 0) {
+            return output(targetRpm);
+        }
+
+        float feedForwardDuty = model.feedForward(targetRpm);
+        float proportional = Config::Fan::KP * error;
+        float candidate = integral + Config::Fan::KI * error * dt;
+        float duty = feedForwardDuty + proportional + candidate;
+
+        // Anti-windup: only integrate while the output is not pushed further into saturation
+        bool saturatedHigh = duty > 1.0f && error > 0.0f;
+        bool saturatedLow = duty < model.minDuty() && error < 0.0f;
+        if (!saturatedHigh && !saturatedLow) {
+            integral = fminf(fmaxf(candidate, -Config::Fan::MAX_CORRECTION), Config::Fan::MAX_CORRECTION);
+        }
+
+        return clampDuty(feedForwardDuty + proportional + integral);
+    }
+
+    float getLastError() const { return lastError; }
+    float getAverageAbsError() const { return averageAbsError; }
+    float getCorrection() const { return integral; }
+};
+
+#endif // RPM_REGULATOR_H
@@ -0,0 +1,240 @@
+#ifndef SAFETY_MONITOR_H
+#define SAFETY_MONITOR_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "logging.h"
+#include "arena.h"
+#include "system_status.h"
+#include "sensor_bus.h"
+#include "pwm_driver.h"
+#include "safety_trip.h"
+#include "event_log.h"
+
+// Over-temperature protection independent of the main loop. A task of its own samples the
+// sensor and on a trip drives the MOSFET and the PWM to full airflow itself, so neither the
+// mode, a sleeping controller nor a stalled web client delays it. The period is SAMPLE_INTERVAL
+// near the trip temperature and stretches up to MAX_SAMPLE_INTERVAL far below it (see
+// SafetyTrip::nextInterval()), which keeps the task from waking the chip every second in sleep
+// mode. A crossing of the trip temperature at up to MAX_RISE_RATE reaches full airflow within
+// MAX_RESPONSE_TIME (one SAMPLE_INTERVAL, the longest bus wait and one measurement). The loop
+// then moves the fan controller into the override via overrideActive(), and the event stays
+// latched until it is cleared.
+class SafetyMonitor {
+public:
+    struct Event {
+        SafetyTrip::Reason reason = SafetyTrip::Reason::NONE;
+        float tripTemperature = NAN;       // Sample that tripped (last valid one for sensor loss)
+        float peakTemperature = NAN;       // Highest sample while tripped
+        unsigned long tripTime = 0;        // millis() at the trip
+        uint32_t actionLatencyUs = 0;      // End of the tripping measurement to outputs driven
+        uint32_t responseMs = 0;           // Earliest crossing the last sample below the trip temperature allows to outputs driven
+    };
+
+private:
+    SensorBus& bus;
+    PwmDriver& pwm;
+    SafetyTrip trip;
+    TaskHandle_t task = nullptr;
+    std::atomic<bool> active{false};
+
+    // Written by the task, read by the loop
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    Event lastEvent;
+    bool latched = false;
+    uint32_t tripCount = 0;
+    uint32_t worstResponseMs = 0;
+    uint32_t sampleCount = 0;
+    uint32_t failedSamples = 0;
+    unsigned long sampleInterval = Config::Safety::SAMPLE_INTERVAL;
+    float lastTemperature = NAN;
+    unsigned long lastSampleTime = 0;
+
+    static void taskEntry(void* monitor) {
+        static_cast<SafetyMonitor*>(monitor)->run();
+    }
+
+    // Same outputs FanController drives, written directly so the loop is not involved
+    void driveFullAirflow() {
+        digitalWrite(Config::Pins::MOSFET_PIN, HIGH);
+        pwm.setDuty(1.0f);
+    }
+
+    void run() {
+        TickType_t wake = xTaskGetTickCount();
+        unsigned long lastSafeSample = millis();
+        unsigned long interval = Config::Safety::SAMPLE_INTERVAL;
+        for (;;) {
+            vTaskDelayUntil(&wake, pdMS_TO_TICKS(interval));
+
+            unsigned long sampleStart = millis();
+            float temperature = NAN;
+            float humidity = NAN;
+            bool valid = bus.read(temperature, humidity, Config::Safety::BUS_TIMEOUT) &&
+                         SafetyTrip::isValid(temperature);
+            uint32_t measured = micros();
+            unsigned long now = millis();
+
+            SafetyTrip::Reason before = trip.getReason();
+            SafetyTrip::Reason reason = trip.update(valid, temperature, now);
+            if (reason != SafetyTrip::Reason::NONE) {
+                // Flag first, so a duty the loop writes from now on is already the override
+                active.store(true);
+                driveFullAirflow();  // Re-asserted every sample while tripped
+            } else if (before != SafetyTrip::Reason::NONE) {
+                active.store(false);
+            }
+            uint32_t actionLatency = micros() - measured;
+            interval = trip.nextInterval();
+
+            portENTER_CRITICAL(&lock);
+            sampleCount++;
+            sampleInterval = interval;
+            if (valid) {
+                lastTemperature = temperature;
+                lastSampleTime = now;
+            } else {
+                failedSamples++;
+            }
+            if (reason != SafetyTrip::Reason::NONE && before == SafetyTrip::Reason::NONE) {
+                lastEvent.reason = reason;
+                lastEvent.tripTemperature = valid ? temperature : lastTemperature;
+                lastEvent.peakTemperature = lastEvent.tripTemperature;
+                lastEvent.tripTime = now;
+                lastEvent.actionLatencyUs = actionLatency;
+                long sinceSafe = static_cast<long>(millis() - lastSafeSample);
+                lastEvent.responseMs = sinceSafe > 0 ? sinceSafe : 0;  // Negative for a rise above MAX_RISE_RATE
+                if (lastEvent.responseMs > worstResponseMs) worstResponseMs = lastEvent.responseMs;
+                latched = true;
+                tripCount++;
+            } else if (reason != SafetyTrip::Reason::NONE && valid &&
+                       !(temperature <= lastEvent.peakTemperature)) {
+                lastEvent.peakTemperature = temperature;
+            }
+            portEXIT_CRITICAL(&lock);
+
+            if (reason != SafetyTrip::Reason::NONE && before == SafetyTrip::Reason::NONE) {
+                EventLog::record(EventLog::Code::SAFETY_TRIP, static_cast<uint8_t>(reason),
+                                 EventLog::centi(valid ? temperature : lastTemperature));
+                LOG_PRINT("DEBUG: Safety trip (");
+                LOG_PRINT(SafetyTrip::reasonName(reason));
+                LOG_PRINT(") at ");
+                LOG_PRINT(temperature);
+                LOG_PRINTLN("°C, full airflow");
+            }
+            if (reason == SafetyTrip::Reason::NONE && before != SafetyTrip::Reason::NONE) {
+                EventLog::record(EventLog::Code::SAFETY_RELEASE, 0, EventLog::centi(temperature));
+            }
+            if (!valid || temperature < SafetyTrip::TRIP_TEMP) {
+                lastSafeSample = sampleStart + interval - Config::Safety::SAMPLE_INTERVAL;
+            }
+        }
+    }
+
+public:
+    SafetyMonitor(SensorBus& sensorBus, PwmDriver& pwmDriver) : bus(sensorBus), pwm(pwmDriver) {}
+
+    // After the sensor and the PWM are initialized
+    void begin() {
+        if (task) return;
+        if (xTaskCreate(taskEntry, "safety", Config::Safety::TASK_STACK_SIZE, this,
+                        Config::Safety::TASK_PRIORITY, &task) != pdPASS) {
+            task = nullptr;
+            LOG_PRINTLN("DEBUG: Failed to start safety monitor");
+            return;
+        }
+        LOG_PRINT("DEBUG: Safety monitor started, trip at ");
+        LOG_PRINT(SafetyTrip::TRIP_TEMP);
+        LOG_PRINTLN("°C");
+    }
+
+    // Full airflow required; safe to call from any task
+    bool overrideActive() const {
+        return active.load();
+    }
+
+    const std::atomic<bool>& overrideFlag() const {
+        return active;
+    }
+
+    // Samples taken so far; each one the chip was not awake for is a wakeup
+    uint32_t getSampleCount() {
+        portENTER_CRITICAL(&lock);
+        uint32_t samples = sampleCount;
+        portEXIT_CRITICAL(&lock);
+        return samples;
+    }
+
+    // Called from the loop: publishes the latched state in the status
+    void update(SystemStatus& status) {
+        portENTER_CRITICAL(&lock);
+        status.safety.overrideActive = active.load();
+        status.safety.latched = latched;
+        status.safety.reason = SafetyTrip::reasonName(lastEvent.reason);
+        status.safety.tripCount = tripCount;
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // Acknowledges the last event; a trip still in progress stays active
+    void clearLatch() {
+        portENTER_CRITICAL(&lock);
+        latched = active.load();
+        portEXIT_CRITICAL(&lock);
+    }
+
+    void toJson(TextWriter& out) {
+        auto printTemperature = [&out](float value) {
+            if (isnan(value)) {
+                out.print("null");
+            } else {
+                out.print(value, 2);
+            }
+        };
+
+        portENTER_CRITICAL(&lock);
+        Event event = lastEvent;
+        bool eventLatched = latched;
+        uint32_t trips = tripCount;
+        uint32_t worst = worstResponseMs;
+        uint32_t samples = sampleCount;
+        uint32_t failed = failedSamples;
+        float temperature = lastTemperature;
+        unsigned long sampleTime = lastSampleTime;
+        unsigned long interval = sampleInterval;
+        portEXIT_CRITICAL(&lock);
+
+        out.print("{\"running\":").print(task != nullptr);
+        out.print(",\"override_active\":").print(overrideActive());
+        out.print(",\"latched\":").print(eventLatched);
+        out.print(",\"trip_temperature\":").print(SafetyTrip::TRIP_TEMP, 1);
+        out.print(",\"release_temperature\":").print(SafetyTrip::RELEASE_TEMP, 1);
+        out.print(",\"sample_interval_ms\":").print(interval);
+        out.print(",\"max_rise_rate\":").print(Config::Safety::MAX_RISE_RATE, 1);
+        out.print(",\"guaranteed_response_ms\":").print(Config::Safety::MAX_RESPONSE_TIME);
+        out.print(",\"temperature\":");
+        printTemperature(temperature);
+        out.print(",\"sample_age_ms\":").print(millis() - sampleTime);
+        out.print(",\"samples\":").print(samples);
+        out.print(",\"failed_samples\":").print(failed);
+        out.print(",\"trip_count\":").print(trips);
+        out.print(",\"worst_response_ms\":").print(worst);
+        out.print(",\"last_event\":");
+        if (event.reason == SafetyTrip::Reason::NONE) {
+            out.print("null}");
+            return;
+        }
+        out.print("{\"reason\":\"").print(SafetyTrip::reasonName(event.reason)).print('"');
+        out.print(",\"temperature\":");
+        printTemperature(event.tripTemperature);
+        out.print(",\"peak_temperature\":");
+        printTemperature(event.peakTemperature);
+        out.print(",\"age_ms\":").print(millis() - event.tripTime);
+        out.print(",\"action_latency_us\":").print(event.actionLatencyUs);
+        out.print(",\"response_ms\":").print(event.responseMs).print("}}");
+    }
+};
+
+#endif // SAFETY_MONITOR_H
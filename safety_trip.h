@@ -0,0 +1,104 @@
+#ifndef SAFETY_TRIP_H
+#define SAFETY_TRIP_H
+
+#include <math.h>
+#include <stdint.h>
+#include "config.h"
+
+// Trip decision of the safety monitor, one call per safety sample. Free of hardware access so
+// tools/safety_latency_sim.cpp runs the same code on a host.
+// A single valid sample at or above the trip temperature trips; the trip holds until valid
+// samples stayed below the release temperature for RELEASE_HOLD. Losing the sensor while the
+// last valid temperature was in the operating range also trips, as the fire may still be burning.
+// nextInterval() stretches the sampling period while the temperature is far below the trip
+// temperature: a rise of up to MAX_RISE_RATE still reaches full airflow within MAX_RESPONSE_TIME,
+// and while hot the period stays within SENSOR_LOSS_TIMEOUT so sensor loss is caught as before.
+class SafetyTrip {
+public:
+    enum class Reason : uint8_t {
+        NONE,
+        OVER_TEMPERATURE,
+        SENSOR_LOSS
+    };
+
+    static constexpr float TRIP_TEMP = Config::MAX_TEMP - Config::Safety::TRIP_MARGIN;
+    static constexpr float RELEASE_TEMP = TRIP_TEMP - Config::Safety::RELEASE_HYSTERESIS;
+
+private:
+    static constexpr float MIN_VALID_TEMP = -40.0f;
+    static constexpr float MAX_VALID_TEMP = 125.0f;
+
+    Reason reason = Reason::NONE;
+    bool haveValid = false;
+    bool lastSampleValid = false;
+    float lastValidTemp = 0.0f;
+    unsigned long lastValidTime = 0;
+    unsigned long coolSince = 0;
+
+public:
+    static bool isValid(float temperature) {
+        return !isnan(temperature) && temperature >= MIN_VALID_TEMP && temperature <= MAX_VALID_TEMP;
+    }
+
+    static const char* reasonName(Reason value) {
+        switch (value) {
+            case Reason::OVER_TEMPERATURE: return "over_temperature";
+            case Reason::SENSOR_LOSS:      return "sensor_loss";
+            default:                       return "none";
+        }
+    }
+
+    // valid is false for a failed read; returns the reason while full airflow is required
+    Reason update(bool valid, float temperature, unsigned long now) {
+        valid = valid && isValid(temperature);
+        lastSampleValid = valid;
+        if (valid) {
+            haveValid = true;
+            lastValidTemp = temperature;
+            lastValidTime = now;
+
+            if (temperature >= TRIP_TEMP) {
+                reason = Reason::OVER_TEMPERATURE;
+                coolSince = now;
+            } else if (reason != Reason::NONE) {
+                if (temperature >= RELEASE_TEMP) {
+                    coolSince = now;
+                } else if (now - coolSince >= Config::Safety::RELEASE_HOLD) {
+                    reason = Reason::NONE;
+                }
+            }
+            return reason;
+        }
+
+        if (reason == Reason::NONE && haveValid && lastValidTemp >= Config::TEMP_THRESHOLD &&
+            now - lastValidTime >= Config::Safety::SENSOR_LOSS_TIMEOUT) {
+            reason = Reason::SENSOR_LOSS;
+        }
+        if (reason != Reason::NONE) {
+            coolSince = now;  // Only valid samples can release
+        }
+        return reason;
+    }
+
+    // Time until the next sample in ms. The crossing cannot come earlier than the distance to
+    // the trip temperature at MAX_RISE_RATE, so the next sample may come that much later than
+    // one SAMPLE_INTERVAL after it.
+    unsigned long nextInterval() const {
+        if (reason != Reason::NONE || !lastSampleValid) {
+            return Config::Safety::SAMPLE_INTERVAL;  // Release hold and sensor loss count samples
+        }
+        float headroom = (TRIP_TEMP - lastValidTemp) / Config::Safety::MAX_RISE_RATE * 1000.0f;
+        unsigned long interval = Config::Safety::MAX_SAMPLE_INTERVAL;
+        if (lastValidTemp >= Config::TEMP_THRESHOLD) {
+            interval = Config::Safety::SENSOR_LOSS_TIMEOUT;
+        }
+        if (headroom < interval - Config::Safety::SAMPLE_INTERVAL) {
+            interval = Config::Safety::SAMPLE_INTERVAL + static_cast<unsigned long>(headroom > 0.0f ? headroom : 0.0f);
+        }
+        return interval;
+    }
+
+    Reason getReason() const { return reason; }
+};
+
+#endif // SAFETY_TRIP_H
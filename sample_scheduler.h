@@ -0,0 +1,90 @@
+#ifndef SAMPLE_SCHEDULER_H
+#define SAMPLE_SCHEDULER_H
+
+#include <math.h>
+#include <stdint.h>
+#include "config.h"
+
+// Sensor interval driven by the temperature signal instead of fixed mode intervals. The interval
+// follows the filtered slope, so the temperature moves by about TARGET_STEP between samples.
+// A sample that misses the prediction from the previous sample and slope by more than
+// RESIDUAL_LIMIT drops the interval to MIN_INTERVAL: a fire lit between two slow samples shows
+// up on the first sample after it, long before the slope window has caught up.
+// The interval shrinks at once, and grows by at most INTERVAL_GROWTH per
+// sample when it is flat, but only after the slope window has refilled at the shorter interval.
+// The interval is bounded by MIN_INTERVAL and the maximum for the current mode.
+// Free of hardware access so tools/sampling_sim.cpp runs the same code on a host.
+class SampleScheduler {
+private:
+    unsigned long interval = Config::Sensor::MIN_INTERVAL;
+    float lastValue = 0.0f;               // Accepted value at the last sample
+    float predictedSlope = 0.0f;          // Slope at the last sample in °C/min
+    unsigned long lastSampleTime = 0;
+    bool havePrediction = false;
+    float residual = 0.0f;
+    float rate = 0.0f;
+    int holdSamples = 0;                  // Samples before the interval may grow again
+
+    // Samples counted per hour; the last full hour is reported once available
+    unsigned long hourStart = 0;
+    uint32_t hourSamples = 0;
+    uint32_t lastHourSamples = 0;
+    bool hourComplete = false;
+
+    void countSample(unsigned long now) {
+        if (now - hourStart >= 3600000UL) {
+            lastHourSamples = hourSamples;
+            hourComplete = true;
+            hourSamples = 0;
+            hourStart = now;
+        }
+        hourSamples++;
+    }
+
+public:
+    // One accepted sample through the filter; returns the interval until the next one.
+    // maxInterval is the bound for the current mode.
+    unsigned long update(float value, float slope, unsigned long now, unsigned long maxInterval) {
+        countSample(now);
+
+        bool missed = false;
+        if (havePrediction) {
+            float minutes = (now - lastSampleTime) / 60000.0f;
+            residual = fabsf(value - (lastValue + predictedSlope * minutes));
+            missed = residual > Config::Sensor::RESIDUAL_LIMIT;
+        }
+        lastValue = value;
+        predictedSlope = slope;
+        lastSampleTime = now;
+        havePrediction = true;
+        rate = fabsf(slope);
+
+        // A missed prediction means the trend changed and the slope lags behind it
+        float desired = missed ? 0.0f
+                      : rate > 0.0f ? Config::Sensor::TARGET_STEP / rate * 60000.0f
+                      : static_cast<float>(maxInterval);
+        if (desired < interval) {
+            // The slope is only trusted again once its window holds samples at the new rate
+            holdSamples = Config::Sensor::SLOPE_WINDOW;
+        } else if (holdSamples > 0) {
+            holdSamples--;
+            desired = static_cast<float>(interval);
+        }
+        float grown = interval * Config::Sensor::INTERVAL_GROWTH;
+        float next = fminf(fminf(desired, grown), static_cast<float>(maxInterval));
+        interval = static_cast<unsigned long>(fmaxf(next, static_cast<float>(Config::Sensor::MIN_INTERVAL)));
+        return interval;
+    }
+
+    unsigned long getInterval() const { return interval; }
+    float getResidual() const { return residual; }
+    float getRate() const { return rate; }
+
+    float samplesPerHour(unsigned long now) const {
+        if (hourComplete) return static_cast<float>(lastHourSamples);
+        unsigned long elapsed = now - hourStart;
+        return elapsed > 0 ? hourSamples * 3600000.0f / elapsed : 0.0f;
+    }
+};
+
+#endif // SAMPLE_SCHEDULER_H
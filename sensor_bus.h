@@ -0,0 +1,42 @@
+#ifndef SENSOR_BUS_H
+#define SENSOR_BUS_H
+
+#include <Arduino.h>
+#include <Adafruit_SHT4x.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// The SHT4x shared by the loop task and the safety monitor task. A mutex serializes the
+// measurements, so one task never interrupts the other's I2C transfer.
+class SensorBus {
+private:
+    Adafruit_SHT4x& sht4;
+    SemaphoreHandle_t mutex = nullptr;
+
+public:
+    explicit SensorBus(Adafruit_SHT4x& sensor) : sht4(sensor) {}
+
+    // Before the first read and before other tasks start
+    void begin() {
+        if (!mutex) mutex = xSemaphoreCreateMutex();
+    }
+
+    Adafruit_SHT4x& sensor() { return sht4; }
+
+    // One measurement; false if the bus stayed busy for timeoutMs or the sensor did not answer
+    bool read(float& temperature, float& humidity, unsigned long timeoutMs = portMAX_DELAY) {
+        if (mutex && xSemaphoreTake(mutex, timeoutMs == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs)) != pdTRUE) {
+            return false;
+        }
+        sensors_event_t humidityEvent, temperatureEvent;
+        bool success = sht4.getEvent(&humidityEvent, &temperatureEvent);
+        if (mutex) xSemaphoreGive(mutex);
+
+        if (!success) return false;
+        temperature = temperatureEvent.temperature;
+        humidity = humidityEvent.relative_humidity;
+        return true;
+    }
+};
+
+#endif // SENSOR_BUS_H
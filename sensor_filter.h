@@ -0,0 +1,183 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <math.h>
+#include "config.h"
+
+// Incremental filter pipeline for the temperature signal, run once per sensor sample:
+//   1. median-of-N window for despiking (Hampel style: outliers are replaced by the median)
+//   2. exponential smoother with a time constant, so irregular sample intervals are handled
+//   3. sliding-window least-squares slope, maintained in O(1) per sample
+// Also tracks stuck readings, so all plausibility state lives in one place.
+class SensorFilter {
+public:
+    struct Result {
+        float despiked;     // Raw value, or the window median if the raw value was a spike
+        float smoothed;     // Exponentially smoothed temperature in °C
+        float slope;        // Least-squares temperature slope in °C/min
+        bool spike;         // Raw value deviated too far from the window median
+        bool stuck;         // Identical readings for too many samples in a row
+    };
+
+private:
+    static constexpr int MEDIAN_SIZE = Config::Sensor::MEDIAN_WINDOW;
+    static constexpr int SLOPE_SIZE = Config::Sensor::SLOPE_WINDOW;
+    static constexpr int RESYNC_SAMPLES = 256;   // Recompute slope sums to cancel float drift
+
+    // Median window (raw values, including rejected ones so real steps pass after N/2 samples)
+    float medianWindow[MEDIAN_SIZE] = {0};
+    int medianIndex = 0;
+    int medianCount = 0;
+
+    // Smoother state
+    float smoothed = 0.0f;
+    unsigned long lastSmoothTime = 0;
+    bool smootherInitialized = false;
+
+    // Slope window; x is time in seconds relative to the newest sample
+    float slopeValues[SLOPE_SIZE] = {0};
+    unsigned long slopeTimes[SLOPE_SIZE] = {0};
+    int slopeIndex = 0;
+    int slopeCount = 0;
+    float sumX = 0.0f;
+    float sumY = 0.0f;
+    float sumXX = 0.0f;
+    float sumXY = 0.0f;
+    int samplesSinceResync = 0;
+    float slope = 0.0f;
+
+    // Stuck value detection
+    float lastTemp = -300.0f;
+    float lastHum = -300.0f;
+    uint8_t sameValueCount = 0;
+
+    float pushMedian(float value) {
+        medianWindow[medianIndex] = value;
+        medianIndex = (medianIndex + 1) % MEDIAN_SIZE;
+        if (medianCount < MEDIAN_SIZE) medianCount++;
+
+        // Insertion sort of a copy, N is small and fixed
+        float sorted[MEDIAN_SIZE] = {0};
+        for (int i = 0; i < medianCount; i++) {
+            float v = medianWindow[i];
+            int j = i;
+            while (j > 0 && sorted[j - 1] > v) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = v;
+        }
+        return sorted[medianCount / 2];
+    }
+
+    void updateSmoother(float value, unsigned long timestamp) {
+        if (!smootherInitialized) {
+            smoothed = value;
+            smootherInitialized = true;
+        } else {
+            float dt = (timestamp - lastSmoothTime) / 1000.0f;
+            float alpha = dt / (Config::Sensor::SMOOTHING_TIME_CONSTANT + dt);
+            smoothed += alpha * (value - smoothed);
+        }
+        lastSmoothTime = timestamp;
+    }
+
+    float relativeTime(int index, unsigned long newest) const {
+        return -static_cast<float>(newest - slopeTimes[index]) / 1000.0f;
+    }
+
+    void resyncSlopeSums(unsigned long newest) {
+        sumX = sumY = sumXX = sumXY = 0.0f;
+        for (int i = 0; i < slopeCount; i++) {
+            int index = (slopeIndex - 1 - i + SLOPE_SIZE) % SLOPE_SIZE;
+            float x = relativeTime(index, newest);
+            sumX += x;
+            sumY += slopeValues[index];
+            sumXX += x * x;
+            sumXY += x * slopeValues[index];
+        }
+        samplesSinceResync = 0;
+    }
+
+    void updateSlope(float value, unsigned long timestamp) {
+        if (slopeCount > 0) {
+            // Move the origin to the new sample: x -> x - dx for every stored point
+            int newestIndex = (slopeIndex - 1 + SLOPE_SIZE) % SLOPE_SIZE;
+            float dx = (timestamp - slopeTimes[newestIndex]) / 1000.0f;
+            float n = static_cast<float>(slopeCount);
+            sumXX += -2.0f * dx * sumX + n * dx * dx;
+            sumXY -= dx * sumY;
+            sumX -= n * dx;
+        }
+
+        if (slopeCount == SLOPE_SIZE) {
+            // Drop the oldest point, which is overwritten below
+            float x = relativeTime(slopeIndex, timestamp);
+            float y = slopeValues[slopeIndex];
+            sumX -= x;
+            sumY -= y;
+            sumXX -= x * x;
+            sumXY -= x * y;
+        } else {
+            slopeCount++;
+        }
+
+        // New point sits at x = 0
+        slopeValues[slopeIndex] = value;
+        slopeTimes[slopeIndex] = timestamp;
+        slopeIndex = (slopeIndex + 1) % SLOPE_SIZE;
+        sumY += value;
+
+        if (++samplesSinceResync >= RESYNC_SAMPLES) {
+            resyncSlopeSums(timestamp);
+        }
+
+        float n = static_cast<float>(slopeCount);
+        float denominator = n * sumXX - sumX * sumX;
+        slope = (slopeCount >= 2 && denominator > 1e-6f)
+            ? ((n * sumXY - sumX * sumY) / denominator) * 60.0f
+            : 0.0f;
+    }
+
+    bool checkStuck(float temperature, float humidity) {
+        if (temperature == lastTemp && humidity == lastHum) {
+            if (sameValueCount < 255) sameValueCount++;
+        } else {
+            sameValueCount = 0;
+        }
+        lastTemp = temperature;
+        lastHum = humidity;
+        return sameValueCount >= Config::Sensor::MAX_SAME_VALUE_COUNT;
+    }
+
+public:
+    // Runs one sample through the pipeline. Rejected samples (spike or stuck) only enter
+    // the median window; the smoother and slope keep their previous state.
+    Result update(float temperature, float humidity, unsigned long timestamp) {
+        Result result;
+        float median = pushMedian(temperature);
+        result.spike = medianCount == MEDIAN_SIZE &&
+                       fabsf(temperature - median) > Config::Sensor::MAX_SPIKE_DEVIATION;
+        result.stuck = checkStuck(temperature, humidity);
+        result.despiked = result.spike ? median : temperature;
+
+        if (!result.spike && !result.stuck) {
+            updateSmoother(result.despiked, timestamp);
+            updateSlope(result.despiked, timestamp);
+        }
+
+        result.smoothed = smoothed;
+        result.slope = slope;
+        return result;
+    }
+
+    float getSmoothed() const {
+        return smoothed;
+    }
+
+    float getSlope() const {
+        return slope;
+    }
+};
+
+#endif // SENSOR_FILTER_H
@@ -4,146 +4,131 @@
 #include <Adafruit_SHT4x.h>
 #include <Wire.h>
 #include "config.h"
+#include "logging.h"
+#include "sensor_bus.h"
 #include "system_status.h"
 #include "fan_controller.h"
+#include "sensor_filter.h"
+#include "sample_scheduler.h"
+#include "event_log.h"
 
 class SensorManager {
 private:
-    Adafruit_SHT4x& sht4;
+    SensorBus& bus;
     SystemStatus& status;
     FanController& controller;
     
     uint8_t errorCount = 0;
+    unsigned long lastUpdate = 0;
     static constexpr uint8_t MAX_ERRORS = 3;
     
-    // Temperature history for spike detection
-    static constexpr int TEMP_HISTORY_SIZE = 5;
-    float tempHistory[TEMP_HISTORY_SIZE] = {0};
-    int tempHistoryIndex = 0;
-    bool historyInitialized = false;
+    // Shared filter pipeline (despiking, smoothing, slope, stuck detection)
+    SensorFilter filter;
 
-    // Adaptive sampling intervals
-    static constexpr unsigned long SLEEP_MODE_INTERVAL = 10000;   // 10 seconds in sleep mode
-    static constexpr unsigned long ACTIVE_MODE_INTERVAL = 2000;   // 2 seconds in active mode
-    static constexpr unsigned long NIGHT_MODE_INTERVAL = 15000;   // 15 seconds during night hours
+    // Interval from the rate of change of the filtered signal
+    SampleScheduler scheduler;
 
     // Validity thresholds
     static constexpr float MIN_VALID_TEMP = -40.0f;
     static constexpr float MAX_VALID_TEMP = 125.0f;
     static constexpr float MIN_VALID_HUM = 0.0f;
     static constexpr float MAX_VALID_HUM = 100.0f;
-    static constexpr float MAX_TEMP_CHANGE = 5.0f;  // Maximum plausible temperature change per second
 
     unsigned long getSensorInterval() {
-        time_t now;
-        time(&now);
-        struct tm* timeinfo = localtime(&now);
-        
-        // Night mode (22:00 - 06:00)
-        if (timeinfo->tm_hour >= 22 || timeinfo->tm_hour < 6) {
-            return NIGHT_MODE_INTERVAL;
-        }
-        
-        // Sleep/Active mode based on controller state
-        return controller.isInSleepMode() ? SLEEP_MODE_INTERVAL : ACTIVE_MODE_INTERVAL;
+        return scheduler.getInterval();
     }
 
-    void updateTempHistory(float temp) {
-        tempHistory[tempHistoryIndex] = temp;
-        tempHistoryIndex = (tempHistoryIndex + 1) % TEMP_HISTORY_SIZE;
-        
-        if (tempHistoryIndex == 0) {
-            historyInitialized = true;
-        }
+    // Regulation, activity checks and heat accounting need regular samples while the fan runs
+    unsigned long maxSensorInterval() const {
+        return status.fanOn ? Config::Sensor::ACTIVE_MAX_INTERVAL : Config::Sensor::MAX_INTERVAL;
     }
 
-    bool isTemperatureSpike(float temp) {
-        if (!historyInitialized) return false;
+    void updateSampling(float temperature, unsigned long now) {
+        scheduler.update(temperature, status.temperatureSlope, now, maxSensorInterval());
+        status.sampling.intervalMs = scheduler.getInterval();
+        status.sampling.samplesPerHour = scheduler.samplesPerHour(now);
+        status.sampling.residual = scheduler.getResidual();
+        status.sampling.rate = scheduler.getRate();
+    }
 
-        float avgTemp = 0;
-        for (int i = 0; i < TEMP_HISTORY_SIZE; i++) {
-            avgTemp += tempHistory[i];
+    // Journals the first rejected reading of a run; detail 0 range, 1 stuck, 2 spike
+    void reportImplausible(uint8_t check, float temperature) {
+        if (errorCount == 0) {
+            EventLog::record(EventLog::Code::SENSOR_IMPLAUSIBLE, check, EventLog::centi(temperature));
         }
-        avgTemp /= TEMP_HISTORY_SIZE;
-
-        // Check if new temperature deviates significantly from average
-        return abs(temp - avgTemp) > MAX_TEMP_CHANGE;
     }
-    
-    bool checkSensorValues(float temperature, float humidity) {
+
+    bool checkSensorValues(float temperature, float humidity, unsigned long now) {
         // Basic range checks
         if (temperature < MIN_VALID_TEMP || temperature > MAX_VALID_TEMP ||
             humidity < MIN_VALID_HUM || humidity > MAX_VALID_HUM) {
-            Serial.println("DEBUG: Sensor values out of valid range");
+            LOG_PRINTLN("DEBUG: Sensor values out of valid range");
+            reportImplausible(0, temperature);
             return false;
         }
         
-        // Check for "stuck" values
-        static float lastTemp = -300.0f;
-        static float lastHum = -300.0f;
-        static uint8_t sameValueCount = 0;
+        SensorFilter::Result result = filter.update(temperature, humidity, now);
         
-        if (temperature == lastTemp && humidity == lastHum) {
-            sameValueCount++;
-            if (sameValueCount >= 5) {
-                Serial.println("DEBUG: Sensor values appear to be stuck");
-                return false;
-            }
-        } else {
-            sameValueCount = 0;
+        if (result.stuck) {
+            LOG_PRINTLN("DEBUG: Sensor values appear to be stuck");
+            reportImplausible(1, temperature);
+            return false;
         }
         
-        // Check for temperature spikes
-        if (isTemperatureSpike(temperature)) {
-            Serial.println("DEBUG: Temperature spike detected");
+        if (result.spike) {
+            LOG_PRINTLN("DEBUG: Temperature spike detected");
+            reportImplausible(2, temperature);
             return false;
         }
         
-        lastTemp = temperature;
-        lastHum = humidity;
-        updateTempHistory(temperature);
-        
+        status.filteredTemperature = result.smoothed;
+        status.temperatureSlope = result.slope;
         return true;
     }
     
     void updateErrorState(bool success) {
         if (!success) {
             errorCount++;
-            Serial.print("DEBUG: Sensor error count: ");
-            Serial.println(errorCount);
+            LOG_PRINT("DEBUG: Sensor error count: ");
+            LOG_PRINTLN(errorCount);
             
             if (errorCount >= MAX_ERRORS) {
+                if (errorCount == MAX_ERRORS) EventLog::record(EventLog::Code::SENSOR_ERROR);
                 status.errorState = SystemStatus::ErrorState::SENSOR_ERROR;
-                Serial.println("DEBUG: Maximum sensor errors reached");
+                LOG_PRINTLN("DEBUG: Maximum sensor errors reached");
             }
         } else {
             if (errorCount > 0) {
-                Serial.println("DEBUG: Sensor recovered from errors");
+                LOG_PRINTLN("DEBUG: Sensor recovered from errors");
             }
             errorCount = 0;
             if (status.errorState == SystemStatus::ErrorState::SENSOR_ERROR) {
                 status.errorState = SystemStatus::ErrorState::NONE;
+                EventLog::record(EventLog::Code::SENSOR_RECOVERED);
             }
         }
     }
 
 public:
-    SensorManager(Adafruit_SHT4x& sht4Sensor, 
+    SensorManager(SensorBus& sensorBus, 
                  SystemStatus& systemStatus,
                  FanController& fanController)
-        : sht4(sht4Sensor)
+        : bus(sensorBus)
         , status(systemStatus)
         , controller(fanController)
     {
-        Serial.println("DEBUG: Sensor manager initialized");
+        LOG_PRINTLN("DEBUG: Sensor manager initialized");
     }
 
     bool initialize() {
-        Serial.println("DEBUG: Initializing sensor");
+        LOG_PRINTLN("DEBUG: Initializing sensor");
+        bus.begin();
         
+        Adafruit_SHT4x& sht4 = bus.sensor();
         if (!sht4.begin(&Wire)) {
-            Serial.println("DEBUG: Failed to find SHT4x sensor");
+            LOG_PRINTLN("DEBUG: Failed to find SHT4x sensor");
             status.errorState = SystemStatus::ErrorState::SENSOR_ERROR;
+            EventLog::record(EventLog::Code::SENSOR_ERROR);
             return false;
         }
 
@@ -155,12 +140,18 @@ public:
         status.errorState = SystemStatus::ErrorState::NONE;
         errorCount = 0;
         
-        Serial.println("DEBUG: Sensor initialization successful");
+        LOG_PRINTLN("DEBUG: Sensor initialization successful");
         return true;
     }
 
+    // Time in ms until the next sample is due
+    unsigned long msUntilNextSample() {
+        unsigned long elapsed = millis() - lastUpdate;
+        unsigned long interval = getSensorInterval();
+        return elapsed >= interval ? 0 : interval - elapsed;
+    }
+
     bool update() {
-        static unsigned long lastUpdate = 0;
         unsigned long now = millis();
         unsigned long interval = getSensorInterval();
         
@@ -169,41 +160,42 @@ public:
         }
         lastUpdate = now;
 
-        Serial.println("DEBUG: Reading sensor");
+        LOG_PRINTLN("DEBUG: Reading sensor");
         
-        sensors_event_t humidity_event, temp_event;
-        bool success = sht4.getEvent(&humidity_event, &temp_event);
+        float newTemp = 0.0f;
+        float newHum = 0.0f;
+        bool success = bus.read(newTemp, newHum);
         
         if (success) {
-            float newTemp = temp_event.temperature;
-            float newHum = humidity_event.relative_humidity;
-            
-            Serial.print("DEBUG: Temperature reading: ");
-            Serial.print(newTemp);
-            Serial.print("°C, Humidity: ");
-            Serial.print(newHum);
-            Serial.println("%");
+            LOG_PRINT("DEBUG: Temperature reading: ");
+            LOG_PRINT(newTemp);
+            LOG_PRINT("°C, Humidity: ");
+            LOG_PRINT(newHum);
+            LOG_PRINTLN("%");
             
-            if (checkSensorValues(newTemp, newHum)) {
+            if (checkSensorValues(newTemp, newHum, now)) {
                 status.temperature = newTemp;
                 status.humidity = newHum;
+                status.updateAirState();
                 status.updateMinMaxTemperature(newTemp);
                 status.lastSensorUpdate = now;
+                updateSampling(newTemp, now);
                 
                 if (status.autoMode) {
                     controller.updateAutomaticMode();
                 }
                 
-                status.updateOperatingStats();
+#if FEATURE_HEAT_ENGINE
                 status.updateHeatCalculation();
+#endif
                 
                 updateErrorState(true);
                 return true;
             } else {
-                Serial.println("DEBUG: Sensor values failed plausibility check");
+                LOG_PRINTLN("DEBUG: Sensor values failed plausibility check");
             }
         } else {
-            Serial.println("DEBUG: Failed to read sensor");
+            LOG_PRINTLN("DEBUG: Failed to read sensor");
         }
         
         updateErrorState(false);
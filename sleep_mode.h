@@ -0,0 +1,75 @@
+#ifndef SLEEP_MODE_H
+#define SLEEP_MODE_H
+
+#include "config.h"
+
+// Sleep mode of automatic mode below SLEEP_TEMP_THRESHOLD: the fan stays off except for
+// activity checks, and a rising temperature during a check (or above the threshold) ends it.
+// Once the fire has burnt down it is entered again when the fan is off, the temperature is
+// below the threshold and its slope no longer positive. Free of hardware access so tools/sleep_cycle_sim.cpp
+// runs the same code on a host; FanController maps the actions to fan speed and status.
+class SleepMode {
+public:
+    static constexpr float SLEEP_TEMP_THRESHOLD = 22.0f;    // Below this temperature -> sleep mode
+    static constexpr float TEMP_RISE_THRESHOLD = 0.2f;      // Temperature slope indicating activity in °C/min
+
+    enum class Action {
+        SLEEP,          // Fan off until the next check
+        START_CHECK,    // Activity check begins, fan at minimum speed
+        CHECK,          // Activity check running
+        FIRE_START,     // Rising temperature in sleep mode, sleep mode left
+        ACTIVE,         // Rising temperature outside sleep mode
+        COOL_DOWN,      // Cooled below the threshold with the fan still running: fan off first
+        ENTER_SLEEP     // Fan off and not rising: sleep mode entered
+    };
+
+private:
+    bool sleeping = true;
+    unsigned long lastCheck = 0;
+
+public:
+    // Allows an immediate first check
+    void begin(unsigned long now, unsigned long checkInterval) {
+        lastCheck = now - checkInterval;
+    }
+
+    // Pass below SLEEP_TEMP_THRESHOLD (and no fan curve asking for airflow)
+    Action belowThreshold(float slope, bool fanRunning, unsigned long now, unsigned long checkInterval) {
+        bool rising = slope > TEMP_RISE_THRESHOLD;
+        if (!sleeping) {
+            if (rising) return Action::ACTIVE;
+            if (fanRunning || slope > 0.0f) return Action::COOL_DOWN;
+            sleeping = true;
+            lastCheck = now;    // The fire just ended, the next check follows a full interval
+            return Action::ENTER_SLEEP;
+        }
+
+        Action action;
+        if (now - lastCheck >= checkInterval) {
+            lastCheck = now;
+            action = Action::START_CHECK;
+        } else if (now - lastCheck < Config::CHECK_DURATION) {
+            action = Action::CHECK;
+        } else {
+            return Action::SLEEP;
+        }
+        if (rising) {
+            sleeping = false;
+            return Action::FIRE_START;
+        }
+        return action;
+    }
+
+    // Pass at or above SLEEP_TEMP_THRESHOLD; true when it ended sleep mode on a rising
+    // temperature, a fire start
+    bool aboveThreshold(float slope) {
+        bool fireStart = sleeping && slope > TEMP_RISE_THRESHOLD;
+        sleeping = false;
+        return fireStart;
+    }
+
+    bool isSleeping() const { return sleeping; }
+    unsigned long getLastCheck() const { return lastCheck; }
+};
+
+#endif // SLEEP_MODE_H
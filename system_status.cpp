@@ -1,129 +1,338 @@
 #include "system_status.h"
 #include "config.h"
+#include "logging.h"
+#include "psychrometrics.h"
 
 SystemStatus::SystemStatus() :
     temperature(0.0f),
     minTemperature(100.0f),
     maxTemperature(-40.0f),
     humidity(0.0f),
+    filteredTemperature(0.0f),
+    temperatureSlope(0.0f),
+    dewPoint(0.0f),
+    absoluteHumidity(0.0f),
+    enthalpy(0.0f),
+    humidityRatio(0.0f),
+    dryAirDensity(Config::Heat::AIR_DENSITY),
     autoMode(true),
     fanOn(false),
     manualFanSpeed(0.5f),
     currentFanSpeed(0.0f),
     targetFanSpeed(0.0f),
     fanRPM(0.0f),
-    autoModeStatus("System started"),
+    fanDuty(0.0f),
+    targetRPM(0.0f),
+    rpmError(0.0f),
+    rpmErrorAverage(0.0f),
+    statusCode(StatusCode::STARTED),
+    statusValue(0),
     lastSensorUpdate(0),
     lastRPMUpdate(0),
+#if FEATURE_HEAT_ENGINE
     lastHeatCalc(0),
+#endif
     errorState(ErrorState::NONE),
     manualOverride(false),
-    rpmErrorCount(0),
-    totalOperatingTime(0),
+    rpmErrorCount(0)
+#if FEATURE_STATISTICS
+    , totalOperatingTime(0),
     fanOperatingTime(0),
     energyUsage(0.0f),
-    referenceTemp(0.0f),
+    fanPower(0.0f),
+    coefficientOfPerformance(0.0f)
+#endif
+#if FEATURE_HEAT_ENGINE
+    , referenceTemp(0.0f),
+    referenceHumidityRatio(0.0f),
     totalHeatEnergy(0.0f),
     currentHeatPower(0.0f),
+    latentHeatPower(0.0f),
     airVolumeMoved(0.0f),
     heatCalcInitialized(false)
+#endif
 {
-    initializeSystem();
+    memset(fieldHashes, 0, sizeof(fieldHashes));
+    memset(fieldVersions, 0, sizeof(fieldVersions));
 }
 
+#if FEATURE_HEAT_ENGINE
+// Ambient reference from the current sample. Heating leaves the humidity ratio of the room air
+// unchanged, so a sample taken while the stove is already hot still gives the ambient moisture;
+// its temperature is capped at the fire threshold.
 void SystemStatus::initializeSystem() {
     heatCalcInitialized = true;
-    referenceTemp = temperature;
+    referenceTemp = min(temperature, Config::TEMP_THRESHOLD);
+    referenceHumidityRatio = humidityRatio;
     lastHeatCalc = millis();
     
-    Serial.println("Heat calculation initialized:");
-    Serial.print("Reference Temperature: ");
-    Serial.println(referenceTemp);
+    LOG_PRINTLN("Heat calculation initialized:");
+    LOG_PRINT("Reference Temperature: ");
+    LOG_PRINTLN(referenceTemp);
 }
+#endif
 
 bool SystemStatus::setAutoMode(bool enable) {
     autoMode = enable;
     if (!enable) {
         manualFanSpeed = currentFanSpeed > 0.0f ? currentFanSpeed : 0.5f;
     }
-    Serial.print("Mode changed to: ");
-    Serial.println(enable ? "Automatic" : "Manual");
+    LOG_PRINT("Mode changed to: ");
+    LOG_PRINTLN(enable ? "Automatic" : "Manual");
     return true;
 }
 
+void SystemStatus::updateAirState() {
+    Psychrometrics::AirState air = Psychrometrics::airState(temperature, humidity);
+    dewPoint = air.dewPoint;
+    absoluteHumidity = air.absoluteHumidity;
+    enthalpy = air.enthalpy;
+    humidityRatio = air.humidityRatio;
+    dryAirDensity = air.dryAirDensity;
+}
+
+#if FEATURE_HEAT_ENGINE
+// Call with each valid sample. The reference follows the ambient air while the fan is off and
+// the stove is cold, so each fire is measured against the room it started in.
 void SystemStatus::updateHeatCalculation() {
+    unsigned long now = millis();
     if (!heatCalcInitialized) {
         initializeSystem();
     }
     
-    if (!fanOn) return;
+    if (!fanOn) {
+        if (temperature < Config::TEMP_THRESHOLD) {
+            referenceTemp = temperature;
+            referenceHumidityRatio = humidityRatio;
+        }
+        currentHeatPower = 0.0f;
+        latentHeatPower = 0.0f;
+        lastHeatCalc = now;
+        return;
+    }
     
-    unsigned long now = millis();
     float deltaTime = (now - lastHeatCalc) / 1000.0f;
     lastHeatCalc = now;
     
     float tempDiff = temperature - referenceTemp;
     if (tempDiff > Config::Heat::MIN_TEMP_DIFF) {
-        float airflow = (Config::Heat::MAX_AIRFLOW / 3600.0f) * currentFanSpeed;
-        float airDensity = Config::Heat::AIR_DENSITY * (293.15f / (temperature + 273.15f));
+        // Airflow scales with the measured speed; fall back to the commanded airflow without tach
+        float airflowFraction = fanRPM > 0.0f ? min(fanRPM / Config::Fan::MAX_RPM, 1.0f) : currentFanSpeed;
+        float airflow = (Config::Heat::MAX_AIRFLOW / 3600.0f) * airflowFraction;
         
-        currentHeatPower = airDensity * airflow * 
-                         Config::Heat::AIR_SPECIFIC_HEAT * 
-                         tempDiff * 
-                         Config::Heat::SYSTEM_EFFICIENCY;
+        // Enthalpy gain of the dry air mass flow over the reference state (kJ/kg -> J/kg),
+        // sensible plus latent heat of the moisture the air picked up
+        float massFlow = dryAirDensity * airflow;
+        float enthalpyGain = enthalpy - Psychrometrics::enthalpy(referenceTemp, referenceHumidityRatio);
+        currentHeatPower = max(massFlow * enthalpyGain * 1000.0f * Config::Heat::SYSTEM_EFFICIENCY, 0.0f);
+        latentHeatPower = massFlow * (humidityRatio - referenceHumidityRatio) *
+                          Psychrometrics::LATENT_HEAT * 1000.0f * Config::Heat::SYSTEM_EFFICIENCY;
         
         totalHeatEnergy += (currentHeatPower * deltaTime) / 3600000.0f;
         airVolumeMoved += airflow * deltaTime;
+    } else {
+        currentHeatPower = 0.0f;
+        latentHeatPower = 0.0f;
     }
 }
+#endif
 
-String SystemStatus::toJson() const {
-    String json = "{";
-    
+// Serialized fields in output order. Nested objects count as one field for selection and versioning.
+const SystemStatus::Field SystemStatus::FIELDS[] = {
     // Basic sensor data
-    json += "\"temperature\":" + String(temperature, 1);
-    json += ",\"min_temperature\":" + String(minTemperature, 1);
-    json += ",\"max_temperature\":" + String(maxTemperature, 1);
-    json += ",\"humidity\":" + String(humidity, 1);
-    
+    {"temperature", [](const SystemStatus& s, TextWriter& out) { out.print(s.temperature, 1); }},
+    {"min_temperature", [](const SystemStatus& s, TextWriter& out) { out.print(s.minTemperature, 1); }},
+    {"max_temperature", [](const SystemStatus& s, TextWriter& out) { out.print(s.maxTemperature, 1); }},
+    {"humidity", [](const SystemStatus& s, TextWriter& out) { out.print(s.humidity, 1); }},
+    {"filtered_temperature", [](const SystemStatus& s, TextWriter& out) { out.print(s.filteredTemperature, 2); }},
+    {"temperature_slope", [](const SystemStatus& s, TextWriter& out) { out.print(s.temperatureSlope, 3); }},
+    {"dew_point", [](const SystemStatus& s, TextWriter& out) { out.print(s.dewPoint, 1); }},
+    {"absolute_humidity", [](const SystemStatus& s, TextWriter& out) { out.print(s.absoluteHumidity, 2); }},
+    {"enthalpy", [](const SystemStatus& s, TextWriter& out) { out.print(s.enthalpy, 1); }},
+    {"sampling", [](const SystemStatus& s, TextWriter& out) {
+        out.print("{\"interval_ms\":").print(s.sampling.intervalMs);
+        out.print(",\"samples_per_hour\":").print(s.sampling.samplesPerHour, 0);
+        out.print(",\"residual\":").print(s.sampling.residual, 2);
+        out.print(",\"rate\":").print(s.sampling.rate, 2).print('}');
+    }},
+
     // Operation mode
-    json += ",\"auto_mode\":" + String(autoMode ? "true" : "false");
-    json += ",\"fan_on\":" + String(fanOn ? "true" : "false");
-    
+    {"auto_mode", [](const SystemStatus& s, TextWriter& out) { out.print(s.autoMode); }},
+    {"fan_on", [](const SystemStatus& s, TextWriter& out) { out.print(s.fanOn); }},
+
     // Fan control
-    json += ",\"manual_fan_speed\":" + String(manualFanSpeed, 3);
-    json += ",\"current_fan_speed\":" + String(currentFanSpeed, 3);
-    json += ",\"target_fan_speed\":" + String(targetFanSpeed, 3);
-    json += ",\"fan_rpm\":" + String(fanRPM);
-    
+    {"manual_fan_speed", [](const SystemStatus& s, TextWriter& out) { out.print(s.manualFanSpeed, 3); }},
+    {"current_fan_speed", [](const SystemStatus& s, TextWriter& out) { out.print(s.currentFanSpeed, 3); }},
+    {"target_fan_speed", [](const SystemStatus& s, TextWriter& out) { out.print(s.targetFanSpeed, 3); }},
+    {"fan_rpm", [](const SystemStatus& s, TextWriter& out) { out.print(s.fanRPM, 2); }},
+    {"fan_duty", [](const SystemStatus& s, TextWriter& out) { out.print(s.fanDuty, 3); }},
+    {"target_rpm", [](const SystemStatus& s, TextWriter& out) { out.print(s.targetRPM, 0); }},
+    {"rpm_error", [](const SystemStatus& s, TextWriter& out) { out.print(s.rpmError, 0); }},
+    {"rpm_error_avg", [](const SystemStatus& s, TextWriter& out) { out.print(s.rpmErrorAverage, 0); }},
+    {"fan_health", [](const SystemStatus& s, TextWriter& out) {
+        out.print("{\"model_ready\":").print(s.fanHealth.modelReady);
+        out.print(",\"score\":").print(s.fanHealth.score, 0);
+        out.print(",\"rpm_shortfall_percent\":").print(s.fanHealth.rpmShortfallPercent, 1);
+        out.print(",\"variance_ratio\":").print(s.fanHealth.varianceRatio, 2);
+        out.print(",\"hours_to_maintenance\":").print(s.fanHealth.hoursToMaintenance, 0);
+        out.print(",\"shortfall_warning\":").print(s.fanHealth.shortfallWarning);
+        out.print(",\"variance_warning\":").print(s.fanHealth.varianceWarning);
+        out.print(",\"drift_warning\":").print(s.fanHealth.driftWarning).print('}');
+    }},
+    {"fan_calibration", [](const SystemStatus& s, TextWriter& out) {
+        out.print("{\"calibrated\":").print(s.fanCalibration.calibrated);
+        out.print(",\"running\":").print(s.fanCalibration.running);
+        out.print(",\"state\":\"").print(s.fanCalibration.state);
+        out.print("\",\"failure\":\"").print(s.fanCalibration.failure);
+        out.print("\",\"progress\":").print(s.fanCalibration.progress, 2);
+        out.print(",\"start_duty\":").print(s.fanCalibration.startDuty, 3);
+        out.print(",\"min_duty\":").print(s.fanCalibration.minDuty, 3);
+        out.print(",\"min_rpm\":").print(s.fanCalibration.minRpm, 0);
+        out.print(",\"max_rpm\":").print(s.fanCalibration.maxRpm, 0).print('}');
+    }},
+
+    {"safety", [](const SystemStatus& s, TextWriter& out) {
+        out.print("{\"override_active\":").print(s.safety.overrideActive);
+        out.print(",\"latched\":").print(s.safety.latched);
+        out.print(",\"reason\":\"").print(s.safety.reason);
+        out.print("\",\"trip_count\":").print(s.safety.tripCount).print('}');
+    }},
+    {"wifi", [](const SystemStatus& s, TextWriter& out) {
+        out.print("{\"state\":\"").print(s.wifi.state);
+        out.print("\",\"rssi\":");
+        if (s.wifi.connected) out.print(static_cast<long>(s.wifi.rssi));
+        else out.print("null");
+        out.print(",\"last_disconnect_reason\":").print(static_cast<unsigned int>(s.wifi.lastDisconnectReason));
+        out.print(",\"disconnects\":").print(static_cast<unsigned long>(s.wifi.disconnects));
+        out.print(",\"failed_attempts\":").print(static_cast<unsigned long>(s.wifi.failedAttempts)).print('}');
+    }},
+
     // Heat calculation data
-    json += ",\"heat_calc_active\":true";
-    json += ",\"reference_temp\":" + String(referenceTemp, 1);
-    json += ",\"total_heat_energy\":" + String(totalHeatEnergy, 3);
-    json += ",\"current_heat_power\":" + String(currentHeatPower, 1);
-    json += ",\"air_volume_moved\":" + String(airVolumeMoved, 2);
-    
-    // Calculate average power
-    float runningHours = fanOperatingTime / 3600.0f;
-    float avgPower = runningHours > 0 ? (totalHeatEnergy * 1000.0f) / runningHours : 0;
-    json += ",\"avg_heat_power\":" + String(avgPower, 1);
-    
+#if FEATURE_HEAT_ENGINE
+    {"heat_calc_active", [](const SystemStatus&, TextWriter& out) { out.print(true); }},
+    {"reference_temp", [](const SystemStatus& s, TextWriter& out) { out.print(s.referenceTemp, 1); }},
+    {"total_heat_energy", [](const SystemStatus& s, TextWriter& out) { out.print(s.totalHeatEnergy, 3); }},
+    {"current_heat_power", [](const SystemStatus& s, TextWriter& out) { out.print(s.currentHeatPower, 1); }},
+    {"latent_heat_power", [](const SystemStatus& s, TextWriter& out) { out.print(s.latentHeatPower, 1); }},
+    {"air_volume_moved", [](const SystemStatus& s, TextWriter& out) { out.print(s.airVolumeMoved, 2); }},
+#else
+    {"heat_calc_active", [](const SystemStatus&, TextWriter& out) { out.print(false); }},
+#endif
+#if FEATURE_HEAT_ENGINE && FEATURE_STATISTICS
+    {"avg_heat_power", [](const SystemStatus& s, TextWriter& out) {
+        float runningHours = s.fanOperatingTime / 3600.0f;
+        out.print(runningHours > 0 ? (s.totalHeatEnergy * 1000.0f) / runningHours : 0.0f, 1);
+    }},
+#endif
+
     // Operating statistics
-    json += ",\"total_operating_time\":" + String(totalOperatingTime);
-    json += ",\"fan_operating_time\":" + String(fanOperatingTime);
-    json += ",\"energy_usage\":" + String(energyUsage, 3);
-    json += ",\"auto_mode_status\":\"" + autoModeStatus + "\"";
-    json += ",\"error_state\":\"" + getErrorString() + "\"";
-    json += ",\"last_sensor_update\":" + String(lastSensorUpdate);
-    json += ",\"last_rpm_update\":" + String(lastRPMUpdate);
-    json += ",\"last_heat_calc\":" + String(lastHeatCalc);
-    
-    json += "}";
-    return json;
+#if FEATURE_STATISTICS
+    {"total_operating_time", [](const SystemStatus& s, TextWriter& out) { out.print(s.totalOperatingTime); }},
+    {"fan_operating_time", [](const SystemStatus& s, TextWriter& out) { out.print(s.fanOperatingTime); }},
+    {"energy_usage", [](const SystemStatus& s, TextWriter& out) { out.print(s.energyUsage, 3); }},
+    {"fan_power", [](const SystemStatus& s, TextWriter& out) { out.print(s.fanPower, 3); }},
+    {"cop", [](const SystemStatus& s, TextWriter& out) { out.print(s.coefficientOfPerformance, 1); }},
+    {"power", [](const SystemStatus& s, TextWriter& out) {
+        out.print("{\"active_percent\":").print(s.power.activePercent, 1);
+        out.print(",\"idle_percent\":").print(s.power.idlePercent, 1);
+        out.print(",\"light_sleep_percent\":").print(s.power.lightSleepPercent, 1);
+        out.print(",\"estimated_current_ma\":").print(s.power.estimatedCurrent, 1);
+        out.print(",\"active_wakeups_per_hour\":").print(s.power.activeWakeupsPerHour, 0);
+        out.print(",\"sleep_wakeups_per_hour\":").print(s.power.sleepWakeupsPerHour, 0);
+        out.print(",\"light_sleep_available\":").print(s.power.lightSleepAvailable).print('}');
+    }},
+#endif
+
+    // Status and timestamps
+    {"auto_mode_status", [](const SystemStatus& s, TextWriter& out) {
+        char statusText[64];
+        s.formatStatus(statusText, sizeof(statusText));
+        out.print('"').print(statusText).print('"');
+    }},
+    {"status_code", [](const SystemStatus& s, TextWriter& out) {
+        out.print('"').print(getStatusCodeName(s.statusCode)).print('"');
+    }},
+    {"error_state", [](const SystemStatus& s, TextWriter& out) { out.print('"').print(getErrorString(s.errorState)).print('"'); }},
+    {"last_sensor_update", [](const SystemStatus& s, TextWriter& out) { out.print(s.lastSensorUpdate); }},
+    {"last_rpm_update", [](const SystemStatus& s, TextWriter& out) { out.print(s.lastRPMUpdate); }},
+#if FEATURE_HEAT_ENGINE
+    {"last_heat_calc", [](const SystemStatus& s, TextWriter& out) { out.print(s.lastHeatCalc); }},
+#endif
+};
+
+const int SystemStatus::FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+void SystemStatus::toJson(TextWriter& out, FieldMask fields) const {
+    static_assert(sizeof(FIELDS) / sizeof(FIELDS[0]) <= MAX_FIELDS, "More status fields than the field mask holds");
+    char boot[9];
+    snprintf(boot, sizeof(boot), "%08lx", static_cast<unsigned long>(bootId));
+    out.print("{\"version\":").print(getVersion(fields));
+    out.print(",\"boot\":\"").print(boot).print('"');
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (!(fields & (static_cast<FieldMask>(1) << i))) continue;
+        out.print(",\"").print(FIELDS[i].name).print("\":");
+        FIELDS[i].write(*this, out);
+    }
+    out.print('}');
 }
 
-String SystemStatus::getErrorString() const {
-    switch(errorState) {
+SystemStatus::FieldMask SystemStatus::parseFieldList(const char* list) {
+    if (!list || !*list) return ALL_FIELDS;
+
+    FieldMask mask = 0;
+    while (*list) {
+        const char* end = strchr(list, ',');
+        size_t length = end ? static_cast<size_t>(end - list) : strlen(list);
+        for (int i = 0; i < FIELD_COUNT; i++) {
+            if (strlen(FIELDS[i].name) == length && strncmp(FIELDS[i].name, list, length) == 0) {
+                mask |= static_cast<FieldMask>(1) << i;
+                break;
+            }
+        }
+        if (!end) break;
+        list = end + 1;
+    }
+    return mask;
+}
+
+// Renders every field and compares a hash of its text with the previous pass, so the
+// version follows exactly what a client would see change
+uint32_t SystemStatus::refreshVersion() {
+    bool changed = false;
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        char buffer[384];
+        TextWriter text(buffer, sizeof(buffer));
+        FIELDS[i].write(*this, text);
+
+        // FNV-1a
+        uint32_t hash = 2166136261UL;
+        for (size_t j = 0; j < text.length(); j++) {
+            hash = (hash ^ static_cast<uint8_t>(buffer[j])) * 16777619UL;
+        }
+        if (hash != fieldHashes[i]) {
+            if (!changed) {
+                version++;
+                changed = true;
+            }
+            fieldHashes[i] = hash;
+            fieldVersions[i] = version;
+        }
+    }
+    return version;
+}
+
+uint32_t SystemStatus::getVersion(FieldMask fields) const {
+    uint32_t latest = 0;
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if ((fields & (static_cast<FieldMask>(1) << i)) && fieldVersions[i] > latest) {
+            latest = fieldVersions[i];
+        }
+    }
+    return latest;
+}
+
+const char* SystemStatus::getErrorString(ErrorState state) {
+    switch(state) {
         case ErrorState::NONE:
             return "OK";
         case ErrorState::SENSOR_ERROR:
@@ -135,4 +344,87 @@ String SystemStatus::getErrorString() const {
         default:
             return "Unknown Error";
     }
-}
\ No newline at end of file
+}
+
+const char* SystemStatus::getStatusCodeName(StatusCode code) {
+    switch (code) {
+        case StatusCode::STARTED:           return "started";
+        case StatusCode::READY:             return "ready";
+        case StatusCode::CHECK_STARTED:     return "check_started";
+        case StatusCode::CHECKING:          return "checking";
+        case StatusCode::SLEEPING:          return "sleeping";
+        case StatusCode::ACTIVITY_DETECTED: return "activity_detected";
+        case StatusCode::WARMUP:            return "warmup";
+        case StatusCode::OPERATING:         return "operating";
+        case StatusCode::COOLING_FAN_OFF:   return "cooling_fan_off";
+        case StatusCode::COOLING_RESIDUAL:  return "cooling_residual";
+        case StatusCode::ENTERING_SLEEP:    return "entering_sleep";
+        case StatusCode::ERROR_RECOVERY:    return "error_recovery";
+        case StatusCode::CRITICAL_ERROR:    return "critical_error";
+        case StatusCode::RECOVERED:         return "recovered";
+        case StatusCode::SAFETY_OVERRIDE:   return "safety_override";
+        case StatusCode::CALIBRATING:       return "calibrating";
+        default:                            return "unknown";
+    }
+}
+
+void SystemStatus::formatStatus(char* buffer, size_t size) const {
+    // Deadlines are turned into the remaining time at the moment of formatting
+    long remaining = static_cast<long>(statusValue - millis());
+    if (remaining < 0) remaining = 0;
+
+    switch (statusCode) {
+        case StatusCode::STARTED:
+            snprintf(buffer, size, "System started");
+            break;
+        case StatusCode::READY:
+            snprintf(buffer, size, "System Ready");
+            break;
+        case StatusCode::CHECK_STARTED:
+            snprintf(buffer, size, "Checking for Activity...");
+            break;
+        case StatusCode::CHECKING:
+            snprintf(buffer, size, "Checking for Activity (%lds)", remaining / 1000);
+            break;
+        case StatusCode::SLEEPING:
+            snprintf(buffer, size, "Sleep Mode - Next Check in %ld Minutes", remaining / 60000);
+            break;
+        case StatusCode::ACTIVITY_DETECTED:
+            snprintf(buffer, size, "Activity Detected - Starting Normal Operation");
+            break;
+        case StatusCode::WARMUP:
+            snprintf(buffer, size, "Warm-up Phase: Optimizing Heat Distribution (%lu%%)",
+                     static_cast<unsigned long>(statusValue));
+            break;
+        case StatusCode::OPERATING:
+            snprintf(buffer, size, "Operating Phase: %lu%% Power", static_cast<unsigned long>(statusValue));
+            break;
+        case StatusCode::COOLING_FAN_OFF:
+            snprintf(buffer, size, "Cooling Phase: Fan Off");
+            break;
+        case StatusCode::COOLING_RESIDUAL:
+            snprintf(buffer, size, "Cooling Phase: Using Residual Heat");
+            break;
+        case StatusCode::ENTERING_SLEEP:
+            snprintf(buffer, size, "Entering Sleep Mode");
+            break;
+        case StatusCode::ERROR_RECOVERY:
+            snprintf(buffer, size, "Error - Recovery Attempt %lu", static_cast<unsigned long>(statusValue));
+            break;
+        case StatusCode::CRITICAL_ERROR:
+            snprintf(buffer, size, "Critical Error - System Restart Required");
+            break;
+        case StatusCode::RECOVERED:
+            snprintf(buffer, size, "System Recovered");
+            break;
+        case StatusCode::SAFETY_OVERRIDE:
+            snprintf(buffer, size, "Over-Temperature - Full Airflow");
+            break;
+        case StatusCode::CALIBRATING:
+            snprintf(buffer, size, "Calibrating Fan (%lu%%)", static_cast<unsigned long>(statusValue));
+            break;
+        default:
+            snprintf(buffer, size, "Unknown");
+            break;
+    }
+}
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "arena.h"
 
 class SystemStatus {
 public:
@@ -14,6 +15,15 @@ public:
     float minTemperature;
     float maxTemperature;
     float humidity;
+    float filteredTemperature;  // Smoothed temperature from the sensor filter pipeline
+    float temperatureSlope;     // Least-squares temperature slope in °C/min
+
+    // Moist air state derived from temperature and humidity
+    float dewPoint;             // °C
+    float absoluteHumidity;     // g/m³
+    float enthalpy;             // kJ/kg dry air
+    float humidityRatio;        // kg water / kg dry air
+    float dryAirDensity;        // kg dry air / m³
 
     // Operation mode
     bool autoMode;
@@ -24,15 +34,40 @@ public:
     float currentFanSpeed;
     float targetFanSpeed;
     float fanRPM;
+    float fanDuty;              // Applied PWM duty 0.0 - 1.0
+    float targetRPM;            // Set point of the RPM regulator
+    float rpmError;             // Last tracking error (target - measured) in RPM
+    float rpmErrorAverage;      // Smoothed absolute tracking error in RPM
     bool manualOverride;
 
-    // Status messages
-    String autoModeStatus;
+    // Controller status as a code plus one numeric value; the text is only built in toJson()
+    enum class StatusCode : uint8_t {
+        STARTED,
+        READY,
+        CHECK_STARTED,
+        CHECKING,               // value: millis() when the activity check ends
+        SLEEPING,               // value: millis() of the next activity check
+        ACTIVITY_DETECTED,
+        WARMUP,                 // value: fan speed in percent
+        OPERATING,              // value: fan speed in percent
+        COOLING_FAN_OFF,
+        COOLING_RESIDUAL,
+        ENTERING_SLEEP,
+        ERROR_RECOVERY,         // value: recovery attempt
+        CRITICAL_ERROR,
+        RECOVERED,
+        SAFETY_OVERRIDE,        // Over-temperature, full airflow
+        CALIBRATING             // value: sweep progress in percent
+    };
+    StatusCode statusCode;
+    uint32_t statusValue;
 
     // Timestamps
     unsigned long lastSensorUpdate;
     unsigned long lastRPMUpdate;
+#if FEATURE_HEAT_ENGINE
     unsigned long lastHeatCalc;
+#endif
 
     // Error states
     enum class ErrorState {
@@ -46,23 +81,122 @@ public:
     // Error counting
     int rpmErrorCount;
 
+#if FEATURE_STATISTICS
     // Operating statistics
     unsigned long totalOperatingTime;
     unsigned long fanOperatingTime;
-    float energyUsage;
+    float energyUsage;               // Fan electrical energy in Wh
+    float fanPower;                  // Current fan electrical power in W
+    float coefficientOfPerformance;  // Heat recovered / fan energy
+
+    // Power management statistics
+    struct PowerStats {
+        float activePercent = 0.0f;
+        float idlePercent = 0.0f;
+        float lightSleepPercent = 0.0f;
+        float estimatedCurrent = 0.0f;      // Average supply current in mA
+        float activeWakeupsPerHour = 0.0f;
+        float sleepWakeupsPerHour = 0.0f;
+        bool lightSleepAvailable = false;
+    };
+    PowerStats power;
+#endif
+
+    // Fan health model output
+    struct FanHealthStats {
+        bool modelReady = false;
+        float score = 100.0f;                // 0 - 100
+        float rpmShortfallPercent = 0.0f;    // Recent RPM below the learned baseline at the same duty
+        float varianceRatio = 1.0f;          // Recent / baseline RPM variance (worst bucket)
+        float hoursToMaintenance = -1.0f;    // -1 if no degradation trend
+        bool shortfallWarning = false;
+        bool varianceWarning = false;
+        bool driftWarning = false;
+    };
+    FanHealthStats fanHealth;
+
+    // Safety monitor state, published by the loop
+    struct SafetyStats {
+        bool overrideActive = false;
+        bool latched = false;               // Trip not yet acknowledged
+        const char* reason = "none";        // Reason of the last trip
+        uint32_t tripCount = 0;
+    };
+    SafetyStats safety;
+
+    // Station link, published by the WiFi manager
+    struct WifiStats {
+        const char* state = "off";
+        bool connected = false;
+        int32_t rssi = 0;                   // Smoothed, dBm
+        uint8_t lastDisconnectReason = 0;   // 802.11 / ESP-IDF reason code, 0 if none
+        uint32_t disconnects = 0;           // Links lost after connecting
+        uint32_t failedAttempts = 0;        // In a row
+    };
+    WifiStats wifi;
+
+    // Fan calibration sweep and the duty -> RPM model in use
+    struct FanCalibrationStats {
+        bool calibrated = false;            // Measured table in use, otherwise the datasheet curve
+        bool running = false;
+        const char* state = "idle";
+        const char* failure = "";
+        float progress = 0.0f;              // 0.0 - 1.0
+        float startDuty = 0.0f;
+        float minDuty = 0.0f;               // Lowest regulated duty
+        float minRpm = 0.0f;
+        float maxRpm = 0.0f;
+    };
+    FanCalibrationStats fanCalibration;
+
+    // Adaptive sensor sampling
+    struct SamplingStats {
+        unsigned long intervalMs = Config::Sensor::MIN_INTERVAL;
+        float samplesPerHour = 0.0f;
+        float residual = 0.0f;              // Last sample against the prediction in °C
+        float rate = 0.0f;                  // Rate of change the interval follows in °C/min
+    };
+    SamplingStats sampling;
 
+#if FEATURE_HEAT_ENGINE
     // Heat calculation
     float referenceTemp;
+    float referenceHumidityRatio;
     float totalHeatEnergy;
-    float currentHeatPower;
+    float currentHeatPower;     // Enthalpy gain of the moved air over the reference state in W
+    float latentHeatPower;      // Part of currentHeatPower carried by added moisture in W
     float airVolumeMoved;
     bool heatCalcInitialized;
+#endif
+
+    // Serialization with field selection; bit i of a mask selects the i-th serialized field
+    using FieldMask = uint64_t;
+    static constexpr int MAX_FIELDS = 64;
+    static constexpr FieldMask ALL_FIELDS = ~static_cast<FieldMask>(0);
+    void toJson(TextWriter& out, FieldMask fields = ALL_FIELDS) const;
+    // Mask for a comma separated list of field names; unknown names are ignored, empty selects all
+    static FieldMask parseFieldList(const char* list);
+
+    // Change versions: refreshVersion() bumps the version when any serialized field changed
+    // since the previous call; getVersion() is the latest version at which a selected field changed
+    uint32_t refreshVersion();
+    uint32_t getVersion(FieldMask fields = ALL_FIELDS) const;
+    // Random per boot; versions restart with every boot, so they only compare within one bootId
+    uint32_t getBootId() const { return bootId; }
 
     // Methods
-    String toJson() const;
-    void initializeSystem();
     bool setAutoMode(bool enable);
+    // Recomputes the moist air state from temperature and humidity
+    void updateAirState();
+
+    void setStatus(StatusCode code, uint32_t value = 0) {
+        statusCode = code;
+        statusValue = value;
+    }
+#if FEATURE_HEAT_ENGINE
+    void initializeSystem();
     void updateHeatCalculation();
+#endif
     
     bool needsSensorUpdate() const {
         return (millis() - lastSensorUpdate) >= Config::Sensor::UPDATE_INTERVAL;
@@ -72,9 +206,11 @@ public:
         return (millis() - lastRPMUpdate) >= Config::Tacho::RPM_UPDATE_INTERVAL;
     }
 
+#if FEATURE_HEAT_ENGINE
     bool needsHeatCalc() const {
         return (millis() - lastHeatCalc) >= Config::Heat::CALC_INTERVAL;
     }
+#endif
 
     void updateMinMaxTemperature(float newTemp) {
         if (newTemp < minTemperature) minTemperature = newTemp;
@@ -86,20 +222,29 @@ public:
         maxTemperature = temperature;
     }
 
-    void updateOperatingStats() {
-        totalOperatingTime++;
-        if (fanOn) {
-            fanOperatingTime++;
-            energyUsage += (1.68f * currentFanSpeed) / 3600.0f;
-        }
-    }
-
+#if FEATURE_HEAT_ENGINE
     bool isHeatCalcInitialized() const {
         return heatCalcInitialized;
     }
+#endif
+
+    static const char* getErrorString(ErrorState state);
+    static const char* getStatusCodeName(StatusCode code);
 
 private:
-    String getErrorString() const;
+    struct Field {
+        const char* name;
+        void (*write)(const SystemStatus& status, TextWriter& out);
+    };
+    static const Field FIELDS[];
+    static const int FIELD_COUNT;
+
+    uint32_t version = 0;
+    uint32_t bootId = esp_random();
+    uint32_t fieldHashes[MAX_FIELDS];
+    uint32_t fieldVersions[MAX_FIELDS];
+
+    void formatStatus(char* buffer, size_t size) const;
 };
 
 #endif // SYSTEM_STATUS_H
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef TIMEKEEPER_H
+#define TIMEKEEPER_H
+
+#include <Arduino.h>
+#include <time.h>
+#include <esp_sntp.h>
+#include "config.h"
+#include "logging.h"
+
+// Wall clock for the control logic. SNTP runs in the background (configTzTime never blocks)
+// and the local calendar state is cached: localtime is only evaluated when a 15 minute slot
+// boundary passes or a new sync arrives, so the hot paths just read integers.
+// Until the first sync the clock is unknown and the day part stays at DAY; after a sync the
+// RTC keeps counting monotonically even if later syncs fail.
+class Timekeeper {
+public:
+    enum class DayPart {
+        NIGHT,      // 22:00 - 06:00
+        DAY,        // 06:00 - 17:00
+        EVENING     // 17:00 - 22:00
+    };
+
+private:
+    static constexpr int SLOT_MINUTES = 15;
+    static constexpr time_t MIN_VALID_EPOCH = 1700000000;  // Anything earlier is time since boot
+
+    static inline volatile bool syncEvent = false;  // Set from the SNTP task
+
+    bool synced = false;
+    int currentHour = 12;
+    int currentWeekday = 0;
+    int currentSlot = 12 * 60 / SLOT_MINUTES;
+    int currentYearDay = 0;
+    long currentDayNumber = 0;
+    DayPart currentDayPart = DayPart::DAY;
+
+    unsigned long lastRefresh = 0;
+    unsigned long nextRefreshIn = 0;
+    unsigned long lastSyncMillis = 0;
+
+    static void onTimeSync(struct timeval*) {
+        syncEvent = true;
+    }
+
+    static DayPart dayPartForHour(int hour) {
+        if (hour >= 22 || hour < 6) return DayPart::NIGHT;
+        if (hour >= 17) return DayPart::EVENING;
+        return DayPart::DAY;
+    }
+
+    void refresh() {
+        time_t now;
+        time(&now);
+        lastRefresh = millis();
+
+        if (now < MIN_VALID_EPOCH) {
+            // No wall clock yet, look again in a minute
+            nextRefreshIn = 60000;
+            return;
+        }
+
+        if (!synced) {
+            synced = true;
+            LOG_PRINTLN("DEBUG: Wall clock available");
+        }
+
+        struct tm timeinfo;
+        localtime_r(&now, &timeinfo);
+        currentHour = timeinfo.tm_hour;
+        currentWeekday = timeinfo.tm_wday;
+        currentYearDay = timeinfo.tm_yday;
+        // Days since 1970-01-01 of the local date: whole years plus leap days, then the day of the year
+        int yearsBefore = timeinfo.tm_year + 1900 - 1;
+        currentDayNumber = 365L * (timeinfo.tm_year - 70) + (yearsBefore / 4 - yearsBefore / 100 + yearsBefore / 400) -
+                           (1969 / 4 - 1969 / 100 + 1969 / 400) + timeinfo.tm_yday;
+        currentSlot = (timeinfo.tm_hour * 60 + timeinfo.tm_min) / SLOT_MINUTES;
+        currentDayPart = dayPartForHour(currentHour);
+
+        // Milliseconds until the next slot boundary (hour changes fall on slot boundaries)
+        int secondsIntoSlot = (timeinfo.tm_min % SLOT_MINUTES) * 60 + timeinfo.tm_sec;
+        nextRefreshIn = (SLOT_MINUTES * 60 - secondsIntoSlot) * 1000UL;
+    }
+
+public:
+    // Starts background SNTP with the configured timezone rules
+    void begin() {
+        sntp_set_time_sync_notification_cb(onTimeSync);
+        configTzTime(Config::Time::TIMEZONE, Config::Time::NTP_SERVER_PRIMARY,
+                     Config::Time::NTP_SERVER_SECONDARY);
+        refresh();
+        LOG_PRINTLN("DEBUG: Timekeeping started");
+    }
+
+    // Cheap per-loop call: one subtraction unless a boundary passed or a sync arrived
+    void update() {
+        if (syncEvent) {
+            syncEvent = false;
+            lastSyncMillis = millis();
+            LOG_PRINTLN("DEBUG: SNTP time synchronized");
+            refresh();
+            return;
+        }
+        if (millis() - lastRefresh >= nextRefreshIn) {
+            refresh();
+        }
+    }
+
+    bool isSynced() const { return synced; }
+    int hour() const { return currentHour; }
+    int weekday() const { return currentWeekday; }
+    int slot() const { return currentSlot; }
+    int yearDay() const { return currentYearDay; }
+    // Local calendar days since 1970-01-01, for counting days across year ends
+    long dayNumber() const { return currentDayNumber; }
+    DayPart dayPart() const { return currentDayPart; }
+
+    // Seconds since the last SNTP sync, or -1 if none happened during this boot
+    long secondsSinceSync() const {
+        return lastSyncMillis == 0 ? -1 : static_cast<long>((millis() - lastSyncMillis) / 1000);
+    }
+};
+
+#endif // TIMEKEEPER_H
@@ -0,0 +1,250 @@
+// Host replay of the learned check schedule (activity_histogram.h, as ActivityScheduler drives
+// it) against the fixed day-part schedule it replaced (30 min at night, 5 min during the day,
+// 3 min in the evening). Synthetic households light fires by habit: most evenings around a
+// household-specific time, weekend mornings or afternoons, and now and then at a random time.
+// In sleep mode the controller runs a CHECK_DURATION check whenever the check interval has
+// passed; a check sees a fire once the air at the sensor rises (DETECT_LAG after lighting), and
+// without a check the fire is noticed when the room passes the sleep threshold. A detected
+// start is recorded in the slot of its detection, as the controller does. No checks run while a
+// fire burns and cools down.
+// After LEARN_WEEKS of learning, one week is replayed. Reports checks per week and the
+// detection delay p50 / p95 / max for both schedules, and for the learned one in its first
+// week from the prior. Random fires away from the habits are found later than with the fixed
+// schedule (p95), habitual ones sooner. Also checks that a start in the first
+// slot of a day spreads into the previous weekday and that the decay applies one step per
+// elapsed day. Exits non-zero when the learned schedule needs more checks than the fixed one
+// or detects later at p50.
+//
+// Build and run: g++ -O2 -std=gnu++17 -I. tools/activity_replay.cpp -o activity_replay
+//                ./activity_replay [households]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "activity_histogram.h"
+
+namespace {
+
+constexpr double MINUTE = 60000.0;
+constexpr double HOUR = 60.0 * MINUTE;
+constexpr double DAY = 24.0 * HOUR;
+constexpr double WEEK = 7.0 * DAY;
+constexpr int LEARN_WEEKS = 4;
+constexpr double DETECT_LAG = 2.0 * MINUTE;             // Lighting until the slope passes the threshold
+constexpr double PASSIVE_MIN = 15.0 * MINUTE;           // Lighting until the room passes the sleep threshold
+constexpr double PASSIVE_MAX = 30.0 * MINUTE;
+
+std::mt19937 rng(1701);
+
+double uniform(double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(rng);
+}
+
+double gaussian(double mean, double sigma) {
+    return std::normal_distribution<double>(mean, sigma)(rng);
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+// Weekday 0 is Sunday, as tm_wday; the replay starts on a Sunday at midnight
+int weekdayAt(double t) { return static_cast<int>(t / DAY) % 7; }
+int slotAt(double t) { return static_cast<int>(fmod(t, DAY) / (ActivityHistogram::SLOT_MINUTES * MINUTE)); }
+long dayAt(double t) { return static_cast<long>(t / DAY); }
+
+struct Fire {
+    double start;
+    double end;             // Burnt down and cooled below the sleep threshold
+    double passive;         // Noticed without a check
+};
+
+struct Household {
+    double evening;         // Habitual evening start, minutes after midnight
+    double eveningSigma;
+    double eveningChance;
+    double weekend;         // Weekend start
+    double weekendChance;
+    double randomChance;    // Per day, at any time between 07:00 and 23:00
+};
+
+Household randomHousehold() {
+    Household h;
+    h.evening = uniform(16.5 * 60, 20.0 * 60);
+    h.eveningSigma = uniform(15.0, 45.0);
+    h.eveningChance = uniform(0.5, 0.9);
+    h.weekend = uniform(9.0 * 60, 15.0 * 60);
+    h.weekendChance = uniform(0.3, 0.8);
+    h.randomChance = uniform(0.02, 0.15);
+    return h;
+}
+
+std::vector<Fire> fires(const Household& h, int weeks) {
+    std::vector<Fire> result;
+    for (int day = 0; day < weeks * 7; day++) {
+        std::vector<double> starts;
+        bool weekend = day % 7 == 0 || day % 7 == 6;
+        if (weekend && uniform(0.0, 1.0) < h.weekendChance) starts.push_back(gaussian(h.weekend, 45.0));
+        if (uniform(0.0, 1.0) < h.eveningChance) starts.push_back(gaussian(h.evening, h.eveningSigma));
+        if (uniform(0.0, 1.0) < h.randomChance) starts.push_back(uniform(7.0 * 60, 23.0 * 60));
+        std::sort(starts.begin(), starts.end());
+        for (double minute : starts) {
+            double start = day * DAY + minute * MINUTE;
+            if (!result.empty() && start < result.back().end) continue;  // Still burning
+            double end = start + uniform(2.5, 5.0) * HOUR + uniform(1.0, 2.0) * HOUR;
+            result.push_back({start, end, start + uniform(PASSIVE_MIN, PASSIVE_MAX)});
+        }
+    }
+    return result;
+}
+
+unsigned long fixedInterval(double t) {
+    int hour = static_cast<int>(fmod(t, DAY) / HOUR);
+    if (hour >= 22 || hour < 6) return 30 * 60000UL;
+    if (hour >= 17) return 3 * 60000UL;
+    return 5 * 60000UL;
+}
+
+// Learned schedule as ActivityScheduler runs it: decay on the first use of each day
+struct Learned {
+    ActivityHistogram histogram;
+    long lastDecayDay = -1;
+
+    void decay(double t) {
+        long day = dayAt(t);
+        if (lastDecayDay >= 0 && day > lastDecayDay) histogram.decay(day - lastDecayDay);
+        lastDecayDay = day;
+    }
+
+    unsigned long interval(double t) {
+        decay(t);
+        return ActivityHistogram::checkInterval(histogram.likelihood(weekdayAt(t), slotAt(t)));
+    }
+
+    void record(double t) {
+        decay(t);
+        histogram.recordStart(weekdayAt(t), slotAt(t));
+    }
+};
+
+struct Result {
+    std::vector<double> delays;     // Evaluated week, minutes
+    int checks = 0;                 // Evaluated week
+};
+
+// Replays the fires; learned is null for the fixed schedule
+void replay(const std::vector<Fire>& list, Learned* learned, double evalStart, Result& result) {
+    double lastCheck = 0.0;
+    double t = 0.0;
+    double end = evalStart + WEEK;
+    size_t next = 0;
+    while (t < end) {
+        // Sleep mode until the next fire is detected
+        const Fire* fire = next < list.size() ? &list[next] : nullptr;
+        unsigned long interval = learned ? learned->interval(t) : fixedInterval(t);
+        double check = lastCheck + interval;
+        if (check < t) check = t;
+        // The interval changes with the slot, look again at the next slot boundary
+        double slotLength = ActivityHistogram::SLOT_MINUTES * MINUTE;
+        double boundary = (floor(t / slotLength) + 1.0) * slotLength;
+        if (check > boundary && !(fire && fire->passive <= boundary)) {
+            t = boundary;
+            continue;
+        }
+        if (fire && fire->passive <= check) {
+            double detected = fire->passive;
+            if (detected >= evalStart && detected < end) result.delays.push_back((detected - fire->start) / MINUTE);
+            if (learned) learned->record(detected);
+            t = lastCheck = fire->end;
+            next++;
+            continue;
+        }
+        if (check >= end) break;
+        lastCheck = check;
+        if (check >= evalStart) result.checks++;
+        if (fire && check + Config::CHECK_DURATION >= fire->start + DETECT_LAG) {
+            double detected = std::max(check, fire->start + DETECT_LAG);
+            if (detected >= evalStart) result.delays.push_back((detected - fire->start) / MINUTE);
+            if (learned) learned->record(detected);
+            t = lastCheck = fire->end;
+            next++;
+            continue;
+        }
+        // A check can only start once the interval is evaluated again, every control pass
+        t = check + Config::Sensor::MIN_INTERVAL;
+    }
+}
+
+bool checkHistogram() {
+    bool ok = true;
+
+    // A start in the first slot of Monday spreads into Sunday's last slot
+    ActivityHistogram carry;
+    uint8_t sundayBefore = carry.weightAt(0, ActivityHistogram::SLOTS_PER_DAY - 1);
+    uint8_t mondayBefore = carry.weightAt(1, ActivityHistogram::SLOTS_PER_DAY - 1);
+    carry.recordStart(1, 0);
+    if (carry.weightAt(0, ActivityHistogram::SLOTS_PER_DAY - 1) <= sundayBefore ||
+        carry.weightAt(1, ActivityHistogram::SLOTS_PER_DAY - 1) != mondayBefore) {
+        printf("FAIL: start at midnight not spread into the previous day\n");
+        ok = false;
+    }
+
+    // Three days at once decay as much as three single days
+    ActivityHistogram once;
+    ActivityHistogram daily;
+    once.recordStart(3, 40);
+    daily.recordStart(3, 40);
+    once.decay(3);
+    for (int i = 0; i < 3; i++) daily.decay(1);
+    if (memcmp(once.data(), daily.data(), ActivityHistogram::size()) != 0 ||
+        once.weightAt(3, 40) >= ActivityHistogram::MAX_WEIGHT) {
+        printf("FAIL: decay not applied per elapsed day\n");
+        ok = false;
+    }
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int households = argc > 1 ? atoi(argv[1]) : 200;
+    if (households <= 0) households = 200;
+    bool ok = checkHistogram();
+
+    Result fixed, fresh, learned;
+    for (int i = 0; i < households; i++) {
+        Household household = randomHousehold();
+        std::vector<Fire> list = fires(household, LEARN_WEEKS + 1);
+        replay(list, nullptr, LEARN_WEEKS * WEEK, fixed);
+        Learned first;
+        replay(list, &first, 0.0, fresh);      // From the prior, the replay ends after the first week
+        Learned trained;
+        replay(list, &trained, LEARN_WEEKS * WEEK, learned);
+    }
+    printf("%d households, %d weeks of learning, one week replayed\n\n", households, LEARN_WEEKS);
+    printf("%-24s %14s %12s %12s %12s\n", "", "checks/week", "delay p50", "delay p95", "delay max");
+    const Result* results[] = {&fixed, &fresh, &learned};
+    const char* names[] = {"Fixed day parts", "Learned, first week", "Learned"};
+    for (int i = 0; i < 3; i++) {
+        const Result& r = *results[i];
+        printf("%-24s %14.0f %8.1f min %8.1f min %8.1f min\n", names[i], static_cast<double>(r.checks) / households,
+               percentile(r.delays, 50), percentile(r.delays, 95), percentile(r.delays, 100));
+    }
+
+    if (learned.checks >= fixed.checks) {
+        printf("FAIL: learned schedule needs as many checks as the fixed one\n");
+        ok = false;
+    }
+    if (percentile(learned.delays, 50) > percentile(fixed.delays, 50)) {
+        printf("FAIL: learned schedule detects fire starts later at p50\n");
+        ok = false;
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+// Host simulation of the calibration sweep in fan_calibrator.h against simulated fans, and of
+// the resulting FanModel against the datasheet defaults. Each fan has a random speed range,
+// curve shape and either a speed floor at low duty (keeps turning down to 0 %) or a stall duty
+// with a higher start duty. Speed follows the target with first-order spin-up, spin-down and
+// coast-down; the tach is read every second (with loop jitter) as whole pulses, plus ripple.
+// Checks per fan that the sweep completes, finds the stall and start duties within one fine
+// step and measures each point within 3 % or two tach pulses over half the settle window (the
+// resolution of 1 s readings at low speed); that the lowest regulated duty keeps the fan
+// turning and that the fault threshold passes the healthy fan and flags a blocked one.
+// Also checks abort and a blocked fan. Exits non-zero on any failure.
+//
+// Build and run: g++ -O2 -std=gnu++17 -I. tools/fan_calibration_sim.cpp -o fan_calibration_sim
+//                ./fan_calibration_sim [fans]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "fan_calibrator.h"
+
+namespace {
+
+constexpr double SIM_STEP = 10.0;                      // ms
+constexpr double TACH_INTERVAL = Config::Tacho::RPM_UPDATE_INTERVAL;
+constexpr double MAX_POINT_ERROR = 0.03;               // Table point against the true speed
+constexpr double MIN_POINT_ERROR = 2.0 * Config::FanCalibration::SETTLE_MIN_RPM; // Tach resolution at low speed
+constexpr double MAX_CURVE_ERROR = 0.05;               // Interpolated curve, fraction of full speed
+constexpr double DUTY_EPSILON = 1e-3;
+
+std::mt19937 rng(2024);
+
+double uniform(double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(rng);
+}
+
+struct Fan {
+    double maxRpm;
+    double floorRpm;        // Speed at and below the knee
+    double knee;            // Duty where the curve leaves the floor
+    double gamma;           // Curve shape above the knee
+    bool stalls;            // Otherwise it keeps turning at the floor down to 0 %
+    double stallDuty;       // Lowest duty a running fan keeps turning at
+    double startDuty;       // Lowest duty that starts a standing fan
+    double stallRpm;        // Speed just above the stall duty
+    double tauUp, tauDown, tauCoast;   // ms
+    bool blocked = false;
+
+    double rpm = 0.0;
+    double pulses = 0.0;    // Fractional tach pulses carried between readings
+
+    // Steady-state speed of a running fan
+    double truth(double duty) const {
+        if (duty >= knee) return floorRpm + (maxRpm - floorRpm) * pow((duty - knee) / (1.0 - knee), gamma);
+        if (!stalls) return floorRpm;
+        return stallRpm + (floorRpm - stallRpm) * (duty - stallDuty) / (knee - stallDuty);
+    }
+
+    bool turnsAt(double duty) const {
+        return !stalls || duty >= stallDuty - DUTY_EPSILON;
+    }
+
+    void advance(bool power, double duty, double dt) {
+        double target = 0.0;
+        bool running = rpm > 0.0;
+        if (power && !blocked) {
+            bool turns = running ? turnsAt(duty) : (!stalls || duty >= startDuty - DUTY_EPSILON);
+            if (turns) target = truth(duty);
+        }
+        double tau = !power ? tauCoast : (target > rpm ? tauUp : tauDown);
+        rpm += (target - rpm) * (1.0 - exp(-dt / tau));
+        if (target == 0.0 && rpm < 40.0) rpm = 0.0;
+        double ripple = rpm * std::normal_distribution<double>(0.0, 0.005)(rng);
+        pulses += std::max(rpm + ripple, 0.0) / 60000.0 * Config::Tacho::PULSES_PER_REVOLUTION * dt;
+    }
+
+    // Whole pulses since the last reading, as main.ino computes the speed
+    float read(double interval) {
+        double whole = floor(pulses);
+        pulses -= whole;
+        return static_cast<float>(whole * 60000.0 / (interval * Config::Tacho::PULSES_PER_REVOLUTION));
+    }
+};
+
+Fan randomFan() {
+    Fan fan;
+    fan.maxRpm = uniform(1500.0, 2300.0);
+    fan.floorRpm = uniform(250.0, 500.0);
+    fan.knee = uniform(0.1, 0.25);
+    fan.gamma = uniform(0.8, 1.2);
+    fan.stalls = uniform(0.0, 1.0) < 0.6;
+    fan.stallDuty = fan.stalls ? uniform(0.03, fan.knee - 0.02) : 0.0;
+    fan.startDuty = fan.stalls ? fan.stallDuty + uniform(0.01, 0.1) : 0.0;
+    fan.stallRpm = fan.floorRpm * uniform(0.6, 0.8);
+    fan.tauUp = uniform(700.0, 2000.0);
+    fan.tauDown = uniform(1000.0, 3000.0);
+    fan.tauCoast = uniform(2000.0, 5000.0);
+    return fan;
+}
+
+struct Run {
+    FanCalibrator calibrator;
+    double duration = 0.0;      // ms
+};
+
+// Runs the sweep like FanController: outputs applied until the next tach reading.
+// abortAt < 0 runs to the end.
+void calibrate(Fan& fan, Run& run, double abortAt = -1.0) {
+    FanCalibrator::Output out = run.calibrator.start(0);
+    double t = 0.0;
+    double nextRead = TACH_INTERVAL;
+    double lastRead = 0.0;
+    while (run.calibrator.isRunning() && t < 2.0 * Config::FanCalibration::MAX_DURATION) {
+        fan.advance(out.power, out.duty, SIM_STEP);
+        t += SIM_STEP;
+        if (t >= nextRead) {
+            float rpm = fan.read(t - lastRead);
+            lastRead = t;
+            nextRead = t + TACH_INTERVAL + uniform(0.0, 50.0);
+            if (abortAt >= 0.0 && t >= abortAt) run.calibrator.abort();
+            out = run.calibrator.step(rpm, static_cast<unsigned long>(t));
+        }
+    }
+    run.duration = t;
+}
+
+double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5)];
+}
+
+// Largest curve error over the regulated range, as a fraction of full speed
+double curveError(const FanModel& model, const Fan& fan) {
+    double worst = 0.0;
+    for (double duty = model.minDuty(); duty <= 1.0; duty += 0.005) {
+        if (!fan.turnsAt(duty)) continue;
+        worst = std::max(worst, fabs(model.rpmAt(static_cast<float>(duty)) - fan.truth(duty)) / fan.maxRpm);
+    }
+    return worst;
+}
+
+// Duty range of the regulator with a false fault alarm for the healthy fan
+int falseFaults(const FanModel& model, const Fan& fan) {
+    int count = 0;
+    for (double duty = model.minDuty(); duty <= 1.0; duty += 0.01) {
+        if (!fan.turnsAt(duty) || fan.truth(duty) < model.faultThreshold(static_cast<float>(duty))) count++;
+    }
+    return count;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int fans = argc > 1 ? atoi(argv[1]) : 500;
+    if (fans <= 0) fans = 500;
+
+    int failures = 0;
+    std::vector<double> durations, stallErrors, startErrors, calibratedCurve, datasheetCurve;
+    int calibratedFaults = 0, datasheetFaults = 0;
+    int calibratedStalls = 0, datasheetStalls = 0;
+
+    for (int i = 0; i < fans; i++) {
+        Fan fan = randomFan();
+        Run run;
+        calibrate(fan, run);
+        if (run.calibrator.getState() != FanCalibrator::State::DONE) {
+            printf("FAIL fan %d: %s (%s)\n", i, FanCalibrator::getStateName(run.calibrator.getState()),
+                   run.calibrator.getFailure());
+            failures++;
+            continue;
+        }
+        durations.push_back(run.duration / 1000.0);
+
+        FanModel model;
+        FanModel datasheet;
+        if (!model.apply(run.calibrator.getResult())) {
+            printf("FAIL fan %d: table rejected\n", i);
+            failures++;
+            continue;
+        }
+
+        const FanModel::Table& table = model.getTable();
+        double foundStall = table.stallDuty / static_cast<double>(FanModel::DUTY_SCALE);
+        double foundStart = model.startDuty();
+        double stallError = foundStall - fan.stallDuty;
+        double startError = foundStart - fan.startDuty;
+        stallErrors.push_back(stallError);
+        startErrors.push_back(startError);
+        bool ok = stallError >= -DUTY_EPSILON && stallError <= Config::FanCalibration::FINE_STEP + DUTY_EPSILON &&
+                  startError >= -DUTY_EPSILON && startError <= Config::FanCalibration::FINE_STEP + DUTY_EPSILON;
+
+        for (int p = 0; p < table.count; p++) {
+            double duty = table.points[p].duty / static_cast<double>(FanModel::DUTY_SCALE);
+            double limit = std::max(MAX_POINT_ERROR * fan.truth(duty), MIN_POINT_ERROR);
+            if (fabs(table.points[p].rpm - fan.truth(duty)) > limit) ok = false;
+        }
+
+        calibratedCurve.push_back(curveError(model, fan));
+        datasheetCurve.push_back(curveError(datasheet, fan));
+        if (calibratedCurve.back() > MAX_CURVE_ERROR) ok = false;
+
+        int faults = falseFaults(model, fan);
+        calibratedFaults += faults > 0;
+        datasheetFaults += falseFaults(datasheet, fan) > 0;
+        if (faults > 0 || model.faultThreshold(model.minDuty()) <= 0.0f) ok = false;
+
+        // Lowest regulated duty must keep the fan turning
+        bool stallsCalibrated = !fan.turnsAt(model.minDuty());
+        calibratedStalls += stallsCalibrated;
+        datasheetStalls += !fan.turnsAt(datasheet.minDuty());
+        if (stallsCalibrated) ok = false;
+
+        if (!ok) {
+            printf("FAIL fan %d: stall %.3f/%.3f start %.3f/%.3f curve %.3f faults %d\n", i, foundStall,
+                   fan.stallDuty, foundStart, fan.startDuty, calibratedCurve.back(), faults);
+            failures++;
+        }
+    }
+
+    printf("%d fans, %d failed\n", fans, failures);
+    if (!durations.empty()) {
+        printf("Sweep duration p50 %.0f s, max %.0f s\n", percentile(durations, 50), percentile(durations, 100));
+        printf("Stall duty error min %+.3f max %+.3f, start duty error min %+.3f max %+.3f\n",
+               percentile(stallErrors, 0), percentile(stallErrors, 100), percentile(startErrors, 0),
+               percentile(startErrors, 100));
+        printf("\n%-12s %18s %18s %22s %20s\n", "", "curve error p50", "curve error max", "fans with false faults",
+               "fans stalled at min");
+        printf("%-12s %17.1f%% %17.1f%% %22d %20d\n", "Datasheet", 100.0 * percentile(datasheetCurve, 50),
+               100.0 * percentile(datasheetCurve, 100), datasheetFaults, datasheetStalls);
+        printf("%-12s %17.1f%% %17.1f%% %22d %20d\n", "Calibrated", 100.0 * percentile(calibratedCurve, 50),
+               100.0 * percentile(calibratedCurve, 100), calibratedFaults, calibratedStalls);
+    }
+
+    // Abort at a random point: stops at once and leaves the outputs off
+    int abortFailures = 0;
+    for (int i = 0; i < fans / 10 + 1; i++) {
+        Fan fan = randomFan();
+        Run run;
+        calibrate(fan, run, uniform(1000.0, 120000.0));
+        FanCalibrator::Output out = run.calibrator.step(1000.0f, static_cast<unsigned long>(run.duration) + 1000);
+        bool stopped = run.calibrator.getState() == FanCalibrator::State::ABORTED ||
+                       run.calibrator.getState() == FanCalibrator::State::DONE;
+        if (!stopped || out.power || out.duty != 0.0f) abortFailures++;
+    }
+    printf("\nAbort: %d failures\n", abortFailures);
+    failures += abortFailures;
+
+    // Blocked fan: fails at the spin-up instead of writing a table
+    Fan blocked = randomFan();
+    blocked.blocked = true;
+    Run blockedRun;
+    calibrate(blocked, blockedRun);
+    bool blockedOk = blockedRun.calibrator.getState() == FanCalibrator::State::FAILED &&
+                     blockedRun.duration <= Config::FanCalibration::SETTLE_TIMEOUT + TACH_INTERVAL * 2;
+    printf("Blocked fan: %s (%s) after %.0f s\n", FanCalibrator::getStateName(blockedRun.calibrator.getState()),
+           blockedRun.calibrator.getFailure(), blockedRun.duration / 1000.0);
+    if (!blockedOk) failures++;
+
+    printf("%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
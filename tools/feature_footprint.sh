@@ -0,0 +1,51 @@
+#!/bin/bash
+# Measures the flash and RAM cost of each compile-time feature (see FEATURE_* in config.h).
+# Builds the full firmware once, then once per feature with that feature disabled, and
+# prints the difference reported by arduino-cli.
+#
+# Usage: tools/feature_footprint.sh [fqbn]
+set -euo pipefail
+
+FQBN="${1:-esp32:esp32:XIAO_ESP32C6}"
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+# arduino-cli wants the sketch directory named like the .ino file
+mkdir -p "$WORK/main"
+cp "$ROOT"/*.h "$ROOT"/*.cpp "$ROOT"/main.ino "$WORK/main/"
+
+# Prints "<flash bytes> <ram bytes>" for a build with the given extra flags
+measure() {
+    local flags="$1"
+    local output
+    output=$(arduino-cli compile --fqbn "$FQBN" --build-path "$WORK/build" \
+        --build-property "compiler.cpp.extra_flags=$flags" \
+        --build-property "compiler.c.extra_flags=$flags" "$WORK/main" 2>&1) || {
+        echo "$output" >&2
+        return 1
+    }
+    local flash ram
+    flash=$(echo "$output" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+    ram=$(echo "$output" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+    echo "$flash $ram"
+}
+
+read -r FULL_FLASH FULL_RAM <<< "$(measure "")"
+printf "%-22s %10s %10s\n" "build" "flash" "ram"
+printf "%-22s %10d %10d\n" "all features" "$FULL_FLASH" "$FULL_RAM"
+
+# The web UI depends on the REST API, so disabling the API also drops the UI
+declare -A VARIANTS=(
+    [FEATURE_WEB_UI]="-DFEATURE_WEB_UI=0"
+    [FEATURE_REST_API]="-DFEATURE_WEB_UI=0 -DFEATURE_REST_API=0"
+    [FEATURE_HEAT_ENGINE]="-DFEATURE_HEAT_ENGINE=0"
+    [FEATURE_STATISTICS]="-DFEATURE_STATISTICS=0"
+    [FEATURE_LOGGING]="-DFEATURE_LOGGING=0"
+    [FEATURE_MQTT]="-DFEATURE_MQTT=0"
+)
+
+for feature in FEATURE_WEB_UI FEATURE_REST_API FEATURE_HEAT_ENGINE FEATURE_STATISTICS FEATURE_LOGGING FEATURE_MQTT; do
+    read -r flash ram <<< "$(measure "${VARIANTS[$feature]}")"
+    printf "%-22s %10d %10d\n" "$feature" "$((FULL_FLASH - flash))" "$((FULL_RAM - ram))"
+done
@@ -0,0 +1,725 @@
+// Host HTTP load generator for the REST API. Client threads send a weighted mix of
+// GET /api/v1/status, GET / and the POST control routes (toggle, mode, speed), either over
+// keep-alive connections or one connection per request, closed loop or with a think time.
+// Reports per route and overall p50/p95/p99/max latency (connect included for new
+// connections), rejected requests (4xx, e.g. a toggle in automatic mode) and the error rate
+// (connect failures, timeouts, resets, 5xx).
+//
+// --simulate runs the host-simulated firmware on 127.0.0.1: the real HttpServer with the same
+// routes and response sizes (status JSON, the embedded web UI), serviced by a loop shaped
+// like main.ino's, with handle(), a control tick every --tick ms and waitForActivity() in
+// between. It then also reports the loop busy time per iteration and how late the control
+// tick ran. --slowdown N stretches the loop work N times to approximate the slower MCU.
+// Against a unit (--host), the loop timing comes from /api/v1/system/watchdog instead.
+//
+// For regressions between builds, --out writes the summary as JSON and --baseline compares
+// against an earlier one; exits 2 if p95, p99, the share of requests that needed a keep-alive
+// reconnect or the tick lateness p99 grew by more than --tolerance percent or the error rate
+// grew by more than 0.5 points. A reconnect counts towards the latency of its request.
+//
+// Build and run: g++ -O2 -std=gnu++17 -pthread -I. tools/load_test.cpp http_server.cpp -o load_test
+//                ./load_test --simulate -c 8 -d 10
+//                ./load_test --host 192.168.1.50 -c 4 -d 30 --mix status=90,root=10
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "http_server.h"
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#include "html_content.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// ---------------------------------------------------------------------------------------------
+// Request mix
+
+enum Kind { STATUS, ROOT, TOGGLE, MODE, SPEED, KIND_COUNT };
+const char* const KIND_NAMES[KIND_COUNT] = {"status", "root", "toggle", "mode", "speed"};
+
+struct Options {
+    bool simulate = false;
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    int clients = 4;
+    double duration = 10.0;            // s
+    long maxRequests = 0;              // 0: run for the duration
+    double thinkMs = 0.0;              // Pause between requests of one client
+    bool keepAlive = true;
+    int timeoutMs = 5000;
+    int weights[KIND_COUNT] = {80, 5, 5, 5, 5};
+    double slowdown = 1.0;
+    int tickMs = 10;
+    const char* out = nullptr;
+    const char* baseline = nullptr;
+    double tolerance = 20.0;           // Percent
+};
+
+bool parseMix(const char* text, int* weights) {
+    int parsed[KIND_COUNT] = {0};
+    std::string mix(text);
+    size_t start = 0;
+    while (start < mix.size()) {
+        size_t end = mix.find(',', start);
+        if (end == std::string::npos) end = mix.size();
+        std::string item = mix.substr(start, end - start);
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string name = item.substr(0, eq);
+        int kind = -1;
+        for (int k = 0; k < KIND_COUNT; k++) {
+            if (name == KIND_NAMES[k]) kind = k;
+        }
+        if (kind < 0) return false;
+        parsed[kind] = atoi(item.c_str() + eq + 1);
+        start = end + 1;
+    }
+    int total = 0;
+    for (int k = 0; k < KIND_COUNT; k++) total += parsed[k];
+    if (total <= 0) return false;
+    memcpy(weights, parsed, sizeof(parsed));
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Host-simulated firmware: the real HttpServer behind a loop shaped like main.ino's
+
+class SimFirmware {
+private:
+    HttpServer server;
+    double slowdown;
+    int tickMs;
+    std::atomic<bool> running{false};
+    std::thread loopThread;
+
+    // State the control routes act on, with the FanCommands rules
+    bool autoMode = true;
+    bool fanOn = false;
+    float manualSpeed = 0.5f;
+    uint32_t version = 1;
+
+    std::vector<double> busyUs;        // Loop work per iteration
+    std::vector<double> latenessMs;    // Control tick start after its due time
+
+    static void spin(double microseconds) {
+        Clock::time_point until = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                                     std::chrono::duration<double, std::micro>(microseconds));
+        while (Clock::now() < until) {
+        }
+    }
+
+    void sendResult(bool ok, const char* message) {
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        TextWriter json = server.text();
+        json.print(ok ? "{\"success\":\"" : "{\"error\":\"").print(message).print("\"}");
+        server.send(ok ? 200 : 400, "application/json", json);
+    }
+
+    // Same fields and magnitudes as SystemStatus::toJson with all features
+    void sendStatus() {
+        static const char* const numbers[] = {
+            "temperature", "min_temperature", "max_temperature", "humidity", "filtered_temperature",
+            "temperature_slope", "dew_point", "absolute_humidity", "enthalpy", "manual_fan_speed",
+            "current_fan_speed", "target_fan_speed", "fan_rpm", "fan_duty", "target_rpm", "rpm_error",
+            "rpm_error_avg", "reference_temp", "total_heat_energy", "current_heat_power",
+            "latent_heat_power", "air_volume_moved", "avg_heat_power", "total_operating_time",
+            "fan_operating_time", "energy_usage", "fan_power", "coefficient_of_performance",
+            "last_sensor_update", "last_rpm_update"};
+        TextWriter json = server.text();
+        json.print("{\"version\":").print(static_cast<unsigned long>(version));
+        int i = 0;
+        for (const char* name : numbers) {
+            json.print(",\"").print(name).print("\":").print(21.37 + i++ * 13.1, 2);
+        }
+        json.print(",\"auto_mode\":").print(autoMode).print(",\"fan_on\":").print(fanOn);
+        json.print(",\"heat_calc_active\":true,\"status_code\":\"operating\",\"error_state\":\"none\"");
+        json.print(",\"auto_mode_status\":\"Operating Phase: 63% Power\"");
+        json.print(",\"sampling\":{\"interval_ms\":4000,\"samples_per_hour\":412,\"residual\":0.03,\"rate\":0.41}");
+        json.print(",\"fan_health\":{\"model_ready\":true,\"score\":97,\"rpm_shortfall_percent\":1.2,"
+                   "\"variance_ratio\":1.04,\"hours_to_maintenance\":-1,\"shortfall_warning\":false,"
+                   "\"variance_warning\":false,\"drift_warning\":false}");
+        json.print(",\"fan_calibration\":{\"calibrated\":true,\"running\":false,\"state\":\"done\",\"failure\":\"\","
+                   "\"progress\":1.00,\"start_duty\":0.090,\"min_duty\":0.100,\"min_rpm\":410,\"max_rpm\":1960}");
+        json.print(",\"safety\":{\"override_active\":false,\"latched\":false,\"reason\":\"none\",\"trip_count\":0}");
+        json.print(",\"power\":{\"active_percent\":12.5,\"idle_percent\":40.1,\"light_sleep_percent\":47.4,"
+                   "\"estimated_current\":31.2,\"active_wakeups_per_hour\":3600,\"sleep_wakeups_per_hour\":120,"
+                   "\"light_sleep_available\":true}}");
+        char etag[16];
+        snprintf(etag, sizeof(etag), "\"v%lu\"", static_cast<unsigned long>(version));
+        server.sendHeader("ETag", etag);
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.sendHeader("Cache-Control", "no-cache");
+        server.send(200, "application/json", json);
+    }
+
+    void setupRoutes() {
+        server.on("/", HttpMethod::GET, [this]() {
+            server.sendStatic(200, "text/html", HTML_PARTS, HTML_PART_COUNT);
+        });
+        server.on("/api/v1/status", HttpMethod::GET, [this]() { sendStatus(); });
+        server.on("/api/v1/fan/toggle", HttpMethod::POST, [this]() {
+            if (autoMode) return sendResult(false, "Cannot toggle fan in automatic mode");
+            fanOn = !fanOn;
+            version++;
+            sendResult(true, "Fan state toggled successfully");
+        });
+        server.on("/api/v1/fan/mode", HttpMethod::POST, [this]() {
+            if (!server.hasArg("mode")) return sendResult(false, "Missing 'mode' parameter");
+            const char* mode = server.arg("mode");
+            autoMode = strcmp(mode, "1") == 0 || strcasecmp(mode, "true") == 0;
+            version++;
+            sendResult(true, "Mode updated successfully");
+        });
+        server.on("/api/v1/fan/speed", HttpMethod::POST, [this]() {
+            if (autoMode) return sendResult(false, "Cannot set fan speed in automatic mode");
+            float speed = strtof(server.arg("speed"), nullptr);
+            if (speed < 0.0f || speed > 1.0f) return sendResult(false, "Invalid speed value");
+            manualSpeed = speed;
+            version++;
+            sendResult(true, "Speed updated successfully");
+        });
+        server.onNotFound([this]() { server.send(404, "application/json", "{\"error\":\"Not found\"}"); });
+    }
+
+    void loop() {
+        Clock::time_point nextTick = Clock::now() + std::chrono::milliseconds(tickMs);
+        while (running.load(std::memory_order_relaxed)) {
+            Clock::time_point start = Clock::now();
+            server.handle();
+            double work = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            if (slowdown > 1.0) spin(work * (slowdown - 1.0));
+            busyUs.push_back(work * slowdown);
+
+            Clock::time_point now = Clock::now();
+            if (now >= nextTick) {
+                latenessMs.push_back(elapsedMs(nextTick, now));
+                while (nextTick <= now) nextTick += std::chrono::milliseconds(tickMs);
+            }
+            double untilTick = elapsedMs(Clock::now(), nextTick);
+            if (untilTick >= 1.0) {
+                server.waitForActivity(static_cast<unsigned long>(untilTick));
+            }
+        }
+    }
+
+public:
+    SimFirmware(int port, double loopSlowdown, int tick)
+        : server(static_cast<uint16_t>(port)), slowdown(loopSlowdown), tickMs(tick) {
+        setupRoutes();
+    }
+
+    bool start() {
+        if (!server.begin()) return false;
+        running = true;
+        loopThread = std::thread([this]() { loop(); });
+        return true;
+    }
+
+    void stop() {
+        running = false;
+        if (loopThread.joinable()) loopThread.join();
+    }
+
+    std::vector<double>& getBusyUs() { return busyUs; }
+    std::vector<double>& getLatenessMs() { return latenessMs; }
+};
+
+// ---------------------------------------------------------------------------------------------
+// Client
+
+struct Result {
+    std::vector<double> latency[KIND_COUNT];    // ms, completed responses
+    long rejected[KIND_COUNT] = {0};
+    long errors[KIND_COUNT] = {0};
+    long reconnects = 0;
+};
+
+class Client {
+private:
+    const Options& options;
+    sockaddr_in address;
+    int fd = -1;
+    bool reused = false;
+    std::string buffer;
+
+    void closeSocket() {
+        if (fd >= 0) close(fd);
+        fd = -1;
+        reused = false;
+    }
+
+    bool connectSocket() {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return false;
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        timeval timeout = {options.timeoutMs / 1000, (options.timeoutMs % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            closeSocket();
+            return false;
+        }
+        return true;
+    }
+
+    // 0: complete, 1: closed before any byte (stale keep-alive), -1: error
+    int exchange(const std::string& request, int& status, bool& serverCloses) {
+        if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+            return reused ? 1 : -1;
+        }
+        buffer.clear();
+        size_t headerEnd = std::string::npos;
+        long contentLength = -1;
+        char chunk[4096];
+        while (true) {
+            if (headerEnd != std::string::npos && contentLength >= 0 &&
+                buffer.size() >= headerEnd + contentLength) {
+                return 0;
+            }
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n == 0) {
+                if (buffer.empty()) return reused ? 1 : -1;
+                // Without Content-Length the body ends with the connection
+                if (headerEnd != std::string::npos && contentLength < 0) {
+                    serverCloses = true;
+                    return 0;
+                }
+                return -1;
+            }
+            if (n < 0) return (errno == ECONNRESET && buffer.empty() && reused) ? 1 : -1;
+            buffer.append(chunk, n);
+
+            if (headerEnd == std::string::npos) {
+                size_t end = buffer.find("\r\n\r\n");
+                if (end == std::string::npos) continue;
+                headerEnd = end + 4;
+                if (sscanf(buffer.c_str(), "HTTP/1.%*d %d", &status) != 1) return -1;
+                std::string headers = buffer.substr(0, headerEnd);
+                std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+                size_t length = headers.find("\r\ncontent-length:");
+                if (length != std::string::npos) contentLength = atol(headers.c_str() + length + 17);
+                serverCloses = headers.find("\r\nconnection: close") != std::string::npos;
+            }
+        }
+    }
+
+public:
+    explicit Client(const Options& clientOptions) : options(clientOptions) {
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.port));
+        inet_pton(AF_INET, options.host.c_str(), &address.sin_addr);
+    }
+
+    ~Client() { closeSocket(); }
+
+    // One request; returns the HTTP status, or -1 on a transport error
+    int request(const std::string& text, Result& result, double& latency) {
+        Clock::time_point start = Clock::now();
+        for (int attempt = 0; attempt < 2; attempt++) {
+            if (fd < 0 && !connectSocket()) return -1;
+            int status = 0;
+            bool serverCloses = false;
+            int outcome = exchange(text, status, serverCloses);
+            if (outcome == 1) {
+                // The server closed an idle keep-alive connection; a client retries on a new one.
+                // The failed round trip and the reconnect stay in the latency of the request.
+                closeSocket();
+                result.reconnects++;
+                continue;
+            }
+            if (outcome < 0) {
+                closeSocket();
+                return -1;
+            }
+            latency = elapsedMs(start, Clock::now());
+            if (!options.keepAlive || serverCloses) closeSocket();
+            else reused = true;
+            return status;
+        }
+        return -1;
+    }
+};
+
+std::string buildRequest(Kind kind, const Options& options, std::mt19937& rng, bool& modeFlag) {
+    const char* connection = options.keepAlive ? "keep-alive" : "close";
+    char body[32] = "";
+    const char* path = "/api/v1/status";
+    bool post = false;
+    switch (kind) {
+        case STATUS: path = "/api/v1/status"; break;
+        case ROOT: path = "/"; break;
+        case TOGGLE: path = "/api/v1/fan/toggle"; post = true; break;
+        case MODE:
+            path = "/api/v1/fan/mode";
+            post = true;
+            modeFlag = !modeFlag;
+            snprintf(body, sizeof(body), "mode=%d", modeFlag ? 1 : 0);
+            break;
+        case SPEED:
+            path = "/api/v1/fan/speed";
+            post = true;
+            snprintf(body, sizeof(body), "speed=%.2f", std::uniform_real_distribution<double>(0.2, 0.8)(rng));
+            break;
+        default: break;
+    }
+    char request[512];
+    if (post) {
+        snprintf(request, sizeof(request),
+                 "POST %s HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n"
+                 "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: %zu\r\n\r\n%s",
+                 path, options.host.c_str(), connection, strlen(body), body);
+    } else {
+        snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n\r\n", path,
+                 options.host.c_str(), connection);
+    }
+    return request;
+}
+
+void runClient(const Options& options, int id, Clock::time_point deadline, std::atomic<long>& issued,
+               Result& result) {
+    std::mt19937 rng(1000 + id);
+    int total = 0;
+    for (int k = 0; k < KIND_COUNT; k++) total += options.weights[k];
+    bool modeFlag = id % 2 == 0;
+    Client client(options);
+
+    while (Clock::now() < deadline) {
+        if (options.maxRequests > 0 && issued.fetch_add(1) >= options.maxRequests) break;
+
+        int pick = std::uniform_int_distribution<int>(0, total - 1)(rng);
+        int kind = 0;
+        while (pick >= options.weights[kind]) pick -= options.weights[kind++];
+
+        double latency = 0.0;
+        int status = client.request(buildRequest(static_cast<Kind>(kind), options, rng, modeFlag), result, latency);
+        if (status < 0 || status >= 500) {
+            result.errors[kind]++;
+        } else {
+            result.latency[kind].push_back(latency);
+            if (status >= 400) result.rejected[kind]++;
+        }
+        if (options.thinkMs > 0.0) {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(options.thinkMs));
+        }
+    }
+}
+
+// Body of a small GET response from the unit, empty on failure
+std::string fetch(const Options& options, const char* path) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return "";
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    inet_pton(AF_INET, options.host.c_str(), &address.sin_addr);
+    timeval timeout = {options.timeoutMs / 1000, (options.timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char request[256];
+    snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", path,
+             options.host.c_str());
+    std::string response;
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0 &&
+        send(fd, request, strlen(request), MSG_NOSIGNAL) > 0) {
+        char chunk[1024];
+        ssize_t n;
+        while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0) response.append(chunk, n);
+    }
+    close(fd);
+    size_t body = response.find("\r\n\r\n");
+    return body == std::string::npos ? "" : response.substr(body + 4);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Reporting
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5)];
+}
+
+// Value of "key": in a flat JSON object, NAN when missing
+double jsonNumber(const std::string& json, const char* key) {
+    std::string pattern = std::string("\"") + key + "\":";
+    size_t at = json.find(pattern);
+    if (at == std::string::npos) return NAN;
+    return strtod(json.c_str() + at + pattern.size(), nullptr);
+}
+
+struct Summary {
+    long requests = 0;
+    long errors = 0;
+    long rejected = 0;
+    long reconnects = 0;
+    double rps = 0.0;
+    double reconnectRate = 0.0;    // Percent of requests
+    double errorRate = 0.0;        // Percent
+    double p50 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0;
+    double busyP99 = NAN, busyMax = NAN;            // us, simulated firmware
+    double tickP50 = NAN, tickP99 = NAN, tickMax = NAN;   // ms
+
+    std::string toJson() const {
+        char text[512];
+        snprintf(text, sizeof(text),
+                 "{\"requests\":%ld,\"errors\":%ld,\"rejected\":%ld,\"reconnects\":%ld,\"rps\":%.1f,"
+                 "\"error_rate\":%.3f,\"reconnect_rate\":%.3f,"
+                 "\"p50_ms\":%.3f,\"p95_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,"
+                 "\"loop_busy_p99_us\":%.1f,\"loop_busy_max_us\":%.1f,"
+                 "\"tick_lateness_p50_ms\":%.3f,\"tick_lateness_p99_ms\":%.3f,\"tick_lateness_max_ms\":%.3f}\n",
+                 requests, errors, rejected, reconnects, rps, errorRate, reconnectRate, p50, p95, p99, max, busyP99, busyMax, tickP50,
+                 tickP99, tickMax);
+        std::string json(text);
+        // NAN is not JSON
+        for (size_t at; (at = json.find("nan")) != std::string::npos;) json.replace(at, 3, "null");
+        return json;
+    }
+};
+
+// Regressed if a percentile grew by more than the tolerance (plus timer resolution) or
+// the error rate by more than half a point
+bool compareBaseline(const Summary& now, const char* path, double tolerance) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("Baseline %s not readable\n", path);
+        return false;
+    }
+    char text[1024];
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    fclose(file);
+    text[length] = '\0';
+    std::string json(text);
+
+    struct Check {
+        const char* key;
+        double value;
+        double slack;       // Absolute allowance for timer resolution
+    };
+    const Check checks[] = {
+        {"p95_ms", now.p95, 0.2},
+        {"p99_ms", now.p99, 0.2},
+        {"reconnect_rate", now.reconnectRate, 1.0},
+        {"tick_lateness_p99_ms", now.tickP99, 0.5},
+    };
+    bool ok = true;
+    printf("\nAgainst baseline %s (tolerance %.0f %%):\n", path, tolerance);
+    for (const Check& check : checks) {
+        double base = jsonNumber(json, check.key);
+        if (std::isnan(base) || std::isnan(check.value)) continue;
+        double limit = base * (1.0 + tolerance / 100.0) + check.slack;
+        bool pass = check.value <= limit;
+        printf("  %-22s %9.3f -> %9.3f  %s\n", check.key, base, check.value, pass ? "ok" : "REGRESSED");
+        ok = ok && pass;
+    }
+    double baseErrors = jsonNumber(json, "error_rate");
+    if (!std::isnan(baseErrors)) {
+        bool pass = now.errorRate <= baseErrors + 0.5;
+        printf("  %-22s %9.3f -> %9.3f  %s\n", "error_rate", baseErrors, now.errorRate, pass ? "ok" : "REGRESSED");
+        ok = ok && pass;
+    }
+    return ok;
+}
+
+void usage() {
+    printf("Usage: load_test (--simulate | --host <ip>) [options]\n"
+           "  --port <n>          target port (80 for a unit, 8080 simulated)\n"
+           "  -c <n>              concurrent clients (4)\n"
+           "  -d <s>              duration in seconds (10)\n"
+           "  -n <n>              stop after n requests\n"
+           "  --mix <list>        weights, e.g. status=80,root=5,toggle=5,mode=5,speed=5\n"
+           "  --think <ms>        pause between requests of one client (0)\n"
+           "  --close             one connection per request instead of keep-alive\n"
+           "  --timeout <ms>      per-request timeout (5000)\n"
+           "  --slowdown <x>      simulated firmware: stretch loop work x times (1)\n"
+           "  --tick <ms>         simulated firmware: control tick period (10)\n"
+           "  --out <file>        write the summary as JSON\n"
+           "  --baseline <file>   compare with an earlier --out, exit 2 on regression\n"
+           "  --tolerance <pct>   allowed growth of p95/p99/tick lateness (20)\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    bool portSet = false;
+    bool targetSet = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--simulate") {
+            options.simulate = true;
+            targetSet = true;
+        } else if (arg == "--host" && hasValue) {
+            options.host = argv[++i];
+            targetSet = true;
+        } else if (arg == "--port" && hasValue) {
+            options.port = atoi(argv[++i]);
+            portSet = true;
+        } else if (arg == "-c" && hasValue) {
+            options.clients = std::max(1, atoi(argv[++i]));
+        } else if (arg == "-d" && hasValue) {
+            options.duration = atof(argv[++i]);
+        } else if (arg == "-n" && hasValue) {
+            options.maxRequests = atol(argv[++i]);
+        } else if (arg == "--mix" && hasValue) {
+            if (!parseMix(argv[++i], options.weights)) {
+                printf("Invalid mix: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--think" && hasValue) {
+            options.thinkMs = atof(argv[++i]);
+        } else if (arg == "--close") {
+            options.keepAlive = false;
+        } else if (arg == "--timeout" && hasValue) {
+            options.timeoutMs = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--slowdown" && hasValue) {
+            options.slowdown = std::max(1.0, atof(argv[++i]));
+        } else if (arg == "--tick" && hasValue) {
+            options.tickMs = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--out" && hasValue) {
+            options.out = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baseline = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            options.tolerance = atof(argv[++i]);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!targetSet) {
+        usage();
+        return 1;
+    }
+    if (!options.simulate && !portSet) options.port = 80;
+    if (options.simulate) options.host = "127.0.0.1";
+
+    SimFirmware* firmware = nullptr;
+    if (options.simulate) {
+        firmware = new SimFirmware(options.port, options.slowdown, options.tickMs);
+        if (!firmware->start()) {
+            printf("Cannot listen on port %d\n", options.port);
+            return 1;
+        }
+    }
+
+    std::string watchdogBefore = options.simulate ? "" : fetch(options, "/api/v1/system/watchdog");
+
+    std::vector<Result> results(options.clients);
+    std::vector<std::thread> threads;
+    std::atomic<long> issued{0};
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::duration_cast<Clock::duration>(
+                                             std::chrono::duration<double>(options.duration));
+    for (int i = 0; i < options.clients; i++) {
+        threads.emplace_back(runClient, std::cref(options), i, deadline, std::ref(issued), std::ref(results[i]));
+    }
+    for (std::thread& thread : threads) thread.join();
+    double seconds = elapsedMs(start, Clock::now()) / 1000.0;
+
+    if (firmware) firmware->stop();
+
+    // Merge per client
+    Result all;
+    for (Result& result : results) {
+        for (int k = 0; k < KIND_COUNT; k++) {
+            all.latency[k].insert(all.latency[k].end(), result.latency[k].begin(), result.latency[k].end());
+            all.rejected[k] += result.rejected[k];
+            all.errors[k] += result.errors[k];
+        }
+        all.reconnects += result.reconnects;
+    }
+
+    printf("Target %s:%d%s, %d clients, %.1f s, %s, think %.0f ms\n", options.host.c_str(), options.port,
+           options.simulate ? " (simulated firmware)" : "", options.clients, seconds,
+           options.keepAlive ? "keep-alive" : "connection per request", options.thinkMs);
+    printf("\n%-8s %8s %8s %7s %8s %8s %8s %8s\n", "route", "count", "rejected", "errors", "p50 ms", "p95 ms",
+           "p99 ms", "max ms");
+
+    Summary summary;
+    std::vector<double> merged;
+    for (int k = 0; k < KIND_COUNT; k++) {
+        std::vector<double>& latency = all.latency[k];
+        long count = static_cast<long>(latency.size()) + all.errors[k];
+        if (count == 0) continue;
+        printf("%-8s %8ld %8ld %7ld %8.2f %8.2f %8.2f %8.2f\n", KIND_NAMES[k], count, all.rejected[k],
+               all.errors[k], percentile(latency, 50), percentile(latency, 95), percentile(latency, 99),
+               percentile(latency, 100));
+        merged.insert(merged.end(), latency.begin(), latency.end());
+        summary.requests += count;
+        summary.errors += all.errors[k];
+        summary.rejected += all.rejected[k];
+    }
+    summary.p50 = percentile(merged, 50);
+    summary.p95 = percentile(merged, 95);
+    summary.p99 = percentile(merged, 99);
+    summary.max = percentile(merged, 100);
+    summary.rps = summary.requests / seconds;
+    summary.errorRate = summary.requests > 0 ? 100.0 * summary.errors / summary.requests : 0.0;
+    summary.reconnects = all.reconnects;
+    summary.reconnectRate = summary.requests > 0 ? 100.0 * all.reconnects / summary.requests : 0.0;
+    printf("%-8s %8ld %8ld %7ld %8.2f %8.2f %8.2f %8.2f\n", "all", summary.requests, summary.rejected,
+           summary.errors, summary.p50, summary.p95, summary.p99, summary.max);
+    printf("\n%.0f requests/s, error rate %.2f %%, %ld keep-alive reconnects\n", summary.rps, summary.errorRate,
+           all.reconnects);
+
+    if (firmware) {
+        std::vector<double>& busy = firmware->getBusyUs();
+        std::vector<double>& lateness = firmware->getLatenessMs();
+        summary.busyP99 = percentile(busy, 99);
+        summary.busyMax = percentile(busy, 100);
+        summary.tickP50 = percentile(lateness, 50);
+        summary.tickP99 = percentile(lateness, 99);
+        summary.tickMax = percentile(lateness, 100);
+        printf("Loop (slowdown %.0fx): busy per iteration p50 %.0f us, p99 %.0f us, max %.0f us\n",
+               options.slowdown, percentile(busy, 50), summary.busyP99, summary.busyMax);
+        printf("Control tick every %d ms: late by p50 %.2f ms, p99 %.2f ms, max %.2f ms (%zu ticks)\n",
+               options.tickMs, summary.tickP50, summary.tickP99, summary.tickMax, lateness.size());
+        delete firmware;
+    } else {
+        std::string watchdogAfter = fetch(options, "/api/v1/system/watchdog");
+        if (!watchdogAfter.empty()) {
+            printf("Unit loop: last %.0f us, max since boot %.0f us (before the run %.0f us)\n",
+                   jsonNumber(watchdogAfter, "last_loop_us"), jsonNumber(watchdogAfter, "max_loop_us"),
+                   jsonNumber(watchdogBefore, "max_loop_us"));
+        }
+    }
+
+    if (options.out) {
+        FILE* file = fopen(options.out, "w");
+        if (file) {
+            fputs(summary.toJson().c_str(), file);
+            fclose(file);
+        }
+    }
+    if (options.baseline && !compareBaseline(summary, options.baseline, options.tolerance)) {
+        printf("REGRESSED\n");
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+// Host simulation of loop and safety wakeups per hour in each operating mode, driven by the
+// same schedules power_manager.h waits on: sensor samples from SampleScheduler (with
+// SensorFilter slopes), RPM updates every RPM_UPDATE_INTERVAL while the fan runs, the WiFi
+// RSSI interval, the MQTT keep-alive, the Watchdog::MAX_WAIT cap and, in sleep mode,
+// Power::MAX_SLEEP_TIME. The safety task samples at SafetyTrip::nextInterval() and each of its
+// samples counts as a wakeup. In sleep mode the learned check schedule (the prior of
+// activity_histogram.h) runs the fan for CHECK_DURATION, during which the loop cannot sleep.
+// Estimates the average current from the Config::Power state currents and compares both with
+// the previous loop, which ran every PREVIOUS_LOOP_DELAY without light sleep.
+// Exits non-zero when a mode does not cut wakeups by MIN_WAKEUP_REDUCTION or sleep mode does
+// not reach light sleep for most of the time.
+//
+// Build and run: g++ -O2 -std=gnu++17 -I. tools/power_sim.cpp -o power_sim
+//                ./power_sim [hours]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include "activity_histogram.h"
+#include "safety_trip.h"
+#include "sample_scheduler.h"
+#include "sensor_filter.h"
+
+namespace {
+
+constexpr double HOUR = 3600000.0;
+constexpr double DAY = 24.0 * HOUR;
+constexpr unsigned long PREVIOUS_LOOP_DELAY = 10;     // Former Config::System::WATCHDOG_DELAY
+constexpr double LOOP_WORK = 1.0;                     // Loop pass without a sensor read in ms
+constexpr double MIN_WAKEUP_REDUCTION = 10.0;
+constexpr double MIN_SLEEP_RESIDENCY = 0.8;           // Share of sleep mode spent in light sleep
+constexpr int CHECK_WEEKDAY = 1;
+
+std::mt19937 rng(4242);
+
+double gaussian(double sigma) {
+    return std::normal_distribution<double>(0.0, sigma)(rng);
+}
+
+struct Scenario {
+    const char* name;
+    bool autoMode;
+    bool sleepMode;         // Controller in sleep mode, checks from the learned schedule
+    bool burning;           // Fan runs for the whole run on a burning fire
+    bool mqtt;
+};
+
+struct Result {
+    double hours = 0.0;
+    uint32_t loopWakeups = 0;
+    uint32_t safetyWakeups = 0;
+    double residency[3] = {0.0, 0.0, 0.0};   // Active, idle, light sleep in ms
+    double charge = 0.0;                     // mA * ms
+
+    double wakeupsPerHour() const { return (loopWakeups + safetyWakeups) / hours; }
+    double current() const { return charge / (hours * HOUR); }
+    double sleepShare() const { return residency[2] / (hours * HOUR); }
+};
+
+double temperatureAt(const Scenario& scenario, double t) {
+    if (!scenario.burning) return 20.0 + 0.3 * sin(2.0 * M_PI * t / DAY) + gaussian(0.02);
+    return 55.0 + 8.0 * sin(2.0 * M_PI * t / HOUR) + gaussian(0.05);
+}
+
+int slotAt(double t) {
+    return static_cast<int>(fmod(t, DAY) / (ActivityHistogram::SLOT_MINUTES * 60000.0));
+}
+
+Result run(const Scenario& scenario, double hours) {
+    const float stateCurrent[3] = {Config::Power::CURRENT_ACTIVE_MA, Config::Power::CURRENT_IDLE_MA,
+                                   Config::Power::CURRENT_LIGHT_SLEEP_MA};
+    const double end = hours * HOUR;
+    const double keepAlive = Config::Mqtt::KEEP_ALIVE * 1000.0 / 2.0;
+    const double readTime = Config::Safety::SENSOR_READ_TIME;
+
+    ActivityHistogram histogram;
+    SensorFilter filter;
+    SampleScheduler scheduler;
+    SafetyTrip trip;
+    Result result;
+    result.hours = hours;
+
+    double t = 0.0;
+    double nextSample = 0.0;
+    double nextRssi = 0.0;
+    double nextKeepAlive = keepAlive;
+    double nextSafety = 0.0;
+    double lastRPM = 0.0;
+    double lastCheck = 0.0;
+    double checkEnd = -1.0;
+    while (t < end) {
+        // Loop pass
+        result.loopWakeups++;
+        double work = LOOP_WORK;
+        bool fanOn = scenario.burning || t < checkEnd;
+        if (t >= nextSample) {
+            work += readTime;
+            float temperature = static_cast<float>(temperatureAt(scenario, t));
+            float humidity = static_cast<float>(45.0 + gaussian(0.3));
+            unsigned long now = static_cast<unsigned long>(t);
+            SensorFilter::Result filtered = filter.update(temperature, humidity, now);
+            unsigned long maxInterval = fanOn ? Config::Sensor::ACTIVE_MAX_INTERVAL : Config::Sensor::MAX_INTERVAL;
+            unsigned long interval = (filtered.spike || filtered.stuck)
+                                         ? scheduler.getInterval()
+                                         : scheduler.update(temperature, filtered.slope, now, maxInterval);
+            nextSample = t + interval;
+
+            // Control pass: a check starts once its interval has passed and finds no fire
+            if (scenario.sleepMode && !fanOn) {
+                unsigned long checkInterval =
+                    ActivityHistogram::checkInterval(histogram.likelihood(CHECK_WEEKDAY, slotAt(t)));
+                if (t - lastCheck >= checkInterval) {
+                    lastCheck = t;
+                    checkEnd = t + Config::CHECK_DURATION;
+                    fanOn = true;
+                    lastRPM = t;
+                }
+            }
+        }
+        if (fanOn && t - lastRPM >= Config::Tacho::RPM_UPDATE_INTERVAL) lastRPM = t;
+        if (t >= nextRssi) nextRssi = t + Config::Wifi::RSSI_INTERVAL;
+        if (scenario.mqtt && t >= nextKeepAlive) nextKeepAlive = t + keepAlive;
+        result.residency[0] += work;
+        result.charge += work * stateCurrent[0];
+        t += work;
+
+        // Wait until the next event, as PowerManager::idle()
+        double next = std::min(nextSample, nextRssi);
+        if (fanOn) next = std::min(next, lastRPM + Config::Tacho::RPM_UPDATE_INTERVAL);
+        if (checkEnd > t) next = std::min(next, checkEnd);
+        if (scenario.mqtt) next = std::min(next, nextKeepAlive);
+        double budget = std::max(0.0, next - t);
+        int state = 1;
+        if (scenario.autoMode && scenario.sleepMode && !fanOn) {
+            budget = std::min(budget, static_cast<double>(Config::Power::MAX_SLEEP_TIME));
+            state = 2;
+        }
+        budget = std::min(budget, static_cast<double>(Config::Watchdog::MAX_WAIT));
+        double waitEnd = t + budget;
+
+        // Safety task samples during the wait
+        while (nextSafety < waitEnd) {
+            result.safetyWakeups++;
+            result.charge += readTime * (stateCurrent[0] - stateCurrent[state]);
+            trip.update(true, static_cast<float>(temperatureAt(scenario, nextSafety)),
+                        static_cast<unsigned long>(nextSafety + readTime));
+            nextSafety += trip.nextInterval();
+        }
+        result.residency[state] += budget;
+        result.charge += budget * stateCurrent[state];
+        t = waitEnd;
+    }
+    return result;
+}
+
+// Previous loop: one pass and a fixed delay, no light sleep; the loop read the sensor itself
+Result previous(double hours) {
+    Result result;
+    result.hours = hours;
+    double pass = LOOP_WORK + PREVIOUS_LOOP_DELAY;
+    result.loopWakeups = static_cast<uint32_t>(hours * HOUR / pass);
+    double active = result.loopWakeups * LOOP_WORK;
+    double idle = hours * HOUR - active;
+    result.residency[0] = active;
+    result.residency[1] = idle;
+    result.charge = active * Config::Power::CURRENT_ACTIVE_MA + idle * Config::Power::CURRENT_IDLE_MA;
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 24.0;
+    if (hours <= 0.0) hours = 24.0;
+
+    const Scenario scenarios[] = {
+        {"Sleep mode", true, true, false, false},
+        {"Sleep mode, MQTT", true, true, false, true},
+        {"Active, fan running", true, false, true, false},
+        {"Manual, fan off", false, false, false, false},
+    };
+
+    bool ok = true;
+    printf("%.0f h per mode, previous loop every %lu ms\n\n", hours, PREVIOUS_LOOP_DELAY);
+    printf("%-22s %10s %10s %10s %8s %9s %12s %10s\n", "", "loop/h", "safety/h", "total/h", "sleep",
+           "current", "previous/h", "previous");
+    for (const Scenario& scenario : scenarios) {
+        Result r = run(scenario, hours);
+        Result p = previous(hours);
+        printf("%-22s %10.0f %10.0f %10.0f %7.1f%% %6.1f mA %12.0f %5.1f mA\n", scenario.name,
+               r.loopWakeups / hours, r.safetyWakeups / hours, r.wakeupsPerHour(), r.sleepShare() * 100.0,
+               r.current(), p.wakeupsPerHour(), p.current());
+        if (r.wakeupsPerHour() * MIN_WAKEUP_REDUCTION > p.wakeupsPerHour()) {
+            printf("FAIL: %s wakes up less than %.0fx less often than the previous loop\n", scenario.name,
+                   MIN_WAKEUP_REDUCTION);
+            ok = false;
+        }
+        if (scenario.sleepMode && r.sleepShare() < MIN_SLEEP_RESIDENCY) {
+            printf("FAIL: %s spends less than %.0f%% in light sleep\n", scenario.name, MIN_SLEEP_RESIDENCY * 100.0);
+            ok = false;
+        }
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
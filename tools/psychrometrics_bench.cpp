@@ -0,0 +1,211 @@
+// Host check and benchmark of psychrometrics.h.
+// Compares the saturation pressure table and the derived properties with the reference
+// equations the table is built from (IAPWS-IF97 above 0 °C, Murphy & Koop 2005 for supercooled
+// water below), shows the error of the Magnus formula for comparison, and times one full update
+// per sample. Exits non-zero when an error exceeds its limit.
+//
+// Build and run: g++ -O2 -std=gnu++17 -I. tools/psychrometrics_bench.cpp -o psychrometrics_bench
+//                ./psychrometrics_bench [--table]
+// --table prints Psychrometrics::SATURATION_TABLE from the reference equations instead.
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <initializer_list>
+#include "psychrometrics.h"
+
+namespace {
+
+// Saturation vapour pressure over liquid water in Pa
+double referenceSaturationPressure(double celsius) {
+    double t = celsius + 273.15;
+    if (celsius < 0.0) {
+        double lnP = 54.842763 - 6763.22 / t - 4.210 * log(t) + 0.000367 * t +
+                     tanh(0.0415 * (t - 218.8)) * (53.878 - 1331.22 / t - 9.44523 * log(t) + 0.014025 * t);
+        return exp(lnP);
+    }
+    static const double n[] = {0.11670521452767e4, -0.72421316703206e6, -0.17073846940092e2,
+                               0.12020824702470e5, -0.32325550322333e7, 0.14915108613530e2,
+                               -0.48232657361591e4, 0.40511340542057e6, -0.23855557567849,
+                               0.65017534844798e3};
+    double theta = t + n[8] / (t - n[9]);
+    double a = theta * theta + n[0] * theta + n[1];
+    double b = n[2] * theta * theta + n[3] * theta + n[4];
+    double c = n[5] * theta * theta + n[6] * theta + n[7];
+    double p = 2.0 * c / (-b + sqrt(b * b - 4.0 * a * c));
+    return p * p * p * p * 1e6;
+}
+
+double referenceDewPoint(double vaporPressure) {
+    double low = -60.0;
+    double high = 150.0;
+    for (int i = 0; i < 60; i++) {
+        double middle = 0.5 * (low + high);
+        if (referenceSaturationPressure(middle) < vaporPressure) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return 0.5 * (low + high);
+}
+
+// Same properties as Psychrometrics::airState(), in double with the reference pressure
+Psychrometrics::AirState referenceAirState(double temperature, double rh, double pressure) {
+    using namespace Psychrometrics;
+    double e = referenceSaturationPressure(temperature) * rh / 100.0;
+    double kelvin = temperature + 273.15;
+    double w = MOLAR_MASS_RATIO * e / (pressure - e);
+    Psychrometrics::AirState state;
+    state.vaporPressure = e;
+    state.humidityRatio = w;
+    state.dewPoint = rh > 0.0 ? referenceDewPoint(e) : TABLE_MIN_TEMP;
+    state.absoluteHumidity = e / (GAS_CONSTANT_VAPOUR * kelvin) * 1000.0;
+    state.enthalpy = SPECIFIC_HEAT_DRY_AIR * temperature + w * (LATENT_HEAT + SPECIFIC_HEAT_VAPOUR * temperature);
+    state.dryAirDensity = (pressure - e) / (GAS_CONSTANT_DRY_AIR * kelvin);
+    state.density = state.dryAirDensity + e / (GAS_CONSTANT_VAPOUR * kelvin);
+    return state;
+}
+
+// Magnus formula with WMO constants, the usual closed form approximation
+constexpr float MAGNUS_A = 611.2f;
+constexpr float MAGNUS_B = 17.62f;
+constexpr float MAGNUS_C = 243.12f;
+
+float magnusSaturationPressure(float temperature) {
+    return MAGNUS_A * expf(MAGNUS_B * temperature / (MAGNUS_C + temperature));
+}
+
+// Direct Magnus evaluation with exp()/log(), the variant the table replaces
+Psychrometrics::AirState directAirState(float temperature, float rh, float pressure) {
+    using namespace Psychrometrics;
+    float e = magnusSaturationPressure(temperature) * rh * 0.01f;
+    float kelvin = temperature + 273.15f;
+    Psychrometrics::AirState state;
+    state.vaporPressure = e;
+    state.humidityRatio = MOLAR_MASS_RATIO * e / (pressure - e);
+    float gamma = logf(e / MAGNUS_A);
+    state.dewPoint = MAGNUS_C * gamma / (MAGNUS_B - gamma);
+    float vaporDensity = e / (GAS_CONSTANT_VAPOUR * kelvin);
+    state.absoluteHumidity = vaporDensity * 1000.0f;
+    state.enthalpy = enthalpy(temperature, state.humidityRatio);
+    state.dryAirDensity = (pressure - e) / (GAS_CONSTANT_DRY_AIR * kelvin);
+    state.density = state.dryAirDensity + vaporDensity;
+    return state;
+}
+
+struct MaxError {
+    const char* name;
+    const char* unit;
+    double limit;                   // Negative: reported only
+    double value = 0.0;
+    double atTemperature = 0.0;
+    double atHumidity = 0.0;
+
+    MaxError(const char* errorName, const char* errorUnit, double errorLimit)
+        : name(errorName), unit(errorUnit), limit(errorLimit) {}
+
+    void add(double error, double temperature, double humidity) {
+        error = fabs(error);
+        if (error > value) {
+            value = error;
+            atTemperature = temperature;
+            atHumidity = humidity;
+        }
+    }
+
+    bool report() const {
+        bool ok = limit < 0.0 || value <= limit;
+        printf("%-38s %9.4f %-6s at %6.1f °C %5.1f %%  ", name, value, unit, atTemperature, atHumidity);
+        if (limit < 0.0) {
+            printf("(for comparison)\n");
+        } else {
+            printf("limit %.4f %s\n", limit, ok ? "ok" : "FAIL");
+        }
+        return ok;
+    }
+};
+
+template <typename Function>
+double nanosecondsPerCall(Function function, int iterations) {
+    volatile float sink = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        float temperature = -20.0f + (i % 1000) * 0.1f;
+        float humidity = 5.0f + (i % 90);
+        Psychrometrics::AirState state = function(temperature, humidity);
+        sink = sink + state.dewPoint + state.enthalpy;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    using namespace Psychrometrics;
+    const double pressure = Config::Heat::AMBIENT_PRESSURE;
+
+    if (argc > 1 && strcmp(argv[1], "--table") == 0) {
+        for (int i = 0; i < TABLE_SIZE; i++) {
+            char value[24];
+            snprintf(value, sizeof(value), "%.7g", referenceSaturationPressure(TABLE_MIN_TEMP + i));
+            printf("%s%s%sf%s", i % 8 == 0 ? "        " : " ", value, strchr(value, '.') ? "" : ".0",
+                   i == TABLE_SIZE - 1 ? "\n" : (i % 8 == 7 ? ",\n" : ","));
+        }
+        return 0;
+    }
+
+    // Table nodes must match the reference; between them linear interpolation adds up to
+    // h²/8 of the curvature of ln(p), largest at the cold end
+    MaxError tableNode("table nodes", "%", 1e-4);
+    MaxError saturation("saturation pressure", "%", 0.15);
+    MaxError magnus("saturation pressure, Magnus formula", "%", -1.0);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        double reference = referenceSaturationPressure(TABLE_MIN_TEMP + i);
+        tableNode.add((SATURATION_TABLE[i] - reference) / reference * 100.0, TABLE_MIN_TEMP + i, 100.0);
+    }
+    for (double t = TABLE_MIN_TEMP; t <= TABLE_MAX_TEMP; t += 0.05) {
+        double reference = referenceSaturationPressure(t);
+        saturation.add((saturationPressure(t) - reference) / reference * 100.0, t, 100.0);
+        magnus.add((magnusSaturationPressure(t) - reference) / reference * 100.0, t, 100.0);
+    }
+
+    MaxError dewPoint("dew point", "K", 0.02);
+    MaxError humidityRatio("humidity ratio", "%", 0.2);
+    MaxError absoluteHumidity("absolute humidity", "%", 0.15);
+    MaxError enthalpyError("enthalpy", "kJ/kg", 1.0);
+    MaxError densityError("moist air density", "%", 0.01);
+    for (double t = TABLE_MIN_TEMP; t <= TABLE_MAX_TEMP; t += 0.25) {
+        for (double rh = 5.0; rh <= 100.0; rh += 5.0) {
+            AirState fast = airState(t, rh);
+            AirState ref = referenceAirState(t, rh, pressure);
+            if (ref.dewPoint > TABLE_MIN_TEMP) {
+                dewPoint.add(fast.dewPoint - ref.dewPoint, t, rh);
+            }
+            // Near boiling the humidity ratio diverges; the fan never runs there
+            if (t > Config::MAX_TEMP || ref.vaporPressure > 0.5 * pressure) continue;
+            humidityRatio.add((fast.humidityRatio - ref.humidityRatio) / ref.humidityRatio * 100.0, t, rh);
+            absoluteHumidity.add((fast.absoluteHumidity - ref.absoluteHumidity) / ref.absoluteHumidity * 100.0, t, rh);
+            enthalpyError.add(fast.enthalpy - ref.enthalpy, t, rh);
+            densityError.add((fast.density - ref.density) / ref.density * 100.0, t, rh);
+        }
+    }
+
+    bool ok = true;
+    for (const MaxError* error : {&tableNode, &saturation, &magnus, &dewPoint, &humidityRatio, &absoluteHumidity,
+                                  &enthalpyError, &densityError}) {
+        ok = error->report() && ok;
+    }
+
+    const int iterations = 2000000;
+    double fast = nanosecondsPerCall([](float t, float rh) { return airState(t, rh); }, iterations);
+    double direct = nanosecondsPerCall(
+        [pressure](float t, float rh) { return directAirState(t, rh, static_cast<float>(pressure)); }, iterations);
+    printf("\nairState() (table)          %8.1f ns/sample\n", fast);
+    printf("direct Magnus (expf, logf)  %8.1f ns/sample\n", direct);
+    printf("The host has a hardware FPU; on the ESP32-C6 expf() and logf() run in software,\n"
+           "while the table path uses only basic float arithmetic.\n");
+
+    return ok ? 0 : 1;
+}
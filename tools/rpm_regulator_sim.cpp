@@ -0,0 +1,227 @@
+// Host simulation of the RPM loop in rpm_regulator.h against simulated fans with load
+// disturbances. Each fan deviates from the datasheet table by a random gain; its speed follows
+// the duty with a first-order lag and the tach is read every second (with loop jitter) as
+// whole pulses, plus ripple. Automatic mode passes every sensor sample (2 s) with a set point
+// that drifts with the temperature; every few minutes the airflow steps or the load changes
+// (filter clogging, a draught on the flue, supply sag).
+// Compares the fan controller's set point handling with the previous one, which rewrote the
+// feed-forward duty on every control pass and so threw away the P correction between tach
+// readings. Reports tracking error in steady state, settling time after load disturbances and
+// duty movement. Exits non-zero when the regulator misses its bounds or does worse than before.
+//
+// Build and run: g++ -O2 -std=gnu++17 -I. tools/rpm_regulator_sim.cpp -o rpm_regulator_sim
+//                ./rpm_regulator_sim [fans]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "rpm_regulator.h"
+
+namespace {
+
+constexpr double SIM_STEP = 10.0;                      // ms
+constexpr double DURATION = 3600000.0;                 // Per fan, ms
+constexpr double CONTROL_INTERVAL = 2000.0;            // Sensor sample, one automatic mode pass
+constexpr double TACH_INTERVAL = Config::Tacho::RPM_UPDATE_INTERVAL;
+constexpr double SETTLE_BAND = 0.03;                   // Settled within 3 % of the set point ...
+constexpr double SETTLE_HOLD = 5000.0;                 // ... for 5 s
+constexpr double STEADY_AFTER = 30000.0;               // Steady state from 30 s after an event
+constexpr double MAX_STEADY_ERROR = 0.03;              // p95 of the steady-state error
+constexpr double MAX_SETTLE_TIME = 40000.0;            // p95 after a load disturbance
+
+struct Event {
+    double time;
+    bool load;                  // Load disturbance, otherwise an airflow step
+    double value;               // New load factor or airflow
+};
+
+struct Scenario {
+    double gain;                // True speed against the datasheet table
+    double tau;                 // ms
+    std::vector<Event> events;
+    unsigned noiseSeed;
+};
+
+struct Result {
+    std::vector<double> steadyErrors;   // |error| / set point, sampled every second
+    std::vector<double> settleTimes;    // After load disturbances, ms
+    double dutyTravel = 0.0;            // Sum of |duty change|
+};
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+Scenario randomScenario(std::mt19937& rng) {
+    auto uniform = [&](double low, double high) { return std::uniform_real_distribution<double>(low, high)(rng); };
+    Scenario scenario;
+    scenario.gain = uniform(0.85, 1.1);
+    scenario.tau = uniform(600.0, 1500.0);
+    scenario.noiseSeed = rng();
+    scenario.events.push_back({0.0, false, uniform(0.3, 1.0)});
+    for (double t = uniform(90000.0, 240000.0); t < DURATION; t += uniform(90000.0, 240000.0)) {
+        bool load = uniform(0.0, 1.0) < 0.5;
+        scenario.events.push_back({t, load, load ? uniform(0.8, 1.05) : uniform(0.3, 1.0)});
+    }
+    return scenario;
+}
+
+// previous: rewrite output() on every control pass, as setFanSpeed() did
+Result run(const Scenario& scenario, bool previous) {
+    std::mt19937 rng(scenario.noiseSeed);
+    std::normal_distribution<double> ripple(0.0, 0.005);
+    std::uniform_real_distribution<double> jitter(-50.0, 50.0);
+
+    FanModel model;
+    RpmRegulator regulator(model);
+    Result result;
+
+    double rpm = 0.0;
+    double pulses = 0.0;
+    double duty = 0.0;
+    double load = 1.0;
+    double airflow = 0.0;
+    float targetRpm = 0.0f;
+    size_t nextEvent = 0;
+    double lastEvent = 0.0;
+    double nextControl = 0.0;
+    double lastTach = 0.0;
+    double nextTach = TACH_INTERVAL;
+    double nextSample = 1000.0;
+    // Settling after the latest load disturbance
+    bool settling = false;
+    double disturbance = 0.0;
+    double inBandSince = -1.0;
+
+    auto setDuty = [&](float value) {
+        result.dutyTravel += fabs(value - duty);
+        duty = value;
+    };
+
+    for (double now = 0.0; now < DURATION; now += SIM_STEP) {
+        unsigned long ms = static_cast<unsigned long>(now);
+        while (nextEvent < scenario.events.size() && scenario.events[nextEvent].time <= now) {
+            const Event& event = scenario.events[nextEvent++];
+            if (event.load) {
+                load = event.value;
+                settling = true;
+                disturbance = now;
+                inBandSince = -1.0;
+            } else {
+                airflow = event.value;
+                settling = false;
+            }
+            lastEvent = now;
+        }
+
+        // Automatic mode pass: the set point drifts slowly with the temperature
+        if (now >= nextControl) {
+            nextControl += CONTROL_INTERVAL;
+            float speed = static_cast<float>(airflow * (1.0 + 0.01 * sin(now / 60000.0)));
+            float next = regulator.rpmForAirflow(speed);
+            bool running = targetRpm > 0.0f;
+            if (previous) {
+                if (!running) regulator.holdFeedback(Config::Fan::SPINUP_TIME, ms);
+                targetRpm = next;
+                setDuty(regulator.output(targetRpm));
+            } else if (next != targetRpm) {
+                if (!running) regulator.holdFeedback(Config::Fan::SPINUP_TIME, ms);
+                targetRpm = next;
+                if (!running) setDuty(regulator.output(targetRpm));
+            }
+        }
+
+        // Fan
+        double steady = duty >= model.minDuty() ? model.rpmAt(static_cast<float>(duty)) * scenario.gain * load : 0.0;
+        rpm += (steady - rpm) * (1.0 - exp(-SIM_STEP / scenario.tau));
+        pulses += std::max(rpm * (1.0 + ripple(rng)), 0.0) / 60000.0 * Config::Tacho::PULSES_PER_REVOLUTION * SIM_STEP;
+
+        // Tach reading and regulator step, as updateRPM() in main.ino
+        if (now >= nextTach) {
+            double interval = now - lastTach;
+            double whole = floor(pulses);
+            pulses -= whole;
+            float measured = static_cast<float>(whole * 60000.0 / (interval * Config::Tacho::PULSES_PER_REVOLUTION));
+            setDuty(regulator.update(targetRpm, measured, static_cast<float>(interval / 1000.0), ms));
+            lastTach = now;
+            nextTach = now + TACH_INTERVAL + jitter(rng);
+        }
+
+        if (now >= nextSample && targetRpm > 0.0f) {
+            nextSample += 1000.0;
+            double error = fabs(rpm - targetRpm) / targetRpm;
+            // Set points out of reach of this fan under this load do not count
+            bool saturated = (duty >= 1.0 && rpm < targetRpm) || (duty <= model.minDuty() && rpm > targetRpm);
+            if (now - lastEvent >= STEADY_AFTER && !saturated) result.steadyErrors.push_back(error);
+            if (settling) {
+                if (error > SETTLE_BAND) {
+                    inBandSince = -1.0;
+                } else if (inBandSince < 0.0) {
+                    inBandSince = now;
+                } else if (now - inBandSince >= SETTLE_HOLD) {
+                    result.settleTimes.push_back(inBandSince - disturbance);
+                    settling = false;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int fans = argc > 1 ? atoi(argv[1]) : 40;
+    std::mt19937 rng(2024);
+
+    Result previous;
+    Result current;
+    for (int i = 0; i < fans; i++) {
+        Scenario scenario = randomScenario(rng);
+        Result before = run(scenario, true);
+        Result after = run(scenario, false);
+        previous.steadyErrors.insert(previous.steadyErrors.end(), before.steadyErrors.begin(), before.steadyErrors.end());
+        previous.settleTimes.insert(previous.settleTimes.end(), before.settleTimes.begin(), before.settleTimes.end());
+        previous.dutyTravel += before.dutyTravel;
+        current.steadyErrors.insert(current.steadyErrors.end(), after.steadyErrors.begin(), after.steadyErrors.end());
+        current.settleTimes.insert(current.settleTimes.end(), after.settleTimes.begin(), after.settleTimes.end());
+        current.dutyTravel += after.dutyTravel;
+    }
+
+    double hours = fans * DURATION / 3600000.0;
+    printf("%d fans, %.0f h each\n\n", fans, DURATION / 3600000.0);
+    printf("%-10s %14s %14s %16s %16s %14s\n", "", "steady p50", "steady p95", "settle p50", "settle p95",
+           "duty per hour");
+    const Result* results[] = {&previous, &current};
+    const char* names[] = {"Previous", "Current"};
+    for (int i = 0; i < 2; i++) {
+        const Result& r = *results[i];
+        printf("%-10s %13.2f%% %13.2f%% %14.1f s %14.1f s %14.2f\n", names[i], 100.0 * percentile(r.steadyErrors, 50),
+               100.0 * percentile(r.steadyErrors, 95), percentile(r.settleTimes, 50) / 1000.0,
+               percentile(r.settleTimes, 95) / 1000.0, r.dutyTravel / hours);
+    }
+
+    bool ok = true;
+    if (percentile(current.steadyErrors, 95) > MAX_STEADY_ERROR) {
+        printf("FAIL: steady-state error p95 above %.0f %%\n", 100.0 * MAX_STEADY_ERROR);
+        ok = false;
+    }
+    if (percentile(current.settleTimes, 95) > MAX_SETTLE_TIME) {
+        printf("FAIL: settling after load disturbances p95 above %.0f s\n", MAX_SETTLE_TIME / 1000.0);
+        ok = false;
+    }
+    // Settling within a tach reading or so of the previous handling, the rest no worse
+    if (percentile(current.steadyErrors, 95) > percentile(previous.steadyErrors, 95) ||
+        percentile(current.settleTimes, 95) > percentile(previous.settleTimes, 95) + 2.0 * TACH_INTERVAL ||
+        current.dutyTravel > previous.dutyTravel) {
+        printf("FAIL: worse than the previous set point handling\n");
+        ok = false;
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
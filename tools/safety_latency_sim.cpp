@@ -0,0 +1,181 @@
+// Host simulation of the over-temperature path of safety_monitor.h, running the real SafetyTrip.
+// Temperature ramps from room temperature cross the trip temperature at random phases of the
+// safety task, at rates up to Config::Safety::MAX_RISE_RATE; the task takes its period from
+// SafetyTrip::nextInterval(), waits for the sensor bus when the loop is reading it and then
+// measures for SENSOR_READ_TIME. Reports the crossing to full airflow latency against
+// Config::Safety::MAX_RESPONSE_TIME and compares it with the previous path, where only the loop
+// reacted in automatic mode at its sensor interval (plus loop stalls) and manual mode never reacted.
+// Also checks sensor loss while hot, that noise around the trip temperature trips only once,
+// and reports the safety task's wakeups per hour at steady temperatures.
+// Exits non-zero when a bound is exceeded.
+//
+// Build and run: g++ -O2 -std=gnu++17 -I. tools/safety_latency_sim.cpp -o safety_latency_sim
+//                ./safety_latency_sim [trials]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "safety_trip.h"
+
+namespace {
+
+constexpr unsigned long LOOP_ACTIVE_INTERVAL = 2000;   // sensor_manager.h intervals
+constexpr unsigned long LOOP_SLEEP_INTERVAL = 10000;
+constexpr unsigned long LOOP_NIGHT_INTERVAL = 15000;
+constexpr double LOOP_STALL_PROBABILITY = 0.1;        // Loop iterations held up by WiFi or a web client
+constexpr unsigned long LOOP_MAX_STALL = 3000;
+constexpr double ROOM_TEMPERATURE = 20.0;
+
+std::mt19937 rng(12345);
+
+double uniform(double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(rng);
+}
+
+struct Stats {
+    std::vector<double> values;
+
+    void add(double value) { values.push_back(value); }
+
+    double percentile(double p) {
+        std::sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+        return values[index];
+    }
+
+    void print(const char* name) {
+        printf("%-34s p50 %7.0f  p99 %7.0f  max %7.0f ms\n", name, percentile(50), percentile(99), percentile(100));
+    }
+};
+
+// Temperature of a ramp from room temperature crossing the trip temperature at crossing (ms)
+// with rate in K/s
+double rampTemperature(double t, double crossing, double rate) {
+    return std::max(ROOM_TEMPERATURE, SafetyTrip::TRIP_TEMP + (t - crossing) * rate / 1000.0);
+}
+
+// Safety task: samples from phase at the period SafetyTrip chooses, waits while the loop holds
+// the bus (a read of SENSOR_READ_TIME every loopInterval from loopPhase), then measures
+double safetyLatency(double crossing, double rate, double phase, double loopPhase, unsigned long loopInterval) {
+    SafetyTrip trip;
+    const double readTime = Config::Safety::SENSOR_READ_TIME;
+    for (double start = phase; start < crossing + 10.0 * Config::Safety::SAMPLE_INTERVAL;
+         start += trip.nextInterval()) {
+        double sinceLoopRead = fmod(start - loopPhase + 1e9 * loopInterval, static_cast<double>(loopInterval));
+        double wait = sinceLoopRead < readTime ? readTime - sinceLoopRead : 0.0;
+        wait = std::min(wait, static_cast<double>(Config::Safety::BUS_TIMEOUT));
+        double measuredAt = start + wait;
+        double temperature = rampTemperature(measuredAt, crossing, rate);
+        double done = measuredAt + readTime;
+        if (trip.update(true, static_cast<float>(temperature), static_cast<unsigned long>(done)) !=
+            SafetyTrip::Reason::NONE) {
+            return done - crossing;
+        }
+    }
+    return INFINITY;
+}
+
+// Previous path: the loop samples every interval, a stalled iteration delays the reaction
+double loopLatency(double crossing, double rate, double phase, unsigned long interval) {
+    for (double start = phase; start < crossing + 10.0 * interval; start += interval) {
+        double stall = uniform(0.0, 1.0) < LOOP_STALL_PROBABILITY ? uniform(0.0, LOOP_MAX_STALL) : 0.0;
+        double measuredAt = start + stall;
+        if (rampTemperature(measuredAt, crossing, rate) >= SafetyTrip::TRIP_TEMP) {
+            return measuredAt + Config::Safety::SENSOR_READ_TIME - crossing;
+        }
+    }
+    return INFINITY;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int trials = argc > 1 ? atoi(argv[1]) : 100000;
+    if (trials <= 0) trials = 100000;
+    bool ok = true;
+
+    printf("Trip %.1f °C, release %.1f °C, guaranteed response %lu ms, %d trials\n\n",
+           SafetyTrip::TRIP_TEMP, SafetyTrip::RELEASE_TEMP, Config::Safety::MAX_RESPONSE_TIME, trials);
+
+    Stats safety, active, sleeping, night;
+    for (int i = 0; i < trials; i++) {
+        double rate = uniform(0.05, Config::Safety::MAX_RISE_RATE);  // K/s, slow warm-up to a flare-up
+        double crossing = uniform(60000.0, 120000.0);
+        double phase = uniform(0.0, Config::Safety::SAMPLE_INTERVAL);
+        double loopPhase = uniform(0.0, LOOP_ACTIVE_INTERVAL);
+        safety.add(safetyLatency(crossing, rate, phase, loopPhase, LOOP_ACTIVE_INTERVAL));
+        active.add(loopLatency(crossing, rate, uniform(0.0, LOOP_ACTIVE_INTERVAL), LOOP_ACTIVE_INTERVAL));
+        sleeping.add(loopLatency(crossing, rate, uniform(0.0, LOOP_SLEEP_INTERVAL), LOOP_SLEEP_INTERVAL));
+        night.add(loopLatency(crossing, rate, uniform(0.0, LOOP_NIGHT_INTERVAL), LOOP_NIGHT_INTERVAL));
+    }
+
+    safety.print("Safety task (any mode)");
+    active.print("Previous, automatic active");
+    sleeping.print("Previous, automatic sleep mode");
+    night.print("Previous, automatic at night");
+    printf("%-34s never\n\n", "Previous, manual mode");
+    if (safety.percentile(100) > Config::Safety::MAX_RESPONSE_TIME) {
+        printf("FAIL: safety response exceeds %lu ms\n", Config::Safety::MAX_RESPONSE_TIME);
+        ok = false;
+    }
+
+    // Sensor lost while hot: trips after SENSOR_LOSS_TIMEOUT, within one more sample period
+    Stats loss;
+    for (int i = 0; i < trials / 10 + 1; i++) {
+        SafetyTrip trip;
+        double phase = uniform(0.0, Config::Safety::SAMPLE_INTERVAL);
+        double lostAt = uniform(30000.0, 60000.0);
+        for (double t = phase; t < lostAt + 20000.0; t += trip.nextInterval()) {
+            bool valid = t < lostAt;
+            if (trip.update(valid, valid ? 60.0f : NAN, static_cast<unsigned long>(t)) == SafetyTrip::Reason::SENSOR_LOSS) {
+                loss.add(t - lostAt);
+                break;
+            }
+        }
+    }
+    loss.print("Sensor loss while hot");
+    double lossBound = Config::Safety::SENSOR_LOSS_TIMEOUT + Config::Safety::SAMPLE_INTERVAL;
+    if (loss.values.size() != static_cast<size_t>(trials / 10 + 1) || loss.percentile(100) > lossBound) {
+        printf("FAIL: sensor loss not detected within %.0f ms\n", lossBound);
+        ok = false;
+    }
+
+    // Noise of ±1 K around the trip temperature: one trip, no release chatter
+    SafetyTrip trip;
+    int transitions = 0;
+    SafetyTrip::Reason last = SafetyTrip::Reason::NONE;
+    for (unsigned long t = 0; t < 3600000UL; t += Config::Safety::SAMPLE_INTERVAL) {
+        float temperature = SafetyTrip::TRIP_TEMP - 0.5f + static_cast<float>(uniform(-1.0, 1.0));
+        SafetyTrip::Reason reason = trip.update(true, temperature, t);
+        if (reason != last) transitions++;
+        last = reason;
+    }
+    printf("\nTransitions with noise at the trip temperature over 1 h: %d\n", transitions);
+    if (transitions != 1) {
+        printf("FAIL: expected a single trip\n");
+        ok = false;
+    }
+
+    // Wakeups of the safety task per hour at a steady temperature, previously 3600 everywhere
+    printf("\nSafety samples per hour:");
+    const float steadyTemperatures[] = {20.0f, 40.0f, 70.0f, 85.0f};
+    for (float temperature : steadyTemperatures) {
+        SafetyTrip steady;
+        int samples = 0;
+        for (unsigned long t = 0; t < 3600000UL; t += steady.nextInterval()) {
+            steady.update(true, temperature, t);
+            samples++;
+        }
+        printf("  %.0f °C %d", temperature, samples);
+        if (temperature < Config::TEMP_THRESHOLD && samples > 3600 / 10) {
+            printf("\nFAIL: sampling a cold stove more often than every 10 s\n");
+            ok = false;
+        }
+    }
+    printf("\n");
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
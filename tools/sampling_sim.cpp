@@ -0,0 +1,194 @@
+// Host simulation of the adaptive sensor sampling in sample_scheduler.h against the previous
+// fixed intervals (2 s active, 10 s sleep mode, 15 s at night), both feeding the real
+// SensorFilter. Synthetic traces: a flat room with slow drift and sensor noise, a fire lit at a
+// random time (second-order rise of random height and time constants), a steady burn with slow
+// swings and the cool-down. Reports samples per hour per phase, the fire-start detection delay
+// (first sample with the filtered slope above the controller's activity threshold) and false
+// detections before the fire. Exits non-zero if the adaptive schedule detects fire starts later
+// than the fixed daytime one at p50 or p99, has more than MAX_FALSE_PER_HOUR false detections,
+// or does not halve the samples per hour. Each trace has its own sensor noise seed, so all
+// schemes see the same traces.
+//
+// Build and run: g++ -O2 -std=gnu++17 -I. tools/sampling_sim.cpp -o sampling_sim
+//                ./sampling_sim [traces]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "sensor_filter.h"
+#include "sample_scheduler.h"
+
+namespace {
+
+constexpr float TEMP_RISE_THRESHOLD = 0.2f;             // sleep_mode.h activity slope in °C/min
+constexpr unsigned long ACTIVE_MODE_INTERVAL = 2000;    // Previous sensor_manager.h intervals
+constexpr unsigned long SLEEP_MODE_INTERVAL = 10000;
+constexpr unsigned long NIGHT_MODE_INTERVAL = 15000;
+constexpr double SENSOR_NOISE = 0.02;                   // SHT4x high precision repeatability in °C
+constexpr double HOUR = 3600000.0;
+constexpr double MAX_FALSE_PER_HOUR = 0.1;
+
+std::mt19937 rng(4242);
+
+double uniform(double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(rng);
+}
+
+struct Trace {
+    double fireStart;       // ms
+    double burnEnd;
+    double end;
+    double rise;            // °C above the room
+    double tau;             // Rise time constant in ms
+    double lag;             // Stove body heating up before the air warms, time constant in ms
+    double driftPhase;
+    unsigned noiseSeed;     // Same sensor noise for every scheme
+
+    double room(double t) const {
+        return 20.0 + 0.5 * sin(2.0 * M_PI * t / (6.0 * HOUR) + driftPhase);
+    }
+
+    double truth(double t) const {
+        if (t < fireStart) return room(t);
+        // Second-order rise: the slope starts at zero while the stove body heats up
+        double burn = std::min(t, burnEnd) - fireStart;
+        double step = 1.0 - (tau * exp(-burn / tau) - lag * exp(-burn / lag)) / (tau - lag);
+        double hot = (rise + 1.5 * sin(2.0 * M_PI * burn / (0.75 * HOUR))) * step;
+        if (t > burnEnd) hot *= exp(-(t - burnEnd) / (0.5 * HOUR));
+        return room(t) + hot;
+    }
+
+    float sample(double t, std::mt19937& noise) const {
+        double value = truth(t) + std::normal_distribution<double>(0.0, SENSOR_NOISE)(noise);
+        return static_cast<float>(round(value * 100.0) / 100.0);  // 0.01 °C resolution
+    }
+};
+
+enum class Scheme { ADAPTIVE, FIXED_DAY, FIXED_NIGHT };
+
+struct Result {
+    double detectionDelay = INFINITY;    // ms
+    int falseDetections = 0;
+    double quietHours = 0.0;
+    uint32_t samples[3] = {0, 0, 0};    // Before the fire, burning, cooling
+    double hours[3] = {0.0, 0.0, 0.0};
+};
+
+Result run(const Trace& trace, Scheme scheme) {
+    SensorFilter filter;
+    SampleScheduler scheduler;
+    Result result;
+    std::mt19937 noise(trace.noiseSeed);
+    bool fanOn = false;
+    bool risingBefore = false;
+    double t = 0.0;
+    while (t < trace.end) {
+        int phase = t < trace.fireStart ? 0 : (t < trace.burnEnd ? 1 : 2);
+        result.samples[phase]++;
+
+        unsigned long now = static_cast<unsigned long>(t);
+        float value = trace.sample(t, noise);
+        SensorFilter::Result filtered = filter.update(value, 45.0f, now);
+        bool rising = filtered.slope > TEMP_RISE_THRESHOLD;
+        if (phase == 0 && rising && !risingBefore && t > 10.0 * 60000.0) {
+            result.falseDetections++;
+        }
+        if (phase > 0 && rising && isinf(result.detectionDelay)) {
+            result.detectionDelay = t - trace.fireStart;
+            fanOn = true;
+        }
+        risingBefore = rising;
+
+        unsigned long interval;
+        if (scheme == Scheme::ADAPTIVE) {
+            unsigned long maxInterval = fanOn ? Config::Sensor::ACTIVE_MAX_INTERVAL : Config::Sensor::MAX_INTERVAL;
+            interval = (filtered.spike || filtered.stuck) ? scheduler.getInterval()
+                                                         : scheduler.update(value, filtered.slope, now, maxInterval);
+        } else if (scheme == Scheme::FIXED_NIGHT) {
+            interval = NIGHT_MODE_INTERVAL;
+        } else {
+            interval = fanOn ? ACTIVE_MODE_INTERVAL : SLEEP_MODE_INTERVAL;
+        }
+        t += interval;
+    }
+    result.hours[0] = trace.fireStart / HOUR;
+    result.hours[1] = (trace.burnEnd - trace.fireStart) / HOUR;
+    result.hours[2] = (trace.end - trace.burnEnd) / HOUR;
+    result.quietHours = (trace.fireStart - 10.0 * 60000.0) / HOUR;
+    return result;
+}
+
+double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5)];
+}
+
+struct Summary {
+    std::vector<double> delays;
+    uint32_t samples[3] = {0, 0, 0};
+    double hours[3] = {0.0, 0.0, 0.0};
+    int falseDetections = 0;
+    double quietHours = 0.0;
+
+    void add(const Result& result) {
+        delays.push_back(result.detectionDelay / 1000.0);
+        for (int i = 0; i < 3; i++) {
+            samples[i] += result.samples[i];
+            hours[i] += result.hours[i];
+        }
+        falseDetections += result.falseDetections;
+        quietHours += result.quietHours;
+    }
+
+    double perHour(int phase) const { return samples[phase] / hours[phase]; }
+    double falsePerHour() const { return falseDetections / quietHours; }
+
+    double overall() const {
+        return (samples[0] + samples[1] + samples[2]) / (hours[0] + hours[1] + hours[2]);
+    }
+
+    void print(const char* name) const {
+        printf("%-16s %7.0f %7.0f %7.0f %7.0f   %6.0f %6.0f %6.0f   %6.2f\n", name, perHour(0), perHour(1),
+               perHour(2), overall(), percentile(delays, 50), percentile(delays, 99), percentile(delays, 100),
+               falsePerHour());
+    }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int traces = argc > 1 ? atoi(argv[1]) : 500;
+    if (traces <= 0) traces = 500;
+
+    Summary adaptive, day, night;
+    for (int i = 0; i < traces; i++) {
+        Trace trace;
+        trace.fireStart = uniform(1.0, 2.0) * HOUR;
+        trace.burnEnd = trace.fireStart + uniform(3.0, 5.0) * HOUR;
+        trace.end = trace.burnEnd + 2.0 * HOUR;
+        trace.rise = uniform(30.0, 70.0);
+        trace.tau = uniform(10.0, 40.0) * 60000.0;
+        trace.lag = uniform(1.0, 5.0) * 60000.0;
+        trace.driftPhase = uniform(0.0, 2.0 * M_PI);
+        trace.noiseSeed = rng();
+        adaptive.add(run(trace, Scheme::ADAPTIVE));
+        day.add(run(trace, Scheme::FIXED_DAY));
+        night.add(run(trace, Scheme::FIXED_NIGHT));
+    }
+
+    printf("%d traces; samples per hour before the fire / burning / cooling / overall,\n", traces);
+    printf("fire-start detection delay p50 / p99 / max in s, false detections per quiet hour\n\n");
+    printf("%-16s %7s %7s %7s %7s   %6s %6s %6s   %6s\n", "", "quiet", "burn", "cool", "all", "p50", "p99", "max",
+           "false");
+    adaptive.print("Adaptive");
+    day.print("Fixed, day");
+    night.print("Fixed, night");
+
+    bool ok = percentile(adaptive.delays, 50) <= percentile(day.delays, 50) &&
+              percentile(adaptive.delays, 99) <= percentile(day.delays, 99) &&
+              adaptive.falsePerHour() <= MAX_FALSE_PER_HOUR && adaptive.overall() <= day.overall() / 2.0;
+    printf("\n%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
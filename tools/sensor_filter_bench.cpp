@@ -0,0 +1,289 @@
+// Host benchmark of sensor_filter.h against the mean/trend code it replaced, on noisy synthetic
+// signals sampled at the scheduler's fastest and slowest intervals with some loop jitter.
+// The previous code used the raw value, rejected spikes by the mean of the last five accepted
+// samples (so a real step was rejected for good) and called the room active when either the
+// rate since the last sample or the mean of the last five differences passed the threshold.
+// Reports for both:
+//   - value noise (RMS error on a flat signal) and lag on a 1 °C/min ramp
+//   - slope noise (RMS error in °C/min on a flat signal) and the time until the mean slope
+//     reaches half of a 1 °C/min step; the previous slope is the five-difference trend
+//   - false activity detections per hour on a flat signal (previous: rate or trend)
+//   - spikes passed into the value and samples until a real 8 °C step is accepted
+// Exits non-zero when the filter is noisier, passes more spikes, detects more false activity
+// than the previous code, or its slope lags by more than one sample behind the previous trend.
+// The value lags by about the smoothing time constant, which the report shows but does not judge.
+//
+// Build and run: g++ -O2 -std=gnu++17 -I. tools/sensor_filter_bench.cpp -o sensor_filter_bench
+//                ./sensor_filter_bench [trials]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "sensor_filter.h"
+
+namespace {
+
+constexpr float TEMP_RISE_THRESHOLD = 0.2f;     // sleep_mode.h activity slope in °C/min
+constexpr double DURATION = 3600000.0;          // Flat signal per trial, ms
+constexpr double RAMP_START = 600000.0;         // Ramp and slope step start, ms
+constexpr double RAMP_RATE = 1.0;               // °C/min
+constexpr double STEP_SIZE = 8.0;               // Real step, °C
+constexpr double SPIKE_PROBABILITY = 0.01;
+constexpr double SPIKE_SIZE = 10.0;             // °C, either sign
+constexpr double JITTER = 100.0;                // Loop jitter of the sample time, ms
+
+std::mt19937 rng(2718);
+
+double uniform(double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(rng);
+}
+
+double gaussian(double sigma) {
+    return std::normal_distribution<double>(0.0, sigma)(rng);
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+// Value, rate and trend of the previous sensor_manager.h / fan_controller.h code
+class PreviousFilter {
+    static constexpr int HISTORY_SIZE = 5;      // sensor_manager.h spike history
+    static constexpr int TREND_SIZE = 6;        // fan_controller.h trend history
+    static constexpr float MAX_TEMP_CHANGE = 5.0f;
+
+    float spikeHistory[HISTORY_SIZE] = {0};
+    int spikeIndex = 0;
+    bool historyInitialized = false;
+    float trendHistory[TREND_SIZE] = {0};
+    int trendIndex = 0;
+    float lastTemperature = 0.0f;
+    double lastTime = 0.0;
+
+public:
+    float value = 0.0f;
+    float rate = 0.0f;          // Since the previous sample, °C/min
+    float trend = 0.0f;         // Mean difference per sample, as compared against the threshold
+    float trendPerMinute = 0.0f;
+    bool rejected = false;
+
+    void update(float temperature, double now) {
+        rejected = false;
+        if (historyInitialized) {
+            float mean = 0.0f;
+            for (float v : spikeHistory) mean += v;
+            mean /= HISTORY_SIZE;
+            if (fabsf(temperature - mean) > MAX_TEMP_CHANGE) {
+                rejected = true;
+                return;
+            }
+        }
+        spikeHistory[spikeIndex] = temperature;
+        spikeIndex = (spikeIndex + 1) % HISTORY_SIZE;
+        if (spikeIndex == 0) historyInitialized = true;
+
+        value = temperature;
+        trendHistory[trendIndex] = temperature;
+        trendIndex = (trendIndex + 1) % TREND_SIZE;
+        float sum = 0.0f;
+        for (int i = 1; i < TREND_SIZE; i++) {
+            int prev = (trendIndex - i - 1 + TREND_SIZE) % TREND_SIZE;
+            int curr = (trendIndex - i + TREND_SIZE) % TREND_SIZE;
+            sum += trendHistory[curr] - trendHistory[prev];
+        }
+        trend = sum / (TREND_SIZE - 1);
+        if (now > lastTime) trendPerMinute = trend / static_cast<float>((now - lastTime) / 60000.0);
+        if (now > lastTime) rate = (temperature - lastTemperature) / static_cast<float>((now - lastTime) / 60000.0);
+        lastTemperature = temperature;
+        lastTime = now;
+    }
+
+    bool active() const { return rate > TEMP_RISE_THRESHOLD || trend > TEMP_RISE_THRESHOLD; }
+};
+
+struct Metrics {
+    std::vector<double> valueError;     // Flat signal, °C
+    std::vector<double> slopeError;     // Flat signal, °C/min
+    std::vector<double> valueLag;       // Ramp, s
+    std::vector<double> slopeSum;       // Slope step: sum over trials per sample after the step
+    std::vector<double> timeSum;        // ... and of the sample times, ms
+    std::vector<double> stepAccept;     // Samples until a real step is accepted
+    double falseDetections = 0.0;
+    int spikes = 0;
+    int spikesPassed = 0;
+};
+
+float quantize(double value) {
+    return static_cast<float>(round(value * 100.0) / 100.0);  // 0.01 °C resolution
+}
+
+// Signal: flat until RAMP_START, then rising at RAMP_RATE
+double rampTruth(double t) {
+    return 20.0 + (t > RAMP_START ? (t - RAMP_START) / 60000.0 * RAMP_RATE : 0.0);
+}
+
+void runTrial(double interval, double noise, Metrics& current, Metrics& previous) {
+    // Flat signal with spikes: noise, false detections, spikes passed
+    {
+        SensorFilter filter;
+        PreviousFilter old;
+        double base = uniform(15.0, 25.0);
+        unsigned long settled = 0;
+        for (double t = 0.0; t < DURATION; t += interval + uniform(-JITTER, JITTER)) {
+            bool spike = uniform(0.0, 1.0) < SPIKE_PROBABILITY && settled >= 10;
+            double reading = base + gaussian(noise) + (spike ? (uniform(0.0, 1.0) < 0.5 ? -SPIKE_SIZE : SPIKE_SIZE) : 0.0);
+            float temperature = quantize(reading);
+            SensorFilter::Result result = filter.update(temperature, static_cast<float>(base), static_cast<unsigned long>(t));
+            old.update(temperature, t);
+            if (++settled < 10) continue;
+
+            if (spike) {
+                current.spikes++;
+                previous.spikes++;
+                if (fabs(result.smoothed - base) > SPIKE_SIZE / 2) current.spikesPassed++;
+                if (fabs(old.value - base) > SPIKE_SIZE / 2) previous.spikesPassed++;
+                continue;
+            }
+            current.valueError.push_back(result.smoothed - base);
+            current.slopeError.push_back(result.slope);
+            previous.valueError.push_back(old.value - base);
+            previous.slopeError.push_back(old.trendPerMinute);
+            if (result.slope > TEMP_RISE_THRESHOLD) current.falseDetections += 1.0;
+            if (old.active()) previous.falseDetections += 1.0;
+        }
+    }
+
+    // Ramp: value lag, and the slope per sample after the ramp starts for the mean response
+    {
+        SensorFilter filter;
+        PreviousFilter old;
+        double end = RAMP_START + 600000.0;
+        size_t index = 0;
+        std::vector<double> currentLag;
+        std::vector<double> previousLag;
+        for (double t = uniform(0.0, interval); t < end; t += interval + uniform(-JITTER, JITTER)) {
+            double truth = rampTruth(t);
+            float temperature = quantize(truth + gaussian(noise));
+            SensorFilter::Result result = filter.update(temperature, 50.0f, static_cast<unsigned long>(t));
+            old.update(temperature, t);
+            if (t < RAMP_START) continue;
+            for (Metrics* m : {&current, &previous}) {
+                if (m->slopeSum.size() <= index) {
+                    m->slopeSum.push_back(0.0);
+                    m->timeSum.push_back(0.0);
+                }
+                m->timeSum[index] += t - RAMP_START;
+            }
+            current.slopeSum[index] += result.slope;
+            previous.slopeSum[index] += old.trendPerMinute;
+            index++;
+            if (t > RAMP_START + 300000.0) {
+                currentLag.push_back((truth - result.smoothed) / RAMP_RATE * 60.0);
+                previousLag.push_back((truth - old.value) / RAMP_RATE * 60.0);
+            }
+        }
+        current.valueLag.push_back(percentile(currentLag, 50));
+        previous.valueLag.push_back(percentile(previousLag, 50));
+    }
+
+    // Real step (a door opened onto the stove): samples until the value follows
+    {
+        SensorFilter filter;
+        PreviousFilter old;
+        int currentAccept = -1;
+        int previousAccept = -1;
+        int after = 0;
+        for (double t = 0.0; t < 600000.0; t += interval) {
+            bool stepped = t >= 300000.0;
+            float temperature = quantize(20.0 + (stepped ? STEP_SIZE : 0.0) + gaussian(noise));
+            SensorFilter::Result result = filter.update(temperature, 50.0f, static_cast<unsigned long>(t));
+            old.update(temperature, t);
+            if (!stepped) continue;
+            after++;
+            if (currentAccept < 0 && !result.spike) currentAccept = after;
+            if (previousAccept < 0 && !old.rejected) previousAccept = after;
+        }
+        current.stepAccept.push_back(currentAccept < 0 ? INFINITY : currentAccept);
+        previous.stepAccept.push_back(previousAccept < 0 ? INFINITY : previousAccept);
+    }
+}
+
+// Mean time after the ramp start at which the mean slope over all trials reaches half the rate, s
+double slopeLag(const Metrics& m, int trials) {
+    for (size_t i = 0; i < m.slopeSum.size(); i++) {
+        if (m.slopeSum[i] / trials >= RAMP_RATE / 2) return m.timeSum[i] / trials / 1000.0;
+    }
+    return INFINITY;
+}
+
+double rms(const std::vector<double>& values) {
+    double sum = 0.0;
+    for (double v : values) sum += v * v;
+    return values.empty() ? 0.0 : sqrt(sum / values.size());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int trials = argc > 1 ? atoi(argv[1]) : 50;
+    if (trials <= 0) trials = 50;
+    bool ok = true;
+
+    const double intervals[] = {static_cast<double>(Config::Sensor::MIN_INTERVAL),
+                                static_cast<double>(Config::Sensor::MAX_INTERVAL)};
+    const double noises[] = {0.02, 0.1};        // SHT4x repeatability, a noisy installation
+
+    printf("%d trials per row, activity threshold %.1f °C/min\n\n", trials, TEMP_RISE_THRESHOLD);
+    printf("%-9s %6s %7s %10s %10s %10s %10s %10s %10s %12s\n", "", "every", "noise", "value rms",
+           "value lag", "slope rms", "slope lag", "false/h", "spikes in", "step after");
+    for (double interval : intervals) {
+        for (double noise : noises) {
+            Metrics current;
+            Metrics previous;
+            for (int i = 0; i < trials; i++) runTrial(interval, noise, current, previous);
+
+            double hours = trials * DURATION / 3600000.0;
+            const Metrics* metrics[] = {&previous, &current};
+            const char* names[] = {"Previous", "Filter"};
+            for (int i = 0; i < 2; i++) {
+                const Metrics& m = *metrics[i];
+                double step = percentile(m.stepAccept, 50);
+                printf("%-9s %4.0f s %5.2f °C %7.3f °C %8.1f s %10.3f %8.1f s %10.1f %5d/%-4d ", names[i],
+                       interval / 1000.0, noise, rms(m.valueError), percentile(m.valueLag, 50),
+                       rms(m.slopeError), slopeLag(m, trials), m.falseDetections / hours,
+                       m.spikesPassed, m.spikes);
+                if (isinf(step)) {
+                    printf("%12s\n", "never");
+                } else {
+                    printf("%4.0f samples\n", step);
+                }
+            }
+
+            if (rms(current.valueError) > rms(previous.valueError) ||
+                rms(current.slopeError) > rms(previous.slopeError)) {
+                printf("FAIL: filter noisier than the previous code\n");
+                ok = false;
+            }
+            if (current.falseDetections > previous.falseDetections || current.spikesPassed > previous.spikesPassed) {
+                printf("FAIL: more false activity or spikes than the previous code\n");
+                ok = false;
+            }
+            if (slopeLag(current, trials) > slopeLag(previous, trials) + interval / 1000.0) {
+                printf("FAIL: slope lags the previous trend by more than one sample\n");
+                ok = false;
+            }
+            if (percentile(current.stepAccept, 100) > Config::Sensor::MEDIAN_WINDOW / 2 + 1) {
+                printf("FAIL: real step not accepted within %d samples\n", Config::Sensor::MEDIAN_WINDOW / 2 + 1);
+                ok = false;
+            }
+        }
+    }
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
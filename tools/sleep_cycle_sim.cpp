@@ -0,0 +1,300 @@
+// Host simulation of the sleep-mode cycle of automatic mode, running the real SleepMode
+// (sleep_mode.h) on the real SensorFilter slope at the SampleScheduler intervals. Each trace
+// starts at noon in a cold room, lights a fire, lets it burn and cool down over the evening
+// and lights a second fire the next day. Above SLEEP_TEMP_THRESHOLD the fan follows the
+// warm-up / operating / residual shapes of fan_controller.h. Checks run at the prior check
+// intervals of activity_histogram.h.
+// Reports the fire starts recorded within DETECT_WINDOW of each fire and the false ones
+// (slope noise during checks), whether and how soon after the room cooled below the threshold
+// sleep mode was entered again, and how long the fan ran below the threshold between the
+// fires. Compares with the previous entry condition (fan off, falling, above TEMP_THRESHOLD -
+// HYSTERESIS and below SLEEP_TEMP_THRESHOLD at once), which never held.
+// Exits non-zero when a trace does not return to sleep within MAX_REENTRY, the fan runs more
+// than MAX_FAN_SHARE of the time between the fires or a second fire is not detected.
+//
+// Build and run: g++ -O2 -std=gnu++17 -I. tools/sleep_cycle_sim.cpp -o sleep_cycle_sim
+//                ./sleep_cycle_sim [traces]
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "activity_histogram.h"
+#include "sample_scheduler.h"
+#include "sensor_filter.h"
+#include "sleep_mode.h"
+
+namespace {
+
+constexpr double MINUTE = 60000.0;
+constexpr double HOUR = 60.0 * MINUTE;
+constexpr double DAY = 24.0 * HOUR;
+constexpr double SENSOR_NOISE = 0.02;                   // SHT4x high precision repeatability in °C
+constexpr float MIN_SPEED = 0.2f;                       // fan_controller.h
+constexpr float WARMUP_SLOPE_THRESHOLD = 0.5f;
+constexpr double MAX_REENTRY = 10.0 * MINUTE;           // Cooled below the threshold until sleep mode
+constexpr double MAX_FAN_SHARE = 0.25;                  // Fan time below the threshold between the fires
+constexpr int WEEKDAY = 1;
+constexpr double WARMUP = 30.0 * MINUTE;                // Filter runs before the controller starts
+constexpr double DETECT_WINDOW = HOUR;
+
+std::mt19937 rng(2718);
+
+double uniform(double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(rng);
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5)];
+}
+
+struct Fire {
+    double start;
+    double end;             // Burnt down, cooling from here
+    double rise;            // °C above the room
+    double tau;             // Rise time constant in ms
+    double coolTau;
+};
+
+struct Trace {
+    double room;
+    Fire fires[2];
+
+    double truth(double t) const {
+        double hot = 0.0;
+        for (const Fire& fire : fires) {
+            if (t < fire.start) continue;
+            double burn = std::min(t, fire.end) - fire.start;
+            double level = fire.rise * (1.0 - exp(-burn / fire.tau));
+            if (t > fire.end) level *= exp(-(t - fire.end) / fire.coolTau);
+            hot += level;
+        }
+        return room + hot;
+    }
+
+    // First time the room is below the threshold after the first fire ended
+    double cooledBelow() const {
+        for (double t = fires[0].end; t < fires[1].start; t += 1000.0) {
+            if (truth(t) < SleepMode::SLEEP_TEMP_THRESHOLD) return t;
+        }
+        return INFINITY;
+    }
+};
+
+Trace randomTrace() {
+    Trace trace;
+    trace.room = uniform(18.5, 20.5);
+    double first = uniform(1.5, 4.0) * HOUR;
+    double second = DAY + uniform(4.0, 7.0) * HOUR;
+    trace.fires[0] = {first, first + uniform(2.5, 4.5) * HOUR, uniform(25.0, 45.0), uniform(10.0, 25.0) * MINUTE,
+                      uniform(0.5, 1.5) * HOUR};
+    trace.fires[1] = {second, second + 3.0 * HOUR, uniform(25.0, 45.0), uniform(10.0, 25.0) * MINUTE,
+                      uniform(0.5, 1.5) * HOUR};
+    return trace;
+}
+
+// Previous sleep-mode logic of fan_controller.h: left like SleepMode, entered only from the
+// cooling band above TEMP_THRESHOLD - HYSTERESIS
+struct PreviousSleepMode {
+    bool sleeping = true;
+    unsigned long lastCheck = 0;
+
+    void begin(unsigned long now, unsigned long checkInterval) { lastCheck = now - checkInterval; }
+
+    SleepMode::Action belowThreshold(float slope, bool, unsigned long now, unsigned long checkInterval) {
+        bool rising = slope > SleepMode::TEMP_RISE_THRESHOLD;
+        if (!sleeping) return SleepMode::Action::ACTIVE;    // Fan at MIN_SPEED
+        SleepMode::Action action;
+        if (now - lastCheck >= checkInterval) {
+            lastCheck = now;
+            action = SleepMode::Action::START_CHECK;
+        } else if (now - lastCheck < Config::CHECK_DURATION) {
+            action = SleepMode::Action::CHECK;
+        } else {
+            return SleepMode::Action::SLEEP;
+        }
+        if (rising) {
+            sleeping = false;
+            return SleepMode::Action::FIRE_START;
+        }
+        return action;
+    }
+
+    bool aboveThreshold(float slope) {
+        bool fireStart = sleeping && slope > SleepMode::TEMP_RISE_THRESHOLD;
+        sleeping = false;
+        return fireStart;
+    }
+
+    void coolingBand(float temp, float slope, bool fanRunning) {
+        if (!fanRunning && slope < 0 && temp < SleepMode::SLEEP_TEMP_THRESHOLD) sleeping = true;
+    }
+
+    bool isSleeping() const { return sleeping; }
+};
+
+void coolingBand(SleepMode&, float, float, bool) {}
+void coolingBand(PreviousSleepMode& mode, float temp, float slope, bool fanRunning) {
+    mode.coolingBand(temp, slope, fanRunning);
+}
+
+// Target speed above the sleep threshold without a user curve, as fan_controller.h
+float speedAbove(float temp, float slope, bool fanRunning) {
+    float normalized = (temp - Config::TEMP_THRESHOLD) / (Config::MAX_TEMP - Config::TEMP_THRESHOLD);
+    if (slope > WARMUP_SLOPE_THRESHOLD) return 0.6f + normalized * 0.4f;
+    if (temp >= Config::TEMP_THRESHOLD + Config::HYSTERESIS) return 0.3f + normalized * normalized * 0.7f;
+    if (temp > Config::TEMP_THRESHOLD - Config::HYSTERESIS) return fanRunning ? 0.3f : 0.0f;
+    return 0.0f;
+}
+
+struct Result {
+    bool detected[2] = {false, false};  // Fire start recorded within DETECT_WINDOW of lighting
+    int falseStarts = 0;
+    bool reentered = false;
+    double reentryDelay = INFINITY; // From cooling below the threshold, ms
+    double fanShare = 0.0;          // Fan time below the threshold between the fires
+};
+
+template <typename Mode>
+Result run(const Trace& trace, unsigned noiseSeed) {
+    std::mt19937 noise(noiseSeed);
+    std::normal_distribution<double> sensor(0.0, SENSOR_NOISE);
+    ActivityHistogram histogram;
+    SensorFilter filter;
+    SampleScheduler scheduler;
+    Mode mode;
+    Result result;
+
+    const double begin = 12.0 * HOUR;       // Noon, fire times are relative to it
+    const double cooled = trace.cooledBelow();
+    double fanBelow = 0.0;
+    double timeBelow = 0.0;
+    bool fanOn = false;
+    double t = 0.0;
+    auto fireStart = [&](double at) {
+        for (int i = 0; i < 2; i++) {
+            if (at >= trace.fires[i].start && at < trace.fires[i].start + DETECT_WINDOW) {
+                result.detected[i] = true;
+                return;
+            }
+        }
+        result.falseStarts++;
+    };
+    auto checkInterval = [&](double at) {
+        int slot = static_cast<int>(fmod(begin + at, DAY) / (ActivityHistogram::SLOT_MINUTES * MINUTE));
+        return ActivityHistogram::checkInterval(histogram.likelihood(WEEKDAY, slot));
+    };
+    mode.begin(static_cast<unsigned long>(WARMUP), checkInterval(WARMUP));
+
+    while (t < trace.fires[1].start + 2.0 * HOUR) {
+        float temp = static_cast<float>(trace.truth(t) + sensor(noise));
+        unsigned long now = static_cast<unsigned long>(t);
+        SensorFilter::Result filtered = filter.update(temp, 45.0f, now);
+        float slope = filtered.slope;
+
+        float target = 0.0f;
+        if (t < WARMUP) {
+            // Slope window still filling
+        } else if (temp < SleepMode::SLEEP_TEMP_THRESHOLD) {
+            switch (mode.belowThreshold(slope, fanOn, now, checkInterval(t))) {
+                case SleepMode::Action::SLEEP:
+                case SleepMode::Action::COOL_DOWN:
+                case SleepMode::Action::ENTER_SLEEP:
+                    break;
+                case SleepMode::Action::FIRE_START:
+                    fireStart(t);
+                    target = MIN_SPEED;
+                    break;
+                default:
+                    target = MIN_SPEED;
+                    break;
+            }
+        } else {
+            if (mode.aboveThreshold(slope)) fireStart(t);
+            target = speedAbove(temp, slope, fanOn);
+            coolingBand(mode, temp, slope, fanOn);
+        }
+        if (!result.reentered && t > cooled && mode.isSleeping()) {
+            result.reentered = true;
+            result.reentryDelay = t - cooled;
+        }
+        fanOn = target > 0.0f;
+
+        unsigned long maxInterval = fanOn ? Config::Sensor::ACTIVE_MAX_INTERVAL : Config::Sensor::MAX_INTERVAL;
+        unsigned long interval = (filtered.spike || filtered.stuck) ? scheduler.getInterval()
+                                                                    : scheduler.update(temp, slope, now, maxInterval);
+        if (t > cooled && t < trace.fires[1].start) {
+            timeBelow += interval;
+            if (fanOn) fanBelow += interval;
+        }
+        t += interval;
+    }
+    result.fanShare = timeBelow > 0.0 ? fanBelow / timeBelow : 0.0;
+    return result;
+}
+
+struct Summary {
+    int traces = 0;
+    int detected[2] = {0, 0};
+    int falseStarts = 0;
+    int reentered = 0;
+    std::vector<double> delays;     // Minutes
+    std::vector<double> fanShares;
+
+    void add(const Result& result) {
+        traces++;
+        for (int i = 0; i < 2; i++) detected[i] += result.detected[i];
+        falseStarts += result.falseStarts;
+        if (result.reentered) {
+            reentered++;
+            delays.push_back(result.reentryDelay / MINUTE);
+        }
+        fanShares.push_back(result.fanShare);
+    }
+
+    void print(const char* name) const {
+        printf("%-16s %5d/%-5d %5d/%-5d %7d %5d/%-5d %6.1f min %6.1f min %7.1f%% %7.1f%%\n", name, detected[0], traces,
+               detected[1], traces, falseStarts, reentered, traces, percentile(delays, 50), percentile(delays, 100),
+               percentile(fanShares, 50) * 100.0, percentile(fanShares, 100) * 100.0);
+    }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int traces = argc > 1 ? atoi(argv[1]) : 200;
+    if (traces <= 0) traces = 200;
+
+    Summary current, previous;
+    for (int i = 0; i < traces; i++) {
+        Trace trace = randomTrace();
+        unsigned seed = static_cast<unsigned>(rng());
+        current.add(run<SleepMode>(trace, seed));
+        previous.add(run<PreviousSleepMode>(trace, seed));
+    }
+
+    printf("%d traces: fire, cool-down, second fire the next day\n\n", traces);
+    printf("%-16s %11s %11s %7s %11s %10s %10s %8s %8s\n", "", "1st fire", "2nd fire", "false", "asleep",
+           "delay p50", "delay max", "fan p50", "fan max");
+    current.print("Sleep mode");
+    previous.print("Previous entry");
+
+    bool ok = true;
+    if (current.reentered != traces || percentile(current.delays, 100) > MAX_REENTRY / MINUTE) {
+        printf("FAIL: sleep mode not entered within %.0f min of cooling down\n", MAX_REENTRY / MINUTE);
+        ok = false;
+    }
+    if (percentile(current.fanShares, 100) > MAX_FAN_SHARE) {
+        printf("FAIL: fan runs more than %.0f%% of the time between the fires\n", MAX_FAN_SHARE * 100.0);
+        ok = false;
+    }
+    if (current.detected[1] != traces) {
+        printf("FAIL: second fire not detected from sleep mode\n");
+        ok = false;
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <Arduino.h>
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include "config.h"
+#include "logging.h"
+#include "arena.h"
+#include "system_status.h"
+#include "event_log.h"
+
+// Supervises the main loop. The ESP task watchdog resets the chip when loop() stops coming
+// back (e.g. a hung I2C read); it is only fed while every subsystem keeps sending heartbeats,
+// so a subsystem that silently stops making progress also ends in a reset. What the loop was
+// doing is kept in a record in RTC memory that survives the reset (not a power loss) and is
+// reported after the reboot.
+class Watchdog {
+public:
+    enum class Subsystem : uint8_t {
+        SENSOR,
+        CONTROL,
+        TACH,
+        NETWORK,
+        LOOP,                           // Main loop outside the subsystems above
+        IDLE                            // Waiting for the next event
+    };
+    static constexpr int HEARTBEAT_COUNT = 4;  // Subsystems up to NETWORK send heartbeats
+    static constexpr uint8_t NO_SUBSYSTEM = 0xFF;
+
+    // Written while the loop runs, so it is current when a reset hits
+    struct Record {
+        uint32_t magic;
+        uint32_t bootCount;
+        uint32_t uptime;                // ms at the last completed loop
+        uint32_t loopCount;
+        uint32_t lastLoopUs;            // Busy time of the last loop iteration
+        uint32_t maxLoopUs;
+        uint32_t heartbeatAge[HEARTBEAT_COUNT];  // ms since each heartbeat at the last loop
+        uint8_t subsystem;              // Subsystem running at the time
+        uint8_t staleSubsystem;         // Subsystem whose heartbeat timed out, NO_SUBSYSTEM if none
+        uint8_t errorState;
+        uint8_t statusCode;
+    };
+
+private:
+    static constexpr uint32_t MAGIC = 0x57444F47;  // "WDOG"
+    static constexpr unsigned long HEARTBEAT_TIMEOUTS[HEARTBEAT_COUNT] = {
+        Config::Watchdog::SENSOR_TIMEOUT, Config::Watchdog::CONTROL_TIMEOUT,
+        Config::Watchdog::TACH_TIMEOUT, Config::Watchdog::NETWORK_TIMEOUT
+    };
+
+    Record& record;                     // Lives in RTC memory
+    Record lastCrash;
+    bool crashValid = false;
+    esp_reset_reason_t resetReason = ESP_RST_UNKNOWN;
+
+    unsigned long lastBeat[HEARTBEAT_COUNT];
+    unsigned long loopStart = 0;
+
+    static const char* subsystemName(uint8_t subsystem) {
+        switch (static_cast<Subsystem>(subsystem)) {
+            case Subsystem::SENSOR:  return "sensor";
+            case Subsystem::CONTROL: return "control";
+            case Subsystem::TACH:    return "tach";
+            case Subsystem::NETWORK: return "network";
+            case Subsystem::LOOP:    return "loop";
+            case Subsystem::IDLE:    return "idle";
+            default:                 return "none";
+        }
+    }
+
+    static const char* resetReasonName(esp_reset_reason_t reason) {
+        switch (reason) {
+            case ESP_RST_POWERON:   return "power_on";
+            case ESP_RST_EXT:       return "external";
+            case ESP_RST_SW:        return "software";
+            case ESP_RST_PANIC:     return "panic";
+            case ESP_RST_INT_WDT:   return "interrupt_watchdog";
+            case ESP_RST_TASK_WDT:  return "task_watchdog";
+            case ESP_RST_WDT:       return "watchdog";
+            case ESP_RST_DEEPSLEEP: return "deep_sleep";
+            case ESP_RST_BROWNOUT:  return "brownout";
+            default:                return "unknown";
+        }
+    }
+
+    bool isCrash(esp_reset_reason_t reason) const {
+        switch (reason) {
+            case ESP_RST_PANIC:
+            case ESP_RST_INT_WDT:
+            case ESP_RST_TASK_WDT:
+            case ESP_RST_WDT:
+            case ESP_RST_BROWNOUT:
+                return true;
+            case ESP_RST_SW:
+                return record.staleSubsystem != NO_SUBSYSTEM;
+            default:
+                return false;
+        }
+    }
+
+public:
+    explicit Watchdog(Record& rtcRecord) : record(rtcRecord) {
+        memset(&lastCrash, 0, sizeof(lastCrash));
+        memset(lastBeat, 0, sizeof(lastBeat));
+    }
+
+    void begin() {
+        resetReason = esp_reset_reason();
+        bool recordValid = resetReason != ESP_RST_POWERON && record.magic == MAGIC;
+        if (recordValid && isCrash(resetReason)) {
+            lastCrash = record;
+            crashValid = true;
+            LOG_PRINT("DEBUG: Recovered from ");
+            LOG_PRINT(resetReasonName(resetReason));
+            LOG_PRINT(" in subsystem ");
+            LOG_PRINTLN(subsystemName(lastCrash.staleSubsystem != NO_SUBSYSTEM ? lastCrash.staleSubsystem
+                                                                                : lastCrash.subsystem));
+        }
+
+        uint32_t bootCount = recordValid ? record.bootCount + 1 : 1;
+        memset(&record, 0, sizeof(record));
+        record.magic = MAGIC;
+        record.bootCount = bootCount;
+        record.subsystem = static_cast<uint8_t>(Subsystem::LOOP);
+        record.staleSubsystem = NO_SUBSYSTEM;
+
+        unsigned long now = millis();
+        for (int i = 0; i < HEARTBEAT_COUNT; i++) {
+            lastBeat[i] = now;
+        }
+
+        // The task watchdog is usually running already (idle task); otherwise start it
+        esp_task_wdt_config_t config = {};
+        config.timeout_ms = Config::Watchdog::TIMEOUT;
+        config.idle_core_mask = 0;
+        config.trigger_panic = true;
+        if (esp_task_wdt_reconfigure(&config) != ESP_OK) {
+            esp_task_wdt_init(&config);
+        }
+        esp_task_wdt_add(nullptr);
+        LOG_PRINTLN("DEBUG: Task watchdog enabled");
+    }
+
+    // Marks the subsystem now running, so a hang is attributed to it
+    void enter(Subsystem subsystem) {
+        record.subsystem = static_cast<uint8_t>(subsystem);
+    }
+
+    // Progress report of a subsystem
+    void beat(Subsystem subsystem) {
+        lastBeat[static_cast<int>(subsystem)] = millis();
+    }
+
+    void beginLoop() {
+        loopStart = micros();
+        enter(Subsystem::LOOP);
+    }
+
+    // End of the busy part of a loop iteration: records timing and state, and feeds the
+    // watchdog unless a heartbeat is overdue, in which case the system restarts
+    void endLoop(const SystemStatus& status) {
+        unsigned long now = millis();
+        uint32_t busy = micros() - loopStart;
+        record.uptime = now;
+        record.loopCount++;
+        record.lastLoopUs = busy;
+        if (busy > record.maxLoopUs) record.maxLoopUs = busy;
+        record.errorState = static_cast<uint8_t>(status.errorState);
+        record.statusCode = static_cast<uint8_t>(status.statusCode);
+
+        for (int i = 0; i < HEARTBEAT_COUNT; i++) {
+            record.heartbeatAge[i] = now - lastBeat[i];
+            if (record.heartbeatAge[i] > HEARTBEAT_TIMEOUTS[i]) {
+                record.staleSubsystem = i;
+                LOG_PRINT("DEBUG: Heartbeat timeout in subsystem ");
+                LOG_PRINTLN(subsystemName(i));
+                EventLog::record(EventLog::Code::RESTART,
+                                 static_cast<uint8_t>(EventLog::RestartCause::HEARTBEAT_TIMEOUT), i);
+                EventLog::persist(true);
+                ESP.restart();
+                return;
+            }
+        }
+
+        esp_task_wdt_reset();
+        enter(Subsystem::IDLE);
+    }
+
+    void toJson(TextWriter& out) const {
+        out.print("{\"reset_reason\":\"").print(resetReasonName(resetReason)).print('"');
+        out.print(",\"boot_count\":").print(record.bootCount);
+        out.print(",\"timeout_ms\":").print(Config::Watchdog::TIMEOUT);
+        out.print(",\"loop_count\":").print(record.loopCount);
+        out.print(",\"last_loop_us\":").print(record.lastLoopUs);
+        out.print(",\"max_loop_us\":").print(record.maxLoopUs);
+
+        unsigned long now = millis();
+        out.print(",\"heartbeat_age_ms\":{");
+        for (int i = 0; i < HEARTBEAT_COUNT; i++) {
+            if (i > 0) out.print(',');
+            out.print('"').print(subsystemName(i)).print("\":").print(now - lastBeat[i]);
+        }
+        out.print('}');
+
+        out.print(",\"last_crash\":");
+        if (!crashValid) {
+            out.print("null}");
+            return;
+        }
+        out.print("{\"subsystem\":\"").print(subsystemName(lastCrash.subsystem)).print('"');
+        out.print(",\"stale_heartbeat\":");
+        if (lastCrash.staleSubsystem != NO_SUBSYSTEM) {
+            out.print('"').print(subsystemName(lastCrash.staleSubsystem)).print('"');
+        } else {
+            out.print("null");
+        }
+        out.print(",\"uptime_ms\":").print(lastCrash.uptime);
+        out.print(",\"loop_count\":").print(lastCrash.loopCount);
+        out.print(",\"last_loop_us\":").print(lastCrash.lastLoopUs);
+        out.print(",\"max_loop_us\":").print(lastCrash.maxLoopUs);
+        out.print(",\"heartbeat_age_ms\":{");
+        for (int i = 0; i < HEARTBEAT_COUNT; i++) {
+            if (i > 0) out.print(',');
+            out.print('"').print(subsystemName(i)).print("\":").print(lastCrash.heartbeatAge[i]);
+        }
+        out.print("},\"error_state\":\"")
+            .print(SystemStatus::getErrorString(static_cast<SystemStatus::ErrorState>(lastCrash.errorState)));
+        out.print("\",\"status_code\":\"")
+            .print(SystemStatus::getStatusCodeName(static_cast<SystemStatus::StatusCode>(lastCrash.statusCode)));
+        out.print("\"}}");
+    }
+};
+
+#endif // WATCHDOG_H
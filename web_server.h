@@ -1,60 +1,170 @@
 #ifndef WEB_SERVER_H
 #define WEB_SERVER_H
 
-#include <WebServer.h>
+#include <climits>
 #include "config.h"
+#include "logging.h"
+#include "http_server.h"
 #include "system_status.h"
-#include "fan_controller.h"
+#include "fan_commands.h"
+#include "watchdog.h"
+#include "safety_monitor.h"
+#include "fan_model.h"
+#include "fan_curve.h"
+#include "event_log.h"
+#if FEATURE_STATISTICS
+#include "energy_meter.h"
+#include "burn_sessions.h"
+#endif
+#if FEATURE_WEB_UI
 #include "html_content.h"
+#endif
 
 class WebServerManager {
 private:
-    WebServer server;
+    HttpServer server;
     SystemStatus& status;
-    FanController& controller;
+    FanCommands& commands;
+    const Watchdog& watchdog;
+    SafetyMonitor& safety;
+    const FanModel& fanModel;
+    const FanCurve& fanCurve;
+#if FEATURE_STATISTICS
+    EnergyMeter& energyMeter;
+    BurnSessionTracker& burnSessions;
+#endif
+    unsigned long lastLongPollCheck = 0;
 
     void setupRoutes() {
         // Root and API routes with debug output
-        server.on("/", HTTP_GET, [this]() { 
-            Serial.println("DEBUG: Serving root page");
+#if FEATURE_WEB_UI
+        server.on("/", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Serving root page");
             handleRoot(); 
         });
+#endif
 
-        server.on("/api/v1/status", HTTP_GET, [this]() { 
-            Serial.println("DEBUG: Status request received");
+        server.on("/api/v1/status", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Status request received");
             handleGetData(); 
         });
 
-        server.on("/api/v1/fan/toggle", HTTP_POST, [this]() { 
-            Serial.println("DEBUG: Fan toggle request received");
+#if FEATURE_STATISTICS
+        server.on("/api/v1/energy", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Energy request received");
+            handleGetEnergy(); 
+        });
+
+        server.on("/api/v1/sessions", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Sessions request received");
+            handleGetSessions(); 
+        });
+#endif
+
+        server.on("/api/v1/system/features", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Feature report request received");
+            handleGetFeatures(); 
+        });
+
+        server.on("/api/v1/system/memory", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Memory report request received");
+            handleGetMemory(); 
+        });
+
+        server.on("/api/v1/system/watchdog", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Watchdog report request received");
+            handleGetWatchdog(); 
+        });
+
+        server.on("/api/v1/events/log", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Event log request received");
+            handleGetEvents(); 
+        });
+
+        server.on("/api/v1/safety", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Safety report request received");
+            handleGetSafety(); 
+        });
+
+        server.on("/api/v1/safety/reset", HttpMethod::POST, [this]() { 
+            LOG_PRINTLN("DEBUG: Safety reset request received");
+            handleResetSafety(); 
+        });
+
+        server.on("/api/v1/fan/toggle", HttpMethod::POST, [this]() { 
+            LOG_PRINTLN("DEBUG: Fan toggle request received");
             handleToggleFan(); 
         });
 
-        server.on("/api/v1/fan/mode", HTTP_POST, [this]() { 
-            Serial.println("DEBUG: Mode change request received");
+        server.on("/api/v1/fan/mode", HttpMethod::POST, [this]() { 
+            LOG_PRINTLN("DEBUG: Mode change request received");
             handleSetAutoMode(); 
         });
 
-        server.on("/api/v1/fan/speed", HTTP_POST, [this]() { 
-            Serial.println("DEBUG: Speed change request received");
+        server.on("/api/v1/fan/speed", HttpMethod::POST, [this]() { 
+            LOG_PRINTLN("DEBUG: Speed change request received");
             handleSetFanSpeed(); 
         });
 
-        server.on("/api/v1/temperature/reset", HTTP_POST, [this]() { 
-            Serial.println("DEBUG: Temperature reset request received");
+        server.on("/api/v1/fan/calibration", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Fan calibration report request received");
+            handleGetCalibration(); 
+        });
+
+        server.on("/api/v1/fan/calibration", HttpMethod::POST, [this]() { 
+            LOG_PRINTLN("DEBUG: Fan calibration start request received");
+            handleStartCalibration(); 
+        });
+
+        server.on("/api/v1/fan/calibration/abort", HttpMethod::POST, [this]() { 
+            LOG_PRINTLN("DEBUG: Fan calibration abort request received");
+            handleAbortCalibration(); 
+        });
+
+        server.on("/api/v1/fan/curve", HttpMethod::GET, [this]() { 
+            LOG_PRINTLN("DEBUG: Fan curve request received");
+            handleGetCurve(); 
+        });
+
+        server.on("/api/v1/fan/curve", HttpMethod::POST, [this]() { 
+            LOG_PRINTLN("DEBUG: Fan curve update received");
+            handleSetCurve(); 
+        });
+
+        server.on("/api/v1/fan/health/reset", HttpMethod::POST, [this]() { 
+            LOG_PRINTLN("DEBUG: Fan health reset request received");
+            handleResetFanHealth(); 
+        });
+
+        server.on("/api/v1/temperature/reset", HttpMethod::POST, [this]() { 
+            LOG_PRINTLN("DEBUG: Temperature reset request received");
             handleResetTemperature(); 
         });
 
         // CORS Options handling
-        server.on("/api/v1/status", HTTP_OPTIONS, [this]() { handleCORS(); });
-        server.on("/api/v1/fan/toggle", HTTP_OPTIONS, [this]() { handleCORS(); });
-        server.on("/api/v1/fan/mode", HTTP_OPTIONS, [this]() { handleCORS(); });
-        server.on("/api/v1/fan/speed", HTTP_OPTIONS, [this]() { handleCORS(); });
-        server.on("/api/v1/temperature/reset", HTTP_OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/status", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+#if FEATURE_STATISTICS
+        server.on("/api/v1/energy", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/sessions", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+#endif
+        server.on("/api/v1/system/features", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/system/memory", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/system/watchdog", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/events/log", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/safety", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/safety/reset", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/fan/toggle", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/fan/mode", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/fan/speed", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/fan/calibration", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/fan/calibration/abort", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/fan/curve", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/fan/health/reset", HttpMethod::OPTIONS, [this]() { handleCORS(); });
+        server.on("/api/v1/temperature/reset", HttpMethod::OPTIONS, [this]() { handleCORS(); });
 
         // 404 Handler
         server.onNotFound([this]() {
-            Serial.println("DEBUG: 404 - Not Found");
+            LOG_PRINTLN("DEBUG: 404 - Not Found");
             handleNotFound();
         });
     }
@@ -62,183 +172,387 @@ private:
     void handleCORS() {
         server.sendHeader("Access-Control-Allow-Origin", "*");
         server.sendHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-        server.sendHeader("Access-Control-Allow-Headers", "Content-Type");
+        server.sendHeader("Access-Control-Allow-Headers", "Content-Type, If-None-Match");
         server.send(204);
     }
 
+#if FEATURE_WEB_UI
     void handleRoot() {
-        Serial.println("DEBUG: Building HTML content");
-        server.send(200, "text/html", buildHtmlContent());
-        Serial.println("DEBUG: Root page sent");
+        LOG_PRINTLN("DEBUG: Streaming HTML content");
+        server.sendStatic(200, "text/html", HTML_PARTS, HTML_PART_COUNT);
     }
+#endif
 
+    // Supports ?fields=a,b for a subset, If-None-Match with the "<boot>-v<version>" ETag, and
+    // ?since=<version>[&boot=<boot>]&wait=<ms> to long-poll until a selected field changes.
+    // A since from another boot (a different boot, or ahead of the current version) answers at once.
     void handleGetData() {
-        Serial.println("DEBUG: Preparing status data");
-        
-        // Add CORS and cache control headers
+        SystemStatus::FieldMask fields = SystemStatus::parseFieldList(server.arg("fields"));
+        status.refreshVersion();
+        uint32_t version = status.getVersion(fields);
+
+        if (server.hasArg("since") && !server.deferExpired()) {
+            uint32_t since = strtoul(server.arg("since"), nullptr, 10);
+            unsigned long wait = strtoul(server.arg("wait"), nullptr, 10);
+            bool sameBoot = !server.hasArg("boot") || strtoul(server.arg("boot"), nullptr, 16) == status.getBootId();
+            if (sameBoot && version == since && wait > 0 && server.defer(wait)) {
+                return;
+            }
+        }
+
+        char etag[24];
+        snprintf(etag, sizeof(etag), "\"%08lx-v%lu\"", static_cast<unsigned long>(status.getBootId()),
+                 static_cast<unsigned long>(version));
+
+        // Add CORS and cache control headers; clients revalidate with the ETag
         server.sendHeader("Access-Control-Allow-Origin", "*");
         server.sendHeader("Access-Control-Allow-Methods", "GET");
-        server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-        server.sendHeader("Pragma", "no-cache");
-        server.sendHeader("Expires", "-1");
+        server.sendHeader("Access-Control-Expose-Headers", "ETag");
+        server.sendHeader("Cache-Control", "no-cache");
+        server.sendHeader("ETag", etag);
+
+        const char* ifNoneMatch = server.header("If-None-Match");
+        if (ifNoneMatch && strcmp(ifNoneMatch, etag) == 0) {
+            server.send(304);
+            return;
+        }
 
         // Generate and send JSON
-        String jsonData = status.toJson();
-        Serial.print("DEBUG: Sending JSON data: ");
-        Serial.println(jsonData);
-        server.send(200, "application/json", jsonData);
+        TextWriter json = server.text();
+        status.toJson(json, fields);
+        server.send(200, "application/json", json);
     }
 
-    void handleToggleFan() {
-        Serial.println("DEBUG: Processing fan toggle request");
-        if (!validatePostRequest()) return;
+#if FEATURE_STATISTICS
+    void handleGetEnergy() {
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.sendHeader("Cache-Control", "no-cache");
+        TextWriter json = server.text();
+        energyMeter.toJson(json);
+        server.send(200, "application/json", json);
+    }
 
-        if (status.autoMode) {
-            sendError(400, "Cannot toggle fan in automatic mode");
-            return;
+    void handleGetSessions() {
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.sendHeader("Cache-Control", "no-cache");
+        TextWriter json = server.text();
+        burnSessions.toJson(json);
+        server.send(200, "application/json", json);
+    }
+#endif
+
+    // Compiled-in features and the static RAM of their objects. Flash per feature
+    // cannot be seen from inside the image, tools/feature_footprint.sh measures it.
+    void handleGetFeatures() {
+        TextWriter json = server.text();
+        json.print("{\"features\":{\"web_ui\":").print(FEATURE_WEB_UI != 0);
+        json.print(",\"rest_api\":true");
+        json.print(",\"heat_engine\":").print(FEATURE_HEAT_ENGINE != 0);
+        json.print(",\"statistics\":").print(FEATURE_STATISTICS != 0);
+        json.print(",\"logging\":").print(FEATURE_LOGGING != 0);
+        json.print(",\"mqtt\":").print(FEATURE_MQTT != 0).print('}');
+
+        json.print(",\"static_ram\":{\"web_server\":").print(sizeof(WebServerManager));
+        json.print(",\"system_status\":").print(sizeof(SystemStatus));
+        json.print(",\"fan_health\":").print(sizeof(FanHealthMonitor));
+#if FEATURE_STATISTICS
+        json.print(",\"energy_meter\":").print(sizeof(EnergyMeter));
+        json.print(",\"burn_sessions\":").print(sizeof(BurnSessionTracker));
+#endif
+        json.print('}');
+
+#if FEATURE_WEB_UI
+        size_t uiBytes = 0;
+        for (int i = 0; i < HTML_PART_COUNT; i++) {
+            uiBytes += strlen(HTML_PARTS[i]);
         }
+        json.print(",\"web_ui_flash\":").print(uiBytes);
+#endif
+        json.print('}');
 
-        status.fanOn = !status.fanOn;
-        controller.toggleFan(status.fanOn);
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.send(200, "application/json", json);
+    }
 
-        if (status.fanOn) {
-            controller.setFanSpeed(status.manualFanSpeed);
-        } else {
-            controller.setFanSpeed(0.0f);
-        }
+    // Request arena usage and heap fragmentation, to confirm long-running units stay healthy
+    void handleGetMemory() {
+        uint32_t freeHeap = ESP.getFreeHeap();
+        uint32_t largestBlock = ESP.getMaxAllocHeap();
+
+        TextWriter json = server.text();
+        json.print("{\"arena_size\":").print(server.getArenaSize());
+        json.print(",\"arena_high_water\":").print(server.getArenaHighWater());
+        json.print(",\"arena_overflows\":").print(server.getArenaOverflows());
+        json.print(",\"free_heap\":").print(freeHeap);
+        json.print(",\"min_free_heap\":").print(ESP.getMinFreeHeap());
+        json.print(",\"largest_free_block\":").print(largestBlock);
+        json.print(",\"fragmentation_percent\":")
+            .print(freeHeap > 0 ? 100.0f - largestBlock * 100.0f / freeHeap : 0.0f, 1);
+        json.print('}');
+
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.sendHeader("Cache-Control", "no-cache");
+        server.send(200, "application/json", json);
+    }
+
+    // Reset reason, loop timing, heartbeat ages and the state saved at the last crash
+    void handleGetWatchdog() {
+        TextWriter json = server.text();
+        watchdog.toJson(json);
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.sendHeader("Cache-Control", "no-cache");
+        server.send(200, "application/json", json);
+    }
+
+    // Event log rows after a cursor
+    // ?after=<seq> returns only newer events, ?limit=<n> caps the count
+    void handleGetEvents() {
+        uint32_t after = server.hasArg("after") ? strtoul(server.arg("after"), nullptr, 10) : 0;
+        int limit = server.hasArg("limit") ? atoi(server.arg("limit")) : Config::EventLog::MAX_PER_RESPONSE;
+        TextWriter json = server.text();
+        EventLog::toJson(json, after, limit);
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.sendHeader("Cache-Control", "no-cache");
+        server.send(200, "application/json", json);
+    }
+
+    // Trip thresholds, guaranteed and measured response times and the last event
+    void handleGetSafety() {
+        TextWriter json = server.text();
+        safety.toJson(json);
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.sendHeader("Cache-Control", "no-cache");
+        server.send(200, "application/json", json);
+    }
+
+    void handleResetSafety() {
+        LOG_PRINTLN("DEBUG: Processing safety reset request");
+        if (!validatePostRequest()) return;
+
+        sendResult(commands.resetSafety());
+    }
+
+    // Sweep progress and the duty -> RPM table in use
+    void handleGetCalibration() {
+        const SystemStatus::FanCalibrationStats& sweep = status.fanCalibration;
+        TextWriter json = server.text();
+        json.print("{\"running\":").print(sweep.running);
+        json.print(",\"state\":\"").print(sweep.state);
+        json.print("\",\"failure\":\"").print(sweep.failure);
+        json.print("\",\"progress\":").print(sweep.progress, 2);
+        json.print(",\"model\":");
+        fanModel.toJson(json);
+        json.print('}');
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.sendHeader("Cache-Control", "no-cache");
+        server.send(200, "application/json", json);
+    }
+
+    void handleStartCalibration() {
+        LOG_PRINTLN("DEBUG: Processing fan calibration start request");
+        if (!validatePostRequest()) return;
 
-        sendSuccess("Fan state toggled successfully");
+        sendResult(commands.startCalibration());
+    }
+
+    void handleAbortCalibration() {
+        LOG_PRINTLN("DEBUG: Processing fan calibration abort request");
+        if (!validatePostRequest()) return;
+
+        sendResult(commands.abortCalibration());
+    }
+
+    void handleToggleFan() {
+        LOG_PRINTLN("DEBUG: Processing fan toggle request");
+        if (!validatePostRequest()) return;
+
+        sendResult(commands.toggleFan());
     }
 
     void handleSetAutoMode() {
-        Serial.println("DEBUG: Processing auto mode change request");
+        LOG_PRINTLN("DEBUG: Processing auto mode change request");
         if (!validatePostRequest()) return;
 
         if (!server.hasArg("mode")) {
-            Serial.println("DEBUG: Missing 'mode' parameter");
+            LOG_PRINTLN("DEBUG: Missing 'mode' parameter");
             sendError(400, "Missing 'mode' parameter");
             return;
         }
 
-        String mode = server.arg("mode");
-        Serial.print("DEBUG: Requested mode: ");
-        Serial.println(mode);
+        const char* mode = server.arg("mode");
+        LOG_PRINT("DEBUG: Requested mode: ");
+        LOG_PRINTLN(mode);
 
-        bool newMode = (mode == "1" || mode.equalsIgnoreCase("true"));
-        
-        if (status.setAutoMode(newMode)) {
-            if (newMode) {
-                controller.updateAutomaticMode();
-            } else if (status.fanOn) {
-                controller.setFanSpeed(status.manualFanSpeed);
-            }
-            sendSuccess("Mode updated successfully");
-        } else {
-            sendError(400, "Failed to update mode");
-        }
+        sendResult(commands.setAutoMode(strcmp(mode, "1") == 0 || strcasecmp(mode, "true") == 0));
     }
 
-    void handleSetFanSpeed() {
-        Serial.println("DEBUG: Processing fan speed change request");
-        if (!validatePostRequest()) return;
+    void handleGetCurve() {
+        TextWriter json = server.text();
+        fanCurve.toJson(json);
+        server.sendHeader("Access-Control-Allow-Origin", "*");
+        server.sendHeader("Cache-Control", "no-cache");
+        server.send(200, "application/json", json);
+    }
 
-        if (status.autoMode) {
-            Serial.println("DEBUG: Cannot set fan speed in automatic mode");
-            sendError(400, "Cannot set fan speed in automatic mode");
+    // Any of points, hysteresis and strategy; the others keep their values
+    void handleSetCurve() {
+        if (!validatePostRequest()) return;
+        if (!server.hasArg("points") && !server.hasArg("hysteresis") && !server.hasArg("strategy")) {
+            sendError(400, "Missing 'points', 'hysteresis' or 'strategy' parameter");
             return;
         }
 
-        if (!server.hasArg("speed")) {
-            Serial.println("DEBUG: Missing 'speed' parameter");
-            sendError(400, "Missing 'speed' parameter");
+        FanCurve::Table table = fanCurve.getTable();
+        if (server.hasArg("points") && !FanCurve::parsePoints(server.arg("points"), table)) {
+            sendError(400, "Invalid 'points' parameter");
             return;
         }
+        if (server.hasArg("hysteresis")) {
+            table.hysteresis = atof(server.arg("hysteresis"));
+        }
+        if (server.hasArg("strategy")) {
+            FanCurve::Strategy strategy;
+            if (!FanCurve::parseStrategy(server.arg("strategy"), strategy)) {
+                sendError(400, "Invalid 'strategy' parameter");
+                return;
+            }
+            table.strategy = static_cast<uint8_t>(strategy);
+        }
+        sendResult(commands.setFanCurve(table));
+    }
 
-        String speedStr = server.arg("speed");
-        Serial.print("DEBUG: Requested speed: ");
-        Serial.println(speedStr);
+    void handleSetFanSpeed() {
+        LOG_PRINTLN("DEBUG: Processing fan speed change request");
+        if (!validatePostRequest()) return;
 
-        float speed = speedStr.toFloat();
-        if (isnan(speed) || speed < 0.0f || speed > 1.0f) {
-            Serial.println("DEBUG: Invalid speed value");
-            sendError(400, "Invalid speed value");
+        if (!server.hasArg("speed")) {
+            LOG_PRINTLN("DEBUG: Missing 'speed' parameter");
+            sendError(400, "Missing 'speed' parameter");
             return;
         }
 
-        status.manualFanSpeed = speed;
-        if (status.fanOn) {
-            controller.setFanSpeed(speed);
-        }
+        const char* speedStr = server.arg("speed");
+        LOG_PRINT("DEBUG: Requested speed: ");
+        LOG_PRINTLN(speedStr);
 
-        sendSuccess("Speed updated successfully");
+        sendResult(commands.setManualSpeed(atof(speedStr)));
     }
 
     void handleResetTemperature() {
-        Serial.println("DEBUG: Processing temperature reset request");
+        LOG_PRINTLN("DEBUG: Processing temperature reset request");
         if (!validatePostRequest()) return;
         
-        status.resetMinMaxTemperature();
-        sendSuccess("Temperature ranges reset successfully");
+        sendResult(commands.resetTemperature());
+    }
+
+    void handleResetFanHealth() {
+        LOG_PRINTLN("DEBUG: Processing fan health reset request");
+        if (!validatePostRequest()) return;
+        
+        sendResult(commands.resetFanHealth());
     }
 
     void handleNotFound() {
-        Serial.println("DEBUG: Handling 404 Not Found");
-        String message = "File Not Found\n\n";
-        message += "URI: ";
-        message += server.uri();
-        message += "\nMethod: ";
-        message += (server.method() == HTTP_GET) ? "GET" : "POST";
-        message += "\nArguments: ";
-        message += server.args();
-        message += "\n";
+        LOG_PRINTLN("DEBUG: Handling 404 Not Found");
+        TextWriter message = server.text();
+        message.print("File Not Found\n\nURI: ").print(server.uri());
+        message.print("\nMethod: ").print((server.method() == HttpMethod::GET) ? "GET" : "POST");
+        message.print("\nArguments: ").print(server.args()).print('\n');
         for (uint8_t i = 0; i < server.args(); i++) {
-            message += " " + server.argName(i) + ": " + server.arg(i) + "\n";
+            message.print(' ').print(server.argName(i)).print(": ").print(server.arg(i)).print('\n');
         }
         server.send(404, "text/plain", message);
     }
 
     bool validatePostRequest() {
-        if (server.method() != HTTP_POST) {
-            Serial.println("DEBUG: Invalid method - expecting POST");
+        if (server.method() != HttpMethod::POST) {
+            LOG_PRINTLN("DEBUG: Invalid method - expecting POST");
             sendError(405, "Method Not Allowed");
             return false;
         }
         return true;
     }
 
-    void sendError(int code, const String& message) {
-        Serial.print("DEBUG: Sending error response: ");
-        Serial.println(message);
+    void sendError(int code, const char* message) {
+        LOG_PRINT("DEBUG: Sending error response: ");
+        LOG_PRINTLN(message);
         
         server.sendHeader("Access-Control-Allow-Origin", "*");
-        String json = "{\"error\":\"" + message + "\"}";
+        TextWriter json = server.text();
+        json.print("{\"error\":\"").print(message).print("\"}");
         server.send(code, "application/json", json);
     }
 
-    void sendSuccess(const String& message) {
-        Serial.print("DEBUG: Sending success response: ");
-        Serial.println(message);
+    void sendResult(const FanCommands::Result& result) {
+        if (result.ok) {
+            sendSuccess(result.message);
+        } else {
+            sendError(400, result.message);
+        }
+    }
+
+    void sendSuccess(const char* message) {
+        LOG_PRINT("DEBUG: Sending success response: ");
+        LOG_PRINTLN(message);
         
         server.sendHeader("Access-Control-Allow-Origin", "*");
-        String json = "{\"success\":\"" + message + "\"}";
+        TextWriter json = server.text();
+        json.print("{\"success\":\"").print(message).print("\"}");
         server.send(200, "application/json", json);
     }
 
 public:
-    WebServerManager(SystemStatus& systemStatus, FanController& fanController)
-        : server(Config::WebServer::PORT), status(systemStatus), controller(fanController)
+#if FEATURE_STATISTICS
+    WebServerManager(SystemStatus& systemStatus, FanCommands& fanCommands, const Watchdog& systemWatchdog,
+                     SafetyMonitor& safetyMonitor, const FanModel& model, const FanCurve& curve, EnergyMeter& meter,
+                     BurnSessionTracker& sessions)
+        : server(Config::WebServer::PORT), status(systemStatus), commands(fanCommands), watchdog(systemWatchdog),
+          safety(safetyMonitor), fanModel(model), fanCurve(curve), energyMeter(meter), burnSessions(sessions)
+#else
+    WebServerManager(SystemStatus& systemStatus, FanCommands& fanCommands, const Watchdog& systemWatchdog,
+                     SafetyMonitor& safetyMonitor, const FanModel& model, const FanCurve& curve)
+        : server(Config::WebServer::PORT), status(systemStatus), commands(fanCommands), watchdog(systemWatchdog),
+          safety(safetyMonitor), fanModel(model), fanCurve(curve)
+#endif
     {
         setupRoutes();
     }
 
     void begin() {
-        server.begin();
-        Serial.println("DEBUG: Web server initialized on port " + String(Config::WebServer::PORT));
-        Serial.println("DEBUG: Server IP address: " + WiFi.localIP().toString());
+        if (!server.begin()) {
+            LOG_PRINTLN("DEBUG: Web server failed to open its listening socket");
+            return;
+        }
+        LOG_PRINTLN("DEBUG: Web server initialized on port " + String(Config::WebServer::PORT));
     }
 
     void handle() {
-        server.handleClient();
+        server.handle();
+
+        // Answer long-polls whose fields changed or whose wait ran out
+        unsigned long now = millis();
+        if (server.deferredCount() > 0 && now - lastLongPollCheck >= Config::WebServer::LONG_POLL_CHECK_INTERVAL) {
+            lastLongPollCheck = now;
+            status.refreshVersion();
+            server.resumeDeferred();
+        }
+    }
+
+    // Sleeps until network activity (including data on extraSocket) or the timeout, used by the power manager
+    bool waitForActivity(unsigned long timeoutMs, int extraSocket = -1) {
+        return server.waitForActivity(timeoutMs, extraSocket);
+    }
+
+    // Time until handle() has timed work (the long-poll check), for the power manager
+    unsigned long msUntilNextEvent() const {
+        if (server.deferredCount() == 0) return ULONG_MAX;
+        unsigned long elapsed = millis() - lastLongPollCheck;
+        return elapsed >= Config::WebServer::LONG_POLL_CHECK_INTERVAL
+                   ? 0 : Config::WebServer::LONG_POLL_CHECK_INTERVAL - elapsed;
+    }
+
+    int activeConnections() const {
+        return server.activeConnections();
     }
 };
 
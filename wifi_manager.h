@@ -0,0 +1,204 @@
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include "config.h"
+#include "logging.h"
+#include "system_status.h"
+#include "event_log.h"
+
+// Station connection as a state machine driven from the loop, so setup() and the control
+// loop never wait for the network. An attempt that gets no IP within CONNECT_TIMEOUT, or is
+// refused by the AP, fails; the next one follows after an exponential backoff from
+// BACKOFF_MIN up to BACKOFF_MAX, shortened by a random part of up to JITTER so units that
+// lost the same AP do not retry in step. A dropped link is retried at once.
+// Link events arrive on the WiFi event task and are handed over through atomics.
+// RSSI, the last disconnect reason and the counters are published in SystemStatus::wifi.
+class WifiManager {
+public:
+    enum class State : uint8_t {
+        CONNECTING,
+        CONNECTED,
+        BACKOFF                 // Waiting before the next attempt
+    };
+
+private:
+    static constexpr uint8_t REASON_NONE = 0;
+
+    SystemStatus& status;
+    State state = State::BACKOFF;
+    unsigned long stateSince = 0;
+    unsigned long backoff = 0;          // Wait of the current BACKOFF state in ms
+    unsigned long lastRssiSample = 0;
+    uint32_t failedAttempts = 0;        // In a row, reset on connect
+    float rssi = NAN;                   // Smoothed, dBm
+
+    // From the event task
+    std::atomic<bool> gotIp{false};
+    std::atomic<bool> linkLost{false};
+    std::atomic<uint8_t> lostReason{REASON_NONE};
+
+    void onEvent(arduino_event_id_t event, arduino_event_info_t info) {
+        if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+            gotIp.store(true);
+        } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+            // Our own disconnect before a retry is no news
+            uint8_t reason = info.wifi_sta_disconnected.reason;
+            if (reason == WIFI_REASON_ASSOC_LEAVE) return;
+            lostReason.store(reason);
+            linkLost.store(true);
+        } else if (event == ARDUINO_EVENT_WIFI_STA_LOST_IP) {
+            lostReason.store(REASON_NONE);
+            linkLost.store(true);
+        }
+    }
+
+    void setState(State next) {
+        state = next;
+        stateSince = millis();
+        status.wifi.state = getStateName(next);
+    }
+
+    void connect() {
+        gotIp.store(false);
+        linkLost.store(false);
+        WiFi.begin(Config::WIFI_SSID, Config::WIFI_PASSWORD);
+        setState(State::CONNECTING);
+    }
+
+    // Doubles per failed attempt from BACKOFF_MIN up to BACKOFF_MAX, minus up to JITTER of it
+    unsigned long nextBackoff() const {
+        unsigned long wait = Config::Wifi::BACKOFF_MAX;
+        if (failedAttempts <= 16) {
+            wait = min(Config::Wifi::BACKOFF_MIN << (failedAttempts - 1), Config::Wifi::BACKOFF_MAX);
+        }
+        return wait - static_cast<unsigned long>(wait * Config::Wifi::JITTER * random(0, 1000) / 1000.0f);
+    }
+
+    void attemptFailed(uint8_t reason) {
+        WiFi.disconnect();
+        failedAttempts++;
+        status.wifi.failedAttempts = failedAttempts;
+        if (reason != REASON_NONE) status.wifi.lastDisconnectReason = reason;
+
+        // One journal entry per outage, not per attempt
+        if (failedAttempts == 1) {
+            EventLog::record(EventLog::Code::WIFI_ERROR, reason);
+        }
+        if (status.errorState == SystemStatus::ErrorState::NONE) {
+            status.errorState = SystemStatus::ErrorState::WIFI_ERROR;
+        }
+
+        backoff = nextBackoff();
+        setState(State::BACKOFF);
+        LOG_PRINT("DEBUG: WiFi connection failed, reason ");
+        LOG_PRINT(reason);
+        LOG_PRINT(", retry in ms ");
+        LOG_PRINTLN(backoff);
+    }
+
+    void connected() {
+        rssi = WiFi.RSSI();
+        lastRssiSample = millis();
+        status.wifi.connected = true;
+        status.wifi.rssi = lroundf(rssi);
+        status.wifi.failedAttempts = 0;
+        EventLog::record(EventLog::Code::WIFI_CONNECTED, static_cast<uint8_t>(failedAttempts > 255 ? 255 : failedAttempts), status.wifi.rssi);
+        failedAttempts = 0;
+        if (status.errorState == SystemStatus::ErrorState::WIFI_ERROR) {
+            status.errorState = SystemStatus::ErrorState::NONE;
+        }
+        setState(State::CONNECTED);
+        LOG_PRINT("DEBUG: WiFi connected, IP address ");
+        LOG_PRINTLN(WiFi.localIP());
+    }
+
+    void disconnected() {
+        uint8_t reason = lostReason.load();
+        status.wifi.connected = false;
+        status.wifi.lastDisconnectReason = reason;
+        status.wifi.disconnects++;
+        EventLog::record(EventLog::Code::WIFI_DISCONNECTED, reason, status.wifi.rssi);
+        LOG_PRINT("DEBUG: WiFi link lost, reason ");
+        LOG_PRINTLN(reason);
+        WiFi.disconnect();
+        connect();
+    }
+
+    void sampleRssi(unsigned long now) {
+        lastRssiSample = now;
+        int8_t sample = WiFi.RSSI();
+        if (sample == 0) return;    // Not associated
+        rssi += Config::Wifi::RSSI_SMOOTHING * (sample - rssi);
+        status.wifi.rssi = lroundf(rssi);
+    }
+
+public:
+    explicit WifiManager(SystemStatus& systemStatus) : status(systemStatus) {}
+
+    // Starts the first attempt and returns at once
+    void begin() {
+        WiFi.persistent(false);         // Credentials come from Config, no flash writes per attempt
+        WiFi.mode(WIFI_STA);
+        WiFi.setAutoReconnect(false);   // Retries follow the backoff here
+        WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { onEvent(event, info); });
+        connect();
+        LOG_PRINTLN("DEBUG: WiFi connecting in the background");
+    }
+
+    void handle() {
+        unsigned long now = millis();
+        switch (state) {
+            case State::CONNECTING:
+                if (gotIp.exchange(false)) {
+                    connected();
+                } else if (linkLost.exchange(false)) {
+                    attemptFailed(lostReason.load());
+                } else if (now - stateSince >= Config::Wifi::CONNECT_TIMEOUT) {
+                    attemptFailed(REASON_NONE);
+                }
+                break;
+
+            case State::CONNECTED:
+                if (linkLost.exchange(false)) {
+                    disconnected();
+                } else if (now - lastRssiSample >= Config::Wifi::RSSI_INTERVAL) {
+                    sampleRssi(now);
+                }
+                break;
+
+            case State::BACKOFF:
+                if (now - stateSince >= backoff) connect();
+                break;
+        }
+    }
+
+    // Time until handle() has timed work, for the power manager
+    unsigned long msUntilNextEvent() const {
+        unsigned long now = millis();
+        unsigned long interval = Config::Wifi::RSSI_INTERVAL;
+        unsigned long since = now - lastRssiSample;
+        if (state == State::CONNECTING) {
+            return Config::Wifi::CONNECT_POLL;
+        } else if (state == State::BACKOFF) {
+            interval = backoff;
+            since = now - stateSince;
+        }
+        return since < interval ? interval - since : 0;
+    }
+
+    bool isConnected() const { return state == State::CONNECTED; }
+
+    static const char* getStateName(State state) {
+        switch (state) {
+            case State::CONNECTING: return "connecting";
+            case State::CONNECTED:  return "connected";
+            case State::BACKOFF:    return "backoff";
+            default:                return "unknown";
+        }
+    }
+};
+
+#endif // WIFI_MANAGER_H